@@ -0,0 +1,190 @@
+/**
+ * ActorRules.cpp - Per-category threshold resolution
+ *
+ * Rules are compiled once into 64-bit masks over the factions and keywords
+ * they reference. Resolving an actor base builds the same masks from its
+ * faction and keyword lists, and the first rule sharing a bit wins.
+ *
+ * Compilation fills in the bit tables and masks of a snapshot before it is
+ * published (a copy of the active one at kDataLoaded, a freshly parsed one on
+ * load/reload) - readers never see a snapshot being modified. Compiling and
+ * publishing are serialized, so a reload racing kDataLoaded cannot publish
+ * rules that were parsed before forms existed and never compiled.
+ *
+ * Results are cached per actor base in a lock-free CategoryCache
+ * (CategoryCache.h), tagged with the snapshot's categoryGeneration so that
+ * publishing new rules invalidates the whole cache without touching it.
+ */
+
+#include "PCH.h"
+#include "ActorRules.h"
+#include "Config.h"
+#include "CellProfiles.h"
+#include "CategoryCache.h"
+
+namespace
+{
+	inline constexpr std::size_t kMaxRuleForms = 64;  // Bits per mask
+
+	CategoryCache g_categoryCache;
+	std::mutex g_compileLock;                    // Serializes compile + publish (game thread vs config watcher)
+	std::uint32_t g_lastCategoryGeneration = 0;  // Guarded by g_compileLock
+	bool g_formsLoaded = false;                  // Guarded by g_compileLock, set at kDataLoaded
+
+	/**
+	 * Resolves all references of one kind and assigns each distinct form a bit.
+	 * Returns the per-rule lists of resolved FormIDs (same order as the rules).
+	 */
+	template <class T>
+	std::vector<std::vector<RE::FormID>> ResolveRuleForms(const std::vector<ActorCategoryRule>& rules,
+		std::vector<std::string> ActorCategoryRule::*references, std::vector<RE::FormID>& bits, const char* kind)
+	{
+		std::vector<std::vector<RE::FormID>> resolved;
+		resolved.reserve(rules.size());
+
+		for (const auto& rule : rules) {
+			auto& ids = resolved.emplace_back();
+			for (const auto& reference : rule.*references) {
+				auto form = LookupConfigForm<T>(reference);
+				if (!form) {
+					logger::warn("  [Category:{}] {} \"{}\" not found - ignoring", rule.name, kind, reference);
+					continue;
+				}
+				ids.push_back(form->GetFormID());
+				bits.push_back(form->GetFormID());
+			}
+		}
+
+		std::sort(bits.begin(), bits.end());
+		bits.erase(std::unique(bits.begin(), bits.end()), bits.end());
+		if (bits.size() > kMaxRuleForms) {
+			logger::warn("  {} distinct {}s referenced, only the first {} are used", bits.size(), kind, kMaxRuleForms);
+			bits.resize(kMaxRuleForms);
+		}
+
+		return resolved;
+	}
+
+	/**
+	 * Builds the masks for an actor base and returns the first matching category.
+	 */
+	std::uint8_t ComputeCategory(RE::TESNPC* base, const PluginConfig& config)
+	{
+		std::uint64_t factionMask = 0;
+		for (const auto& factionRank : base->factions) {
+			if (factionRank.faction) {
+				factionMask |= GetFormBit(config.settings.categoryFactionBits, factionRank.faction->GetFormID());
+			}
+		}
+
+		std::uint64_t keywordMask = 0;
+		for (std::uint32_t i = 0; i < base->numKeywords; ++i) {
+			if (base->keywords[i]) {
+				keywordMask |= GetFormBit(config.settings.categoryKeywordBits, base->keywords[i]->GetFormID());
+			}
+		}
+
+		return MatchCategoryRule(config.settings.categoryRules, factionMask, keywordMask);
+	}
+
+	/**
+	 * @return true if category rules or threshold profiles reference forms
+	 */
+	bool HasFormReferences(const ConfigSettings& settings)
+	{
+		return !settings.categoryRules.empty() || !settings.thresholdProfiles.empty();
+	}
+
+	/**
+	 * Resolves the rule and profile references of an unpublished snapshot and
+	 * assigns it a new category generation. Caller holds g_compileLock.
+	 */
+	void CompileRules(PluginConfig& config)
+	{
+		ResolveProfileForms(config.settings);
+
+		if (config.settings.categoryRules.empty()) {
+			return;
+		}
+
+		logger::info("Compiling actor category rules...");
+
+		auto& rules = config.settings.categoryRules;
+
+		config.settings.categoryFactionBits.clear();
+		config.settings.categoryKeywordBits.clear();
+		auto factionIDs = ResolveRuleForms<RE::TESFaction>(rules, &ActorCategoryRule::factions, config.settings.categoryFactionBits, "faction");
+		auto keywordIDs = ResolveRuleForms<RE::BGSKeyword>(rules, &ActorCategoryRule::keywords, config.settings.categoryKeywordBits, "keyword");
+
+		for (std::size_t i = 0; i < rules.size(); ++i) {
+			rules[i].factionMask = 0;
+			for (auto formID : factionIDs[i]) {
+				rules[i].factionMask |= GetFormBit(config.settings.categoryFactionBits, formID);
+			}
+
+			rules[i].keywordMask = 0;
+			for (auto formID : keywordIDs[i]) {
+				rules[i].keywordMask |= GetFormBit(config.settings.categoryKeywordBits, formID);
+			}
+
+			logger::info("  [Category:{}] faction mask 0x{:016X}, keyword mask 0x{:016X}",
+				rules[i].name, rules[i].factionMask, rules[i].keywordMask);
+		}
+
+		// New generation - cache entries resolved against older rules become stale
+		g_lastCategoryGeneration = (g_lastCategoryGeneration + 1) & CategoryCache::kGenerationMask;
+		if (g_lastCategoryGeneration == 0) {
+			g_lastCategoryGeneration = 1;
+		}
+		config.filter.categoryGeneration = g_lastCategoryGeneration;
+
+		logger::info("Actor category rules compiled: {} rule(s), {} faction(s), {} keyword(s)",
+			rules.size(), config.settings.categoryFactionBits.size(), config.settings.categoryKeywordBits.size());
+	}
+}
+
+void CompileActorRules()
+{
+	std::lock_guard lock(g_compileLock);
+	g_formsLoaded = true;
+
+	// Copy-update-publish: the active snapshot is never modified
+	std::unique_ptr<PluginConfig> compiled;
+	{
+		const SnapshotReadGuard snapshotGuard;  // Until the copy is made, not while publishing
+		const PluginConfig* active = GetActiveConfig();
+		if (!active || !HasFormReferences(active->settings)) {
+			return;
+		}
+		compiled = std::make_unique<PluginConfig>(*active);
+	}
+	CompileRules(*compiled);
+	PublishConfig(std::move(compiled));
+}
+
+void CompileAndPublishConfig(std::unique_ptr<PluginConfig> config)
+{
+	std::lock_guard lock(g_compileLock);
+
+	if (g_formsLoaded && HasFormReferences(config->settings)) {
+		CompileRules(*config);
+	}
+
+	PublishConfig(std::move(config));
+}
+
+std::uint8_t ResolveActorCategory(const FilterParameters& filter, RE::Character* npc)
+{
+	// Rules are compiled once game data is loaded - until then everyone is default
+	if (filter.categoryGeneration == 0) {
+		return 0;
+	}
+
+	auto base = npc->GetActorBase();
+	if (!base) {
+		return 0;
+	}
+
+	const PluginConfig& config = *filter.config;  // Rules are only read on a cache miss
+	return g_categoryCache.Resolve(base->GetFormID(), filter.categoryGeneration, [&] { return ComputeCategory(base, config); });
+}
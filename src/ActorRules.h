@@ -0,0 +1,62 @@
+#pragma once
+
+#include "PCH.h"
+#include "Config.h"
+
+/**
+ * Resolves a "Plugin.esm|0xFormID" or "0xFormID" reference from the INI to a form of type T.
+ *
+ * @param reference Form reference string
+ * @return Pointer to the form, or nullptr if it does not exist or has the wrong type
+ */
+template <class T>
+T* LookupConfigForm(const std::string& reference)
+{
+	const auto separator = reference.find('|');
+	if (separator == std::string::npos) {
+		const auto formID = static_cast<RE::FormID>(strtoul(reference.c_str(), nullptr, 16));
+		return RE::TESForm::LookupByID<T>(formID);
+	}
+
+	auto dataHandler = RE::TESDataHandler::GetSingleton();
+	if (!dataHandler) {
+		return nullptr;
+	}
+
+	const std::string plugin = reference.substr(0, separator);
+	const auto localID = static_cast<RE::FormID>(strtoul(reference.c_str() + separator + 1, nullptr, 16));
+	return dataHandler->LookupForm<T>(localID, plugin);
+}
+
+/**
+ * Compiles the [Category:*] rules into faction/keyword bitsets.
+ * Every faction and keyword referenced by any rule gets one bit; each rule
+ * keeps a mask of its own bits. [Profile:*] cell and worldspace references
+ * are resolved in the same step. The result is published as a new snapshot
+ * of the active configuration. Must run after kDataLoaded so forms can be
+ * looked up. Until then every NPC resolves to the default category and
+ * only sMatch=Interior/Exterior profiles apply.
+ */
+void CompileActorRules();
+
+/**
+ * Publishes a freshly built configuration, compiling its actor category
+ * rules and profiles first if game data is already loaded. Used by the initial load and
+ * by hot reload; serialized with CompileActorRules().
+ *
+ * @param config Unpublished snapshot from BuildConfiguration()
+ */
+void CompileAndPublishConfig(std::unique_ptr<PluginConfig> config);
+
+/**
+ * Resolves the category index of an NPC (0 = default, 1..N = first matching rule).
+ * The result is computed once per actor base and cached in a fixed-size,
+ * lock-free table, so repeated calls cost one hash probe. Dynamic bases
+ * (0xFF, e.g. leveled actors) are resolved on every call, as their FormIDs
+ * are reused.
+ *
+ * @param filter Active filter parameters (rules are read from its snapshot)
+ * @param npc Pointer to the NPC character (must not be null)
+ * @return Index into FilterParameters::categories
+ */
+std::uint8_t ResolveActorCategory(const FilterParameters& filter, RE::Character* npc);
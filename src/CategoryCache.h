@@ -0,0 +1,125 @@
+#pragma once
+
+// Game-independent (also built by tests/) - standard headers only, no PCH.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @return true for a form created at runtime (load order index 0xFF). The
+ *         game reuses these IDs once the form is deleted, e.g. the temporary
+ *         base of a leveled actor after its cell unloads.
+ */
+inline bool IsDynamicFormID(std::uint32_t formID)
+{
+	return (formID >> 24) == 0xFF;
+}
+
+/**
+ * Looks up the bit assigned to a FormID in a rule bit table.
+ *
+ * @param bits Sorted FormIDs referenced by the rules (index = bit)
+ * @return Single-bit mask, or 0 if no rule references this form
+ */
+inline std::uint64_t GetFormBit(const std::vector<std::uint32_t>& bits, std::uint32_t formID)
+{
+	auto it = std::lower_bound(bits.begin(), bits.end(), formID);
+	if (it == bits.end() || *it != formID) {
+		return 0;
+	}
+	return 1ull << (it - bits.begin());
+}
+
+/**
+ * @param rules Compiled rules (anything with factionMask and keywordMask)
+ * @return Index of the first rule sharing a bit with the masks plus one, or 0
+ */
+template <class Rules>
+std::uint8_t MatchCategoryRule(const Rules& rules, std::uint64_t factionMask, std::uint64_t keywordMask)
+{
+	for (std::size_t i = 0; i < rules.size(); ++i) {
+		if ((rules[i].factionMask & factionMask) || (rules[i].keywordMask & keywordMask)) {
+			return static_cast<std::uint8_t>(i + 1);
+		}
+	}
+	return 0;
+}
+
+/**
+ * Per-base category cache: an open-addressing table of 64-bit slots
+ *   bits  0-31  actor base FormID (0 = empty slot)
+ *   bits 32-39  category index
+ *   bits 40-63  categoryGeneration of the snapshot that resolved it
+ * Entries from another generation are stale and may be overwritten, so
+ * publishing new rules invalidates the whole cache without touching it.
+ * Every slot update is a single CAS of the whole word, so a relaxed load
+ * always sees either an empty/stale slot or a complete entry.
+ *
+ * Dynamic bases (IsDynamicFormID) are never cached: their IDs are reused for
+ * unrelated forms without any event the cache could invalidate on.
+ */
+class CategoryCache
+{
+public:
+	static constexpr std::size_t kSize = 0x4000;                // 16384 slots (power of two), ~10k bases at < 65% load
+	static constexpr std::size_t kMaxProbe = 32;                // Give up and resolve uncached after this many slots
+	static constexpr std::uint32_t kGenerationMask = 0xFFFFFF;  // 24 bits stored per slot
+
+	/**
+	 * Returns the cached category of a base, resolving and caching it on a miss.
+	 *
+	 * @param formID Actor base FormID
+	 * @param generation Non-zero rule generation (FilterParameters::categoryGeneration)
+	 * @param compute Callable returning the category, invoked on a miss only
+	 */
+	template <class Compute>
+	std::uint8_t Resolve(std::uint32_t formID, std::uint32_t generation, Compute&& compute)
+	{
+		if (IsDynamicFormID(formID)) {
+			return compute();
+		}
+
+		std::size_t slot = Hash(formID);
+		for (std::size_t probe = 0; probe < kMaxProbe; ++probe, slot = (slot + 1) & (kSize - 1)) {
+			std::uint64_t entry = slots[slot].load(std::memory_order_relaxed);
+			const bool current = entry != 0 && (entry >> 40) == generation;
+
+			if (current && static_cast<std::uint32_t>(entry) == formID) {
+				return static_cast<std::uint8_t>(entry >> 32);
+			}
+
+			if (!current) {
+				// Empty or stale - resolve and try to claim this slot. If another thread
+				// claimed it first, keep our result; later calls find whichever entry won.
+				const std::uint8_t category = compute();
+				slots[slot].compare_exchange_strong(entry, MakeEntry(formID, category, generation), std::memory_order_relaxed);
+				return category;
+			}
+		}
+
+		// Probe limit reached (cache crowded) - resolve without caching
+		return compute();
+	}
+
+private:
+	/**
+	 * Fibonacci hash of a FormID into a slot index.
+	 */
+	static std::size_t Hash(std::uint32_t formID)
+	{
+		return (formID * 0x9E3779B1u) >> (32 - 14);
+	}
+	static_assert(kSize == (1u << 14), "Hash shift must match cache size");
+
+	static std::uint64_t MakeEntry(std::uint32_t formID, std::uint8_t category, std::uint32_t generation)
+	{
+		return static_cast<std::uint64_t>(formID) |
+		       (static_cast<std::uint64_t>(category) << 32) |
+		       (static_cast<std::uint64_t>(generation) << 40);
+	}
+
+	std::array<std::atomic<std::uint64_t>, kSize> slots{};
+};
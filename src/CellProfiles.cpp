@@ -0,0 +1,136 @@
+/**
+ * CellProfiles.cpp - Threshold profile switching by player location
+ *
+ * The filter never looks at the player's cell. Instead, the player's cell
+ * change events (and game load) report the new location to SetPlayerLocation,
+ * which matches it against the profiles once and swaps the active filter
+ * parameter pointer. Profiles only change on those events, so per-call cost
+ * stays one pointer load whatever the number of profiles.
+ *
+ * The same events bump the world generation (WorldEvents.h), but only when
+ * the player enters another space: between interior and exterior, another
+ * interior, or another worldspace. kEnter fires for every exterior cell
+ * border the player walks across, and the per-actor caches stay valid there.
+ */
+
+#include "PCH.h"
+#include "CellProfiles.h"
+#include "ActorRules.h"
+#include "WorldEvents.h"
+
+namespace
+{
+	// Interior cell or worldspace the player was last reported in (main thread only)
+	RE::FormID g_playerSpace = 0;
+
+	/**
+	 * Resolves references of one kind into a sorted FormID list.
+	 */
+	template <class T>
+	std::vector<RE::FormID> ResolveProfileReferences(const ThresholdProfile& profile, const std::vector<std::string>& references, const char* kind)
+	{
+		std::vector<RE::FormID> ids;
+		for (const auto& reference : references) {
+			auto form = LookupConfigForm<T>(reference);
+			if (!form) {
+				logger::warn("  [Profile:{}] {} \"{}\" not found - ignoring", profile.name, kind, reference);
+				continue;
+			}
+			ids.push_back(form->GetFormID());
+		}
+
+		std::sort(ids.begin(), ids.end());
+		ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+		return ids;
+	}
+
+	/**
+	 * Reports a cell as the player's location.
+	 *
+	 * @return true if the cell is in another space than the last one reported
+	 */
+	bool SetLocationFromCell(RE::TESObjectCELL* cell)
+	{
+		PlayerLocation location{};
+		location.cell = cell->GetFormID();
+		location.interior = cell->IsInteriorCell();
+		if (!location.interior) {
+			if (auto worldspace = cell->GetRuntimeData().worldSpace) {
+				location.worldspace = worldspace->GetFormID();
+			}
+		}
+
+		SetPlayerLocation(location);
+
+		// Interiors are their own space; exterior cells share their worldspace's
+		const RE::FormID space = location.interior ? location.cell : location.worldspace;
+		const bool changed = space != g_playerSpace;
+		g_playerSpace = space;
+		return changed;
+	}
+
+	/**
+	 * Receives the player's cell enter/leave events.
+	 */
+	class CellChangeHandler : public RE::BSTEventSink<RE::BGSActorCellEvent>
+	{
+	public:
+		static CellChangeHandler* GetSingleton()
+		{
+			static CellChangeHandler singleton;
+			return &singleton;
+		}
+
+		RE::BSEventNotifyControl ProcessEvent(const RE::BGSActorCellEvent* a_event, RE::BSTEventSource<RE::BGSActorCellEvent>*) override
+		{
+			if (a_event && a_event->flags.get() == RE::BGSActorCellEvent::CellFlag::kEnter) {
+				auto cell = RE::TESForm::LookupByID<RE::TESObjectCELL>(a_event->cellID);
+				if (cell && SetLocationFromCell(cell)) {
+					BumpWorldGeneration(WorldChange::SpaceChange);
+				}
+			}
+			return RE::BSEventNotifyControl::kContinue;
+		}
+	};
+}
+
+void ResolveProfileForms(ConfigSettings& settings)
+{
+	if (settings.thresholdProfiles.empty()) {
+		return;
+	}
+
+	logger::info("Resolving threshold profile locations...");
+
+	for (auto& profile : settings.thresholdProfiles) {
+		profile.cellIDs = ResolveProfileReferences<RE::TESObjectCELL>(profile, profile.cells, "cell");
+		profile.worldspaceIDs = ResolveProfileReferences<RE::TESWorldSpace>(profile, profile.worldspaces, "worldspace");
+
+		logger::info("  [Profile:{}] {} cell(s), {} worldspace(s)", profile.name, profile.cellIDs.size(), profile.worldspaceIDs.size());
+	}
+}
+
+void RegisterCellEventHandler()
+{
+	auto player = RE::PlayerCharacter::GetSingleton();
+	if (!player) {
+		logger::warn("Player not available - threshold profiles will not follow cell changes");
+		return;
+	}
+
+	player->AsBGSActorCellEventSource()->AddEventSink(CellChangeHandler::GetSingleton());
+	logger::info("Registered for player cell changes (threshold profiles)");
+}
+
+void UpdatePlayerLocation()
+{
+	auto player = RE::PlayerCharacter::GetSingleton();
+	if (!player) {
+		return;
+	}
+
+	// The load itself bumps the world generation; this only records the space
+	if (auto cell = player->GetParentCell()) {
+		SetLocationFromCell(cell);
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "PCH.h"
+#include "Config.h"
+
+/**
+ * Resolves the sCells/sWorldspaces references of all [Profile:*] sections
+ * into sorted FormID lists. Must run after kDataLoaded; called together with
+ * the actor category rule compilation.
+ *
+ * @param settings Unpublished settings to update
+ */
+void ResolveProfileForms(ConfigSettings& settings);
+
+/**
+ * Registers for the player's cell change events so the active threshold
+ * profile follows the player. Must run after kDataLoaded.
+ */
+void RegisterCellEventHandler();
+
+/**
+ * Selects the threshold profile for the player's current cell.
+ * Called after a save is loaded or a new game starts, where no cell
+ * change event is guaranteed.
+ */
+void UpdatePlayerLocation();
@@ -1,166 +1,358 @@
+/**
+ * CommentFilter.cpp - NPC comment decision
+ *
+ * Threading model:
+ *   The engine may run actor AI on several job threads, so AllowComment can
+ *   run concurrently with itself. Everything it touches is one of:
+ *   - The filter parameters of an immutable configuration snapshot, loaded once
+ *     per call through GetActiveFilter() (acquire; pairs with the release
+ *     stores in PublishConfig and SetPlayerLocation).
+ *     The call holds a SnapshotReadGuard (two stores to a per-thread slot),
+ *     so a snapshot replaced by a reload (ConfigWatcher.cpp) is not freed
+ *     before the calls that loaded it have returned
+ *   - Per-thread statistics accumulators (FilterStats.cpp, single writer)
+ *   - Lock-free caches whose entries are single atomic words, written with
+ *     CAS and read relaxed (ActorRules.cpp category cache)
+ *   - thread_local scratch state (player or camera forward vector, frustum)
+ *   - The line-of-sight budget and cache, CAS-updated single words (LineOfSight.h)
+ *   - The dwell time and cooldown tables, same scheme (DwellTime.h, RateLimiter.h)
+ *   - The global comment token bucket, one CAS per allowed comment
+ *   - The world generation (WorldEvents.h): those tables clear themselves on
+ *     first use after a space change, teleport or load, one relaxed load per call
+ *   No locks are taken on this path.
+ *
+ * AllowComment only gathers the query from the game (positions, yaw, and
+ * combat/sneak state when the expression reads them); the decision itself is
+ * DecideComment in FilterCore.cpp (or its precomputed table, LookupDecision).
+ * The optional dwell time, line-of-sight and rate limit stages run after it,
+ * and only for comments it allowed. With [Shadow] a candidate configuration
+ * decides the same query too, for statistics only.
+ */
+
 #include "PCH.h"
 #include "CommentFilter.h"
 #include "Config.h"
+#include "ActorRules.h"
+#include "FilterStats.h"
+#include "FilterCore.h"
+#include "LineOfSight.h"
+#include "DwellTime.h"
+#include "RateLimiter.h"
+#include "EyeHeights.h"
 
 namespace
 {
+	inline constexpr std::uint32_t kMaxLoggedMismatches = 32;  // bReferenceCheck differences written to the log
+
 	/**
-	 * Checks if the player is facing toward an NPC within the allowed deviation angle.
+	 * Gets the player's forward vectors, recomputing sin/cos only when the yaw
+	 * or pitch changed. Cached per thread, so concurrent AI threads never share
+	 * or race on it.
 	 *
-	 * @param npc Pointer to the NPC character
-	 * @param dx Delta X between NPC and player
-	 * @param dy Delta Y between NPC and player
-	 * @return true if player is facing the NPC, false otherwise
+	 * @param player Pointer to the player character (already validated by caller)
 	 */
-	inline bool IsPlayerFacingNPC(RE::Character* npc, float dx, float dy)
+	inline const PlayerFacing& GetPlayerFacing(RE::PlayerCharacter* player)
 	{
-		auto player = RE::PlayerCharacter::GetSingleton();
-		if (!player) {
-			return true;
-		}
+		thread_local PlayerFacing facing{ std::numeric_limits<float>::quiet_NaN(), 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f };
 
-		// Calculate angle from player to NPC
-		float angle = atan2(dx, dy);  // x,y: clockwise; 0 at the top
-		if (angle < 0.0f) {
-			angle += pi * 2.0f;
+		const float yaw = player->GetAngleZ();    // Radians, 0 = +Y, clockwise
+		const float pitch = player->GetAngleX();  // Radians, positive = looking down
+		if (yaw != facing.yaw || pitch != facing.pitch) {
+			facing = MakePlayerFacing(yaw, pitch);
 		}
+		return facing;
+	}
 
-		// Calculate deviation from player's facing direction
-		float playerAngle = player->GetAngleZ();  // Get player's yaw rotation in radians
-		float deviation = fabs(angle - playerAngle);
-		if (deviation > pi) {
-			deviation = 2.0f * pi - deviation;
+	/**
+	 * Camera facing, derived from the world camera's look direction only when
+	 * it changed (at most once per frame per thread).
+	 */
+	struct CameraFacing
+	{
+		float directionX;     // Look direction the facing was computed from
+		float directionY;
+		float directionZ;
+		PlayerFacing facing;  // Horizontal part normalized, with its yaw; the direction itself as the view
+	};
+
+	/**
+	 * sFacingSource=Camera: gets the camera's horizontal look direction as a
+	 * player facing. Cached per thread like the actor facing; the camera's
+	 * rotation is read without synchronization (see GetCameraFrustum).
+	 *
+	 * @param player Pointer to the player character, for the fallback
+	 * @return Camera facing, or the actor's facing without a world camera or
+	 *         while the camera looks almost straight up or down
+	 */
+	inline const PlayerFacing& GetCameraFacing(RE::PlayerCharacter* player)
+	{
+		thread_local CameraFacing facing{ std::numeric_limits<float>::quiet_NaN(), 0.0f, 0.0f, { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f } };
+
+		const auto camera = RE::Main::WorldRootCamera();
+		if (!camera) {
+			return GetPlayerFacing(player);
 		}
 
-		return deviation < g_config.maxDeviationAngle;
+		// Gamebryo cameras look along their local X axis (first rotation column)
+		const auto& rotate = camera->world.rotate;
+		const float x = rotate.entry[0][0];
+		const float y = rotate.entry[1][0];
+		const float z = rotate.entry[2][0];
+		if (x != facing.directionX || y != facing.directionY || z != facing.directionZ) {
+			const auto cameraFacing = MakeCameraFacing(x, y, z);
+			if (!cameraFacing) {
+				return GetPlayerFacing(player);
+			}
+			facing = { x, y, z, *cameraFacing };
+		}
+		return facing.facing;
 	}
 
 	/**
-	 * Checks if the NPC is within the maximum greeting distance.
+	 * Camera frustum planes, extracted from the world camera's view-projection
+	 * matrix only when it changed (at most once per frame per thread).
+	 */
+	struct CameraFrustum
+	{
+		float viewProjection[4][4];  // Matrix the planes were extracted from
+		FrustumPlanes planes;
+		bool valid;
+	};
+
+	/**
+	 * Gets the current camera frustum. Cached per thread like the player facing;
+	 * the matrix is read without synchronization, and a frame mixed from two
+	 * camera updates only affects the decision of one comment.
 	 *
-	 * @param distanceSquared Squared distance between NPC and player
-	 * @return true if NPC is within range, false otherwise
+	 * @return Frustum planes, or nullptr if there is no world camera
+	 */
+	const FrustumPlanes* GetCameraFrustum()
+	{
+		thread_local CameraFrustum frustum{};
+
+		const auto camera = RE::Main::WorldRootCamera();
+		if (!camera) {
+			return nullptr;
+		}
+
+		const auto& viewProjection = camera->GetRuntimeData().worldToCam;
+		if (!frustum.valid || !std::equal(&viewProjection[0][0], &viewProjection[0][0] + 16, &frustum.viewProjection[0][0])) {
+			std::copy_n(&viewProjection[0][0], 16, &frustum.viewProjection[0][0]);
+			ExtractFrustumPlanes(frustum.viewProjection, frustum.planes);
+			frustum.valid = true;
+		}
+		return &frustum.planes;
+	}
+
+	/**
+	 * Fills in the query inputs only some modes read: combat and sneak state
+	 * for an expression that uses them, the camera frustum for Frustum. Never
+	 * clears an input, so it can run for the active block and then for the
+	 * shadow candidate.
 	 */
-	inline bool IsWithinGreetingDistance(float distanceSquared)
+	void GatherModeInputs(const FilterParameters& params, RE::Character* npc, RE::PlayerCharacter* player, const RE::NiPoint3& npcPosition, CommentQuery& query)
 	{
-		return distanceSquared <= g_config.maxGreetingDistanceSquared;
+		if (params.filterMode == FilterMode::Expression) {
+			query.npcInCombat = query.npcInCombat || (params.filterExpression->Uses(FilterVariable::InCombat) && npc->IsInCombat());
+			query.playerSneaking = query.playerSneaking || (params.filterExpression->Uses(FilterVariable::Sneaking) && player->IsSneaking());
+		} else if (params.filterMode == FilterMode::Frustum) {
+			query.frustum = GetCameraFrustum();
+			query.headX = npcPosition.x;
+			query.headY = npcPosition.y;
+			query.headZ = npcPosition.z + kFrustumHeadHeight;
+		}
 	}
 
 	/**
-	 * Checks if the NPC is within close range (for bypass feature).
+	 * Gets the NPC name for debug logging.
 	 *
-	 * @param distanceSquared Squared distance between NPC and player
-	 * @return true if NPC is within close range, false otherwise
+	 * @param npc Pointer to the NPC character
+	 * @return NPC name, or "Unknown" if unavailable
 	 */
-	inline bool IsWithinCloseRange(float distanceSquared)
+	const char* GetNPCName(RE::Character* npc)
 	{
-		return distanceSquared <= g_config.closeRangeDistanceSquared;
+		const char* npcName = nullptr;
+		auto baseForm = npc->GetActorBase();
+		if (baseForm) {
+			npcName = baseForm->GetName();
+		}
+		if (!npcName || npcName[0] == '\0') {
+			npcName = "Unknown";
+		}
+		return npcName;
+	}
+
+	/**
+	 * [Shadow]: decides the same query with the candidate configuration and
+	 * records whether it agrees with the active filter decision. Only the
+	 * filter decisions are compared (the dwell, line-of-sight and rate limit
+	 * stages keep per-NPC state and run for the active configuration only).
+	 * Every iTraceEvery-th disagreement is logged, up to kMaxShadowTraces.
+	 */
+	void EvaluateShadow(const FilterParameters& filter, std::uint8_t category, const CommentQuery& query, const CommentDecision& active, RE::Character* npc)
+	{
+		const FilterParameters& candidate = *filter.shadowFilter;
+
+		const std::uint64_t start = filter.Has(FilterFlag::Timing) ? __rdtsc() : 0;
+		// The candidate's tables assume a flat query - not what the active b3DViewCone gathers
+		CommentDecision decision;
+		if (!candidate.Has(FilterFlag::DecisionTable) || filter.Has(FilterFlag::ViewCone3D) ||
+			!LookupDecision(candidate.decisionTables[category], query, decision)) {
+			decision = DecideComment(candidate, candidate.categories[category], query);
+		}
+		const std::uint64_t ticks = start ? __rdtsc() - start : 0;
+
+		RecordShadow(active.allow, decision.allow, ticks);
+
+		const std::uint32_t traceEvery = filter.config->settings.shadowTraceEvery;
+		if (active.allow == decision.allow || !traceEvery) {
+			return;
+		}
+
+		static std::atomic<std::uint32_t> disagreements{ 0 };
+		const std::uint32_t index = disagreements.fetch_add(1, std::memory_order_relaxed);
+		if (index % traceEvery == 0 && index / traceEvery < kMaxShadowTraces) {
+			logger::info("[Shadow] \"{}\" dx={:.1f} dy={:.1f} dz={:.1f} yaw={:.3f} -> active {} ({}), candidate {} ({})",
+				GetNPCName(npc), query.dx, query.dy, query.dz, query.yaw,
+				active.allow ? "ALLOW" : "BLOCK", active.reason, decision.allow ? "ALLOW" : "BLOCK", decision.reason);
+		}
+	}
+
+	/**
+	 * bReferenceCheck: decides the same query with the current filter and the
+	 * original plugin's atan2 test, timing each, and records whether they agree.
+	 * The original compared the angle directly; it is recovered here from the
+	 * category's precomputed cosine in double precision.
+	 */
+	void CompareWithReference(const FilterParameters& filter, const CategoryThresholds& thresholds, const CommentQuery& query, RE::Character* npc)
+	{
+		const float maxDeviation = static_cast<float>(std::acos(static_cast<double>(thresholds.cosMaxDeviation)));
+
+		const std::uint64_t start = __rdtsc();
+		const bool current = DecideComment(filter, thresholds, query).allow;
+		const std::uint64_t middle = __rdtsc();
+		const bool reference = DecideCommentReference(query, maxDeviation);
+		const std::uint64_t end = __rdtsc();
+
+		const bool mismatch = current != reference;
+		RecordReferenceCheck(mismatch, middle - start, end - middle);
+
+		static std::atomic<std::uint32_t> loggedMismatches{ 0 };
+		if (mismatch && loggedMismatches.fetch_add(1, std::memory_order_relaxed) < kMaxLoggedMismatches) {
+			logger::warn("[ReferenceCheck] \"{}\" dx={:.3f} dy={:.3f} yaw={:.6f} max={:.6f} -> current {}, original {}",
+				GetNPCName(npc), query.dx, query.dy, query.yaw, maxDeviation,
+				current ? "ALLOW" : "BLOCK", reference ? "ALLOW" : "BLOCK");
+		}
 	}
 }
 
 bool AllowComment(RE::Character* npc)
 {
+	// One acquire load per call - the active profile's parameters are read-only from here on
+	const SnapshotReadGuard snapshotGuard;
+	const FilterParameters* active = GetActiveFilter();
+
 	// Sanity checks - allow comment if we can't properly evaluate
 	auto player = RE::PlayerCharacter::GetSingleton();
-	if (!npc || !player || npc == player) {
-		if (g_config.enableDebugLogging) {
+	if (!active || !npc || !player || npc == player) {
+		if (active && active->Has(FilterFlag::DebugLogging)) {
 			logger::info("[AllowComment] Sanity check: npc={}, player={}, same={} -> ALLOW",
 				npc ? "valid" : "null",
 				player ? "valid" : "null",
 				(npc == player) ? "yes" : "no");
 		}
+		RecordOutcome(FilterOutcome::AllowSanity);
 		return true;
 	}
 
-	// Get NPC name for logging (if enabled)
-	const char* npcName = nullptr;
-	if (g_config.enableDebugLogging) {
-		auto baseForm = npc->GetActorBase();
-		if (baseForm) {
-			npcName = baseForm->GetName();
-		}
-		if (!npcName || npcName[0] == '\0') {
-			npcName = "Unknown";
+	// Hot parameters only from here on (one cache line unless the NPC is in a high category)
+	const FilterParameters& filter = *active;
+	const std::uint64_t startTicks = filter.Has(FilterFlag::Timing) ? __rdtsc() : 0;  // Only while statistics are exported
+
+	// Resolve the NPC's category once (cached per actor base) and use its thresholds
+	const std::uint8_t category = ResolveActorCategory(filter, npc);
+	const CategoryThresholds& thresholds = filter.categories[category];
+
+	// Gather the query: position deltas, player facing and the mode's extra inputs
+	const PlayerFacing& facing = filter.facingSource == FacingSource::Camera ? GetCameraFacing(player) : GetPlayerFacing(player);
+	const RE::NiPoint3 npcPosition = npc->GetPosition();
+	CommentQuery query{
+		npcPosition.x - player->GetPositionX(),
+		npcPosition.y - player->GetPositionY(),
+		npcPosition.z - player->GetPositionZ(),
+		facing.yaw, facing.forwardX, facing.forwardY, 0.0f, 0.0f,
+		false, false,
+		nullptr, 0.0f, 0.0f, 0.0f
+	};
+	if (filter.Has(FilterFlag::ViewCone3D)) {
+		// Eyes to head, looking along the pitch; the same dot product as the flat test
+		query.forwardX = facing.viewX;
+		query.forwardY = facing.viewY;
+		query.forwardZ = facing.viewZ;
+		query.viewDz = query.dz + GetEyeHeight(npc) - GetEyeHeight(player);
+	}
+	GatherModeInputs(filter, npc, player, npcPosition, query);
+	if (filter.Has(FilterFlag::Shadow)) {
+		GatherModeInputs(*filter.shadowFilter, npc, player, npcPosition, query);
+	}
+
+	// bDecisionTable: one cell read for most queries, exact decision on boundary cells
+	CommentDecision decision;
+	if (!filter.Has(FilterFlag::DecisionTable) || !LookupDecision(filter.decisionTables[category], query, decision)) {
+		decision = DecideComment(filter, thresholds, query);
+	}
+	const FilterOutcome filterOutcome = decision.outcome;
+
+	// Shadow mode: the candidate decides the same query; the result is only recorded
+	if (filter.Has(FilterFlag::Shadow)) {
+		EvaluateShadow(filter, category, query, decision, npc);
+	}
+
+	// Dwell time: only a filter pass counts as facing (the close range bypass never needs a dwell)
+	if (filter.Has(FilterFlag::DwellTime)) {
+		if (filterOutcome == FilterOutcome::AllowFilter && !HasDwelled(npc, filter.config->settings.dwellMilliseconds)) {
+			decision.allow = false;
+			decision.outcome = FilterOutcome::BlockDwell;
+			decision.reason = "not faced long enough";
+		} else if (filterOutcome == FilterOutcome::BlockFilter) {
+			ResetDwell(npc);
 		}
 	}
 
-	// Calculate position deltas
-	float dx = npc->GetPositionX() - player->GetPositionX();
-	float dy = npc->GetPositionY() - player->GetPositionY();
-	float dz = npc->GetPositionZ() - player->GetPositionZ();
-
-	// Calculate 3D distance squared (includes Z-axis for vertical awareness)
-	float distanceSquared = dx * dx + dy * dy + dz * dz;
-	float distance = sqrt(distanceSquared);  // Only calculate sqrt if logging
-
-	// Close Range Bypass: Allow all angles at very close range if enabled
-	// This prevents NPCs from being silent when standing right next to the player
-	if (g_config.enableCloseRangeBypass && IsWithinCloseRange(distanceSquared)) {
-		if (g_config.enableDebugLogging) {
-			logger::info("[AllowComment] \"{}\" dist={:.1f} -> ALLOW (close range bypass)",
-				npcName, distance);
-		}
-		return true;  // Early exit - allow comment regardless of angle
-	}
-
-	bool result = false;
-	const char* reason = "unknown";
-
-	// Apply filters based on configured filter mode
-	switch (g_config.filterMode) {
-		case FilterMode::AngleOnly:
-			// Only check angle
-			result = IsPlayerFacingNPC(npc, dx, dy);
-			reason = result ? "facing" : "not facing";
-			break;
-
-		case FilterMode::DistanceOnly:
-			// Only check distance, ignore angle
-			result = IsWithinGreetingDistance(distanceSquared);
-			reason = result ? "in range" : "out of range";
-			break;
-
-		case FilterMode::Both:
-			// Require BOTH angle AND distance checks to pass
-			// Check distance first (cheap) before angle (expensive atan2)
-			if (!IsWithinGreetingDistance(distanceSquared)) {
-				result = false;
-				reason = "out of range";
-			} else if (!IsPlayerFacingNPC(npc, dx, dy)) {
-				result = false;
-				reason = "not facing";
-			} else {
-				result = true;
-				reason = "facing AND in range";
-			}
-			break;
-
-		case FilterMode::Either:
-			// Allow if EITHER angle OR distance check passes
-			// Check distance first (cheap) before angle (expensive atan2)
-			if (IsWithinGreetingDistance(distanceSquared)) {
-				result = true;
-				reason = "in range";
-			} else if (IsPlayerFacingNPC(npc, dx, dy)) {
-				result = true;
-				reason = "facing";
-			} else {
-				result = false;
-				reason = "not facing AND out of range";
-			}
-			break;
+	// Line of sight: raycasts are only spent on NPCs that passed the filter and dwell time
+	if (decision.allow && filter.Has(FilterFlag::LineOfSight)) {
+		const LineOfSightResult los = CheckLineOfSight(npc, player, query.dx, query.dy, query.dz, filter.config->settings.lineOfSight);
+		RecordLineOfSight(los.source);
+		if (!los.visible) {
+			decision.allow = false;
+			decision.outcome = FilterOutcome::BlockLineOfSight;
+			decision.reason = los.source == LineOfSightSource::Raycast ? "no line of sight" : "no line of sight (cached)";
+		}
+	}
 
-		default:
-			// Fallback to angle-only mode for safety
-			result = IsPlayerFacingNPC(npc, dx, dy);
-			reason = result ? "facing (fallback)" : "not facing (fallback)";
-			break;
+	// Rate limit after everything else: only comments that would really play use up the limits
+	if (decision.allow && filter.Has(FilterFlag::RateLimit)) {
+		const RateLimitResult limit = ApplyRateLimit(npc, filter.config->settings.rateLimit);
+		if (limit != RateLimitResult::Allowed) {
+			decision.allow = false;
+			decision.outcome = limit == RateLimitResult::Cooldown ? FilterOutcome::BlockCooldown : FilterOutcome::BlockRateLimit;
+			decision.reason = limit == RateLimitResult::Cooldown ? "NPC cooldown" : "rate limit";
+		}
 	}
 
-	if (g_config.enableDebugLogging) {
+	if (filter.Has(FilterFlag::DebugLogging)) {
 		logger::info("[AllowComment] \"{}\" dist={:.1f} -> {} ({})",
-			npcName, distance, result ? "ALLOW" : "BLOCK", reason);
+			GetNPCName(npc), sqrt(decision.distanceSquared), decision.allow ? "ALLOW" : "BLOCK", decision.reason);
+	}
+
+	RecordOutcome(decision.outcome, startTicks);
+
+	// Differential check against the original plugin, for angle decisions only
+	// (bypass and broad-phase results have no counterpart in the original)
+	if (filter.Has(FilterFlag::ReferenceCheck) && filter.filterMode == FilterMode::AngleOnly && !filter.Has(FilterFlag::ViewCone3D) &&
+		(filterOutcome == FilterOutcome::AllowFilter || filterOutcome == FilterOutcome::BlockFilter)) {
+		CompareWithReference(filter, thresholds, query, npc);
 	}
 
-	return result;
+	return decision.allow;
 }
@@ -12,9 +12,11 @@
  *   - DISTANCE_ONLY: Only check if NPC is within distance threshold
  *   - BOTH: Require BOTH angle AND distance checks to pass
  *   - EITHER: Allow comment if EITHER angle OR distance check passes
+ *   - EXPRESSION: Custom condition from sFilterExpression (bytecode or native x64)
  *
  * Special Features:
  *   - Close Range Bypass: If enabled, allows comments at close range regardless of angle
+ *   - Actor Categories: Per-category thresholds ([Category:*] sections), resolved once per actor base
  *   - 3D Distance: Includes Z-axis in distance calculations for vertical awareness
  *   - Optimized: Uses squared distances to avoid expensive sqrt() calls
  *
@@ -1,56 +1,88 @@
 #include "PCH.h"
 #include "Config.h"
+#include "ActorRules.h"
+#include "FilterCore.h"
+#include "DwellTime.h"
+#include "WorldEvents.h"
+#include "ConfigLayers.h"
+#include "IniFile.h"
+#include "StartupLog.h"
 
 namespace
 {
 	/**
-	 * Helper function to read a boolean value from INI file.
-	 * Supports multiple formats: true/false, yes/no, 1/0
+	 * A replaced snapshot waiting for the readers that may still use it.
 	 */
-	bool GetPrivateProfileBool(const char* section, const char* key, bool defaultValue, const char* filename)
+	struct RetiredConfig
 	{
-		char buffer[256];
-		GetPrivateProfileStringA(section, key, defaultValue ? "true" : "false", buffer, sizeof(buffer), filename);
+		std::unique_ptr<const PluginConfig> config;
+		std::uint64_t epoch;  // Freed once every reader entered at or after this epoch (SnapshotEpochs.h)
+	};
 
-		// Convert to lowercase for case-insensitive comparison
-		std::string value = buffer;
-		for (char& c : value) {
-			c = static_cast<char>(tolower(c));
-		}
+	// Writers only (config load, rule compilation) - never taken by AllowComment
+	std::mutex g_publishLock;
+	std::unique_ptr<const PluginConfig> g_activeConfigOwner;
+	std::vector<RetiredConfig> g_retiredConfigs;
+	std::optional<PlayerLocation> g_playerLocation;  // Last known location (guarded by g_publishLock)
+	std::string g_activeProfileName;                 // For logging switches (guarded by g_publishLock)
+	std::string g_sourceFingerprint;                 // Config files as last read (load, then the reload worker only)
 
-		// Check various boolean representations
-		if (value == "true" || value == "yes" || value == "1" || value == "on" || value == "enabled") {
-			return true;
-		}
-		if (value == "false" || value == "no" || value == "0" || value == "off" || value == "disabled") {
-			return false;
+	/**
+	 * Frees the retired snapshots no reader can still be using.
+	 * Caller holds g_publishLock.
+	 *
+	 * @return Number of snapshots still waiting for a reader
+	 */
+	std::size_t CollectRetiredConfigsLocked()
+	{
+		if (g_retiredConfigs.empty()) {
+			return 0;
 		}
 
-		// Return default if value is unrecognized
-		return defaultValue;
+		const std::uint64_t oldestReader = GetOldestSnapshotReader();
+		std::erase_if(g_retiredConfigs, [&](const RetiredConfig& retired) {
+			return retired.epoch <= oldestReader;
+		});
+		return g_retiredConfigs.size();
 	}
 
+	// Config sources, lowest precedence first
+	inline constexpr std::array kConfigLayers = {
+		ConfigLayer{ ConfigSource::Ini, kConfigFile },
+		ConfigLayer{ ConfigSource::MCM, kMCMConfigFile },
+		ConfigLayer{ ConfigSource::Override, kOverrideConfigFile }
+	};
+
+	// [Shadow] candidate: the same sources with the shadow file on top (watched
+	// together; the candidate merges only the shadow file onto the active table)
+	inline constexpr std::array kShadowConfigLayers = {
+		ConfigLayer{ ConfigSource::Ini, kConfigFile },
+		ConfigLayer{ ConfigSource::MCM, kMCMConfigFile },
+		ConfigLayer{ ConfigSource::Override, kOverrideConfigFile },
+		ConfigLayer{ ConfigSource::Shadow, kShadowConfigFile }
+	};
+
 	/**
-	 * Helper function to read a float value from INI file.
+	 * @param fileName Cache file name
+	 * @return Location of a merged settings cache (SKSE log directory), or an
+	 *         empty path to disable caching if the directory is unknown
 	 */
-	float GetPrivateProfileFloat(const char* section, const char* key, float defaultValue, const char* filename)
+	std::filesystem::path GetConfigCachePath(std::string_view fileName)
 	{
-		char buffer[256];
-		char defaultStr[64];
-		sprintf_s(defaultStr, sizeof(defaultStr), "%.2f", defaultValue);
-
-		GetPrivateProfileStringA(section, key, defaultStr, buffer, sizeof(buffer), filename);
-
-		return static_cast<float>(atof(buffer));
+		auto path = SKSE::log::log_directory();
+		if (!path) {
+			return {};
+		}
+		return *path / fileName;
 	}
 
 	/**
 	 * Parses filter mode from string value.
 	 * Supports: "Angle", "Distance", "Both", "Either" (case-insensitive)
 	 */
-	FilterMode ParseFilterMode(const char* modeStr)
+	FilterMode ParseFilterMode(std::string_view modeStr)
 	{
-		std::string mode = modeStr;
+		std::string mode(modeStr);
 
 		// Convert to lowercase for case-insensitive comparison
 		for (char& c : mode) {
@@ -65,181 +97,1014 @@ namespace
 			return FilterMode::Both;
 		} else if (mode == "either" || mode == "or") {
 			return FilterMode::Either;
+		} else if (mode == "frustum" || mode == "onscreen" || mode == "on_screen") {
+			return FilterMode::Frustum;
 		}
 
 		// Default to angle-only for backward compatibility
 		return FilterMode::AngleOnly;
 	}
-}
 
-bool LoadConfiguration()
-{
-	// Determine which config file to use - MCM Helper takes priority
-	const char* configPath = nullptr;
-
-	// Check if MCM settings file exists (user has MCM Helper installed and has opened the menu)
-	FILE* mcmFile = nullptr;
-	errno_t mcmErr = fopen_s(&mcmFile, kMCMConfigFile.data(), "r");
-	if (mcmErr == 0 && mcmFile) {
-		fclose(mcmFile);
-		configPath = kMCMConfigFile.data();
-		logger::info("Loading configuration from MCM: {}", kMCMConfigFile);
-	} else {
-		// Fall back to original config file
-		configPath = kConfigFile.data();
-		logger::info("Loading configuration from: {}", kConfigFile);
-
-		FILE* testFile = nullptr;
-		errno_t err = fopen_s(&testFile, kConfigFile.data(), "r");
-		if (err != 0 || !testFile) {
-			logger::warn("Configuration file not found - using defaults");
-		} else {
-			logger::info("Configuration file found and readable");
-			fclose(testFile);
+	/**
+	 * Parses sFacingSource. Anything but "Camera" keeps the actor's yaw.
+	 */
+	FacingSource ParseFacingSource(std::string_view source)
+	{
+		std::string value(source);
+		for (char& c : value) {
+			c = static_cast<char>(tolower(c));
+		}
+		return value == "camera" ? FacingSource::Camera : FacingSource::Actor;
+	}
+
+	/**
+	 * Parses sStartupLog. Anything but "Summary" keeps the full startup log.
+	 */
+	StartupLogVerbosity ParseStartupLogVerbosity(std::string_view verbosity)
+	{
+		return EqualsIgnoreCase(verbosity, "summary"sv) ? StartupLogVerbosity::Summary : StartupLogVerbosity::Full;
+	}
+
+	/**
+	 * Splits a comma-separated list into trimmed, non-empty entries.
+	 */
+	std::vector<std::string> SplitList(std::string_view list)
+	{
+		std::vector<std::string> entries;
+		std::string_view remaining = list;
+
+		while (!remaining.empty()) {
+			const auto comma = remaining.find(',');
+			std::string_view entry = remaining.substr(0, comma);
+			remaining = comma == std::string_view::npos ? std::string_view{} : remaining.substr(comma + 1);
+
+			while (!entry.empty() && isspace(static_cast<unsigned char>(entry.front()))) {
+				entry.remove_prefix(1);
+			}
+			while (!entry.empty() && isspace(static_cast<unsigned char>(entry.back()))) {
+				entry.remove_suffix(1);
+			}
+			if (!entry.empty()) {
+				entries.emplace_back(entry);
+			}
+		}
+
+		return entries;
+	}
+
+	/**
+	 * Fills the thresholds of every category for one profile.
+	 * Category values override profile values, which override [Main]/[Distance].
+	 *
+	 * @param filter Block to fill (filterMode and FilterFlag::CloseRangeBypass already set)
+	 * @param settings Base values and category rules
+	 * @param profile Profile values (empty for the base block)
+	 */
+	void FillThresholds(FilterParameters& filter, const ConfigSettings& settings, const ThresholdOverrides& profile)
+	{
+		const float angle = profile.maxDeviationAngle.value_or(settings.maxDeviationAngle);
+		const float maxDistance = profile.maxGreetingDistance.value_or(settings.maxGreetingDistance);
+		const float closeDistance = profile.closeRangeDistance.value_or(settings.closeRangeDistance);
+
+		filter.categories.fill(MakeCategoryThresholds(filter, angle, maxDistance, closeDistance));
+
+		for (std::size_t i = 0; i < settings.categoryRules.size(); ++i) {
+			const auto& rule = settings.categoryRules[i].thresholds;
+			filter.categories[i + 1] = MakeCategoryThresholds(filter, rule.maxDeviationAngle.value_or(angle),
+				rule.maxGreetingDistance.value_or(maxDistance), rule.closeRangeDistance.value_or(closeDistance));
+		}
+	}
+
+	/**
+	 * Clamps an fMaxDeviationAngle value to 0-180 degrees, keeping fractional
+	 * degrees. Used for [Main] and every override, so both convert the same way.
+	 */
+	float ClampDeviationAngle(float degrees)
+	{
+		return degrees > 0.0f ? std::min(degrees, 180.0f) : 0.0f;
+	}
+
+	/**
+	 * Reads the threshold keys a [Category:*] or [Profile:*] section sets.
+	 */
+	ThresholdOverrides ReadThresholdOverrides(const LayeredConfig& ini, std::string_view section)
+	{
+		ThresholdOverrides overrides;
+		if (ini.Find(section, "fMaxDeviationAngle")) {
+			overrides.maxDeviationAngle = ClampDeviationAngle(ini.GetFloat(section, "fMaxDeviationAngle", 0.0f)) / 180.0f * pi;
+		}
+		if (ini.Find(section, "fMaxGreetingDistance")) {
+			overrides.maxGreetingDistance = std::abs(ini.GetFloat(section, "fMaxGreetingDistance", 0.0f));
+		}
+		if (ini.Find(section, "fCloseRangeDistance")) {
+			overrides.closeRangeDistance = std::abs(ini.GetFloat(section, "fCloseRangeDistance", 0.0f));
+		}
+		return overrides;
+	}
+
+	/**
+	 * @return The section name without the prefix, or std::nullopt if the section does not have it
+	 */
+	std::optional<std::string_view> GetSectionSuffix(std::string_view section, std::string_view prefix)
+	{
+		if (!EqualsIgnoreCase(section.substr(0, prefix.size()), prefix)) {
+			return std::nullopt;
+		}
+		return section.substr(prefix.size());
+	}
+
+	/**
+	 * Loads all [Category:Name] sections in file order (first match wins at runtime).
+	 * Unset thresholds inherit the profile or [Main]/[Distance] values.
+	 */
+	void LoadActorCategories(PluginConfig& config, const LayeredConfig& ini)
+	{
+		config.settings.categoryRules.clear();
+
+		for (const std::string_view section : ini.GetSections()) {
+			const auto name = GetSectionSuffix(section, "Category:"sv);
+			if (!name) {
+				continue;
+			}
+
+			if (config.settings.categoryRules.size() + 1 >= kMaxActorCategories) {
+				logger::warn("  [{}] ignored - at most {} categories are supported", section, kMaxActorCategories - 1);
+				continue;
+			}
+
+			ActorCategoryRule rule{};
+			rule.name = *name;
+			rule.factions = SplitList(ini.GetString(section, "sFactions", ""));
+			rule.keywords = SplitList(ini.GetString(section, "sKeywords", ""));
+			rule.thresholds = ReadThresholdOverrides(ini, section);
+
+			if (rule.factions.empty() && rule.keywords.empty()) {
+				logger::warn("  [{}] has no sFactions or sKeywords - skipping", section);
+				continue;
+			}
+
+			const auto& settings = config.settings;
+			logger::info("  [{}] -> category {}: {} faction(s), {} keyword(s), angle {:.0f} degrees, distance {:.2f}, close range {:.2f}",
+				section, settings.categoryRules.size() + 1, rule.factions.size(), rule.keywords.size(),
+				rule.thresholds.maxDeviationAngle.value_or(settings.maxDeviationAngle) * 180.0f / pi,
+				rule.thresholds.maxGreetingDistance.value_or(settings.maxGreetingDistance),
+				rule.thresholds.closeRangeDistance.value_or(settings.closeRangeDistance));
+
+			config.settings.categoryRules.push_back(std::move(rule));
 		}
 	}
 
-	// ========================================
-	// [Main] Section
-	// ========================================
+	/**
+	 * Parses sMatch of a [Profile:*] section.
+	 */
+	ProfileMatch ParseProfileMatch(std::string_view match)
+	{
+		if (EqualsIgnoreCase(match, "interior"sv)) {
+			return ProfileMatch::Interior;
+		}
+		if (EqualsIgnoreCase(match, "exterior"sv)) {
+			return ProfileMatch::Exterior;
+		}
+		return ProfileMatch::Listed;
+	}
 
-	logger::info("Loading [Main] section...");
+	/**
+	 * Loads all [Profile:Name] sections in file order (first match wins at runtime)
+	 * and builds one filter parameter block per profile. Must run after the base
+	 * block and the category rules are loaded.
+	 */
+	void LoadThresholdProfiles(PluginConfig& config, const LayeredConfig& ini)
+	{
+		config.settings.thresholdProfiles.clear();
+		config.profiles.clear();
+
+		for (const std::string_view section : ini.GetSections()) {
+			const auto name = GetSectionSuffix(section, "Profile:"sv);
+			if (!name) {
+				continue;
+			}
+
+			ThresholdProfile profile{};
+			profile.name = *name;
+			profile.match = ParseProfileMatch(ini.GetString(section, "sMatch", ""));
+			profile.cells = SplitList(ini.GetString(section, "sCells", ""));
+			profile.worldspaces = SplitList(ini.GetString(section, "sWorldspaces", ""));
+			profile.thresholds = ReadThresholdOverrides(ini, section);
+
+			if (profile.match == ProfileMatch::Listed && profile.cells.empty() && profile.worldspaces.empty()) {
+				logger::warn("  [{}] has no sMatch, sCells or sWorldspaces - skipping", section);
+				continue;
+			}
 
-	// Load fMaxDeviationAngle
-	int deviationAngleDegrees = static_cast<int>(GetPrivateProfileFloat("Main", "fMaxDeviationAngle", 30.0f, configPath));
-	const int originalAngle = deviationAngleDegrees;
+			FilterParameters& filter = config.profiles.emplace_back(config.filter);
+			FillThresholds(filter, config.settings, profile.thresholds);
 
-	// Validate and clamp angle to valid range [0, 180]
-	if (deviationAngleDegrees < 0) {
-		logger::warn("  fMaxDeviationAngle ({}) is negative, clamping to 0", deviationAngleDegrees);
-		deviationAngleDegrees = 0;
+			constexpr std::array matchNames = { "listed cells", "all interiors", "all exteriors" };
+			const auto& settings = config.settings;
+			logger::info("  [{}]: {}, {} cell(s), {} worldspace(s), angle {:.0f} degrees, distance {:.2f}, close range {:.2f}",
+				section, matchNames[static_cast<int>(profile.match)], profile.cells.size(), profile.worldspaces.size(),
+				profile.thresholds.maxDeviationAngle.value_or(settings.maxDeviationAngle) * 180.0f / pi,
+				profile.thresholds.maxGreetingDistance.value_or(settings.maxGreetingDistance),
+				profile.thresholds.closeRangeDistance.value_or(settings.closeRangeDistance));
+
+			config.settings.thresholdProfiles.push_back(std::move(profile));
+		}
 	}
-	if (deviationAngleDegrees > 180) {
-		logger::warn("  fMaxDeviationAngle ({}) exceeds 180, clamping to 180", deviationAngleDegrees);
-		deviationAngleDegrees = 180;
+
+	/**
+	 * @return true if a profile applies to a location
+	 */
+	bool MatchesLocation(const ThresholdProfile& profile, const PlayerLocation& location)
+	{
+		if ((profile.match == ProfileMatch::Interior && location.interior) ||
+			(profile.match == ProfileMatch::Exterior && !location.interior)) {
+			return true;
+		}
+		return std::binary_search(profile.cellIDs.begin(), profile.cellIDs.end(), location.cell) ||
+		       (location.worldspace != 0 && std::binary_search(profile.worldspaceIDs.begin(), profile.worldspaceIDs.end(), location.worldspace));
+	}
+
+	/**
+	 * Picks the parameter block for the last known player location and logs
+	 * when the profile changes. Caller holds g_publishLock.
+	 */
+	const FilterParameters* SelectFilter(const PluginConfig& config)
+	{
+		const FilterParameters* selected = &config.filter;
+		std::string_view name = "default"sv;
+
+		if (g_playerLocation) {
+			const auto& profiles = config.settings.thresholdProfiles;
+			for (std::size_t i = 0; i < profiles.size(); ++i) {
+				if (MatchesLocation(profiles[i], *g_playerLocation)) {
+					selected = &config.profiles[i];
+					name = profiles[i].name;
+					break;
+				}
+			}
+		}
+
+		if (name != g_activeProfileName) {
+			if (g_playerLocation) {
+				logger::info("Threshold profile: {} (cell 0x{:08X})", name, g_playerLocation->cell);
+			} else {
+				logger::info("Threshold profile: {}", name);
+			}
+			g_activeProfileName = name;
+		}
+
+		return selected;
 	}
 
-	g_config.maxDeviationAngle = deviationAngleDegrees / 180.0f * pi;
+	/**
+	 * Builds the decision tables of the base block and every profile and points
+	 * the blocks at them. Skipped with debug logging, which wants DecideComment's
+	 * reasons, and for modes the tables cannot represent.
+	 */
+	void BuildDecisionTables(PluginConfig& config)
+	{
+		config.decisionTables.reset();
+		config.filter.decisionTables = nullptr;
+		config.filter.Set(FilterFlag::DecisionTable, false);
+		for (auto& profile : config.profiles) {
+			profile.decisionTables = nullptr;
+			profile.Set(FilterFlag::DecisionTable, false);
+		}
+
+		if (!config.settings.enableDecisionTable) {
+			return;
+		}
+		if (!SupportsDecisionTable(config.filter.filterMode)) {
+			logger::info("  bDecisionTable: not used with this filter mode - deciding every check directly");
+			return;
+		}
+		if (config.filter.Has(FilterFlag::ViewCone3D)) {
+			logger::info("  bDecisionTable: not used with b3DViewCone (the decision depends on the pitch) - deciding every check directly");
+			return;
+		}
+		if (config.filter.Has(FilterFlag::DebugLogging)) {
+			logger::info("  bDecisionTable: not used while bEnableLogging is on - deciding every check directly");
+			return;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		const std::size_t categoryCount = std::min(config.settings.categoryRules.size() + 1, kMaxActorCategories);
+		auto tables = std::make_shared<std::vector<DecisionTable>>((config.profiles.size() + 1) * kMaxActorCategories);
+
+		std::size_t built = 0;
+		std::size_t exactCells = 0;
+		auto build = [&](FilterParameters& filter, std::size_t block) {
+			DecisionTable* blockTables = tables->data() + block * kMaxActorCategories;
+			// Categories without a rule are never resolved and keep an empty table
+			for (std::size_t i = 0; i < categoryCount; ++i) {
+				exactCells += BuildDecisionTable(filter, filter.categories[i], blockTables[i]);
+				++built;
+			}
+			filter.decisionTables = blockTables;
+			filter.Set(FilterFlag::DecisionTable, true);
+		};
 
-	if (originalAngle == deviationAngleDegrees) {
-		logger::info("  fMaxDeviationAngle: {} degrees ({:.4f} radians) - Value OK", deviationAngleDegrees, g_config.maxDeviationAngle);
-	} else {
-		logger::info("  fMaxDeviationAngle: {} degrees ({:.4f} radians) - Clamped from {}", deviationAngleDegrees, g_config.maxDeviationAngle, originalAngle);
+		build(config.filter, 0);
+		for (std::size_t i = 0; i < config.profiles.size(); ++i) {
+			build(config.profiles[i], i + 1);
+		}
+		config.decisionTables = std::move(tables);
+
+		const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+		logger::info("  bDecisionTable: {} table(s) of {} cells in {} us, {:.1f}% of cells on a decision boundary (decided exactly)",
+			built, kDecisionTableCells, elapsed.count(),
+			100.0 * static_cast<double>(exactCells) / static_cast<double>(built * kDecisionTableCells));
 	}
 
-	// Load sFilterMode
-	char filterModeStr[256];
-	GetPrivateProfileStringA("Main", "sFilterMode", "Angle", filterModeStr, sizeof(filterModeStr), configPath);
+	/**
+	 * Logs every setting that differs between two configurations, by INI key.
+	 *
+	 * @param title Line logged before the differences
+	 * @return true if anything changed
+	 */
+	bool LogConfigurationChanges(const PluginConfig& before, const PluginConfig& after, std::string_view title = "Changed settings:"sv)
+	{
+		std::size_t changes = 0;
+		auto logChange = [&](std::string_view key, const auto& from, const auto& to) {
+			if (from != to) {
+				logger::info("  {}: {} -> {}", key, from, to);
+				++changes;
+			}
+		};
 
-	logger::info("  sFilterMode (raw): \"{}\"", filterModeStr);
+		constexpr std::array filterModeNames = { "Angle", "Distance", "Both", "Either", "Expression", "Frustum" };
 
-	g_config.filterMode = ParseFilterMode(filterModeStr);
+		logger::info("{}", title);
+		logChange("[Main] fMaxDeviationAngle", before.settings.maxDeviationAngle * 180.0f / pi, after.settings.maxDeviationAngle * 180.0f / pi);
+		logChange("[Main] sFilterMode", filterModeNames[static_cast<int>(before.filter.filterMode)], filterModeNames[static_cast<int>(after.filter.filterMode)]);
+		logChange("[Main] sFilterExpression", before.settings.filterExpressionSource, after.settings.filterExpressionSource);
+		constexpr std::array facingSourceNames = { "Actor", "Camera" };
+		logChange("[Main] sFacingSource", facingSourceNames[static_cast<int>(before.filter.facingSource)], facingSourceNames[static_cast<int>(after.filter.facingSource)]);
+		logChange("[Main] b3DViewCone", before.filter.Has(FilterFlag::ViewCone3D), after.filter.Has(FilterFlag::ViewCone3D));
+		logChange("[Main] fDwellTime", before.settings.dwellMilliseconds / 1000.0f, after.settings.dwellMilliseconds / 1000.0f);
+		logChange("[Main] bDecisionTable", before.settings.enableDecisionTable, after.settings.enableDecisionTable);
+		logChange("[Distance] fMaxGreetingDistance", before.settings.maxGreetingDistance, after.settings.maxGreetingDistance);
+		logChange("[Distance] bCloseRangeBypass", before.filter.Has(FilterFlag::CloseRangeBypass), after.filter.Has(FilterFlag::CloseRangeBypass));
+		logChange("[Distance] fCloseRangeDistance", before.settings.closeRangeDistance, after.settings.closeRangeDistance);
+		logChange("[LineOfSight] bEnabled", before.filter.Has(FilterFlag::LineOfSight), after.filter.Has(FilterFlag::LineOfSight));
+		logChange("[LineOfSight] iRaycastBudget", before.settings.lineOfSight.raycastBudget, after.settings.lineOfSight.raycastBudget);
+		logChange("[LineOfSight] fCacheTTL", before.settings.lineOfSight.cacheMilliseconds / 1000.0f, after.settings.lineOfSight.cacheMilliseconds / 1000.0f);
+		logChange("[LineOfSight] fMoveTolerance", before.settings.lineOfSight.moveTolerance, after.settings.lineOfSight.moveTolerance);
+		logChange("[RateLimit] fCommentsPerSecond", before.settings.rateLimit.commentsPerSecond, after.settings.rateLimit.commentsPerSecond);
+		logChange("[RateLimit] fNPCCooldown", before.settings.rateLimit.cooldownMilliseconds / 1000.0f, after.settings.rateLimit.cooldownMilliseconds / 1000.0f);
+		logChange("[Debug] bEnableLogging", before.filter.Has(FilterFlag::DebugLogging), after.filter.Has(FilterFlag::DebugLogging));
+		logChange("[Debug] bHotReload (next game start)", before.settings.enableHotReload, after.settings.enableHotReload);
+		constexpr std::array startupLogNames = { "Full", "Summary" };
+		logChange("[Debug] sStartupLog (next game start)", startupLogNames[static_cast<int>(before.settings.startupLogVerbosity)],
+			startupLogNames[static_cast<int>(after.settings.startupLogVerbosity)]);
+		logChange("[Debug] bStartupTrace (next game start)", before.settings.enableStartupTrace, after.settings.enableStartupTrace);
+		logChange("[Debug] bStatsExport (next game start)", before.settings.enableStatsExport, after.settings.enableStatsExport);
+		logChange("[Debug] bReferenceCheck", before.filter.Has(FilterFlag::ReferenceCheck), after.filter.Has(FilterFlag::ReferenceCheck));
+		logChange("[Shadow] bEnabled", before.settings.enableShadow, after.settings.enableShadow);
+		logChange("[Shadow] iTraceEvery", before.settings.shadowTraceEvery, after.settings.shadowTraceEvery);
 
-	constexpr std::array filterModeNames = { "Angle Only", "Distance Only", "Both (AND)", "Either (OR)" };
-	logger::info("  sFilterMode (parsed): {}", filterModeNames[static_cast<int>(g_config.filterMode)]);
+		// Sections are compared by position; a rule that moved changes its precedence
+		auto logSectionChanges = [&](std::string_view prefix, const auto& oldList, const auto& newList, auto&& same) {
+			for (std::size_t i = 0; i < std::max(oldList.size(), newList.size()); ++i) {
+				const auto* oldItem = i < oldList.size() ? &oldList[i] : nullptr;
+				const auto* newItem = i < newList.size() ? &newList[i] : nullptr;
 
-	// ========================================
-	// [Distance] Section
-	// ========================================
+				if (!newItem) {
+					logger::info("  [{}:{}]: removed", prefix, oldItem->name);
+				} else if (!oldItem) {
+					logger::info("  [{}:{}]: added at position {}", prefix, newItem->name, i + 1);
+				} else if (oldItem->name != newItem->name) {
+					logger::info("  [{}:{}]: replaces [{}:{}] at position {}", prefix, newItem->name, prefix, oldItem->name, i + 1);
+				} else if (!same(*oldItem, *newItem)) {
+					logger::info("  [{}:{}]: changed", prefix, newItem->name);
+				} else {
+					continue;
+				}
+				++changes;
+			}
+		};
 
-	logger::info("Loading [Distance] section...");
+		logSectionChanges("Category"sv, before.settings.categoryRules, after.settings.categoryRules,
+			[](const ActorCategoryRule& a, const ActorCategoryRule& b) {
+				return a.factions == b.factions && a.keywords == b.keywords && a.thresholds == b.thresholds;
+			});
+		logSectionChanges("Profile"sv, before.settings.thresholdProfiles, after.settings.thresholdProfiles,
+			[](const ThresholdProfile& a, const ThresholdProfile& b) {
+				return a.match == b.match && a.cells == b.cells && a.worldspaces == b.worldspaces && a.thresholds == b.thresholds;
+			});
 
-	// Load fMaxGreetingDistance
-	const float rawMaxDistance = GetPrivateProfileFloat("Distance", "fMaxGreetingDistance", 150.0f, configPath);
-	g_config.maxGreetingDistance = rawMaxDistance;
+		if (changes == 0) {
+			logger::info("  (none)");
+		}
 
-	logger::info("  fMaxGreetingDistance (raw): {:.2f} units", rawMaxDistance);
+		return changes > 0;
+	}
+}
 
-	// Validate distance is positive
-	if (g_config.maxGreetingDistance < 0.0f) {
-		logger::warn("  fMaxGreetingDistance ({:.2f}) is negative, using absolute value", g_config.maxGreetingDistance);
-		g_config.maxGreetingDistance = std::abs(g_config.maxGreetingDistance);
-		logger::info("  fMaxGreetingDistance (corrected): {:.2f} units", g_config.maxGreetingDistance);
+namespace
+{
+	/**
+	 * Merges one set of configuration sources and logs where each setting came from.
+	 *
+	 * @param layers Sources, lowest precedence first
+	 * @param cachePath Binary cache of the merged sources (empty = no caching)
+	 */
+	LayeredConfig LoadLayers(std::span<const ConfigLayer> layers, const std::filesystem::path& cachePath)
+	{
+		// Merge every source by precedence (INI < MCM < user overrides). Sources are
+		// parsed once; if none changed since the last load, the merged table comes
+		// from the binary cache and nothing is parsed.
+		const auto loadStart = std::chrono::steady_clock::now();
+		LayeredConfig ini = LayeredConfig::Load(layers, cachePath);
+		const auto loadTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - loadStart);
+
+		logger::info("Loading configuration (lowest precedence first):");
+		for (const auto& layer : layers) {
+			const bool present = ini.GetPresentSources() & (1u << static_cast<std::uint32_t>(layer.source));
+			logger::info("  {}: {} - {}", GetConfigSourceName(layer.source), layer.path, present ? "found" : "not found");
+		}
+		if (ini.GetPresentSources() == 0) {
+			logger::warn("Configuration file not found - using defaults");
+		}
+
+		logger::info("  Merged {} setting(s) in {} section(s), {} ({} us)", ini.GetSettings().size(), ini.GetSections().size(),
+			ini.IsFromCache() ? "from cache" : "parsed", loadTime.count());
+		for (const auto& setting : ini.GetSettings()) {
+			logger::info("    [{}] {} = {} ({})", setting.section, setting.key, setting.value, GetConfigSourceName(setting.source));
+		}
+
+		return ini;
 	}
 
-	// Pre-calculate squared distance for performance
-	g_config.maxGreetingDistanceSquared = g_config.maxGreetingDistance * g_config.maxGreetingDistance;
-	logger::info("  fMaxGreetingDistance: {:.2f} units ({:.2f} squared)", g_config.maxGreetingDistance, g_config.maxGreetingDistanceSquared);
+	/**
+	 * Reads and validates merged settings into a new snapshot.
+	 */
+	std::unique_ptr<PluginConfig> BuildSnapshot(const LayeredConfig& ini)
+	{
+		// Build a fresh snapshot; it becomes visible to the filter only when published
+		auto newConfig = std::make_unique<PluginConfig>();
+		PluginConfig& config = *newConfig;
+
+		// ========================================
+		// [Main] Section
+		// ========================================
+
+		logger::info("Loading [Main] section...");
+
+		// Load fMaxDeviationAngle
+		const float rawDeviationAngle = ini.GetFloat("Main", "fMaxDeviationAngle", 30.0f);
+		const float deviationAngleDegrees = ClampDeviationAngle(rawDeviationAngle);
+		config.settings.maxDeviationAngle = deviationAngleDegrees / 180.0f * pi;
+
+		if (deviationAngleDegrees == rawDeviationAngle) {
+			logger::info("  fMaxDeviationAngle: {:.2f} degrees ({:.4f} radians) - Value OK", deviationAngleDegrees, config.settings.maxDeviationAngle);
+		} else {
+			logger::warn("  fMaxDeviationAngle ({:.2f}) is outside 0-180, clamped to {:.2f} degrees ({:.4f} radians)",
+				rawDeviationAngle, deviationAngleDegrees, config.settings.maxDeviationAngle);
+		}
+
+		// Load sFilterMode
+		const std::string_view filterModeStr = ini.GetString("Main", "sFilterMode", "Angle");
 
-	// Load bCloseRangeBypass
-	g_config.enableCloseRangeBypass = GetPrivateProfileBool("Distance", "bCloseRangeBypass", false, configPath);
-	logger::info("  bCloseRangeBypass: {} {}", g_config.enableCloseRangeBypass ? "ENABLED" : "DISABLED", g_config.enableCloseRangeBypass ? "" : "(default)");
+		logger::info("  sFilterMode (raw): \"{}\"", filterModeStr);
 
-	// Load fCloseRangeDistance
-	const float rawCloseDistance = GetPrivateProfileFloat("Distance", "fCloseRangeDistance", 50.0f, configPath);
-	g_config.closeRangeDistance = rawCloseDistance;
+		config.filter.filterMode = ParseFilterMode(filterModeStr);
 
-	if (g_config.enableCloseRangeBypass) {
-		logger::info("  fCloseRangeDistance (raw): {:.2f} units", rawCloseDistance);
+		constexpr std::array filterModeNames = { "Angle Only", "Distance Only", "Both (AND)", "Either (OR)", "Expression", "Frustum (on screen)" };
+		logger::info("  sFilterMode (parsed): {}", filterModeNames[static_cast<int>(config.filter.filterMode)]);
+
+		// Load sFilterExpression (overrides sFilterMode when set and valid)
+		const std::string_view filterExpressionStr = ini.GetString("Main", "sFilterExpression", "");
+
+		config.settings.filterExpression.reset();
+		config.filter.filterExpression = nullptr;
+		config.settings.filterExpressionSource = filterExpressionStr;
+		if (!filterExpressionStr.empty()) {
+			logger::info("  sFilterExpression (raw): \"{}\"", filterExpressionStr);
+
+			const bool compileNative = ini.GetBool("Main", "bCompileFilterExpression", true);
+
+			std::string error;
+			auto expression = FilterExpression::Compile(filterExpressionStr, error);
+			if (expression && compileNative && !expression->CompileNative(error)) {
+				// Keep the interpreter - native code is an optimization only
+				logger::warn("  Filter expression JIT failed ({}), using interpreter", error);
+			}
+			if (expression) {
+				logger::info("  sFilterExpression: {} operation(s), {} - overrides sFilterMode",
+					expression->GetInstructionCount(), expression->IsJitCompiled() ? "native x64" : "interpreted");
+				config.settings.filterExpression = std::move(expression);
+				config.filter.filterExpression = config.settings.filterExpression.get();
+				config.filter.filterMode = FilterMode::Expression;
+			} else {
+				logger::warn("  sFilterExpression is invalid: {}", error);
+				logger::warn("  Falling back to sFilterMode ({})", filterModeNames[static_cast<int>(config.filter.filterMode)]);
+			}
+		}
+
+		// Load sFacingSource
+		config.filter.facingSource = ParseFacingSource(ini.GetString("Main", "sFacingSource", "Actor"));
+		if (config.filter.facingSource == FacingSource::Camera) {
+			logger::info("  sFacingSource: Camera - facing follows the camera's look direction");
+			if (config.filter.filterMode == FilterMode::DistanceOnly || config.filter.filterMode == FilterMode::Frustum) {
+				logger::info("    (no effect with this filter mode except where it falls back to the angle test)");
+			}
+		} else {
+			logger::info("  sFacingSource: Actor (default, player character's yaw)");
+		}
+
+		// Load b3DViewCone
+		config.filter.Set(FilterFlag::ViewCone3D, ini.GetBool("Main", "b3DViewCone", false));
+		logger::info("  b3DViewCone: {}", config.filter.Has(FilterFlag::ViewCone3D) ? "ENABLED - facing cone from the eyes, including pitch" : "DISABLED (default, horizontal angle only)");
+
+		// Load fDwellTime (seconds in the INI, milliseconds in the filter)
+		const float rawDwellTime = ini.GetFloat("Main", "fDwellTime", 0.0f);
+		const float maxDwellTime = kMaxDwellMilliseconds / 1000.0f;
+		const float dwellTime = std::clamp(rawDwellTime, 0.0f, maxDwellTime);
+		if (dwellTime != rawDwellTime) {
+			logger::warn("  fDwellTime ({:.2f}) is outside 0-{:.0f} seconds, clamping to {:.2f}", rawDwellTime, maxDwellTime, dwellTime);
+		}
+		config.settings.dwellMilliseconds = static_cast<std::uint16_t>(dwellTime * 1000.0f);
+		config.filter.Set(FilterFlag::DwellTime, config.settings.dwellMilliseconds != 0);
+		if (config.settings.dwellMilliseconds) {
+			logger::info("  fDwellTime: {} ms - NPCs comment only after passing the filter that long", config.settings.dwellMilliseconds);
+		} else {
+			logger::info("  fDwellTime: 0 (default, no dwell time)");
+		}
+
+		// Load bDecisionTable (tables are built once all thresholds are known)
+		config.settings.enableDecisionTable = ini.GetBool("Main", "bDecisionTable", false);
+		logger::info("  bDecisionTable: {}", config.settings.enableDecisionTable ? "ENABLED" : "DISABLED (default)");
+
+		// ========================================
+		// [Distance] Section
+		// ========================================
+
+		logger::info("Loading [Distance] section...");
+
+		// Load fMaxGreetingDistance
+		const float rawMaxDistance = ini.GetFloat("Distance", "fMaxGreetingDistance", 150.0f);
+		config.settings.maxGreetingDistance = rawMaxDistance;
+
+		logger::info("  fMaxGreetingDistance (raw): {:.2f} units", rawMaxDistance);
 
 		// Validate distance is positive
-		if (g_config.closeRangeDistance < 0.0f) {
-			logger::warn("  fCloseRangeDistance ({:.2f}) is negative, using absolute value", g_config.closeRangeDistance);
-			g_config.closeRangeDistance = std::abs(g_config.closeRangeDistance);
-			logger::info("  fCloseRangeDistance (corrected): {:.2f} units", g_config.closeRangeDistance);
+		if (config.settings.maxGreetingDistance < 0.0f) {
+			logger::warn("  fMaxGreetingDistance ({:.2f}) is negative, using absolute value", config.settings.maxGreetingDistance);
+			config.settings.maxGreetingDistance = std::abs(config.settings.maxGreetingDistance);
+			logger::info("  fMaxGreetingDistance (corrected): {:.2f} units", config.settings.maxGreetingDistance);
 		}
 
 		// Pre-calculate squared distance for performance
-		g_config.closeRangeDistanceSquared = g_config.closeRangeDistance * g_config.closeRangeDistance;
-		logger::info("  fCloseRangeDistance: {:.2f} units ({:.2f} squared)", g_config.closeRangeDistance, g_config.closeRangeDistanceSquared);
-	} else {
-		// Still calculate for consistency, but don't log details
-		g_config.closeRangeDistanceSquared = g_config.closeRangeDistance * g_config.closeRangeDistance;
+		config.settings.maxGreetingDistanceSquared = config.settings.maxGreetingDistance * config.settings.maxGreetingDistance;
+		logger::info("  fMaxGreetingDistance: {:.2f} units ({:.2f} squared)", config.settings.maxGreetingDistance, config.settings.maxGreetingDistanceSquared);
+
+		// Load bCloseRangeBypass
+		config.filter.Set(FilterFlag::CloseRangeBypass, ini.GetBool("Distance", "bCloseRangeBypass", false));
+		logger::info("  bCloseRangeBypass: {} {}", config.filter.Has(FilterFlag::CloseRangeBypass) ? "ENABLED" : "DISABLED", config.filter.Has(FilterFlag::CloseRangeBypass) ? "" : "(default)");
+
+		// Load fCloseRangeDistance
+		const float rawCloseDistance = ini.GetFloat("Distance", "fCloseRangeDistance", 50.0f);
+		config.settings.closeRangeDistance = rawCloseDistance;
+
+		if (config.filter.Has(FilterFlag::CloseRangeBypass)) {
+			logger::info("  fCloseRangeDistance (raw): {:.2f} units", rawCloseDistance);
+
+			// Validate distance is positive
+			if (config.settings.closeRangeDistance < 0.0f) {
+				logger::warn("  fCloseRangeDistance ({:.2f}) is negative, using absolute value", config.settings.closeRangeDistance);
+				config.settings.closeRangeDistance = std::abs(config.settings.closeRangeDistance);
+				logger::info("  fCloseRangeDistance (corrected): {:.2f} units", config.settings.closeRangeDistance);
+			}
+
+			// Pre-calculate squared distance for performance
+			config.settings.closeRangeDistanceSquared = config.settings.closeRangeDistance * config.settings.closeRangeDistance;
+			logger::info("  fCloseRangeDistance: {:.2f} units ({:.2f} squared)", config.settings.closeRangeDistance, config.settings.closeRangeDistanceSquared);
+		} else {
+			// Still calculate for consistency, but don't log details
+			config.settings.closeRangeDistanceSquared = config.settings.closeRangeDistance * config.settings.closeRangeDistance;
+		}
+
+		// Validate fCloseRangeDistance <= fMaxGreetingDistance
+		if (config.filter.Has(FilterFlag::CloseRangeBypass) && config.settings.closeRangeDistance > config.settings.maxGreetingDistance) {
+			logger::warn("  fCloseRangeDistance ({:.2f}) is greater than fMaxGreetingDistance ({:.2f})",
+				config.settings.closeRangeDistance, config.settings.maxGreetingDistance);
+			logger::warn("  This creates confusing behavior - clamping fCloseRangeDistance to fMaxGreetingDistance");
+			config.settings.closeRangeDistance = config.settings.maxGreetingDistance;
+			config.settings.closeRangeDistanceSquared = config.settings.closeRangeDistance * config.settings.closeRangeDistance;
+			logger::info("  fCloseRangeDistance (clamped): {:.2f} units ({:.2f} squared)",
+				config.settings.closeRangeDistance, config.settings.closeRangeDistanceSquared);
+		}
+
+		// ========================================
+		// [LineOfSight] Section
+		// ========================================
+
+		logger::info("Loading [LineOfSight] section...");
+
+		config.filter.Set(FilterFlag::LineOfSight, ini.GetBool("LineOfSight", "bEnabled", false));
+
+		// Budget (raycasts per 16 ms window)
+		const float rawRaycastBudget = ini.GetFloat("LineOfSight", "iRaycastBudget", 4.0f);
+		config.settings.lineOfSight.raycastBudget = static_cast<std::uint32_t>(std::clamp(rawRaycastBudget, 1.0f, 64.0f));
+		if (rawRaycastBudget < 1.0f || rawRaycastBudget > 64.0f) {
+			logger::warn("  iRaycastBudget ({:.0f}) is outside 1-64, clamping to {}", rawRaycastBudget, config.settings.lineOfSight.raycastBudget);
+		}
+
+		// Cache lifetime
+		const float rawCacheTTL = ini.GetFloat("LineOfSight", "fCacheTTL", 1.0f);
+		const float maxCacheTTL = LineOfSightScheduler::kMaxCacheMilliseconds / 1000.0f;
+		const float cacheTTL = std::clamp(rawCacheTTL, 0.0f, maxCacheTTL);
+		if (cacheTTL != rawCacheTTL) {
+			logger::warn("  fCacheTTL ({:.2f}) is outside 0-{:.0f} seconds, clamping to {:.2f}", rawCacheTTL, maxCacheTTL, cacheTTL);
+		}
+		config.settings.lineOfSight.cacheMilliseconds = static_cast<std::uint32_t>(cacheTTL * 1000.0f);
+
+		// Movement that invalidates a cached result
+		config.settings.lineOfSight.moveTolerance = std::abs(ini.GetFloat("LineOfSight", "fMoveTolerance", 32.0f));
+		if (config.settings.lineOfSight.moveTolerance < 1.0f) {
+			logger::warn("  fMoveTolerance ({:.2f}) is below 1 unit, using 1", config.settings.lineOfSight.moveTolerance);
+			config.settings.lineOfSight.moveTolerance = 1.0f;
+		}
+
+		if (config.filter.Has(FilterFlag::LineOfSight)) {
+			logger::info("  bEnabled: ENABLED - allowed comments also need line of sight");
+			logger::info("  iRaycastBudget: {} per {} ms", config.settings.lineOfSight.raycastBudget, kLineOfSightWindowMilliseconds);
+			logger::info("  fCacheTTL: {:.2f} seconds", config.settings.lineOfSight.cacheMilliseconds / 1000.0f);
+			logger::info("  fMoveTolerance: {:.2f} units", config.settings.lineOfSight.moveTolerance);
+		} else {
+			logger::info("  bEnabled: DISABLED (default)");
+		}
+
+		// ========================================
+		// [RateLimit] Section
+		// ========================================
+
+		logger::info("Loading [RateLimit] section...");
+
+		const float rawCommentsPerSecond = ini.GetFloat("RateLimit", "fCommentsPerSecond", 0.0f);
+		config.settings.rateLimit.commentsPerSecond = std::clamp(rawCommentsPerSecond, 0.0f, 100.0f);
+		if (config.settings.rateLimit.commentsPerSecond != rawCommentsPerSecond) {
+			logger::warn("  fCommentsPerSecond ({:.2f}) is outside 0-100, clamping to {:.2f}", rawCommentsPerSecond, config.settings.rateLimit.commentsPerSecond);
+		}
+		if (config.settings.rateLimit.commentsPerSecond > 0.0f && config.settings.rateLimit.commentsPerSecond < 0.01f) {
+			logger::warn("  fCommentsPerSecond ({:.4f}) is below 0.01, using 0.01", config.settings.rateLimit.commentsPerSecond);
+			config.settings.rateLimit.commentsPerSecond = 0.01f;
+		}
+
+		const float rawCooldown = ini.GetFloat("RateLimit", "fNPCCooldown", 0.0f);
+		const float maxCooldown = kMaxCooldownMilliseconds / 1000.0f;
+		const float cooldown = std::clamp(rawCooldown, 0.0f, maxCooldown);
+		if (cooldown != rawCooldown) {
+			logger::warn("  fNPCCooldown ({:.2f}) is outside 0-{:.0f} seconds, clamping to {:.2f}", rawCooldown, maxCooldown, cooldown);
+		}
+		config.settings.rateLimit.cooldownMilliseconds = static_cast<std::uint32_t>(cooldown * 1000.0f);
+
+		config.filter.Set(FilterFlag::RateLimit, config.settings.rateLimit.commentsPerSecond > 0.0f || config.settings.rateLimit.cooldownMilliseconds > 0);
+		if (config.settings.rateLimit.commentsPerSecond > 0.0f) {
+			logger::info("  fCommentsPerSecond: {:.2f} (all NPCs together)", config.settings.rateLimit.commentsPerSecond);
+		} else {
+			logger::info("  fCommentsPerSecond: 0 (default, unlimited)");
+		}
+		if (config.settings.rateLimit.cooldownMilliseconds) {
+			logger::info("  fNPCCooldown: {:.2f} seconds", config.settings.rateLimit.cooldownMilliseconds / 1000.0f);
+		} else {
+			logger::info("  fNPCCooldown: 0 (default, no cooldown)");
+		}
+
+		// Default category thresholds (used when no [Category:*] rule matches)
+		// ========================================
+		// [Category:*] Sections
+		// ========================================
+
+		logger::info("Loading [Category:*] sections...");
+
+		LoadActorCategories(config, ini);
+		if (config.settings.categoryRules.empty()) {
+			logger::info("  No actor categories defined - all NPCs use the default thresholds");
+		}
+
+		// Base thresholds for every category ([Main]/[Distance] plus category values)
+		FillThresholds(config.filter, config.settings, {});
+
+		// ========================================
+		// [Profile:*] Sections
+		// ========================================
+
+		logger::info("Loading [Profile:*] sections...");
+
+		LoadThresholdProfiles(config, ini);
+		if (config.settings.thresholdProfiles.empty()) {
+			logger::info("  No threshold profiles defined - the same thresholds apply everywhere");
+		}
+
+		// ========================================
+		// [Debug] Section
+		// ========================================
+
+		logger::info("Loading [Debug] section...");
+
+		config.filter.Set(FilterFlag::DebugLogging, ini.GetBool("Debug", "bEnableLogging", false));
+		if (config.filter.Has(FilterFlag::DebugLogging)) {
+			logger::info("  bEnableLogging: ENABLED - Will log each NPC comment check");
+			logger::warn("  WARNING: Debug logging is verbose and may impact performance!");
+		} else {
+			logger::info("  bEnableLogging: DISABLED (default)");
+		}
+
+		config.settings.enableHotReload = ini.GetBool("Debug", "bHotReload", false);
+		logger::info("  bHotReload: {}", config.settings.enableHotReload ? "ENABLED - config files are watched for changes" : "DISABLED (default)");
+
+		config.settings.startupLogVerbosity = ParseStartupLogVerbosity(ini.GetString("Debug", "sStartupLog", "Full"));
+		logger::info("  sStartupLog: {}", config.settings.startupLogVerbosity == StartupLogVerbosity::Summary ?
+			"SUMMARY - only warnings and the final status are kept" : "FULL (default)");
+
+		config.settings.enableStartupTrace = ini.GetBool("Debug", "bStartupTrace", false);
+		logger::info("  bStartupTrace: {}", config.settings.enableStartupTrace ? "ENABLED - startup timeline written to to-your-face-reloaded-startup.json" : "DISABLED (default)");
+
+		config.settings.enableStatsExport = ini.GetBool("Debug", "bStatsExport", false);
+		config.filter.Set(FilterFlag::Timing, config.settings.enableStatsExport);
+		logger::info("  bStatsExport: {}", config.settings.enableStatsExport ? "ENABLED - live statistics in shared memory, calls are timed" : "DISABLED (default)");
+
+		config.filter.Set(FilterFlag::ReferenceCheck, ini.GetBool("Debug", "bReferenceCheck", false));
+		if (config.filter.Has(FilterFlag::ReferenceCheck)) {
+			logger::info("  bReferenceCheck: ENABLED - AngleOnly decisions are compared with the original plugin");
+			if (config.filter.filterMode != FilterMode::AngleOnly) {
+				logger::warn("  bReferenceCheck only applies to sFilterMode=AngleOnly - nothing will be compared");
+			} else if (config.filter.Has(FilterFlag::ViewCone3D)) {
+				logger::warn("  bReferenceCheck compares the horizontal test only - nothing will be compared with b3DViewCone");
+			}
+		} else {
+			logger::info("  bReferenceCheck: DISABLED (default)");
+		}
+
+		// ========================================
+		// [Shadow] Section
+		// ========================================
+
+		logger::info("Loading [Shadow] section...");
+
+		config.settings.enableShadow = ini.GetBool("Shadow", "bEnabled", false);
+		config.settings.shadowTraceEvery = static_cast<std::uint32_t>(std::max(ini.GetFloat("Shadow", "iTraceEvery", 0.0f), 0.0f));
+		if (config.settings.enableShadow) {
+			logger::info("  bEnabled: true - a candidate from {} is evaluated alongside (results unchanged)", kShadowConfigFile);
+			if (config.settings.shadowTraceEvery) {
+				logger::info("  iTraceEvery: {} - every {}th disagreement is logged (at most {})", config.settings.shadowTraceEvery, config.settings.shadowTraceEvery, kMaxShadowTraces);
+			}
+		} else {
+			logger::info("  bEnabled: false (default)");
+		}
+
+		// Decision tables need every threshold, the filter mode and the debug flag
+		BuildDecisionTables(config);
+
+		// ========================================
+		// Configuration Summary
+		// ========================================
+
+		logger::info("--------------------------------------------------------");
+		logger::info("Configuration Summary:");
+		logger::info("--------------------------------------------------------");
+
+		// Determine effective behavior mode
+		if (config.filter.filterMode == FilterMode::AngleOnly && !config.filter.Has(FilterFlag::CloseRangeBypass)) {
+			logger::info("  Active Mode: ANGLE ONLY");
+			logger::info("    NPCs will only comment when player faces them");
+			logger::info("    Maximum deviation: {} degrees", deviationAngleDegrees);
+		} else if (config.filter.filterMode == FilterMode::DistanceOnly) {
+			logger::info("  Active Mode: DISTANCE ONLY");
+			logger::info("    NPCs will only comment when within {:.2f} units", config.settings.maxGreetingDistance);
+		} else if (config.filter.filterMode == FilterMode::Both) {
+			logger::info("  Active Mode: BOTH (angle AND distance required)");
+			logger::info("    NPCs will only comment when within {:.2f} units AND within {} degrees", config.settings.maxGreetingDistance, deviationAngleDegrees);
+			if (config.filter.Has(FilterFlag::CloseRangeBypass)) {
+				logger::info("    Exception: All angles allowed when < {:.2f} units", config.settings.closeRangeDistance);
+			}
+		} else if (config.filter.filterMode == FilterMode::Either) {
+			logger::info("  Active Mode: EITHER (angle OR distance)");
+			logger::info("    NPCs will comment when within {:.2f} units OR within {} degrees", config.settings.maxGreetingDistance, deviationAngleDegrees);
+		} else if (config.filter.filterMode == FilterMode::Frustum) {
+			logger::info("  Active Mode: FRUSTUM (on screen)");
+			logger::info("    NPCs will only comment when their head is in the camera view");
+			if (config.filter.Has(FilterFlag::CloseRangeBypass)) {
+				logger::info("    Exception: Comments allowed off screen when < {:.2f} units", config.settings.closeRangeDistance);
+			}
+		} else if (config.filter.filterMode == FilterMode::Expression) {
+			logger::info("  Active Mode: EXPRESSION");
+			logger::info("    NPCs will comment when: {}", filterExpressionStr);
+			if (config.filter.Has(FilterFlag::CloseRangeBypass)) {
+				logger::info("    Exception: All angles allowed when < {:.2f} units", config.settings.closeRangeDistance);
+			}
+		}
+		if (config.filter.facingSource == FacingSource::Camera &&
+			config.filter.filterMode != FilterMode::DistanceOnly && config.filter.filterMode != FilterMode::Frustum) {
+			logger::info("    Facing is measured from the camera, not the character");
+		}
+		if (config.filter.Has(FilterFlag::ViewCone3D) &&
+			config.filter.filterMode != FilterMode::DistanceOnly && config.filter.filterMode != FilterMode::Frustum) {
+			logger::info("    Facing is a 3D cone from the eyes: NPCs far above or below the view do not count");
+		}
+		if (config.filter.Has(FilterFlag::DwellTime)) {
+			logger::info("    Dwell time: the filter must pass for {} ms before an NPC comments", config.settings.dwellMilliseconds);
+		}
+		if (config.settings.rateLimit.commentsPerSecond > 0.0f) {
+			logger::info("    At most {:.2f} comments per second from all NPCs together", config.settings.rateLimit.commentsPerSecond);
+		}
+		if (config.settings.rateLimit.cooldownMilliseconds) {
+			logger::info("    Each NPC waits {:.2f} seconds between comments", config.settings.rateLimit.cooldownMilliseconds / 1000.0f);
+		}
+		if (config.filter.Has(FilterFlag::LineOfSight)) {
+			logger::info("    Line of sight required (up to {} raycasts per {} ms, cached {:.2f} s)",
+				config.settings.lineOfSight.raycastBudget, kLineOfSightWindowMilliseconds, config.settings.lineOfSight.cacheMilliseconds / 1000.0f);
+		}
+
+		return newConfig;
 	}
 
-	// Validate fCloseRangeDistance <= fMaxGreetingDistance
-	if (g_config.enableCloseRangeBypass && g_config.closeRangeDistance > g_config.maxGreetingDistance) {
-		logger::warn("  fCloseRangeDistance ({:.2f}) is greater than fMaxGreetingDistance ({:.2f})",
-			g_config.closeRangeDistance, g_config.maxGreetingDistance);
-		logger::warn("  This creates confusing behavior - clamping fCloseRangeDistance to fMaxGreetingDistance");
-		g_config.closeRangeDistance = g_config.maxGreetingDistance;
-		g_config.closeRangeDistanceSquared = g_config.closeRangeDistance * g_config.closeRangeDistance;
-		logger::info("  fCloseRangeDistance (clamped): {:.2f} units ({:.2f} squared)",
-			g_config.closeRangeDistance, g_config.closeRangeDistanceSquared);
+	/**
+	 * Profiles differ from the base block only in their thresholds (and the
+	 * decision tables built from them) - everything else (flags, expression,
+	 * category generation) follows the base block.
+	 */
+	void SyncProfileBlocks(PluginConfig& config)
+	{
+		config.filter.config = &config;
+		for (auto& profile : config.profiles) {
+			const auto categories = profile.categories;
+			const DecisionTable* decisionTables = profile.decisionTables;
+			profile = config.filter;
+			profile.categories = categories;
+			profile.decisionTables = decisionTables;
+			profile.Set(FilterFlag::DecisionTable, decisionTables != nullptr);
+		}
 	}
 
-	// ========================================
-	// [Debug] Section
-	// ========================================
+	/**
+	 * Builds the [Shadow] candidate for a snapshot and warns about differences
+	 * the shadow evaluation does not model.
+	 *
+	 * Only the shadow file is parsed, on top of the active snapshot's merged
+	 * sources, and the candidate is logged as its differences from the active
+	 * configuration rather than setting by setting.
+	 *
+	 * @param ini The active snapshot's merged sources
+	 */
+	void BuildShadowCandidate(PluginConfig& config, const LayeredConfig& ini)
+	{
+		logger::info("--------------------------------------------------------");
+		logger::info("Shadow candidate configuration:");
+		logger::info("--------------------------------------------------------");
+
+		const ConfigLayer& layer = kShadowConfigLayers.back();
+		const LayeredConfig shadowIni = LayeredConfig::Overlay(ini, layer);
+		const bool present = shadowIni.GetPresentSources() & (1u << static_cast<std::uint32_t>(layer.source));
+		logger::info("  {}: {} - {}", GetConfigSourceName(layer.source), layer.path, present ? "found" : "not found");
+		for (const auto& setting : shadowIni.GetSettings()) {
+			if (setting.source == ConfigSource::Shadow) {
+				logger::info("    [{}] {} = {} ({})", setting.section, setting.key, setting.value, GetConfigSourceName(setting.source));
+			}
+		}
+
+		std::unique_ptr<PluginConfig> candidate;
+		{
+			// Warnings about the candidate's values still reach the log
+			const QuietLogScope quiet;
+			candidate = BuildSnapshot(shadowIni);
+		}
+		SyncProfileBlocks(*candidate);
+		LogConfigurationChanges(config, *candidate, "Differences from the active configuration:"sv);
+
+		if (candidate->settings.categoryRules.size() != config.settings.categoryRules.size()) {
+			logger::warn("  Shadow: the candidate has {} categories, the active configuration {} - NPCs keep their active category index",
+				candidate->settings.categoryRules.size(), config.settings.categoryRules.size());
+		}
+		if (candidate->profiles.size() != config.profiles.size()) {
+			logger::warn("  Shadow: the candidate has {} profiles, the active configuration {} - its [Main]/[Distance] values are used everywhere",
+				candidate->profiles.size(), config.profiles.size());
+		}
+		if (candidate->filter.facingSource != config.filter.facingSource || candidate->filter.Has(FilterFlag::ViewCone3D) != config.filter.Has(FilterFlag::ViewCone3D)) {
+			logger::warn("  Shadow: sFacingSource and b3DViewCone follow the active configuration (the facing is gathered once per check)");
+		}
+		if (candidate->filter.Has(FilterFlag::DwellTime) || candidate->filter.Has(FilterFlag::LineOfSight) || candidate->filter.Has(FilterFlag::RateLimit)) {
+			logger::info("  Shadow: fDwellTime, [LineOfSight] and [RateLimit] are not evaluated - only the filter decisions are compared");
+		}
 
-	logger::info("Loading [Debug] section...");
+		config.shadow = std::move(candidate);
+	}
+}
 
-	g_config.enableDebugLogging = GetPrivateProfileBool("Debug", "bEnableLogging", false, configPath);
-	if (g_config.enableDebugLogging) {
-		logger::info("  bEnableLogging: ENABLED - Will log each NPC comment check");
-		logger::warn("  WARNING: Debug logging is verbose and may impact performance!");
-	} else {
-		logger::info("  bEnableLogging: DISABLED (default)");
+std::unique_ptr<PluginConfig> BuildConfiguration()
+{
+	const LayeredConfig ini = LoadLayers(kConfigLayers, GetConfigCachePath(kConfigCacheFile));
+	auto config = BuildSnapshot(ini);
+	if (config->settings.enableShadow) {
+		BuildShadowCandidate(*config, ini);
 	}
+	return config;
+}
 
-	// ========================================
-	// Configuration Summary
-	// ========================================
+bool LoadConfiguration()
+{
+	g_sourceFingerprint = LayeredConfig::GetFingerprint(kShadowConfigLayers);  // Before reading, so a write meanwhile reloads
 
+	// Publish for the filter (readers see either the old or the new snapshot, never a mix)
+	CompileAndPublishConfig(BuildConfiguration());
+
+	logger::info("Configuration loaded successfully");
+
+	return true;
+}
+
+bool ReloadConfiguration()
+{
 	logger::info("--------------------------------------------------------");
-	logger::info("Configuration Summary:");
+	logger::info("Configuration file changed - reloading...");
 	logger::info("--------------------------------------------------------");
 
-	// Determine effective behavior mode
-	if (g_config.filterMode == FilterMode::AngleOnly && !g_config.enableCloseRangeBypass) {
-		logger::info("  Active Mode: ANGLE ONLY");
-		logger::info("    NPCs will only comment when player faces them");
-		logger::info("    Maximum deviation: {} degrees", deviationAngleDegrees);
-	} else if (g_config.filterMode == FilterMode::DistanceOnly) {
-		logger::info("  Active Mode: DISTANCE ONLY");
-		logger::info("    NPCs will only comment when within {:.2f} units", g_config.maxGreetingDistance);
-	} else if (g_config.filterMode == FilterMode::Both) {
-		logger::info("  Active Mode: BOTH (angle AND distance required)");
-		logger::info("    NPCs will only comment when within {:.2f} units AND within {} degrees", g_config.maxGreetingDistance, deviationAngleDegrees);
-		if (g_config.enableCloseRangeBypass) {
-			logger::info("    Exception: All angles allowed when < {:.2f} units", g_config.closeRangeDistance);
-		}
-	} else if (g_config.filterMode == FilterMode::Either) {
-		logger::info("  Active Mode: EITHER (angle OR distance)");
-		logger::info("    NPCs will comment when within {:.2f} units OR within {} degrees", g_config.maxGreetingDistance, deviationAngleDegrees);
+	// Editors may delete and recreate the file while saving - never fall back to
+	// defaults on reload, just wait for the next change
+	const bool configExists = std::any_of(kConfigLayers.begin(), kConfigLayers.end(), [](const ConfigLayer& layer) {
+		return std::filesystem::exists(layer.path);
+	});
+	if (!configExists) {
+		logger::warn("Configuration file is missing - keeping the current settings");
+		return false;
 	}
 
-	logger::info("Configuration loaded successfully");
+	// Saving without changes, or touching an unrelated file of the same name,
+	// does not rebuild and re-validate the whole snapshot
+	std::string fingerprint = LayeredConfig::GetFingerprint(kShadowConfigLayers);
+	if (fingerprint == g_sourceFingerprint) {
+		logger::info("Configuration files are unchanged (same size and write time) - nothing to reload");
+		return true;
+	}
+	g_sourceFingerprint = std::move(fingerprint);
+
+	auto newConfig = BuildConfiguration();
+
+	// Released before publishing, so the snapshot it protects can be freed right away
+	if (const SnapshotReadGuard snapshotGuard; const PluginConfig* active = GetActiveConfig()) {
+		bool changed = LogConfigurationChanges(*active, *newConfig);
+		if (active->shadow && newConfig->shadow) {
+			logger::info("Shadow candidate:");
+			changed |= LogConfigurationChanges(*active->shadow, *newConfig->shadow);
+		}
+		if (!changed) {
+			logger::info("No settings changed - keeping the current configuration");
+			return true;
+		}
+	}
+
+	CompileAndPublishConfig(std::move(newConfig));
+
+	logger::info("Configuration reloaded successfully");
 
 	return true;
 }
+
+void PublishConfig(std::unique_ptr<PluginConfig> config)
+{
+	std::lock_guard lock(g_publishLock);
+
+	// [Shadow]: each block points at the candidate's block for the same profile
+	const PluginConfig* shadow = config->shadow.get();
+	config->filter.Set(FilterFlag::Shadow, shadow != nullptr);
+	config->filter.shadowFilter = shadow ? &shadow->filter : nullptr;
+	SyncProfileBlocks(*config);
+	if (shadow && shadow->profiles.size() == config->profiles.size()) {
+		for (std::size_t i = 0; i < config->profiles.size(); ++i) {
+			config->profiles[i].shadowFilter = &shadow->profiles[i];
+		}
+	}
+
+	// Release stores pair with the acquire loads in GetActiveConfig/GetActiveFilter
+	g_activeConfig.store(config.get(), std::memory_order_release);
+	g_activeFilter.store(SelectFilter(*config), std::memory_order_release);
+
+	if (g_activeConfigOwner) {
+		g_retiredConfigs.push_back({ std::move(g_activeConfigOwner), AdvanceSnapshotEpoch() });
+	}
+	g_activeConfigOwner = std::move(config);
+
+	// Usually frees the replaced snapshot right away - AllowComment calls are short
+	CollectRetiredConfigsLocked();
+
+	// Cached results may depend on the old settings (e.g. fMoveTolerance)
+	BumpWorldGeneration(WorldChange::ConfigChange);
+}
+
+std::size_t CollectRetiredConfigs()
+{
+	std::lock_guard lock(g_publishLock);
+	return CollectRetiredConfigsLocked();
+}
+
+void SetPlayerLocation(const PlayerLocation& location)
+{
+	std::lock_guard lock(g_publishLock);
+
+	g_playerLocation = location;
+	if (g_activeConfigOwner) {
+		g_activeFilter.store(SelectFilter(*g_activeConfigOwner), std::memory_order_release);
+	}
+}
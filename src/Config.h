@@ -1,21 +1,82 @@
 #pragma once
 
+#include "FilterParameters.h"
+#include "FilterExpression.h"
+#include "StartupLog.h"
+#include "LineOfSight.h"
+#include "RateLimiter.h"
+#include "SnapshotEpochs.h"
+
 /**
- * Filter mode determines how angle and distance filters are combined
+ * Optional threshold values from a [Category:*] or [Profile:*] section.
+ * Unset values inherit from the enclosing level: a category inherits from
+ * the active profile, a profile from [Main]/[Distance].
  */
-enum class FilterMode
+struct ThresholdOverrides
 {
-	AngleOnly = 0,     // Original behavior - angle-based filtering only
-	DistanceOnly = 1,  // Distance-based filtering only
-	Both = 2,          // Both angle AND distance required (strict)
-	Either = 3         // Either angle OR distance (permissive)
+	std::optional<float> maxDeviationAngle;    // Radians
+	std::optional<float> maxGreetingDistance;  // Game units
+	std::optional<float> closeRangeDistance;   // Game units
+
+	bool operator==(const ThresholdOverrides&) const = default;
 };
 
 /**
- * Plugin configuration structure holding all settings.
- * Loaded from to-your-face-reloaded.ini at plugin initialization.
+ * Actor category rule from a [Category:Name] section.
+ * Faction/keyword references stay as strings until forms are loaded,
+ * then CompileActorRules() turns them into bitsets.
  */
-struct PluginConfig
+struct ActorCategoryRule
+{
+	std::string name;                   // Section name without the "Category:" prefix
+	std::vector<std::string> factions;  // "Plugin.esm|0xFormID" or "0xFormID" references
+	std::vector<std::string> keywords;  // Same format as factions
+	std::uint64_t factionMask;          // Compiled bitset over all referenced factions
+	std::uint64_t keywordMask;          // Compiled bitset over all referenced keywords
+	ThresholdOverrides thresholds;      // Values set in the section
+};
+
+/**
+ * Which locations a [Profile:Name] section applies to, besides its listed cells/worldspaces.
+ */
+enum class ProfileMatch : std::uint8_t
+{
+	Listed = 0,    // Only the cells and worldspaces in sCells/sWorldspaces
+	Interior = 1,  // Every interior cell
+	Exterior = 2   // Every exterior cell
+};
+
+/**
+ * Threshold profile from a [Profile:Name] section. The first profile matching
+ * the player's cell replaces the [Main]/[Distance] thresholds while the player
+ * is there. References are resolved once forms are loaded.
+ */
+struct ThresholdProfile
+{
+	std::string name;                       // Section name without the "Profile:" prefix
+	ProfileMatch match;                     // sMatch
+	std::vector<std::string> cells;         // "Plugin.esm|0xFormID" or "0xFormID" references
+	std::vector<std::string> worldspaces;   // Same format as cells
+	std::vector<RE::FormID> cellIDs;        // Resolved cells (sorted)
+	std::vector<RE::FormID> worldspaceIDs;  // Resolved worldspaces (sorted)
+	ThresholdOverrides thresholds;          // Values set in the section
+};
+
+/**
+ * Where the player is, as far as profile selection is concerned.
+ */
+struct PlayerLocation
+{
+	RE::FormID cell;        // Current cell
+	RE::FormID worldspace;  // Worldspace of the cell (0 for interiors)
+	bool interior;          // Cell is an interior
+};
+
+/**
+ * Cold settings - values as read from the INI, used for logging, reload diffs,
+ * rule compilation and category cache misses, never on the common path.
+ */
+struct ConfigSettings
 {
 	// Angle-based filtering (existing feature)
 	float maxDeviationAngle;  // Maximum angle in radians for allowing comments
@@ -25,23 +86,154 @@ struct PluginConfig
 	float maxGreetingDistanceSquared; // Squared distance (optimization to avoid sqrt)
 
 	// Close range bypass (new feature)
-	bool enableCloseRangeBypass;      // Allow comments at close range regardless of angle
 	float closeRangeDistance;         // Distance threshold for close range bypass
 	float closeRangeDistanceSquared;  // Squared close range distance (optimization)
 
-	// Filter mode (new feature)
-	FilterMode filterMode;  // How to combine angle and distance filters
+	// Filter expression (new feature)
+	std::shared_ptr<const FilterExpression> filterExpression;  // Owner of FilterParameters::filterExpression
+	std::string filterExpressionSource;                        // sFilterExpression as written (for reload diffs)
+
+	// Per-category thresholds (new feature)
+	std::vector<ActorCategoryRule> categoryRules;  // Rule i maps to category i + 1, first match wins
+	std::vector<RE::FormID> categoryFactionBits;   // Sorted factions referenced by rules (index = bit)
+	std::vector<RE::FormID> categoryKeywordBits;   // Sorted keywords referenced by rules (index = bit)
+
+	// Per-cell threshold profiles (new feature)
+	std::vector<ThresholdProfile> thresholdProfiles;  // First match wins; profile i uses PluginConfig::profiles[i]
+
+	// Decision tables (new feature)
+	bool enableDecisionTable;  // bDecisionTable as read (tables are only built for modes they support)
+
+	// Dwell time (new feature)
+	std::uint16_t dwellMilliseconds;  // fDwellTime, read only with FilterFlag::DwellTime
 
-	// Debug logging (for troubleshooting)
-	bool enableDebugLogging;  // Log each NPC comment check to help diagnose issues
+	// Line of sight (new feature)
+	LineOfSightSettings lineOfSight;  // Raycast budget and cache, read only with FilterFlag::LineOfSight
+
+	// Comment rate limit (new feature)
+	RateLimitSettings rateLimit;  // Read only with FilterFlag::RateLimit
+
+	// Shadow evaluation (new feature)
+	bool enableShadow;               // [Shadow] bEnabled as read (a candidate is only built if this is set)
+	std::uint32_t shadowTraceEvery;  // Log every Nth disagreement (0 = none)
+
+	// Config file watching
+	bool enableHotReload;  // Watch the config files and reload on change (read at startup only)
+
+	// Startup logging
+	StartupLogVerbosity startupLogVerbosity;  // Records written from the buffered startup log (read at startup only)
+	bool enableStartupTrace;                  // Write the startup phase timeline as Chrome trace JSON (read at startup only)
+
+	// Live statistics
+	bool enableStatsExport;  // Publish filter statistics in shared memory (read at startup only)
 };
 
-// Global configuration instance
-inline PluginConfig g_config;
+/**
+ * Plugin configuration structure holding all settings.
+ * Loaded from to-your-face-reloaded.ini at plugin initialization.
+ *
+ * Split into the hot parameters the filter reads on every call and the cold
+ * settings everything else uses, so the filter's working set stays small.
+ *
+ * Instances are immutable snapshots once published with PublishConfig():
+ * changes are made by copying the active snapshot, modifying the copy and
+ * publishing it (see CompileActorRules).
+ */
+struct PluginConfig
+{
+	FilterParameters filter;                 // Hot - first member, so it starts the (64-byte aligned) allocation
+	ConfigSettings settings;                 // Cold
+	std::vector<FilterParameters> profiles;  // Hot block per threshold profile (same order as settings.thresholdProfiles)
+
+	// Decision tables of filter and profiles, kMaxActorCategories per block. Shared with
+	// copies of the snapshot (CompileActorRules), whose blocks keep pointing into them.
+	std::shared_ptr<const std::vector<DecisionTable>> decisionTables;
+
+	// Candidate configuration for [Shadow] (the configuration files plus the shadow
+	// file), or nullptr. Shared with copies of the snapshot like the decision tables.
+	std::shared_ptr<const PluginConfig> shadow;
+};
+
+// Published configuration snapshot. Written only by PublishConfig() (release store);
+// read by the filter with a single acquire load per call, so every field written
+// before publication is visible on any AI thread without further synchronization.
+inline std::atomic<const PluginConfig*> g_activeConfig{ nullptr };
+
+/**
+ * @return The published configuration snapshot, or nullptr if none is loaded yet.
+ *         Valid while the calling thread holds a SnapshotReadGuard taken before
+ *         the load; without one it may be freed as soon as it is replaced.
+ */
+inline const PluginConfig* GetActiveConfig()
+{
+	return g_activeConfig.load(std::memory_order_acquire);
+}
+
+// Filter parameters of the active profile, pointing into the published snapshot.
+// Switched by PublishConfig() and SetPlayerLocation() with a release store, so
+// the filter needs exactly one acquire load per call to get its thresholds.
+inline std::atomic<const FilterParameters*> g_activeFilter{ nullptr };
+
+/**
+ * @return Filter parameters of the profile for the player's current location,
+ *         or nullptr if no configuration is loaded yet. Valid for as long as
+ *         the snapshot it belongs to (FilterParameters::config), i.e. while
+ *         the calling thread holds a SnapshotReadGuard.
+ */
+inline const FilterParameters* GetActiveFilter()
+{
+	return g_activeFilter.load(std::memory_order_acquire);
+}
+
+/**
+ * Publishes a new configuration snapshot and retires the previous one.
+ * Never blocks readers. A retired snapshot is freed as soon as no thread
+ * that might have loaded it is still inside its SnapshotReadGuard - by this
+ * call if possible, otherwise by a later CollectRetiredConfigs().
+ * The profile for the last known player location is selected from the
+ * new snapshot.
+ *
+ * @param config Fully initialized snapshot (must not be modified afterwards)
+ */
+void PublishConfig(std::unique_ptr<PluginConfig> config);
+
+/**
+ * Frees the retired snapshots no reader can still be using. Called after
+ * each publication, periodically by the config watcher while any are left,
+ * and on game save and load.
+ *
+ * @return Number of retired snapshots still waiting for a reader
+ */
+std::size_t CollectRetiredConfigs();
+
+/**
+ * Records the player's location and switches to the matching threshold profile.
+ * Called on cell change and game load, never from the filter. Switching is a
+ * single pointer store; readers pick it up on their next call.
+ *
+ * @param location The player's new location
+ */
+void SetPlayerLocation(const PlayerLocation& location);
 
 // Constants
 inline constexpr std::string_view kConfigFile = "Data\\SKSE\\Plugins\\to-your-face-reloaded.ini"sv;
-inline constexpr float pi = 3.1415f;  // Probably overkill for this mod
+inline constexpr std::string_view kMCMConfigFile = "Data\\MCM\\Settings\\to-your-face-reloaded.ini"sv;
+inline constexpr std::string_view kOverrideConfigFile = "Data\\SKSE\\Plugins\\to-your-face-reloaded_custom.ini"sv;
+inline constexpr std::string_view kShadowConfigFile = "Data\\SKSE\\Plugins\\to-your-face-reloaded_shadow.ini"sv;
+inline constexpr std::string_view kConfigCacheFile = "to-your-face-reloaded.cache"sv;  // In the SKSE log directory
+inline constexpr std::uint32_t kMaxShadowTraces = 256;  // [Shadow] disagreements logged per game session at most
+
+/**
+ * Reads and validates the configuration into a new, unpublished snapshot.
+ * Settings are merged from to-your-face-reloaded.ini, the MCM settings file and
+ * to-your-face-reloaded_custom.ini (highest precedence last); keys missing from
+ * every file and invalid values fall back to defaults. With [Shadow] bEnabled
+ * the candidate (the same files plus to-your-face-reloaded_shadow.ini) is
+ * built too and attached as PluginConfig::shadow.
+ *
+ * @return Snapshot ready for CompileAndPublishConfig()
+ */
+std::unique_ptr<PluginConfig> BuildConfiguration();
 
 /**
  * Loads plugin configuration from to-your-face-reloaded.ini file.
@@ -51,3 +243,14 @@ inline constexpr float pi = 3.1415f;  // Probably overkill for this mod
  * @return true if configuration was loaded successfully, false otherwise
  */
 bool LoadConfiguration();
+
+/**
+ * Re-reads the configuration after a file change and publishes it if any
+ * setting differs from the active snapshot. Changed keys are logged. Returns
+ * right away if no config file's size or write time changed since the last read.
+ * Runs on the config reload worker thread; the filter keeps using the previous
+ * snapshot until the new one is published.
+ *
+ * @return false if the file could not be read (the active configuration is kept)
+ */
+bool ReloadConfiguration();
@@ -0,0 +1,352 @@
+/**
+ * ConfigLayers.cpp - Layered configuration merge and binary cache
+ *
+ * Cache file layout (little endian, all strings as u32 length + bytes):
+ *   u32 magic 'TYFC', u32 version
+ *   string fingerprint          - per source: u8 source, u8 exists, u64 size, i64 write time
+ *   u32 presentSources
+ *   u32 section count, sections
+ *   u32 setting count, settings - section, key, value, u8 source
+ *   u64 FNV-1a of everything above
+ * Any mismatch (version, fingerprint, length, checksum) discards the cache
+ * and the sources are parsed again.
+ *
+ * Game-independent (also built by tests/) - standard headers only, no PCH.
+ */
+
+#include "ConfigLayers.h"
+#include "IniFile.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <fstream>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+using namespace std::literals;
+
+namespace
+{
+	inline constexpr std::uint32_t kCacheMagic = 0x43465954;  // "TYFC"
+	inline constexpr std::uint32_t kCacheVersion = 1;
+
+	std::uint64_t HashFNV1a(std::string_view data)
+	{
+		std::uint64_t hash = 0xCBF29CE484222325ull;
+		for (const char c : data) {
+			hash = (hash ^ static_cast<std::uint8_t>(c)) * 0x100000001B3ull;
+		}
+		return hash;
+	}
+
+	/**
+	 * Appends fixed-size values and length-prefixed strings to a byte buffer.
+	 */
+	class CacheWriter
+	{
+	public:
+		template <class T>
+		void Write(T value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			const auto bytes = std::bit_cast<std::array<char, sizeof(T)>>(value);
+			buffer.append(bytes.data(), bytes.size());
+		}
+
+		void WriteString(std::string_view text)
+		{
+			Write(static_cast<std::uint32_t>(text.size()));
+			buffer.append(text);
+		}
+
+		std::string buffer;
+	};
+
+	/**
+	 * Reads back what CacheWriter wrote. Every read is bounds checked; after the
+	 * first failure all reads fail and Failed() reports it.
+	 */
+	class CacheReader
+	{
+	public:
+		explicit CacheReader(std::string_view data) :
+			remaining(data) {}
+
+		template <class T>
+		T Read()
+		{
+			std::array<char, sizeof(T)> bytes{};
+			if (!failed && remaining.size() >= sizeof(T)) {
+				std::copy_n(remaining.data(), sizeof(T), bytes.data());
+				remaining.remove_prefix(sizeof(T));
+			} else {
+				failed = true;
+			}
+			return std::bit_cast<T>(bytes);
+		}
+
+		std::string ReadString()
+		{
+			const auto length = Read<std::uint32_t>();
+			if (failed || remaining.size() < length) {
+				failed = true;
+				return {};
+			}
+			std::string text(remaining.substr(0, length));
+			remaining.remove_prefix(length);
+			return text;
+		}
+
+		bool Failed() const { return failed; }
+		bool AtEnd() const { return remaining.empty(); }
+
+	private:
+		std::string_view remaining;
+		bool failed = false;
+	};
+
+	/**
+	 * Describes the current state of every source. The cache is valid only if
+	 * this matches byte for byte.
+	 */
+	std::string BuildFingerprint(std::span<const ConfigLayer> layers, std::uint32_t& presentSources)
+	{
+		CacheWriter fingerprint;
+		presentSources = 0;
+
+		for (const auto& layer : layers) {
+			std::error_code error;
+			const auto size = std::filesystem::file_size(layer.path, error);
+			const bool exists = !error;
+			const auto writeTime = exists ? std::filesystem::last_write_time(layer.path, error) : std::filesystem::file_time_type{};
+
+			fingerprint.Write(static_cast<std::uint8_t>(layer.source));
+			fingerprint.Write(static_cast<std::uint8_t>(exists && !error));
+			fingerprint.Write(static_cast<std::uint64_t>(exists ? size : 0));
+			fingerprint.Write(static_cast<std::int64_t>(writeTime.time_since_epoch().count()));
+
+			if (exists) {
+				presentSources |= 1u << static_cast<std::uint32_t>(layer.source);
+			}
+		}
+
+		return std::move(fingerprint.buffer);
+	}
+
+	bool SettingLess(const ConfigSetting& setting, std::pair<std::string_view, std::string_view> target)
+	{
+		const int section = CompareIgnoreCase(setting.section, target.first);
+		return section != 0 ? section < 0 : CompareIgnoreCase(setting.key, target.second) < 0;
+	}
+}
+
+std::string_view GetConfigSourceName(ConfigSource source)
+{
+	constexpr std::array names = { "INI"sv, "MCM"sv, "override"sv, "shadow"sv };
+	const auto index = static_cast<std::size_t>(source);
+	return index < names.size() ? names[index] : "?"sv;
+}
+
+std::string LayeredConfig::GetFingerprint(std::span<const ConfigLayer> layers)
+{
+	std::uint32_t presentSources = 0;
+	return BuildFingerprint(layers, presentSources);
+}
+
+LayeredConfig LayeredConfig::Load(std::span<const ConfigLayer> layers, const std::filesystem::path& cachePath)
+{
+	LayeredConfig merged;
+
+	std::uint32_t presentSources = 0;
+	const std::string fingerprint = BuildFingerprint(layers, presentSources);
+
+	if (!cachePath.empty() && merged.ReadCache(cachePath, fingerprint)) {
+		merged.fromCache = true;
+		return merged;
+	}
+
+	for (const auto& layer : layers) {
+		if (!(presentSources & (1u << static_cast<std::uint32_t>(layer.source)))) {
+			continue;
+		}
+		if (auto ini = IniFile::Load(std::string(layer.path).c_str())) {
+			merged.Merge(layer.source, *ini);
+			merged.presentSources |= 1u << static_cast<std::uint32_t>(layer.source);
+		}
+	}
+
+	// Only cache what matches the fingerprint (a file that vanished between stat and read is not cached)
+	if (!cachePath.empty() && merged.presentSources == presentSources) {
+		merged.WriteCache(cachePath, fingerprint);
+	}
+
+	return merged;
+}
+
+LayeredConfig LayeredConfig::Overlay(const LayeredConfig& base, const ConfigLayer& layer)
+{
+	LayeredConfig merged = base;
+	merged.fromCache = false;
+
+	std::error_code error;
+	if (std::filesystem::exists(layer.path, error)) {
+		if (auto ini = IniFile::Load(std::string(layer.path).c_str())) {
+			merged.Merge(layer.source, *ini);
+			merged.presentSources |= 1u << static_cast<std::uint32_t>(layer.source);
+		}
+	}
+
+	return merged;
+}
+
+void LayeredConfig::Merge(ConfigSource source, const IniFile& ini)
+{
+	for (const auto& name : ini.GetSections()) {
+		const bool known = std::any_of(sections.begin(), sections.end(), [&](const std::string& section) {
+			return EqualsIgnoreCase(section, name);
+		});
+		if (!known) {
+			sections.emplace_back(name);
+		}
+	}
+
+	// Entries are sorted with duplicates in file order - the first one is the one the file means
+	const auto& entries = ini.GetEntries();
+	for (std::size_t i = 0; i < entries.size(); ++i) {
+		const auto& entry = entries[i];
+		if (i > 0 && EqualsIgnoreCase(entries[i - 1].section, entry.section) && EqualsIgnoreCase(entries[i - 1].key, entry.key)) {
+			continue;
+		}
+
+		// Higher sources are merged later and replace the value
+		auto it = std::lower_bound(settings.begin(), settings.end(), std::pair{ entry.section, entry.key }, SettingLess);
+		if (it != settings.end() && EqualsIgnoreCase(it->section, entry.section) && EqualsIgnoreCase(it->key, entry.key)) {
+			it->value = entry.value;
+			it->source = source;
+		} else {
+			settings.insert(it, { std::string(entry.section), std::string(entry.key), std::string(entry.value), source });
+		}
+	}
+}
+
+const ConfigSetting* LayeredConfig::Find(std::string_view section, std::string_view key) const
+{
+	const auto it = std::lower_bound(settings.begin(), settings.end(), std::pair{ section, key }, SettingLess);
+	if (it == settings.end() || !EqualsIgnoreCase(it->section, section) || !EqualsIgnoreCase(it->key, key)) {
+		return nullptr;
+	}
+	return &*it;
+}
+
+std::string_view LayeredConfig::GetString(std::string_view section, std::string_view key, std::string_view defaultValue) const
+{
+	const auto setting = Find(section, key);
+	return setting ? std::string_view(setting->value) : defaultValue;
+}
+
+bool LayeredConfig::GetBool(std::string_view section, std::string_view key, bool defaultValue) const
+{
+	const auto setting = Find(section, key);
+	return setting ? ParseIniBool(setting->value, defaultValue) : defaultValue;
+}
+
+float LayeredConfig::GetFloat(std::string_view section, std::string_view key, float defaultValue) const
+{
+	const auto setting = Find(section, key);
+	return setting ? ParseIniFloat(setting->value, defaultValue) : defaultValue;
+}
+
+bool LayeredConfig::ReadCache(const std::filesystem::path& path, std::string_view fingerprint)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return false;
+	}
+
+	std::string data(static_cast<std::size_t>(file.tellg()), '\0');
+	file.seekg(0);
+	if (!file.read(data.data(), static_cast<std::streamsize>(data.size())) || data.size() < sizeof(std::uint64_t)) {
+		return false;
+	}
+
+	// Checksum covers everything before it
+	const std::string_view body(data.data(), data.size() - sizeof(std::uint64_t));
+	CacheReader checksum(std::string_view(data).substr(body.size()));
+	if (checksum.Read<std::uint64_t>() != HashFNV1a(body)) {
+		return false;
+	}
+
+	CacheReader reader(body);
+	if (reader.Read<std::uint32_t>() != kCacheMagic || reader.Read<std::uint32_t>() != kCacheVersion ||
+		reader.ReadString() != fingerprint) {
+		return false;
+	}
+
+	presentSources = reader.Read<std::uint32_t>();
+
+	const auto sectionCount = reader.Read<std::uint32_t>();
+	for (std::uint32_t i = 0; i < sectionCount && !reader.Failed(); ++i) {
+		sections.push_back(reader.ReadString());
+	}
+
+	const auto settingCount = reader.Read<std::uint32_t>();
+	for (std::uint32_t i = 0; i < settingCount && !reader.Failed(); ++i) {
+		ConfigSetting setting;
+		setting.section = reader.ReadString();
+		setting.key = reader.ReadString();
+		setting.value = reader.ReadString();
+		setting.source = static_cast<ConfigSource>(reader.Read<std::uint8_t>());
+		settings.push_back(std::move(setting));
+	}
+
+	if (reader.Failed() || !reader.AtEnd()) {
+		sections.clear();
+		settings.clear();
+		presentSources = 0;
+		return false;
+	}
+
+	return true;
+}
+
+void LayeredConfig::WriteCache(const std::filesystem::path& path, std::string_view fingerprint) const
+{
+	CacheWriter writer;
+	writer.Write(kCacheMagic);
+	writer.Write(kCacheVersion);
+	writer.WriteString(fingerprint);
+	writer.Write(presentSources);
+
+	writer.Write(static_cast<std::uint32_t>(sections.size()));
+	for (const auto& section : sections) {
+		writer.WriteString(section);
+	}
+
+	writer.Write(static_cast<std::uint32_t>(settings.size()));
+	for (const auto& setting : settings) {
+		writer.WriteString(setting.section);
+		writer.WriteString(setting.key);
+		writer.WriteString(setting.value);
+		writer.Write(static_cast<std::uint8_t>(setting.source));
+	}
+
+	writer.Write(HashFNV1a(writer.buffer));
+
+	// Write a temporary file and rename it so a crash never leaves a torn cache
+	auto tempPath = path;
+	tempPath += ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file || !file.write(writer.buffer.data(), static_cast<std::streamsize>(writer.buffer.size()))) {
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+	if (error) {
+		std::filesystem::remove(tempPath, error);
+	}
+}
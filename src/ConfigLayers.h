@@ -0,0 +1,127 @@
+#pragma once
+
+// Game-independent (also built by tests/) - standard headers only, no PCH.
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class IniFile;
+
+/**
+ * Configuration sources, lowest precedence first.
+ * Built-in defaults are not stored - a key missing from every file makes the
+ * getter return its default.
+ */
+enum class ConfigSource : std::uint8_t
+{
+	Ini = 0,       // Data\SKSE\Plugins\to-your-face-reloaded.ini (shipped with the mod)
+	MCM = 1,       // Data\MCM\Settings\to-your-face-reloaded.ini (written by MCM Helper)
+	Override = 2,  // Data\SKSE\Plugins\to-your-face-reloaded_custom.ini (user overrides)
+	Shadow = 3,    // Data\SKSE\Plugins\to-your-face-reloaded_shadow.ini (shadow candidate only)
+	kCount
+};
+
+/**
+ * @return Short name of a source for the log
+ */
+std::string_view GetConfigSourceName(ConfigSource source);
+
+/**
+ * One configuration file taking part in the merge.
+ */
+struct ConfigLayer
+{
+	ConfigSource source;
+	std::string_view path;
+};
+
+/**
+ * One merged setting and the source that provided its value.
+ */
+struct ConfigSetting
+{
+	std::string section;
+	std::string key;
+	std::string value;
+	ConfigSource source;
+};
+
+/**
+ * Flat table of all settings, merged from every source by precedence.
+ *
+ * Each source is parsed once and each key keeps the value of the highest
+ * source that sets it, so a key missing from the MCM file still comes from
+ * the INI instead of a hard-coded default.
+ *
+ * The merged table is cached in a binary file keyed by the size and write
+ * time of every source. If no source changed since the cache was written,
+ * loading reads the cache and parses nothing.
+ */
+class LayeredConfig
+{
+public:
+	/**
+	 * Loads and merges the sources, using the cache when it is still valid.
+	 *
+	 * @param layers Sources, lowest precedence first (missing files are skipped)
+	 * @param cachePath Binary cache file (empty = no caching)
+	 */
+	static LayeredConfig Load(std::span<const ConfigLayer> layers, const std::filesystem::path& cachePath);
+
+	/**
+	 * Merges one more source on top of an already merged table. Only that
+	 * source is parsed; nothing is cached.
+	 *
+	 * @param base Merged lower sources
+	 * @param layer Source to merge on top (a missing file leaves the table as it is)
+	 */
+	static LayeredConfig Overlay(const LayeredConfig& base, const ConfigLayer& layer);
+
+	/**
+	 * @return Existence, size and write time of every source, as used for the cache.
+	 *         Changes whenever a source file is written, created or deleted.
+	 */
+	static std::string GetFingerprint(std::span<const ConfigLayer> layers);
+
+	/**
+	 * @return The merged setting, or nullptr if no source sets the key
+	 */
+	const ConfigSetting* Find(std::string_view section, std::string_view key) const;
+
+	std::string_view GetString(std::string_view section, std::string_view key, std::string_view defaultValue) const;
+	bool GetBool(std::string_view section, std::string_view key, bool defaultValue) const;
+	float GetFloat(std::string_view section, std::string_view key, float defaultValue) const;
+
+	/**
+	 * @return Distinct section names, in order of first appearance (lowest source first)
+	 */
+	const std::vector<std::string>& GetSections() const { return sections; }
+
+	/**
+	 * @return All merged settings, sorted by section then key (case-insensitive)
+	 */
+	const std::vector<ConfigSetting>& GetSettings() const { return settings; }
+
+	/**
+	 * @return Bitmask of (1 << ConfigSource) for every source file that exists
+	 */
+	std::uint32_t GetPresentSources() const { return presentSources; }
+
+	/**
+	 * @return true if the table was read from the binary cache
+	 */
+	bool IsFromCache() const { return fromCache; }
+
+private:
+	void Merge(ConfigSource source, const IniFile& ini);
+	bool ReadCache(const std::filesystem::path& path, std::string_view fingerprint);
+	void WriteCache(const std::filesystem::path& path, std::string_view fingerprint) const;
+
+	std::vector<ConfigSetting> settings;
+	std::vector<std::string> sections;
+	std::uint32_t presentSources = 0;
+	bool fromCache = false;
+};
@@ -0,0 +1,196 @@
+/**
+ * ConfigWatcher.cpp - Hot reload of the configuration files
+ *
+ * Two background threads:
+ *   - The watcher waits for directory change notifications (FileWatcher.h;
+ *     ReadDirectoryChangesW in the game) on every config directory and feeds
+ *     them to a ReloadDebouncer. The plugin INI, its _custom override and the
+ *     shadow file share a directory, the MCM settings file has its own.
+ *     MCM Helper creates Data\MCM\Settings the first time settings are
+ *     saved, so a directory that is missing (or deleted later) is polled
+ *     every kMissingDirectoryPoll and counts as changed once it appears.
+ *   - The reload worker parses, validates and publishes (ReloadConfiguration)
+ *     once the changes have been quiet for kReloadDebounce. The watcher keeps
+ *     re-arming and debouncing meanwhile; changes that arrive during a reload
+ *     lead to exactly one more reload after it. The worker also retries
+ *     freeing replaced snapshots that an AllowComment call was still reading,
+ *     every kCollectRetry.
+ * The game's threads only ever see the snapshot pointer swap.
+ */
+
+#include "PCH.h"
+#include "ConfigWatcher.h"
+#include "Config.h"
+#include "FileWatcher.h"
+#include "ReloadDebouncer.h"
+
+#include <condition_variable>
+
+namespace
+{
+	inline constexpr auto kReloadDebounce = std::chrono::milliseconds(250);       // Quiet time before reloading
+	inline constexpr auto kCollectRetry = std::chrono::seconds(1);                // Retry freeing snapshots still being read
+	inline constexpr auto kMissingDirectoryPoll = std::chrono::seconds(2);        // Retry watching directories that do not exist
+	inline constexpr std::array kConfigFiles = { kConfigFile, kMCMConfigFile, kOverrideConfigFile, kShadowConfigFile };
+
+	using Clock = ReloadDebouncer::Clock;
+
+	/**
+	 * Runs reloads off the watcher thread. Requests made while a reload runs
+	 * are merged into one more reload after it.
+	 */
+	class ReloadWorker
+	{
+	public:
+		void Request()
+		{
+			{
+				std::lock_guard lock(mutex);
+				requested = true;
+			}
+			wake.notify_one();
+		}
+
+		/**
+		 * Thread body. Runs until the game exits.
+		 */
+		void Run()
+		{
+			bool retiredPending = false;
+			for (;;) {
+				{
+					std::unique_lock lock(mutex);
+					if (retiredPending) {
+						wake.wait_for(lock, kCollectRetry, [&] { return requested; });
+					} else {
+						wake.wait(lock, [&] { return requested; });
+					}
+					if (!std::exchange(requested, false)) {
+						lock.unlock();
+						retiredPending = CollectRetiredConfigs() != 0;
+						continue;
+					}
+				}
+
+				ReloadConfiguration();
+				retiredPending = CollectRetiredConfigs() != 0;
+			}
+		}
+
+	private:
+		std::mutex mutex;
+		std::condition_variable wake;
+		bool requested = false;
+	};
+
+	ReloadWorker g_reloadWorker;
+
+	/**
+	 * Tries to watch the directories that were missing.
+	 */
+	void WatchMissingDirectories(FileWatcher& watcher, ReloadDebouncer& debouncer, std::vector<std::string>& missing)
+	{
+		std::erase_if(missing, [&](const std::string& directory) {
+			std::string error;
+			if (!watcher.Watch(directory, error)) {
+				return false;
+			}
+			logger::info("Config watcher: {} appeared - now watched", directory);
+			debouncer.OnDirectoryAppeared(directory, Clock::now());
+			return true;
+		});
+	}
+
+	/**
+	 * Watcher thread body. Runs until waiting for notifications fails.
+	 */
+	void WatchConfigFiles(std::unique_ptr<FileWatcher> watcher, std::vector<std::string> missing)
+	{
+		ReloadDebouncer debouncer(kConfigFiles, kReloadDebounce);
+		std::vector<FileChange> changes;
+		Clock::time_point nextPoll = Clock::now() + kMissingDirectoryPoll;
+
+		for (;;) {
+			std::optional<Clock::time_point> wakeAt = debouncer.GetDeadline();
+			if (!missing.empty()) {
+				wakeAt = wakeAt ? std::min(*wakeAt, nextPoll) : nextPoll;
+			}
+			auto timeout = FileWatcher::kWaitForever;
+			if (wakeAt) {
+				const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(*wakeAt - Clock::now());
+				timeout = std::max(remaining, std::chrono::milliseconds(0));
+			}
+
+			changes.clear();
+			std::string error;
+			if (watcher->Wait(timeout, changes, error) == FileWatchResult::Failed) {
+				logger::error("Config watcher stopped: {}", error);
+				return;
+			}
+
+			// Every change to a config file restarts the quiet period, so a burst of writes reloads once
+			const auto now = Clock::now();
+			for (const auto& change : changes) {
+				debouncer.OnChange(change, now);
+				if (change.kind == FileChangeKind::DirectoryLost) {
+					logger::warn("Config watcher: {} was removed - watching for it to reappear", change.directory);
+					missing.push_back(change.directory);
+				}
+			}
+
+			if (!missing.empty() && now >= nextPoll) {
+				WatchMissingDirectories(*watcher, debouncer, missing);
+				nextPoll = now + kMissingDirectoryPoll;
+			}
+
+			if (const std::uint32_t changed = debouncer.TakeDue(Clock::now())) {
+				for (std::size_t i = 0; i < kConfigFiles.size(); ++i) {
+					if (changed & (1u << i)) {
+						logger::info("Config watcher: {} changed", kConfigFiles[i]);
+					}
+				}
+				g_reloadWorker.Request();
+			}
+		}
+	}
+}
+
+bool StartConfigWatcher()
+{
+	logger::info("Starting config watcher...");
+
+	auto watcher = CreateFileWatcher();
+	if (!watcher) {
+		logger::warn("  No file watcher on this platform - hot reload disabled");
+		return false;
+	}
+
+	const ReloadDebouncer layout(kConfigFiles, kReloadDebounce);
+	std::vector<std::string> missing;
+	for (const auto& directory : layout.GetDirectories()) {
+		std::string error;
+		if (watcher->Watch(directory, error)) {
+			logger::info("  Watching {}", directory);
+		} else {
+			logger::info("  {} not watched ({}) - checked every {} s until it exists", directory, error, kMissingDirectoryPoll.count());
+			missing.push_back(directory);
+		}
+	}
+
+	if (missing.size() == layout.GetDirectories().size()) {
+		logger::warn("  No config directory could be watched - hot reload disabled");
+		return false;
+	}
+
+	// Parsing competes with nothing important, keep both threads away from the render/AI threads
+	std::thread worker([] { g_reloadWorker.Run(); });
+	SetThreadPriority(worker.native_handle(), THREAD_PRIORITY_BELOW_NORMAL);
+	worker.detach();
+
+	std::thread watcherThread(WatchConfigFiles, std::move(watcher), std::move(missing));
+	SetThreadPriority(watcherThread.native_handle(), THREAD_PRIORITY_BELOW_NORMAL);
+	watcherThread.detach();
+
+	logger::info("  Hot reload enabled (changes apply {} ms after the last write)", kReloadDebounce.count());
+	return true;
+}
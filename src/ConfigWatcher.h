@@ -0,0 +1,12 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * Starts the background threads that watch the config files (INI, MCM
+ * settings, _custom override and shadow file) and call ReloadConfiguration()
+ * once a burst of changes has settled. The threads live until the game exits.
+ *
+ * @return true if at least one config directory is being watched
+ */
+bool StartConfigWatcher();
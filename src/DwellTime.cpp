@@ -0,0 +1,32 @@
+/**
+ * DwellTime.cpp - Gaze dwell time, game side
+ *
+ * Supplies the clock (StageClock.h) and the actor's FormID to the shared DwellTracker
+ * (DwellTime.h). Called from AllowComment on the AI threads; the tracker is
+ * lock-free.
+ */
+
+#include "PCH.h"
+#include "DwellTime.h"
+#include "StageClock.h"
+#include "WorldEvents.h"
+
+namespace
+{
+	DwellTracker g_dwellTracker;  // 32 KB, shared by all AI threads
+	WorldGenerationWatch g_dwellWorld;  // A teleport or load ends every gaze
+}
+
+bool HasDwelled(RE::Character* npc, std::uint32_t dwellMilliseconds)
+{
+	if (g_dwellWorld.Changed()) {
+		g_dwellTracker.Clear();
+	}
+
+	return g_dwellTracker.Facing(npc->GetFormID(), GetStageMilliseconds(), dwellMilliseconds);
+}
+
+void ResetDwell(RE::Character* npc)
+{
+	g_dwellTracker.NotFacing(npc->GetFormID(), GetStageMilliseconds());
+}
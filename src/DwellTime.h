@@ -0,0 +1,175 @@
+#pragma once
+
+// Game-independent (also built by tests/) - standard headers only, no PCH.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace RE
+{
+	class Character;
+}
+
+/**
+ * Gaze dwell time (fDwellTime).
+ *
+ * An NPC that passes the filter may only comment once it has kept passing it
+ * for the dwell time, so sweeping the camera past a crowd no longer triggers
+ * greetings. The filter only runs when an NPC tries to comment, so "kept
+ * passing" means consecutive facing checks no more than kDwellGapTicks apart;
+ * a failed facing check, or a longer gap, starts the dwell over.
+ *
+ * Per-actor state lives in a fixed open-addressing table of 64-bit words:
+ *   bits  0-31  actor reference FormID (0 = empty slot)
+ *   bits 32-51  time of the last facing check, in 4 ms ticks modulo 2^20 (~70 min)
+ *   bits 52-63  dwell accumulated up to that check, in 4 ms ticks (saturates at ~16 s)
+ * A new entry claims its slot with a CAS; the owning actor then updates it
+ * with a plain store (two threads checking the same NPC at once lose at most
+ * a few ms of dwell). Entries expire lazily: an entry whose last check is
+ * older than the gap is treated as empty, by its own actor and by any other
+ * actor probing through it. Nothing is allocated after startup.
+ *
+ * Gaps are taken modulo the timestamp range, so an actor faced again exactly
+ * one wrap after its last check would continue its old dwell. The first
+ * check in each wrap period of the full clock clears the table instead.
+ *
+ * DwellTracker never calls into the game (time is passed in), so it can be
+ * driven with synthetic timestamps outside of Skyrim.
+ */
+
+inline constexpr std::uint64_t kDwellTickMilliseconds = 4;
+inline constexpr std::uint32_t kDwellGapTicks = 250;        // 1 s between facing checks continues a dwell
+inline constexpr std::uint32_t kMaxDwellMilliseconds = 10000;  // fDwellTime limit, below the 12-bit saturation
+
+class DwellTracker
+{
+public:
+	static constexpr std::size_t kTableSize = 0x1000;  // 4096 slots (power of two)
+	static constexpr std::size_t kMaxProbe = 16;       // Slots searched per actor
+
+	/**
+	 * Records a check the actor passed and tests its dwell.
+	 *
+	 * @param actorID NPC reference FormID (non-zero)
+	 * @param nowMilliseconds Monotonic time
+	 * @param dwellMilliseconds Required dwell (fDwellTime)
+	 * @return true once the actor has passed for at least the dwell time
+	 */
+	bool Facing(std::uint32_t actorID, std::uint64_t nowMilliseconds, std::uint32_t dwellMilliseconds)
+	{
+		const std::uint64_t ticks = nowMilliseconds / kDwellTickMilliseconds;
+		const std::uint64_t now = ticks & kTimeMask;
+
+		// A new wrap period: forget entries whose gap could alias
+		std::uint64_t seenPeriod = period.load(std::memory_order_relaxed);
+		if (seenPeriod != ticks >> kTimeBits && period.compare_exchange_strong(seenPeriod, ticks >> kTimeBits, std::memory_order_relaxed)) {
+			Clear();
+		}
+
+		std::size_t slot = HashActor(actorID);
+		std::size_t freeSlot = kTableSize;
+		std::uint64_t freeEntry = 0;
+
+		for (std::size_t probe = 0; probe < kMaxProbe; ++probe, slot = (slot + 1) & (kTableSize - 1)) {
+			std::uint64_t entry = table[slot].load(std::memory_order_relaxed);
+			const std::uint64_t gap = (now - (entry >> kTimeShift)) & kTimeMask;
+
+			if (static_cast<std::uint32_t>(entry) == actorID) {
+				// Continue the dwell, or start over after a gap. Repeat checks within
+				// one tick change nothing and skip the store.
+				const std::uint64_t dwell = gap <= kDwellGapTicks ? std::min((entry >> kDwellShift) + gap, kMaxDwell) : 0;
+				if (gap != 0) {
+					table[slot].store(MakeEntry(actorID, now, dwell), std::memory_order_relaxed);
+				}
+				return dwell * kDwellTickMilliseconds >= dwellMilliseconds;
+			}
+
+			if (freeSlot == kTableSize && (entry == 0 || gap > kDwellGapTicks)) {
+				freeSlot = slot;
+				freeEntry = entry;
+			}
+			if (entry == 0) {
+				break;
+			}
+		}
+
+		// First facing check - the dwell starts now
+		if (freeSlot != kTableSize) {
+			table[freeSlot].compare_exchange_strong(freeEntry, MakeEntry(actorID, now, 0), std::memory_order_relaxed);
+		}
+		return dwellMilliseconds == 0;
+	}
+
+	/**
+	 * Records a facing check the actor failed: its dwell starts over.
+	 * Expires the actor's entry rather than removing it, so probe sequences
+	 * through the slot stay intact.
+	 */
+	void NotFacing(std::uint32_t actorID, std::uint64_t nowMilliseconds)
+	{
+		const std::uint64_t now = (nowMilliseconds / kDwellTickMilliseconds) & kTimeMask;
+
+		std::size_t slot = HashActor(actorID);
+		for (std::size_t probe = 0; probe < kMaxProbe; ++probe, slot = (slot + 1) & (kTableSize - 1)) {
+			std::uint64_t entry = table[slot].load(std::memory_order_relaxed);
+			if (static_cast<std::uint32_t>(entry) == actorID) {
+				const std::uint64_t expired = (now - kDwellGapTicks - 1) & kTimeMask;
+				if (((now - (entry >> kTimeShift)) & kTimeMask) <= kDwellGapTicks) {
+					table[slot].compare_exchange_strong(entry, MakeEntry(actorID, expired, 0), std::memory_order_relaxed);
+				}
+				return;
+			}
+			if (entry == 0) {
+				return;
+			}
+		}
+	}
+
+	/**
+	 * Forgets all actors (after a world change, see WorldEvents.h).
+	 */
+	void Clear()
+	{
+		for (auto& slot : table) {
+			slot.store(0, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	static constexpr int kTimeShift = 32;
+	static constexpr int kDwellShift = 52;
+	static constexpr int kTimeBits = 20;
+	static constexpr std::uint64_t kTimeMask = (1ull << kTimeBits) - 1;
+	static constexpr std::uint64_t kMaxDwell = (1ull << 12) - 1;
+	static_assert(kMaxDwellMilliseconds / kDwellTickMilliseconds < kMaxDwell, "fDwellTime limit must not reach the saturated dwell");
+
+	static std::size_t HashActor(std::uint32_t actorID)
+	{
+		return (actorID * 0x9E3779B1u) >> (32 - 12);
+	}
+	static_assert(kTableSize == (1u << 12), "HashActor shift must match table size");
+
+	static std::uint64_t MakeEntry(std::uint32_t actorID, std::uint64_t time, std::uint64_t dwell)
+	{
+		return static_cast<std::uint64_t>(actorID) | (time << kTimeShift) | (dwell << kDwellShift);
+	}
+
+	std::array<std::atomic<std::uint64_t>, kTableSize> table{};
+	std::atomic<std::uint64_t> period{ 0 };  // Full clock's wrap period the table's timestamps belong to
+};
+
+/**
+ * Game adapter: applies fDwellTime to a check the filter allowed.
+ *
+ * @param npc NPC that wants to comment
+ * @param dwellMilliseconds Required dwell (non-zero)
+ * @return true if the NPC has been faced long enough
+ */
+bool HasDwelled(RE::Character* npc, std::uint32_t dwellMilliseconds);
+
+/**
+ * Game adapter: restarts the NPC's dwell after a failed facing check.
+ */
+void ResetDwell(RE::Character* npc);
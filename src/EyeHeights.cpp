@@ -0,0 +1,33 @@
+/**
+ * EyeHeights.cpp - Eye heights by race, game side
+ *
+ * Reads the race's height and the actor's sex for the shared RaceEyeHeights
+ * cache (EyeHeights.h). Called from AllowComment on the AI threads; race
+ * records are immutable once game data is loaded.
+ */
+
+#include "PCH.h"
+#include "EyeHeights.h"
+
+namespace
+{
+	RaceEyeHeights g_eyeHeights;  // 2 KB, shared by all AI threads
+}
+
+float GetEyeHeight(RE::Actor* actor)
+{
+	const auto race = actor->GetRace();
+	if (!race) {
+		return kBaseEyeHeight;
+	}
+
+	const auto base = actor->GetActorBase();
+	const bool female = base && base->GetSex() == RE::SEX::kFemale;
+
+	return g_eyeHeights.Get(race->GetFormID(), female, [race] {
+		return RaceEyeHeight{
+			kBaseEyeHeight * race->data.height[RE::SEX::kMale],
+			kBaseEyeHeight * race->data.height[RE::SEX::kFemale]
+		};
+	});
+}
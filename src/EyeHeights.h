@@ -0,0 +1,115 @@
+#pragma once
+
+// Game-independent (also built by tests/) - standard headers only, no PCH.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace RE
+{
+	class Actor;
+}
+
+/**
+ * Eye heights by race (b3DViewCone).
+ *
+ * The 3D view cone runs from the player's eyes to the NPC's head, so both
+ * need a height above the actor's position. It is taken from the race record:
+ * kBaseEyeHeight scaled by the race's male or female height, the same factor
+ * the game scales the skeleton by. Reading the race record on every call
+ * would chase several pointers, so each race's two heights are cached in a
+ * small open-addressing table of 64-bit words:
+ *   bits  0-31  race FormID (0 = empty slot)
+ *   bits 32-47  male eye height, 1/8 game units
+ *   bits 48-63  female eye height, 1/8 game units
+ * Races never change once game data is loaded, so entries are written once
+ * (CAS into an empty slot) and never expire. Per-reference scale is ignored.
+ *
+ * RaceEyeHeights never calls into the game; the race heights come from a
+ * callable that only runs on a cache miss.
+ */
+
+inline constexpr float kBaseEyeHeight = 120.0f;  // Eye height of a height 1.0 humanoid, game units
+
+/**
+ * Eye heights of one race.
+ */
+struct RaceEyeHeight
+{
+	float male;
+	float female;
+};
+
+class RaceEyeHeights
+{
+public:
+	static constexpr std::size_t kTableSize = 0x100;  // 256 slots (power of two), far more than there are races
+	static constexpr std::size_t kMaxProbe = 16;      // Slots searched per race
+
+	/**
+	 * Gets a race's eye height, computing and caching it on first use.
+	 *
+	 * @param raceID Race FormID (non-zero)
+	 * @param female Use the female height
+	 * @param compute Callable returning the race's RaceEyeHeight (cache misses only)
+	 * @return Eye height in game units
+	 */
+	template <class Compute>
+	float Get(std::uint32_t raceID, bool female, Compute&& compute)
+	{
+		std::size_t slot = HashRace(raceID);
+		for (std::size_t probe = 0; probe < kMaxProbe; ++probe, slot = (slot + 1) & (kTableSize - 1)) {
+			std::uint64_t entry = table[slot].load(std::memory_order_relaxed);
+			if (static_cast<std::uint32_t>(entry) == raceID) {
+				return Decode(entry, female);
+			}
+			if (entry == 0) {
+				const RaceEyeHeight heights = compute();
+				const std::uint64_t updated = static_cast<std::uint64_t>(raceID) |
+				                              (static_cast<std::uint64_t>(Encode(heights.male)) << kMaleShift) |
+				                              (static_cast<std::uint64_t>(Encode(heights.female)) << kFemaleShift);
+				// Losing the CAS to the same race is fine; losing it to another one leaves this race uncached until next time
+				table[slot].compare_exchange_strong(entry, updated, std::memory_order_relaxed);
+				return Decode(updated, female);
+			}
+		}
+
+		// Probe window full: answer without caching
+		const RaceEyeHeight heights = compute();
+		return female ? heights.female : heights.male;
+	}
+
+private:
+	static constexpr int kMaleShift = 32;
+	static constexpr int kFemaleShift = 48;
+	static constexpr float kUnitsPerStep = 0.125f;
+
+	static std::size_t HashRace(std::uint32_t raceID)
+	{
+		return (raceID * 0x9E3779B1u) >> (32 - 8);
+	}
+	static_assert(kTableSize == (1u << 8), "HashRace shift must match table size");
+
+	static std::uint16_t Encode(float height)
+	{
+		return static_cast<std::uint16_t>(std::clamp(height / kUnitsPerStep + 0.5f, 0.0f, 65535.0f));
+	}
+
+	static float Decode(std::uint64_t entry, bool female)
+	{
+		return static_cast<float>((entry >> (female ? kFemaleShift : kMaleShift)) & 0xFFFF) * kUnitsPerStep;
+	}
+
+	std::array<std::atomic<std::uint64_t>, kTableSize> table{};
+};
+
+/**
+ * Game adapter: eye (or head) height of an actor above its position, from its
+ * race and sex through the shared cache.
+ *
+ * @param actor NPC or the player
+ * @return Height in game units (kBaseEyeHeight without a race)
+ */
+float GetEyeHeight(RE::Actor* actor);
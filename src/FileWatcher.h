@@ -0,0 +1,70 @@
+#pragma once
+
+// Game-independent (also built by tests/) - standard headers only, no PCH.
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * FileWatcher.h - Directory change notifications
+ *
+ * The platform layer of the config watcher (ConfigWatcher.cpp). Backends:
+ *   FileWatcherWin32.cpp   - overlapped ReadDirectoryChangesW (the plugin)
+ *   FileWatcherInotify.cpp - inotify (Linux; tests/FileWatcherTest)
+ * Directories are watched non-recursively. What a change means is decided by
+ * the caller (ReloadDebouncer.h); the backends only report names.
+ */
+
+enum class FileChangeKind : std::uint8_t
+{
+	Modified,       // A file in the directory was created, written, renamed or deleted
+	Overflow,       // Notifications were dropped - anything in the directory may have changed
+	DirectoryLost   // The directory was deleted or moved; it is no longer watched
+};
+
+struct FileChange
+{
+	FileChangeKind kind;
+	std::string directory;  // As passed to Watch()
+	std::string name;       // File name relative to the directory (UTF-8), empty unless Modified
+};
+
+enum class FileWatchResult : std::uint8_t
+{
+	Changes,  // At least one change was appended
+	Timeout,  // Nothing happened before the timeout
+	Failed    // The wait itself failed; the watcher is unusable (see error)
+};
+
+class FileWatcher
+{
+public:
+	static constexpr auto kWaitForever = std::chrono::milliseconds::max();
+
+	virtual ~FileWatcher() = default;
+
+	/**
+	 * Starts watching a directory.
+	 *
+	 * @param directory Directory path (relative paths are relative to the working directory)
+	 * @param error Receives the reason on failure
+	 * @return false if the directory does not exist or cannot be watched
+	 */
+	virtual bool Watch(const std::string& directory, std::string& error) = 0;
+
+	/**
+	 * Waits for changes in any watched directory.
+	 *
+	 * @param timeout Longest wait, or kWaitForever
+	 * @param changes Receives the changes (appended)
+	 * @param error Receives the reason if the result is Failed
+	 */
+	virtual FileWatchResult Wait(std::chrono::milliseconds timeout, std::vector<FileChange>& changes, std::string& error) = 0;
+};
+
+/**
+ * @return The backend for this platform, or nullptr if there is none
+ */
+std::unique_ptr<FileWatcher> CreateFileWatcher();
@@ -0,0 +1,134 @@
+/**
+ * FileWatcherInotify.cpp - FileWatcher backend for Linux (inotify)
+ *
+ * Stands in for ReadDirectoryChangesW where the plugin itself does not run,
+ * so the config watcher's logic can be tested with real file operations.
+ * Reports the same events: names created, written, renamed or deleted in a
+ * watched directory, queue overflows, and the directory itself going away.
+ *
+ * Game-independent (also built by tests/) - standard headers only, no PCH.
+ */
+
+#include "FileWatcher.h"
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unordered_map>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace
+{
+	constexpr std::uint32_t kWatchMask = IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO |
+	                                     IN_DELETE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+	class InotifyWatcher final : public FileWatcher
+	{
+	public:
+		InotifyWatcher() : fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {}
+
+		~InotifyWatcher() override
+		{
+			if (fd >= 0) {
+				close(fd);
+			}
+		}
+
+		bool Watch(const std::string& directory, std::string& error) override
+		{
+			if (fd < 0) {
+				error = "inotify_init1 failed";
+				return false;
+			}
+
+			const int wd = inotify_add_watch(fd, directory.c_str(), kWatchMask);
+			if (wd < 0) {
+				error = std::strerror(errno);
+				return false;
+			}
+			directories[wd] = directory;
+			return true;
+		}
+
+		FileWatchResult Wait(std::chrono::milliseconds timeout, std::vector<FileChange>& changes, std::string& error) override
+		{
+			pollfd request{ fd, POLLIN, 0 };
+			const int wait = timeout == kWaitForever ? -1 : static_cast<int>(std::min<long long>(timeout.count(), 0x7FFFFFFF));
+			const int ready = poll(&request, 1, wait);
+			if (ready < 0) {
+				if (errno == EINTR) {
+					return FileWatchResult::Timeout;
+				}
+				error = std::strerror(errno);
+				return FileWatchResult::Failed;
+			}
+			if (ready == 0) {
+				return FileWatchResult::Timeout;
+			}
+
+			const std::size_t before = changes.size();
+			for (;;) {
+				const ssize_t bytes = read(fd, buffer, sizeof(buffer));
+				if (bytes <= 0) {
+					break;  // EAGAIN: drained
+				}
+				for (const char* entry = buffer; entry < buffer + bytes;) {
+					const auto* event = reinterpret_cast<const inotify_event*>(entry);
+					Translate(*event, changes);
+					entry += sizeof(inotify_event) + event->len;
+				}
+			}
+			return changes.size() != before ? FileWatchResult::Changes : FileWatchResult::Timeout;
+		}
+
+	private:
+		void Translate(const inotify_event& event, std::vector<FileChange>& changes)
+		{
+			if (event.mask & IN_Q_OVERFLOW) {
+				for (const auto& [wd, directory] : directories) {
+					changes.push_back({ FileChangeKind::Overflow, directory, {} });
+				}
+				return;
+			}
+
+			const auto watched = directories.find(event.wd);
+			if (watched == directories.end()) {
+				return;  // Already reported lost
+			}
+
+			if (event.mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+				changes.push_back({ FileChangeKind::DirectoryLost, watched->second, {} });
+				inotify_rm_watch(fd, event.wd);
+				directories.erase(watched);
+				return;
+			}
+
+			if (event.len) {
+				changes.push_back({ FileChangeKind::Modified, watched->second, std::string(event.name) });
+			}
+		}
+
+		int fd;
+		std::unordered_map<int, std::string> directories;
+		alignas(inotify_event) char buffer[16 * 1024];
+	};
+}
+
+std::unique_ptr<FileWatcher> CreateFileWatcher()
+{
+	return std::make_unique<InotifyWatcher>();
+}
+
+#elif !defined(_WIN32)
+
+std::unique_ptr<FileWatcher> CreateFileWatcher()
+{
+	return nullptr;  // No backend for this platform
+}
+
+#endif
@@ -0,0 +1,184 @@
+/**
+ * FileWatcherWin32.cpp - FileWatcher backend for Windows (ReadDirectoryChangesW)
+ *
+ * Keeps an overlapped ReadDirectoryChangesW call pending on each watched
+ * directory and sleeps in WaitForMultipleObjects. A completed call is parsed
+ * into FileChanges and re-queued right away, so nothing is missed while the
+ * caller handles the changes. A completion with no data means the buffer
+ * overflowed (reported as Overflow); a read that cannot be re-queued means
+ * the directory is gone (DirectoryLost).
+ *
+ * Game-independent - Windows and standard headers only, no PCH.
+ */
+
+#include "FileWatcher.h"
+
+#ifdef _WIN32
+
+#include <algorithm>
+#include <string_view>
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+
+namespace
+{
+	/**
+	 * One watched directory with its pending change notification.
+	 * Not movable - the OVERLAPPED and buffer are in use by the kernel.
+	 */
+	struct WatchedDirectory
+	{
+		std::string path;
+		HANDLE directory = INVALID_HANDLE_VALUE;
+		OVERLAPPED overlapped{};
+		bool pending = false;  // A read is queued - the kernel owns overlapped and buffer
+		alignas(DWORD) std::byte buffer[16 * 1024];
+
+		~WatchedDirectory()
+		{
+			if (pending) {
+				CancelIoEx(directory, &overlapped);
+				DWORD bytes = 0;
+				GetOverlappedResult(directory, &overlapped, &bytes, TRUE);  // Wait until the kernel lets go of the buffer
+			}
+			if (directory != INVALID_HANDLE_VALUE) {
+				CloseHandle(directory);
+			}
+			if (overlapped.hEvent) {
+				CloseHandle(overlapped.hEvent);
+			}
+		}
+
+		/**
+		 * Queues the next change notification.
+		 */
+		bool QueueRead()
+		{
+			ResetEvent(overlapped.hEvent);
+			pending = ReadDirectoryChangesW(directory, buffer, sizeof(buffer), FALSE,
+				FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+				nullptr, &overlapped, nullptr) != FALSE;
+			return pending;
+		}
+	};
+
+	std::string GetErrorText(DWORD error)
+	{
+		return "error " + std::to_string(error);
+	}
+
+	std::string ToUtf8(std::wstring_view name)
+	{
+		const int size = WideCharToMultiByte(CP_UTF8, 0, name.data(), static_cast<int>(name.size()), nullptr, 0, nullptr, nullptr);
+		std::string result(static_cast<std::size_t>(std::max(size, 0)), '\0');
+		WideCharToMultiByte(CP_UTF8, 0, name.data(), static_cast<int>(name.size()), result.data(), size, nullptr, nullptr);
+		return result;
+	}
+
+	class Win32Watcher final : public FileWatcher
+	{
+	public:
+		bool Watch(const std::string& path, std::string& error) override
+		{
+			if (directories.size() >= MAXIMUM_WAIT_OBJECTS) {
+				error = "too many watched directories";
+				return false;
+			}
+
+			auto watched = std::make_unique<WatchedDirectory>();
+			watched->path = path;
+			watched->directory = CreateFileA(path.c_str(), FILE_LIST_DIRECTORY,
+				FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+				FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+			if (watched->directory == INVALID_HANDLE_VALUE) {
+				error = GetErrorText(GetLastError());
+				return false;
+			}
+
+			watched->overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+			if (!watched->overlapped.hEvent || !watched->QueueRead()) {
+				error = GetErrorText(GetLastError());
+				return false;
+			}
+
+			directories.push_back(std::move(watched));
+			return true;
+		}
+
+		FileWatchResult Wait(std::chrono::milliseconds timeout, std::vector<FileChange>& changes, std::string& error) override
+		{
+			std::vector<HANDLE> events;
+			for (const auto& watched : directories) {
+				events.push_back(watched->overlapped.hEvent);
+			}
+
+			const DWORD wait = timeout == kWaitForever ? INFINITE : static_cast<DWORD>(std::min<long long>(timeout.count(), INFINITE - 1));
+			if (events.empty()) {
+				Sleep(wait);
+				return FileWatchResult::Timeout;
+			}
+
+			const DWORD result = WaitForMultipleObjects(static_cast<DWORD>(events.size()), events.data(), FALSE, wait);
+			if (result == WAIT_TIMEOUT) {
+				return FileWatchResult::Timeout;
+			}
+			if (result < WAIT_OBJECT_0 || result >= WAIT_OBJECT_0 + events.size()) {
+				error = "wait failed (" + GetErrorText(GetLastError()) + ")";
+				return FileWatchResult::Failed;
+			}
+
+			const std::size_t index = result - WAIT_OBJECT_0;
+			WatchedDirectory& watched = *directories[index];
+
+			DWORD bytes = 0;
+			watched.pending = false;
+			if (GetOverlappedResult(watched.directory, &watched.overlapped, &bytes, FALSE) == FALSE) {
+				changes.push_back({ FileChangeKind::Overflow, watched.path, {} });
+			} else {
+				Translate(watched, bytes, changes);
+			}
+
+			if (!watched.QueueRead()) {
+				changes.push_back({ FileChangeKind::DirectoryLost, watched.path, {} });
+				directories.erase(directories.begin() + static_cast<std::ptrdiff_t>(index));
+			}
+			return FileWatchResult::Changes;
+		}
+
+	private:
+		/**
+		 * @param bytes Size of the completed notification (0 = the buffer overflowed)
+		 */
+		static void Translate(const WatchedDirectory& watched, DWORD bytes, std::vector<FileChange>& changes)
+		{
+			if (bytes == 0) {
+				changes.push_back({ FileChangeKind::Overflow, watched.path, {} });
+				return;
+			}
+
+			const std::byte* entry = watched.buffer;
+			for (;;) {
+				const auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(entry);
+				const std::wstring_view name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+				changes.push_back({ FileChangeKind::Modified, watched.path, ToUtf8(name) });
+
+				if (info->NextEntryOffset == 0) {
+					return;
+				}
+				entry += info->NextEntryOffset;
+			}
+		}
+
+		std::vector<std::unique_ptr<WatchedDirectory>> directories;
+	};
+}
+
+std::unique_ptr<FileWatcher> CreateFileWatcher()
+{
+	return std::make_unique<Win32Watcher>();
+}
+
+#endif
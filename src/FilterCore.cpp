@@ -0,0 +1,539 @@
+/**
+ * FilterCore.cpp - Comment decision, independent of the game
+ *
+ * The geometry and the per-mode logic that AllowComment applies, working only
+ * on a CommentQuery. No game objects are touched here, so the same code runs
+ * in the game and against synthetic queries, and a given query always gives
+ * the same decision. Built without the PCH, so tests/ can compile it as is.
+ */
+
+#include "FilterCore.h"
+#include "FilterExpression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <optional>
+
+#include <immintrin.h>  // SSE frustum test
+
+namespace
+{
+	/**
+	 * Calculates how far the NPC is from the player's facing direction.
+	 *
+	 * @param yaw Player yaw in radians
+	 * @param dx Delta X between NPC and player
+	 * @param dy Delta Y between NPC and player
+	 * @return Deviation in radians, 0 (straight ahead) to pi (directly behind)
+	 */
+	inline float GetFacingDeviation(float yaw, float dx, float dy)
+	{
+		// Calculate angle from player to NPC
+		float angle = std::atan2(dx, dy);  // x,y: clockwise; 0 at the top
+		if (angle < 0.0f) {
+			angle += pi * 2.0f;
+		}
+
+		// Calculate deviation from player's facing direction
+		float deviation = std::fabs(angle - yaw);
+		if (deviation > pi) {
+			deviation = 2.0f * pi - deviation;
+		}
+
+		return deviation;
+	}
+
+	/**
+	 * Checks if the player is facing toward an NPC within the allowed deviation angle.
+	 *
+	 * Equivalent to the original atan2 test (deviation < maxDeviationAngle) because
+	 * cos is strictly decreasing on [0, pi]: deviation < max  <=>  cos(deviation) > cos(max),
+	 * and cos(deviation) = dot(forward, delta) / |delta|. Multiplying through by |delta|
+	 * leaves one dot product, one sqrt and a compare against the precomputed cosine.
+	 *
+	 * The delta is three-dimensional: with b3DViewCone it runs from the player's
+	 * eyes to the NPC's head (viewDz) and forward includes the pitch, making the
+	 * test a cone. The flat test is the case forwardZ = viewDz = 0, where the
+	 * extra terms add exactly zero, so both share this code and cost the same.
+	 *
+	 * @param query Player forward vector and NPC deltas
+	 * @param thresholds Thresholds of the NPC's category
+	 * @return true if player is facing the NPC, false otherwise
+	 */
+	inline bool IsPlayerFacingNPC(const CommentQuery& query, const CategoryThresholds& thresholds)
+	{
+		const float dot = query.forwardX * query.dx + query.forwardY * query.dy + query.forwardZ * query.viewDz;
+		return dot > thresholds.cosMaxDeviation * std::sqrt(query.dx * query.dx + query.dy * query.dy + query.viewDz * query.viewDz);
+	}
+
+	/**
+	 * Evaluates the compiled sFilterExpression.
+	 * Only the variables the expression actually reads are computed.
+	 *
+	 * @return Expression result
+	 */
+	bool EvaluateFilterExpression(const FilterExpression& expression, const CommentQuery& query, float distanceSquared)
+	{
+		FilterInputs inputs{};
+
+		if (expression.Uses(FilterVariable::Distance)) {
+			inputs.values[static_cast<std::size_t>(FilterVariable::Distance)] = std::sqrt(distanceSquared);
+		}
+		if (expression.Uses(FilterVariable::Angle)) {
+			inputs.values[static_cast<std::size_t>(FilterVariable::Angle)] = GetFacingDeviation(query.yaw, query.dx, query.dy) * 180.0f / pi;
+		}
+		inputs.values[static_cast<std::size_t>(FilterVariable::Height)] = query.dz;
+		inputs.values[static_cast<std::size_t>(FilterVariable::InCombat)] = query.npcInCombat ? 1.0f : 0.0f;
+		inputs.values[static_cast<std::size_t>(FilterVariable::Sneaking)] = query.playerSneaking ? 1.0f : 0.0f;
+
+		return expression.Evaluate(inputs);
+	}
+
+	/**
+	 * Checks if the NPC is within the maximum greeting distance.
+	 *
+	 * @param distanceSquared Squared distance between NPC and player
+	 * @param thresholds Thresholds of the NPC's category
+	 * @return true if NPC is within range, false otherwise
+	 */
+	inline bool IsWithinGreetingDistance(float distanceSquared, const CategoryThresholds& thresholds)
+	{
+		return distanceSquared <= thresholds.maxGreetingDistanceSquared;
+	}
+
+	/**
+	 * Checks if the NPC is within close range (for bypass feature).
+	 *
+	 * @param distanceSquared Squared distance between NPC and player
+	 * @param thresholds Thresholds of the NPC's category
+	 * @return true if NPC is within close range, false otherwise
+	 */
+	inline bool IsWithinCloseRange(float distanceSquared, const CategoryThresholds& thresholds)
+	{
+		return distanceSquared <= thresholds.closeRangeDistanceSquared;
+	}
+
+	/**
+	 * Broad-phase reject: checks if the NPC is too far away to pass in any case.
+	 * Only active in modes where distance is a hard requirement (DistanceOnly, Both);
+	 * otherwise candidateRangeSquared is infinity and this never rejects.
+	 *
+	 * @param distanceSquared Squared distance between NPC and player
+	 * @param thresholds Thresholds of the NPC's category
+	 * @return true if the NPC can never pass the filter, false otherwise
+	 */
+	inline bool IsOutsideCandidateRange(float distanceSquared, const CategoryThresholds& thresholds)
+	{
+		return distanceSquared > thresholds.candidateRangeSquared;
+	}
+
+	// Decision table cell classification. A predicate over a cell is true, false,
+	// or unknown (nullopt) when the cell straddles its boundary.
+	using CellTest = std::optional<bool>;
+
+	inline constexpr double kCellDistanceMargin = 1e-5;  // Relative, on squared distances
+	inline constexpr double kCellAngleMargin = 1e-4;     // Radians
+
+	/**
+	 * Cell in the player's frame, already grown by the rounding margin.
+	 */
+	struct CellBounds
+	{
+		double forward[2];
+		double lateral[2];
+		double height[2];
+	};
+
+	CellTest Not(CellTest a)
+	{
+		return a ? CellTest(!*a) : std::nullopt;
+	}
+
+	CellTest And(CellTest a, CellTest b)
+	{
+		if (a == false || b == false) {
+			return false;
+		}
+		return a && b ? CellTest(true) : std::nullopt;
+	}
+
+	CellTest Or(CellTest a, CellTest b)
+	{
+		if (a == true || b == true) {
+			return true;
+		}
+		return a && b ? CellTest(false) : std::nullopt;
+	}
+
+	/**
+	 * Squared distance range along one axis of the cell.
+	 */
+	void AddSquaredRange(const double (&axis)[2], double& minimum, double& maximum)
+	{
+		const double low = axis[0] * axis[0];
+		const double high = axis[1] * axis[1];
+		minimum += (axis[0] <= 0.0 && axis[1] >= 0.0) ? 0.0 : std::min(low, high);
+		maximum += std::max(low, high);
+	}
+
+	/**
+	 * distanceSquared <= limit for every point of the cell?
+	 */
+	CellTest IsCellWithin(const CellBounds& cell, float limitSquared)
+	{
+		double minimum = 0.0;
+		double maximum = 0.0;
+		AddSquaredRange(cell.forward, minimum, maximum);
+		AddSquaredRange(cell.lateral, minimum, maximum);
+		AddSquaredRange(cell.height, minimum, maximum);
+
+		const double limit = limitSquared;
+		if (maximum <= limit * (1.0 - kCellDistanceMargin)) {
+			return true;
+		}
+		if (minimum > limit * (1.0 + kCellDistanceMargin)) {
+			return false;
+		}
+		return std::nullopt;
+	}
+
+	/**
+	 * IsPlayerFacingNPC for every point of the cell? The facing test only looks
+	 * at the XY plane, where the cell is a rectangle on the lateral >= 0 side.
+	 * Unless it contains the player, the directions it covers run between two
+	 * of its corners, so the corner angles bound the deviation.
+	 */
+	CellTest IsCellFacing(const CellBounds& cell, float cosMaxDeviation)
+	{
+		if (cell.forward[0] <= 0.0 && cell.forward[1] >= 0.0 && cell.lateral[0] <= 0.0) {
+			return std::nullopt;
+		}
+
+		double minimum = pi * 2.0;
+		double maximum = 0.0;
+		for (double forward : cell.forward) {
+			for (double lateral : cell.lateral) {
+				const double deviation = std::atan2(lateral, forward);
+				minimum = std::min(minimum, deviation);
+				maximum = std::max(maximum, deviation);
+			}
+		}
+
+		const double maxDeviation = std::acos(static_cast<double>(cosMaxDeviation));
+		if (maximum < maxDeviation - kCellAngleMargin) {
+			return true;
+		}
+		if (minimum > maxDeviation + kCellAngleMargin) {
+			return false;
+		}
+		return std::nullopt;
+	}
+
+	/**
+	 * DecideComment's logic over a whole cell.
+	 *
+	 * @return Cell code: FilterOutcome + 1, or 0 if the cell needs the exact decision
+	 */
+	std::uint8_t ClassifyCell(const FilterParameters& filter, const CategoryThresholds& thresholds, const CellBounds& cell)
+	{
+		auto code = [](FilterOutcome outcome) { return static_cast<std::uint8_t>(static_cast<std::uint8_t>(outcome) + 1); };
+		auto decide = [&](CellTest allow) -> std::uint8_t {
+			return allow ? code(*allow ? FilterOutcome::AllowFilter : FilterOutcome::BlockFilter) : 0;
+		};
+
+		const CellTest outside = Not(IsCellWithin(cell, thresholds.candidateRangeSquared));
+		if (outside != false) {
+			return outside ? code(FilterOutcome::BlockOutOfRange) : 0;
+		}
+
+		if (filter.Has(FilterFlag::CloseRangeBypass)) {
+			const CellTest bypass = IsCellWithin(cell, thresholds.closeRangeDistanceSquared);
+			if (bypass != false) {
+				return bypass ? code(FilterOutcome::AllowBypass) : 0;
+			}
+		}
+
+		switch (filter.filterMode) {
+			case FilterMode::AngleOnly:
+				return decide(IsCellFacing(cell, thresholds.cosMaxDeviation));
+			case FilterMode::DistanceOnly:
+				return decide(IsCellWithin(cell, thresholds.maxGreetingDistanceSquared));
+			case FilterMode::Both:
+				return decide(And(IsCellWithin(cell, thresholds.maxGreetingDistanceSquared), IsCellFacing(cell, thresholds.cosMaxDeviation)));
+			case FilterMode::Either:
+				return decide(Or(IsCellWithin(cell, thresholds.maxGreetingDistanceSquared), IsCellFacing(cell, thresholds.cosMaxDeviation)));
+			default:
+				return 0;
+		}
+	}
+}
+
+PlayerFacing MakePlayerFacing(float yaw, float pitch)
+{
+	const float forwardX = std::sin(yaw);
+	const float forwardY = std::cos(yaw);
+	const float horizontal = std::cos(pitch);
+	return { yaw, pitch, forwardX, forwardY, forwardX * horizontal, forwardY * horizontal, -std::sin(pitch) };
+}
+
+std::optional<PlayerFacing> MakeCameraFacing(float x, float y, float z)
+{
+	const float length = std::sqrt(x * x + y * y);
+	if (length < kMinCameraHorizontal) {
+		return std::nullopt;
+	}
+
+	// The game's yaw wraps at exactly 2pi; the mod's truncated pi would leave a
+	// camera turned left 1.85e-4 radians short of the same actor yaw
+	float yaw = std::atan2(x, y);
+	if (yaw < 0.0f) {
+		yaw += 2.0f * std::numbers::pi_v<float>;
+	}
+	return PlayerFacing{ yaw, std::asin(std::clamp(-z, -1.0f, 1.0f)), x / length, y / length, x, y, z };
+}
+
+CategoryThresholds MakeCategoryThresholds(const FilterParameters& filter, float maxDeviationAngle, float maxGreetingDistance, float closeRangeDistance)
+{
+	// A bypass radius beyond the greeting distance would let NPCs through that the distance gate rejects
+	if (filter.Has(FilterFlag::CloseRangeBypass)) {
+		closeRangeDistance = std::min(closeRangeDistance, maxGreetingDistance);
+	}
+
+	CategoryThresholds thresholds{};
+	thresholds.cosMaxDeviation = std::cos(maxDeviationAngle);
+	thresholds.maxGreetingDistanceSquared = maxGreetingDistance * maxGreetingDistance;
+	thresholds.closeRangeDistanceSquared = closeRangeDistance * closeRangeDistance;
+
+	// Broad-phase reject radius: in modes where distance is a hard requirement,
+	// anything beyond fMaxGreetingDistance is rejected before any other work.
+	if (filter.filterMode == FilterMode::DistanceOnly || filter.filterMode == FilterMode::Both) {
+		thresholds.candidateRangeSquared = thresholds.maxGreetingDistanceSquared;
+	} else {
+		thresholds.candidateRangeSquared = std::numeric_limits<float>::infinity();
+	}
+
+	return thresholds;
+}
+
+void ExtractFrustumPlanes(const float (&m)[4][4], FrustumPlanes& planes)
+{
+	// Inside <=> -w <= x <= w, -w <= y <= w, w > 0 (in front of the camera), z <= w.
+	// Each condition is a plane: row 3 plus or minus another row.
+	const float rows[6][4] = {
+		{ m[3][0] + m[0][0], m[3][1] + m[0][1], m[3][2] + m[0][2], m[3][3] + m[0][3] },  // Left
+		{ m[3][0] - m[0][0], m[3][1] - m[0][1], m[3][2] - m[0][2], m[3][3] - m[0][3] },  // Right
+		{ m[3][0] + m[1][0], m[3][1] + m[1][1], m[3][2] + m[1][2], m[3][3] + m[1][3] },  // Bottom
+		{ m[3][0] - m[1][0], m[3][1] - m[1][1], m[3][2] - m[1][2], m[3][3] - m[1][3] },  // Top
+		{ m[3][0], m[3][1], m[3][2], m[3][3] },                                          // Near (camera plane)
+		{ m[3][0] - m[2][0], m[3][1] - m[2][1], m[3][2] - m[2][2], m[3][3] - m[2][3] }   // Far
+	};
+
+	for (std::size_t i = 0; i < 8; ++i) {
+		const float length = i < 6 ? std::sqrt(rows[i][0] * rows[i][0] + rows[i][1] * rows[i][1] + rows[i][2] * rows[i][2]) : 0.0f;
+		if (length > 0.0f) {
+			planes.a[i] = rows[i][0] / length;
+			planes.b[i] = rows[i][1] / length;
+			planes.c[i] = rows[i][2] / length;
+			planes.d[i] = rows[i][3] / length;
+		} else {
+			// Padding (or a degenerate matrix row): a plane every point is inside
+			planes.a[i] = planes.b[i] = planes.c[i] = 0.0f;
+			planes.d[i] = std::numeric_limits<float>::max();
+		}
+	}
+}
+
+bool IsInFrustum(const FrustumPlanes& planes, float x, float y, float z, float radius)
+{
+	const __m128 px = _mm_set1_ps(x);
+	const __m128 py = _mm_set1_ps(y);
+	const __m128 pz = _mm_set1_ps(z);
+	const __m128 limit = _mm_set1_ps(-radius);
+
+	// Signed distances to planes 0-3 and 4-7; outside if any is beyond the radius
+	int outside = 0;
+	for (std::size_t i = 0; i < 8; i += 4) {
+		__m128 distance = _mm_mul_ps(_mm_load_ps(planes.a + i), px);
+		distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(planes.b + i), py));
+		distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(planes.c + i), pz));
+		distance = _mm_add_ps(distance, _mm_load_ps(planes.d + i));
+		outside |= _mm_movemask_ps(_mm_cmplt_ps(distance, limit));
+	}
+
+	return outside == 0;
+}
+
+CommentDecision DecideComment(const FilterParameters& filter, const CategoryThresholds& thresholds, const CommentQuery& query)
+{
+	// Calculate 3D distance squared (includes Z-axis for vertical awareness)
+	const float distanceSquared = query.dx * query.dx + query.dy * query.dy + query.dz * query.dz;
+
+	// Broad-phase reject: in crowded cells most NPCs are out of range, so drop
+	// them before the bypass check and angle math
+	if (IsOutsideCandidateRange(distanceSquared, thresholds)) {
+		return { false, FilterOutcome::BlockOutOfRange, "out of range", distanceSquared };
+	}
+
+	// Close Range Bypass: Allow all angles at very close range if enabled
+	// This prevents NPCs from being silent when standing right next to the player
+	if (filter.Has(FilterFlag::CloseRangeBypass) && IsWithinCloseRange(distanceSquared, thresholds)) {
+		return { true, FilterOutcome::AllowBypass, "close range bypass", distanceSquared };
+	}
+
+	bool result = false;
+	const char* reason = "unknown";
+
+	// Apply filters based on configured filter mode
+	switch (filter.filterMode) {
+		case FilterMode::AngleOnly:
+			// Only check angle
+			result = IsPlayerFacingNPC(query, thresholds);
+			reason = result ? "facing" : "not facing";
+			break;
+
+		case FilterMode::DistanceOnly:
+			// Only check distance, ignore angle
+			result = IsWithinGreetingDistance(distanceSquared, thresholds);
+			reason = result ? "in range" : "out of range";
+			break;
+
+		case FilterMode::Both:
+			// Require BOTH angle AND distance checks to pass
+			// Check distance first (cheap) before angle (dot product + sqrt)
+			if (!IsWithinGreetingDistance(distanceSquared, thresholds)) {
+				result = false;
+				reason = "out of range";
+			} else if (!IsPlayerFacingNPC(query, thresholds)) {
+				result = false;
+				reason = "not facing";
+			} else {
+				result = true;
+				reason = "facing AND in range";
+			}
+			break;
+
+		case FilterMode::Either:
+			// Allow if EITHER angle OR distance check passes
+			// Check distance first (cheap) before angle (dot product + sqrt)
+			if (IsWithinGreetingDistance(distanceSquared, thresholds)) {
+				result = true;
+				reason = "in range";
+			} else if (IsPlayerFacingNPC(query, thresholds)) {
+				result = true;
+				reason = "facing";
+			} else {
+				result = false;
+				reason = "not facing AND out of range";
+			}
+			break;
+
+		case FilterMode::Frustum:
+			// On screen: the NPC's head inside the camera frustum. Without a camera
+			// (loading, menus) behave like AngleOnly.
+			if (query.frustum) {
+				result = IsInFrustum(*query.frustum, query.headX, query.headY, query.headZ, kFrustumHeadRadius);
+				reason = result ? "on screen" : "off screen";
+			} else {
+				result = IsPlayerFacingNPC(query, thresholds);
+				reason = result ? "facing (no camera)" : "not facing (no camera)";
+			}
+			break;
+
+		case FilterMode::Expression:
+			// Custom expression from sFilterExpression
+			result = EvaluateFilterExpression(*filter.filterExpression, query, distanceSquared);
+			reason = result ? "expression true" : "expression false";
+			break;
+
+		default:
+			// Fallback to angle-only mode for safety
+			result = IsPlayerFacingNPC(query, thresholds);
+			reason = result ? "facing (fallback)" : "not facing (fallback)";
+			break;
+	}
+
+	return { result, result ? FilterOutcome::AllowFilter : FilterOutcome::BlockFilter, reason, distanceSquared };
+}
+
+bool SupportsDecisionTable(FilterMode mode)
+{
+	return mode == FilterMode::AngleOnly || mode == FilterMode::DistanceOnly ||
+	       mode == FilterMode::Both || mode == FilterMode::Either;
+}
+
+std::size_t BuildDecisionTable(const FilterParameters& filter, const CategoryThresholds& thresholds, DecisionTable& table)
+{
+	table.cells.fill(0);
+	table.range = 0.0f;
+	table.inverseCellSize = 0.0f;
+
+	// Distance only matters up to the greeting distance (the bypass radius is
+	// clamped to it); an empty table sends everything to DecideComment
+	const float range = std::sqrt(thresholds.maxGreetingDistanceSquared);
+	if (!SupportsDecisionTable(filter.filterMode) || !(range > 0.0f) || !std::isfinite(range)) {
+		return kDecisionTableCells;
+	}
+	table.range = range;
+	table.inverseCellSize = static_cast<float>(kDecisionTableSize) / range;
+
+	// Covers the rounding in the rotation and quantization of a query at up to
+	// this distance, so a point just across a cell edge is still classified right
+	const double cellSize = static_cast<double>(range) / kDecisionTableSize;
+	const double margin = 1e-3 + range * 1e-5;
+
+	std::size_t exactCells = 0;
+	for (std::size_t z = 0; z < kDecisionTableSize; ++z) {
+		for (std::size_t y = 0; y < kDecisionTableSize; ++y) {
+			for (std::size_t x = 0; x < 2 * kDecisionTableSize; ++x) {
+				const CellBounds cell{
+					{ (static_cast<double>(x) - kDecisionTableSize) * cellSize - margin, (static_cast<double>(x) + 1 - kDecisionTableSize) * cellSize + margin },
+					{ std::max(0.0, y * cellSize - margin), (y + 1) * cellSize + margin },
+					{ std::max(0.0, z * cellSize - margin), (z + 1) * cellSize + margin }
+				};
+
+				const std::uint8_t code = ClassifyCell(filter, thresholds, cell);
+				const std::size_t index = (z * kDecisionTableSize + y) * 2 * kDecisionTableSize + x;
+				table.cells[index / 2] |= static_cast<std::uint8_t>(code << ((index & 1) * 4));
+				exactCells += code == 0 ? 1 : 0;
+			}
+		}
+	}
+
+	return exactCells;
+}
+
+bool LookupDecision(const DecisionTable& table, const CommentQuery& query, CommentDecision& decision)
+{
+	// Into the player's frame; lateral and height fold onto their positive half
+	const float forward = query.forwardX * query.dx + query.forwardY * query.dy;
+	const float lateral = std::fabs(query.forwardY * query.dx - query.forwardX * query.dy);
+	const float height = std::fabs(query.dz);
+
+	// Also false for an empty table (range 0) and NaN input
+	if (!(forward > -table.range && forward < table.range && lateral < table.range && height < table.range)) {
+		return false;
+	}
+
+	// min() catches a coordinate just below the range rounding up to the next cell
+	const std::size_t x = std::min(static_cast<std::size_t>((forward + table.range) * table.inverseCellSize), 2 * kDecisionTableSize - 1);
+	const std::size_t y = std::min(static_cast<std::size_t>(lateral * table.inverseCellSize), kDecisionTableSize - 1);
+	const std::size_t z = std::min(static_cast<std::size_t>(height * table.inverseCellSize), kDecisionTableSize - 1);
+	const std::size_t index = (z * kDecisionTableSize + y) * 2 * kDecisionTableSize + x;
+
+	const std::uint8_t code = (table.cells[index / 2] >> ((index & 1) * 4)) & 0xF;
+	if (code == 0) {
+		return false;
+	}
+
+	const auto outcome = static_cast<FilterOutcome>(code - 1);
+	const bool allow = outcome == FilterOutcome::AllowBypass || outcome == FilterOutcome::AllowFilter;
+	decision = { allow, outcome, allow ? "table: allow" : "table: block", query.dx * query.dx + query.dy * query.dy + query.dz * query.dz };
+	return true;
+}
+
+bool DecideCommentReference(const CommentQuery& query, float maxDeviationAngle)
+{
+	return GetFacingDeviation(query.yaw, query.dx, query.dy) < maxDeviationAngle;
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+// Game-independent (also built by tests/) - standard headers only, no PCH.
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "FilterParameters.h"
+#include "FilterStats.h"
+
+/**
+ * Player facing direction as a unit vector in the XY plane, and the full
+ * look direction including pitch for b3DViewCone.
+ */
+struct PlayerFacing
+{
+	float yaw;       // Yaw the vectors were computed from
+	float pitch;     // Pitch the view vector was computed from
+	float forwardX;  // sin(yaw)
+	float forwardY;  // cos(yaw)
+	float viewX;     // Look direction, unit length
+	float viewY;
+	float viewZ;
+};
+
+/**
+ * Computes the forward vectors for a yaw and pitch.
+ *
+ * @param yaw Radians, 0 = +Y, clockwise
+ * @param pitch Radians, positive = looking down
+ */
+PlayerFacing MakePlayerFacing(float yaw, float pitch);
+
+// Below this horizontal length the camera looks almost straight up or down
+// and its yaw is unreliable; the actor's yaw is used instead
+inline constexpr float kMinCameraHorizontal = 0.01f;
+
+/**
+ * Computes the facing for a camera look direction (sFacingSource=Camera),
+ * a unit vector in world space (the camera's local X axis).
+ *
+ * @return Horizontal part normalized with its yaw (as GetAngleZ: 0 = +Y,
+ *         clockwise, 0 to 2pi) and pitch, the direction itself as the view;
+ *         nullopt while the camera looks almost straight up or down
+ */
+std::optional<PlayerFacing> MakeCameraFacing(float x, float y, float z);
+
+/**
+ * Builds the precomputed thresholds for one category.
+ *
+ * @param filter Filter mode and close range bypass the thresholds are for
+ * @param maxDeviationAngle Allowed deviation in radians
+ * @param maxGreetingDistance Greeting distance in game units
+ * @param closeRangeDistance Close range bypass distance in game units
+ */
+CategoryThresholds MakeCategoryThresholds(const FilterParameters& filter, float maxDeviationAngle, float maxGreetingDistance, float closeRangeDistance);
+
+// Frustum mode tests a sphere around the NPC's head rather than its feet
+inline constexpr float kFrustumHeadHeight = 110.0f;  // Above the actor's position, game units
+inline constexpr float kFrustumHeadRadius = 25.0f;   // Counts as on screen while partly visible
+
+/**
+ * Camera view frustum in world space, one plane per lane (left, right,
+ * bottom, top, near, far, then two padding planes that always pass).
+ * Structure of arrays so four planes are tested with one SSE multiply-add
+ * chain. Planes are normalized: a[i]*x + b[i]*y + c[i]*z + d[i] is the signed
+ * distance in game units, positive inside.
+ */
+struct alignas(64) FrustumPlanes
+{
+	float a[8];
+	float b[8];
+	float c[8];
+	float d[8];
+};
+
+/**
+ * Extracts the frustum planes from a view-projection matrix (Gribb/Hartmann).
+ *
+ * @param viewProjection Row-major world-to-clip matrix, clip = M * (x, y, z, 1)
+ * @param planes Receives the normalized planes
+ */
+void ExtractFrustumPlanes(const float (&viewProjection)[4][4], FrustumPlanes& planes);
+
+/**
+ * @return true if a sphere is at least partly inside all frustum planes
+ */
+bool IsInFrustum(const FrustumPlanes& planes, float x, float y, float z, float radius);
+
+// Decision table resolution: cells along the lateral and height axes (forward has twice as many)
+inline constexpr std::size_t kDecisionTableSize = 16;
+inline constexpr std::size_t kDecisionTableCells = 2 * kDecisionTableSize * kDecisionTableSize * kDecisionTableSize;
+
+/**
+ * Precomputed decisions of one category, over the NPC's position in the
+ * player's frame: forward (along the facing direction, -range to range),
+ * lateral and height (both 0 to range - the decision is symmetric in them).
+ *
+ * Each cell holds a 4-bit code: FilterOutcome + 1 if every point within the
+ * cell - grown by a margin covering float rounding in the rotation and in
+ * DecideComment's own compares - gets that outcome, or 0 if the cell touches
+ * a decision boundary and the query has to be decided exactly. Queries
+ * outside the table are decided exactly as well; beyond fMaxGreetingDistance
+ * distance no longer varies, so the exact path is the broad-phase reject or
+ * the facing test alone.
+ */
+struct alignas(64) DecisionTable
+{
+	float range;            // Half-extent in game units (0 = empty, every query is decided exactly)
+	float inverseCellSize;  // Cells per game unit
+	std::array<std::uint8_t, kDecisionTableCells / 2> cells;  // Two codes per byte, low nibble first
+};
+
+/**
+ * @return true if the mode's decision depends only on the NPC's relative position
+ */
+bool SupportsDecisionTable(FilterMode mode);
+
+/**
+ * Classifies every cell of a category's table.
+ *
+ * @param filter Filter mode and close range bypass to tabulate
+ * @param thresholds Category thresholds
+ * @param table Receives the cells
+ * @return Number of cells left to the exact decision
+ */
+std::size_t BuildDecisionTable(const FilterParameters& filter, const CategoryThresholds& thresholds, DecisionTable& table);
+
+/**
+ * Everything the filter needs to know about one comment attempt. AllowComment
+ * gathers it from the game; DecideComment never calls into the game, so a
+ * decision depends only on the query and the filter parameters and can be
+ * driven by synthetic NPCs outside of Skyrim.
+ */
+struct CommentQuery
+{
+	float dx;              // NPC position minus player position
+	float dy;
+	float dz;
+	float yaw;             // Player yaw in radians (0 = +Y, clockwise)
+	float forwardX;        // Unit look direction: sin(yaw), cos(yaw), 0 for the flat facing test;
+	float forwardY;        // with b3DViewCone tilted by the player's pitch
+	float forwardZ;
+	float viewDz;          // b3DViewCone: NPC head minus player eye height (dz between them), else 0
+	bool npcInCombat;      // Only filled in when the filter expression reads inCombat
+	bool playerSneaking;   // Only filled in when the filter expression reads sneaking
+
+	// Frustum mode only
+	const FrustumPlanes* frustum;  // Camera frustum, nullptr = no camera (falls back to the angle test)
+	float headX;                   // NPC head position in world space
+	float headY;
+	float headZ;
+};
+
+/**
+ * Result of DecideComment.
+ */
+struct CommentDecision
+{
+	bool allow;
+	FilterOutcome outcome;   // For statistics
+	const char* reason;      // For debug logging
+	float distanceSquared;   // 3D, includes Z for vertical awareness
+};
+
+/**
+ * Applies the filter mode, close range bypass and broad-phase reject to one query.
+ *
+ * @param filter Active filter parameters
+ * @param thresholds Thresholds of the NPC's category
+ * @param query NPC/player geometry and state
+ * @return Decision with its outcome and reason
+ */
+CommentDecision DecideComment(const FilterParameters& filter, const CategoryThresholds& thresholds, const CommentQuery& query);
+
+/**
+ * Looks the decision up in a category's table: a rotation into the player's
+ * frame, a quantization and one cell read, no sqrt and no mode switch.
+ * Decides the same as DecideComment (except for the reason text) whenever it
+ * answers.
+ *
+ * @param table Table of the NPC's category
+ * @param query NPC/player geometry
+ * @param decision Receives the decision if the table has one
+ * @return false if the query is outside the table or on a boundary cell -
+ *         call DecideComment instead
+ */
+bool LookupDecision(const DecisionTable& table, const CommentQuery& query, CommentDecision& decision);
+
+/**
+ * The original To Your Face test (reference-src/ToYourFace.cpp): one atan2,
+ * deviation from the player's yaw, compared against the angle directly.
+ * Kept for bReferenceCheck, which compares it with DecideComment in AngleOnly mode,
+ * and for tests/ReferenceDiffTest, which does the same offline. Wraps angles
+ * with the same truncated pi as the original, so its boundary is the original's.
+ *
+ * @param query NPC/player geometry
+ * @param maxDeviationAngle Allowed deviation in radians
+ * @return true if the original plugin would allow the comment
+ */
+bool DecideCommentReference(const CommentQuery& query, float maxDeviationAngle);
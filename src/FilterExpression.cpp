@@ -0,0 +1,638 @@
+/**
+ * FilterExpression.cpp - sFilterExpression parser, bytecode compiler and interpreter
+ *
+ * Pipeline:
+ *   1. Tokenizer    - identifiers, numbers, operators, parentheses
+ *   2. Parser       - recursive descent into a typed AST (Bool / Number nodes);
+ *                     type errors are reported at parse time with the column
+ *   3. Lowering     - straight-line register bytecode, one register per result.
+ *                     There are no jumps: every input is precomputed and has no
+ *                     side effects, so evaluating both sides of && / || is cheaper
+ *                     than branching on them
+ *   4. JIT (x64)    - optional, see FilterExpressionJit.cpp
+ *
+ * Comparisons follow C++ semantics for NaN (everything false except !=).
+ */
+
+#include "FilterExpression.h"
+
+#include <charconv>
+#include <cctype>
+#include <system_error>
+
+using namespace std::literals;
+
+namespace
+{
+	using OpCode = FilterExpression::OpCode;
+	using CompareOp = FilterExpression::CompareOp;
+	using Instruction = FilterExpression::Instruction;
+
+	// "{}" placeholders only - std::format is not available with every toolchain tests/ builds with
+	void AppendArgument(std::string& out, std::string_view value) { out += value; }
+	void AppendArgument(std::string& out, char value) { out += value; }
+	void AppendArgument(std::string& out, std::size_t value) { out += std::to_string(value); }
+
+	template <class... Args>
+	std::string FormatError(std::string_view fmt, const Args&... args)
+	{
+		std::string out;
+		std::size_t pos = 0;
+		[[maybe_unused]] auto append = [&](const auto& arg) {
+			const auto placeholder = fmt.find("{}"sv, pos);
+			out += fmt.substr(pos, placeholder - pos);
+			AppendArgument(out, arg);
+			pos = placeholder + 2;
+		};
+		(append(args), ...);
+		out += fmt.substr(pos);
+		return out;
+	}
+
+	struct VariableInfo
+	{
+		std::string_view name;
+		FilterVariable variable;
+		bool isBool;
+	};
+
+	inline constexpr VariableInfo kVariables[] = {
+		{ "dist"sv, FilterVariable::Distance, false },
+		{ "angle"sv, FilterVariable::Angle, false },
+		{ "height"sv, FilterVariable::Height, false },
+		{ "inCombat"sv, FilterVariable::InCombat, true },
+		{ "sneaking"sv, FilterVariable::Sneaking, true }
+	};
+
+	// ========================================
+	// Tokenizer
+	// ========================================
+
+	enum class TokenKind
+	{
+		End,
+		Identifier,
+		Number,
+		LParen,
+		RParen,
+		Not,
+		And,
+		Or,
+		Compare
+	};
+
+	struct Token
+	{
+		TokenKind kind;
+		std::string_view text;
+		std::size_t column;
+		CompareOp compare;
+		float number;
+	};
+
+	class Tokenizer
+	{
+	public:
+		explicit Tokenizer(std::string_view source) : source(source) {}
+
+		/**
+		 * Reads the next token. Returns false and sets error on invalid input.
+		 */
+		bool Next(Token& token, std::string& error)
+		{
+			while (pos < source.size() && isspace(static_cast<unsigned char>(source[pos]))) {
+				++pos;
+			}
+
+			token = Token{ TokenKind::End, {}, pos + 1, CompareOp::Less, 0.0f };
+			if (pos >= source.size()) {
+				return true;
+			}
+
+			const char c = source[pos];
+			const char next = pos + 1 < source.size() ? source[pos + 1] : '\0';
+
+			if (isalpha(static_cast<unsigned char>(c)) || c == '_') {
+				const std::size_t start = pos;
+				while (pos < source.size() && (isalnum(static_cast<unsigned char>(source[pos])) || source[pos] == '_')) {
+					++pos;
+				}
+				token.kind = TokenKind::Identifier;
+				token.text = source.substr(start, pos - start);
+				return true;
+			}
+
+			if (isdigit(static_cast<unsigned char>(c)) || c == '.') {
+				const std::size_t start = pos;
+				while (pos < source.size() && (isdigit(static_cast<unsigned char>(source[pos])) || source[pos] == '.')) {
+					++pos;
+				}
+				token.kind = TokenKind::Number;
+				token.text = source.substr(start, pos - start);
+				const auto [end, ec] = std::from_chars(token.text.data(), token.text.data() + token.text.size(), token.number);
+				if (ec != std::errc() || end != token.text.data() + token.text.size()) {
+					error = FormatError("invalid number \"{}\" at column {}", token.text, token.column);
+					return false;
+				}
+				return true;
+			}
+
+			auto single = [&](TokenKind kind) {
+				token.kind = kind;
+				token.text = source.substr(pos, 1);
+				++pos;
+				return true;
+			};
+			auto compare = [&](CompareOp op, std::size_t length) {
+				token.kind = TokenKind::Compare;
+				token.compare = op;
+				token.text = source.substr(pos, length);
+				pos += length;
+				return true;
+			};
+
+			switch (c) {
+				case '(':
+					return single(TokenKind::LParen);
+				case ')':
+					return single(TokenKind::RParen);
+				case '<':
+					return next == '=' ? compare(CompareOp::LessEqual, 2) : compare(CompareOp::Less, 1);
+				case '>':
+					return next == '=' ? compare(CompareOp::GreaterEqual, 2) : compare(CompareOp::Greater, 1);
+				case '=':
+					if (next == '=') {
+						return compare(CompareOp::Equal, 2);
+					}
+					break;
+				case '!':
+					return next == '=' ? compare(CompareOp::NotEqual, 2) : single(TokenKind::Not);
+				case '&':
+					if (next == '&') {
+						token.kind = TokenKind::And;
+						token.text = source.substr(pos, 2);
+						pos += 2;
+						return true;
+					}
+					break;
+				case '|':
+					if (next == '|') {
+						token.kind = TokenKind::Or;
+						token.text = source.substr(pos, 2);
+						pos += 2;
+						return true;
+					}
+					break;
+				default:
+					break;
+			}
+
+			error = FormatError("unexpected character '{}' at column {}", c, pos + 1);
+			return false;
+		}
+
+	private:
+		std::string_view source;
+		std::size_t pos = 0;
+	};
+
+	// ========================================
+	// Typed AST
+	// ========================================
+
+	enum class NodeKind
+	{
+		Constant,  // Number or Bool literal
+		Variable,  // Number or Bool variable
+		Compare,   // Number <op> Number -> Bool
+		Not,       // !Bool -> Bool
+		And,       // Bool && Bool -> Bool
+		Or         // Bool || Bool -> Bool
+	};
+
+	struct Node
+	{
+		NodeKind kind;
+		bool isBool;  // Result type: Bool or Number
+		CompareOp compare = CompareOp::Less;
+		FilterVariable variable = FilterVariable::Distance;
+		float constant = 0.0f;
+		std::unique_ptr<Node> lhs;
+		std::unique_ptr<Node> rhs;
+	};
+
+	class Parser
+	{
+	public:
+		Parser(std::string_view source, std::string& error) : tokenizer(source), error(error) {}
+
+		std::unique_ptr<Node> Parse()
+		{
+			if (!Advance()) {
+				return nullptr;
+			}
+
+			auto root = ParseOr();
+			if (!root) {
+				return nullptr;
+			}
+			if (current.kind != TokenKind::End) {
+				return Fail("unexpected \"{}\" at column {}", current.text, current.column);
+			}
+			if (!root->isBool) {
+				return Fail("expression must be a condition, not a number (add a comparison)");
+			}
+			return root;
+		}
+
+	private:
+		template <class... Args>
+		std::unique_ptr<Node> Fail(std::string_view fmt, const Args&... args)
+		{
+			if (error.empty()) {
+				error = FormatError(fmt, args...);
+			}
+			return nullptr;
+		}
+
+		bool Advance() { return tokenizer.Next(current, error); }
+
+		static std::unique_ptr<Node> MakeBinary(NodeKind kind, std::unique_ptr<Node> lhs, std::unique_ptr<Node> rhs)
+		{
+			auto node = std::make_unique<Node>();
+			node->kind = kind;
+			node->isBool = true;
+			node->lhs = std::move(lhs);
+			node->rhs = std::move(rhs);
+			return node;
+		}
+
+		std::unique_ptr<Node> RequireBool(std::unique_ptr<Node> node, std::string_view op, std::size_t column)
+		{
+			if (node && !node->isBool) {
+				return Fail("operand of '{}' at column {} must be a condition, not a number", op, column);
+			}
+			return node;
+		}
+
+		std::unique_ptr<Node> ParseOr()
+		{
+			auto lhs = ParseAnd();
+			while (lhs && current.kind == TokenKind::Or) {
+				const auto column = current.column;
+				if (!Advance()) {
+					return nullptr;
+				}
+				if (++operators > FilterExpression::kMaxInstructions) {
+					return Fail("expression is too long (more than {} operations)", FilterExpression::kMaxInstructions);
+				}
+				lhs = RequireBool(std::move(lhs), "||"sv, column);
+				auto rhs = RequireBool(ParseAnd(), "||"sv, column);
+				if (!lhs || !rhs) {
+					return nullptr;
+				}
+				lhs = MakeBinary(NodeKind::Or, std::move(lhs), std::move(rhs));
+			}
+			return lhs;
+		}
+
+		std::unique_ptr<Node> ParseAnd()
+		{
+			auto lhs = ParseUnary();
+			while (lhs && current.kind == TokenKind::And) {
+				const auto column = current.column;
+				if (!Advance()) {
+					return nullptr;
+				}
+				if (++operators > FilterExpression::kMaxInstructions) {
+					return Fail("expression is too long (more than {} operations)", FilterExpression::kMaxInstructions);
+				}
+				lhs = RequireBool(std::move(lhs), "&&"sv, column);
+				auto rhs = RequireBool(ParseUnary(), "&&"sv, column);
+				if (!lhs || !rhs) {
+					return nullptr;
+				}
+				lhs = MakeBinary(NodeKind::And, std::move(lhs), std::move(rhs));
+			}
+			return lhs;
+		}
+
+		std::unique_ptr<Node> ParseUnary()
+		{
+			if (current.kind == TokenKind::Not || current.kind == TokenKind::LParen) {
+				// The instruction limit is only checked when lowering; fail here before
+				// a deeply nested (or malicious) expression can exhaust the stack
+				if (depth >= FilterExpression::kMaxNestingDepth) {
+					return Fail("expression is nested too deeply (more than {} levels) at column {}", FilterExpression::kMaxNestingDepth, current.column);
+				}
+				++depth;
+				auto node = ParseNested();
+				--depth;
+				return node;
+			}
+
+			return ParseComparison();
+		}
+
+		/**
+		 * '!' unary | '(' expr ')' - the recursive part of ParseUnary.
+		 */
+		std::unique_ptr<Node> ParseNested()
+		{
+			if (current.kind == TokenKind::Not) {
+				const auto column = current.column;
+				if (!Advance()) {
+					return nullptr;
+				}
+				auto operand = RequireBool(ParseUnary(), "!"sv, column);
+				if (!operand) {
+					return nullptr;
+				}
+				auto node = std::make_unique<Node>();
+				node->kind = NodeKind::Not;
+				node->isBool = true;
+				node->lhs = std::move(operand);
+				return node;
+			}
+
+			const auto column = current.column;  // '('
+			if (!Advance()) {
+				return nullptr;
+			}
+			auto inner = ParseOr();
+			if (!inner) {
+				return nullptr;
+			}
+			if (current.kind != TokenKind::RParen) {
+				return Fail("missing ')' for '(' at column {}", column);
+			}
+			if (!Advance()) {
+				return nullptr;
+			}
+			return inner;
+		}
+
+		std::unique_ptr<Node> ParseComparison()
+		{
+			auto lhs = ParseOperand();
+			if (!lhs || current.kind != TokenKind::Compare) {
+				return lhs;
+			}
+
+			const auto op = current.compare;
+			const auto opText = current.text;
+			const auto column = current.column;
+			if (!Advance()) {
+				return nullptr;
+			}
+			auto rhs = ParseOperand();
+			if (!rhs) {
+				return nullptr;
+			}
+			if (lhs->isBool || rhs->isBool) {
+				return Fail("operands of '{}' at column {} must be numbers", opText, column);
+			}
+
+			auto node = MakeBinary(NodeKind::Compare, std::move(lhs), std::move(rhs));
+			node->compare = op;
+			return node;
+		}
+
+		std::unique_ptr<Node> ParseOperand()
+		{
+			auto node = std::make_unique<Node>();
+
+			if (current.kind == TokenKind::Number) {
+				node->kind = NodeKind::Constant;
+				node->isBool = false;
+				node->constant = current.number;
+				return Advance() ? std::move(node) : nullptr;
+			}
+
+			if (current.kind != TokenKind::Identifier) {
+				if (current.kind == TokenKind::End) {
+					return Fail("unexpected end of expression");
+				}
+				return Fail("unexpected \"{}\" at column {}", current.text, current.column);
+			}
+
+			if (current.text == "true"sv || current.text == "false"sv) {
+				node->kind = NodeKind::Constant;
+				node->isBool = true;
+				node->constant = current.text == "true"sv ? 1.0f : 0.0f;
+				return Advance() ? std::move(node) : nullptr;
+			}
+
+			for (const auto& info : kVariables) {
+				if (current.text == info.name) {
+					node->kind = NodeKind::Variable;
+					node->isBool = info.isBool;
+					node->variable = info.variable;
+					return Advance() ? std::move(node) : nullptr;
+				}
+			}
+
+			return Fail("unknown variable \"{}\" at column {}", current.text, current.column);
+		}
+
+		Tokenizer tokenizer;
+		Token current{};
+		std::string& error;
+		std::size_t depth = 0;      // Open '!' and '(' (see kMaxNestingDepth)
+		std::size_t operators = 0;  // '&&' and '||' so far - each needs an instruction, and long
+		                            // chains would make lowering recurse as deep as they are long
+	};
+
+	// ========================================
+	// Shared comparison semantics
+	// ========================================
+
+	inline bool CompareValues(CompareOp op, float a, float b)
+	{
+		switch (op) {
+			case CompareOp::Less:
+				return a < b;
+			case CompareOp::LessEqual:
+				return a <= b;
+			case CompareOp::Greater:
+				return a > b;
+			case CompareOp::GreaterEqual:
+				return a >= b;
+			case CompareOp::Equal:
+				return a == b;
+			case CompareOp::NotEqual:
+				return a != b;
+		}
+		return false;
+	}
+
+	/**
+	 * Mirrors a comparison so its operands can be swapped (a < b  <=>  b > a).
+	 */
+	inline CompareOp MirrorCompare(CompareOp op)
+	{
+		switch (op) {
+			case CompareOp::Less:
+				return CompareOp::Greater;
+			case CompareOp::LessEqual:
+				return CompareOp::GreaterEqual;
+			case CompareOp::Greater:
+				return CompareOp::Less;
+			case CompareOp::GreaterEqual:
+				return CompareOp::LessEqual;
+			default:
+				return op;  // == and != are symmetric
+		}
+	}
+
+	// ========================================
+	// Lowering to bytecode
+	// ========================================
+
+	class Lowering
+	{
+	public:
+		Lowering(std::vector<Instruction>& code, std::uint32_t& usedVariables) : code(code), usedVariables(usedVariables) {}
+
+		/**
+		 * Emits code for a Bool node and returns its result register, or -1 if
+		 * the program would exceed kMaxInstructions.
+		 */
+		int Lower(const Node& node)
+		{
+			switch (node.kind) {
+				case NodeKind::Constant:
+					return Emit({ OpCode::LoadConst, CompareOp::Less, 0, 0, 0, node.constant });
+
+				case NodeKind::Variable:
+					Use(node.variable);
+					return Emit({ OpCode::LoadBool, CompareOp::Less, 0, Index(node.variable), 0, 0.0f });
+
+				case NodeKind::Compare:
+					return LowerCompare(node);
+
+				case NodeKind::Not:
+				{
+					const int a = Lower(*node.lhs);
+					return a < 0 ? -1 : Emit({ OpCode::Not, CompareOp::Less, 0, static_cast<std::uint8_t>(a), 0, 0.0f });
+				}
+
+				case NodeKind::And:
+				case NodeKind::Or:
+				{
+					const int a = Lower(*node.lhs);
+					const int b = a < 0 ? -1 : Lower(*node.rhs);
+					if (b < 0) {
+						return -1;
+					}
+					const auto op = node.kind == NodeKind::And ? OpCode::And : OpCode::Or;
+					return Emit({ op, CompareOp::Less, 0, static_cast<std::uint8_t>(a), static_cast<std::uint8_t>(b), 0.0f });
+				}
+			}
+			return -1;
+		}
+
+	private:
+		static std::uint8_t Index(FilterVariable variable) { return static_cast<std::uint8_t>(variable); }
+
+		void Use(FilterVariable variable) { usedVariables |= 1u << Index(variable); }
+
+		int Emit(Instruction instruction)
+		{
+			if (code.size() >= FilterExpression::kMaxInstructions) {
+				return -1;
+			}
+			instruction.dst = static_cast<std::uint8_t>(code.size());
+			code.push_back(instruction);
+			return instruction.dst;
+		}
+
+		int LowerCompare(const Node& node)
+		{
+			const Node& lhs = *node.lhs;
+			const Node& rhs = *node.rhs;
+
+			// Both constant: fold
+			if (lhs.kind == NodeKind::Constant && rhs.kind == NodeKind::Constant) {
+				const bool value = CompareValues(node.compare, lhs.constant, rhs.constant);
+				return Emit({ OpCode::LoadConst, CompareOp::Less, 0, 0, 0, value ? 1.0f : 0.0f });
+			}
+
+			// Constant on the left: mirror so the constant is always the right operand
+			if (lhs.kind == NodeKind::Constant) {
+				Use(rhs.variable);
+				return Emit({ OpCode::CompareVarConst, MirrorCompare(node.compare), 0, Index(rhs.variable), 0, lhs.constant });
+			}
+
+			Use(lhs.variable);
+			if (rhs.kind == NodeKind::Constant) {
+				return Emit({ OpCode::CompareVarConst, node.compare, 0, Index(lhs.variable), 0, rhs.constant });
+			}
+
+			Use(rhs.variable);
+			return Emit({ OpCode::CompareVarVar, node.compare, 0, Index(lhs.variable), Index(rhs.variable), 0.0f });
+		}
+
+		std::vector<Instruction>& code;
+		std::uint32_t& usedVariables;
+	};
+}
+
+FilterExpression::~FilterExpression() = default;
+
+std::unique_ptr<FilterExpression> FilterExpression::Compile(std::string_view source, std::string& error)
+{
+	error.clear();
+
+	Parser parser(source, error);
+	auto root = parser.Parse();
+	if (!root) {
+		return nullptr;
+	}
+
+	std::unique_ptr<FilterExpression> expression(new FilterExpression());
+
+	Lowering lowering(expression->code, expression->usedVariables);
+	const int result = lowering.Lower(*root);
+	if (result < 0) {
+		error = FormatError("expression is too long (more than {} operations)", kMaxInstructions);
+		return nullptr;
+	}
+	expression->resultRegister = static_cast<std::uint8_t>(result);
+
+	return expression;
+}
+
+bool FilterExpression::Interpret(const FilterInputs& inputs) const
+{
+	bool registers[kMaxInstructions];
+
+	for (const auto& instruction : code) {
+		bool& dst = registers[instruction.dst];
+		switch (instruction.op) {
+			case OpCode::CompareVarConst:
+				dst = CompareValues(instruction.compare, inputs.values[instruction.a], instruction.constant);
+				break;
+			case OpCode::CompareVarVar:
+				dst = CompareValues(instruction.compare, inputs.values[instruction.a], inputs.values[instruction.b]);
+				break;
+			case OpCode::LoadBool:
+				dst = inputs.values[instruction.a] != 0.0f;
+				break;
+			case OpCode::LoadConst:
+				dst = instruction.constant != 0.0f;
+				break;
+			case OpCode::Not:
+				dst = !registers[instruction.a];
+				break;
+			case OpCode::And:
+				dst = registers[instruction.a] & registers[instruction.b];
+				break;
+			case OpCode::Or:
+				dst = registers[instruction.a] | registers[instruction.b];
+				break;
+		}
+	}
+
+	return registers[resultRegister];
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+// Game-independent (also built by tests/) - standard headers only, no PCH.
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Variables available to filter expressions.
+ * Booleans are stored as 0.0f / 1.0f so all inputs fit in one float array.
+ */
+enum class FilterVariable : std::uint8_t
+{
+	Distance = 0,  // dist     - 3D distance to the NPC in game units
+	Angle = 1,     // angle    - deviation from the player's facing in degrees (0-180)
+	Height = 2,    // height   - NPC height above the player in game units (dz)
+	InCombat = 3,  // inCombat - NPC is in combat (bool)
+	Sneaking = 4,  // sneaking - player is sneaking (bool)
+	kCount
+};
+
+/**
+ * Inputs for one expression evaluation. Only the variables reported by
+ * FilterExpression::GetUsedVariables() need to be filled in.
+ */
+struct FilterInputs
+{
+	float values[static_cast<std::size_t>(FilterVariable::kCount)];
+};
+
+/**
+ * Compiled filter expression from sFilterExpression.
+ *
+ * Grammar (C-like precedence, ! > comparisons > && > ||):
+ *   expr       := and ( '||' and )*
+ *   and        := unary ( '&&' unary )*
+ *   unary      := '!' unary | '(' expr ')' | comparison | boolVar | 'true' | 'false'
+ *   comparison := operand ( '<' | '<=' | '>' | '>=' | '==' | '!=' ) operand
+ *   operand    := number | numVar
+ *
+ * Example: dist < 150 && (angle < 30 || dist < 50) && !inCombat
+ *
+ * The source is parsed into a typed AST, lowered to straight-line register
+ * bytecode (constant comparisons folded, constants moved to the right), and
+ * optionally JIT-compiled to x64 with Xbyak (CompileNative). The interpreter
+ * is always kept as the reference implementation and as a fallback if code
+ * generation fails. Only the code generator (FilterExpressionJit.cpp) needs
+ * Xbyak; parsing and interpreting use the standard library alone.
+ */
+class FilterExpression
+{
+public:
+	/**
+	 * Parses and compiles an expression to bytecode.
+	 *
+	 * @param source Expression text
+	 * @param error Receives a description with the column on failure
+	 * @return Compiled expression, or nullptr on syntax/type error
+	 */
+	static std::unique_ptr<FilterExpression> Compile(std::string_view source, std::string& error);
+
+	/**
+	 * Generates native x64 code for the bytecode with Xbyak. Evaluate() uses
+	 * it from then on; on failure the interpreter stays in use.
+	 *
+	 * @param error Receives the reason on failure
+	 * @return true if native code was generated
+	 */
+	bool CompileNative(std::string& error);
+
+	~FilterExpression();
+
+	/**
+	 * Evaluates the expression using native code if available.
+	 */
+	bool Evaluate(const FilterInputs& inputs) const
+	{
+		return jitFunction ? jitFunction(inputs.values) : Interpret(inputs);
+	}
+
+	/**
+	 * Evaluates the expression with the bytecode interpreter.
+	 */
+	bool Interpret(const FilterInputs& inputs) const;
+
+	/**
+	 * @return Bitmask of (1 << FilterVariable) for every variable the expression reads
+	 */
+	std::uint32_t GetUsedVariables() const { return usedVariables; }
+
+	/**
+	 * @return true if the expression reads the given variable
+	 */
+	bool Uses(FilterVariable variable) const { return usedVariables & (1u << static_cast<std::uint32_t>(variable)); }
+
+	/**
+	 * @return true if native code was generated
+	 */
+	bool IsJitCompiled() const { return jitFunction != nullptr; }
+
+	/**
+	 * @return Number of bytecode instructions
+	 */
+	std::size_t GetInstructionCount() const { return code.size(); }
+
+	enum class OpCode : std::uint8_t
+	{
+		CompareVarConst,  // r[dst] = values[a] <cmp> constant
+		CompareVarVar,    // r[dst] = values[a] <cmp> values[b]
+		LoadBool,         // r[dst] = values[a] != 0
+		LoadConst,        // r[dst] = constant != 0
+		Not,              // r[dst] = !r[a]
+		And,              // r[dst] = r[a] & r[b]
+		Or                // r[dst] = r[a] | r[b]
+	};
+
+	enum class CompareOp : std::uint8_t
+	{
+		Less,
+		LessEqual,
+		Greater,
+		GreaterEqual,
+		Equal,
+		NotEqual
+	};
+
+	struct Instruction
+	{
+		OpCode op;
+		CompareOp compare;
+		std::uint8_t dst;
+		std::uint8_t a;
+		std::uint8_t b;
+		float constant;
+	};
+
+	static constexpr std::size_t kMaxInstructions = 64;  // One register per instruction
+	static constexpr std::size_t kMaxNestingDepth = 32;  // '!' and '(' nested deeper are a parse error
+
+	/**
+	 * Owner of generated code (defined by the code generator).
+	 */
+	struct NativeCode
+	{
+		virtual ~NativeCode() = default;
+	};
+
+private:
+	// Generated code uses the Windows x64 convention (values in RCX) everywhere;
+	// other compilers are told so, which lets tests/ call it on Linux too
+#ifdef _MSC_VER
+	using JitFunction = bool (*)(const float* values);
+#else
+	using JitFunction = bool(__attribute__((ms_abi)) *)(const float* values);
+#endif
+
+	FilterExpression() = default;
+
+	std::vector<Instruction> code;
+	std::uint8_t resultRegister = 0;
+	std::uint32_t usedVariables = 0;
+
+	std::unique_ptr<NativeCode> jitCode;  // Owns the executable memory
+	JitFunction jitFunction = nullptr;
+};
@@ -0,0 +1,173 @@
+/**
+ * FilterExpressionJit.cpp - x64 code generation for sFilterExpression
+ *
+ * Each bytecode instruction becomes a handful of SSE/GPR instructions. The
+ * VM registers are the bits of R8 (one bit per instruction, at most 64), so
+ * the generated function is a leaf that never touches the stack or a
+ * non-volatile register: Windows x64 needs no unwind information for it,
+ * and an exception or a debugger walking through it sees a plain return
+ * address at [rsp].
+ *
+ * The code always follows the Windows x64 calling convention (values in
+ * RCX); FilterExpression::JitFunction tells non-MSVC compilers so.
+ *
+ * Game-independent (also built by tests/ when Xbyak is found) - standard
+ * headers and Xbyak only, no PCH.
+ */
+
+#include "FilterExpression.h"
+
+#include <bit>
+#include <exception>
+
+#include <xbyak/xbyak.h>
+
+namespace
+{
+	using OpCode = FilterExpression::OpCode;
+	using CompareOp = FilterExpression::CompareOp;
+	using Instruction = FilterExpression::Instruction;
+
+	static_assert(FilterExpression::kMaxInstructions <= 64, "VM registers are the bits of one 64-bit GPR");
+
+	/**
+	 * Generates bool fn(const float* values) from the bytecode.
+	 * Uses only volatile registers: RAX, RCX (values), RDX, R8 (VM registers), XMM0-1.
+	 */
+	struct FilterExpressionCode : Xbyak::CodeGenerator, FilterExpression::NativeCode
+	{
+		FilterExpressionCode(const std::vector<Instruction>& code, std::uint8_t resultRegister) :
+			Xbyak::CodeGenerator(4096)
+		{
+			using namespace Xbyak;
+
+			const Reg64& values = rcx;
+			const Reg64& registers = r8;
+
+			auto value = [&](std::uint8_t index) { return dword[values + index * sizeof(float)]; };
+
+			// al = r[index]
+			auto load = [&](std::uint8_t index, const Reg8& out) {
+				bt(registers, index);
+				setc(out);
+			};
+
+			// r[dst] = al (registers start cleared and are written once)
+			auto store = [&](std::uint8_t dst) {
+				movzx(eax, al);
+				shl(rax, dst);
+				or_(registers, rax);
+			};
+
+			xor_(r8d, r8d);
+
+			for (const auto& instruction : code) {
+				switch (instruction.op) {
+					case OpCode::CompareVarConst:
+						movss(xmm0, value(instruction.a));
+						mov(eax, std::bit_cast<std::uint32_t>(instruction.constant));
+						movd(xmm1, eax);
+						EmitCompare(instruction.compare);
+						store(instruction.dst);
+						break;
+
+					case OpCode::CompareVarVar:
+						movss(xmm0, value(instruction.a));
+						movss(xmm1, value(instruction.b));
+						EmitCompare(instruction.compare);
+						store(instruction.dst);
+						break;
+
+					case OpCode::LoadBool:
+						movss(xmm0, value(instruction.a));
+						xorps(xmm1, xmm1);
+						EmitCompare(CompareOp::NotEqual);
+						store(instruction.dst);
+						break;
+
+					case OpCode::LoadConst:
+						if (instruction.constant != 0.0f) {
+							bts(registers, instruction.dst);
+						}
+						break;
+
+					case OpCode::Not:
+						load(instruction.a, al);
+						xor_(al, 1);
+						store(instruction.dst);
+						break;
+
+					case OpCode::And:
+						load(instruction.a, al);
+						load(instruction.b, dl);
+						and_(al, dl);
+						store(instruction.dst);
+						break;
+
+					case OpCode::Or:
+						load(instruction.a, al);
+						load(instruction.b, dl);
+						or_(al, dl);
+						store(instruction.dst);
+						break;
+				}
+			}
+
+			load(resultRegister, al);
+			movzx(eax, al);
+			ret();
+		}
+
+		/**
+		 * al = xmm0 <op> xmm1 with C++ NaN semantics.
+		 * ucomiss sets ZF=PF=CF=1 when unordered, so the operands are arranged
+		 * such that "above" / "above or equal" are false for NaN.
+		 */
+		void EmitCompare(CompareOp op)
+		{
+			switch (op) {
+				case CompareOp::Less:
+					ucomiss(xmm1, xmm0);
+					seta(al);
+					break;
+				case CompareOp::LessEqual:
+					ucomiss(xmm1, xmm0);
+					setae(al);
+					break;
+				case CompareOp::Greater:
+					ucomiss(xmm0, xmm1);
+					seta(al);
+					break;
+				case CompareOp::GreaterEqual:
+					ucomiss(xmm0, xmm1);
+					setae(al);
+					break;
+				case CompareOp::Equal:
+					ucomiss(xmm0, xmm1);
+					sete(al);
+					setnp(dl);
+					and_(al, dl);
+					break;
+				case CompareOp::NotEqual:
+					ucomiss(xmm0, xmm1);
+					setne(al);
+					setp(dl);
+					or_(al, dl);
+					break;
+			}
+		}
+	};
+}
+
+bool FilterExpression::CompileNative(std::string& error)
+{
+	try {
+		auto generated = std::make_unique<FilterExpressionCode>(code, resultRegister);
+		jitFunction = generated->getCode<JitFunction>();
+		jitCode = std::move(generated);
+		return true;
+	} catch (const std::exception& e) {
+		error = e.what();
+		return false;
+	}
+}
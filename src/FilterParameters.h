@@ -0,0 +1,112 @@
+#pragma once
+
+// Game-independent (also built by tests/) - standard headers only, no PCH.
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+class FilterExpression;
+struct PluginConfig;
+struct DecisionTable;
+
+inline constexpr float pi = 3.1415f;  // Probably overkill for this mod
+
+/**
+ * Filter mode determines how angle and distance filters are combined
+ */
+enum class FilterMode : std::uint8_t
+{
+	AngleOnly = 0,     // Original behavior - angle-based filtering only
+	DistanceOnly = 1,  // Distance-based filtering only
+	Both = 2,          // Both angle AND distance required (strict)
+	Either = 3,        // Either angle OR distance (permissive)
+	Expression = 4,    // Custom sFilterExpression (compiled at load)
+	Frustum = 5        // NPC's head is inside the camera's view frustum (on screen)
+};
+
+/**
+ * Which direction counts as where the player is facing (angle test, filter
+ * expression angle, decision tables)
+ */
+enum class FacingSource : std::uint8_t
+{
+	Actor = 0,   // Player character's yaw (original behavior)
+	Camera = 1   // Camera's horizontal look direction (free third-person camera, furniture, horseback)
+};
+
+/**
+ * Filter thresholds for one actor category.
+ * Precomputed at load so the hot path only indexes a small array.
+ * Four categories share a cache line.
+ */
+struct CategoryThresholds
+{
+	float cosMaxDeviation;             // cos(maximum deviation angle) for the dot product facing test
+	float maxGreetingDistanceSquared;  // Squared greeting distance
+	float closeRangeDistanceSquared;   // Squared close range bypass distance
+	float candidateRangeSquared;       // NPCs beyond this squared distance can never pass (infinity if mode has no distance gate)
+
+	bool operator==(const CategoryThresholds&) const = default;
+};
+static_assert(sizeof(CategoryThresholds) == 16);
+
+// Category 0 is the default ([Main]/[Distance] values), rules map to 1..N
+inline constexpr std::size_t kMaxActorCategories = 8;
+
+/**
+ * Switches of the filter and its optional stages, as bits of
+ * FilterParameters::flags. A stage's settings live off the first line (or in
+ * ConfigSettings) and are only read when its bit is set.
+ */
+enum class FilterFlag : std::uint8_t
+{
+	CloseRangeBypass = 0,  // Allow comments at close range regardless of angle
+	DebugLogging = 1,      // Log each NPC comment check to help diagnose issues
+	Timing = 2,            // Time each call for the live statistics export
+	ReferenceCheck = 3,    // Compare AngleOnly decisions with the original plugin's logic
+	ViewCone3D = 4,        // b3DViewCone: facing test from the player's eyes to the NPC's head, with pitch
+	DecisionTable = 5,     // decisionTables is set (bDecisionTable)
+	DwellTime = 6,         // fDwellTime > 0 (ConfigSettings::dwellMilliseconds)
+	LineOfSight = 7,       // Block allowed comments from NPCs that cannot see the player (ConfigSettings::lineOfSight)
+	RateLimit = 8,         // [RateLimit] has a global limit or an NPC cooldown (ConfigSettings::rateLimit)
+	Shadow = 9             // [Shadow]: also decide with shadowFilter (never changes the result)
+};
+
+/**
+ * Hot filter parameters - everything AllowComment reads on every call, and
+ * nothing else. Cache-line aligned: a 16-byte header and categories 0-2 fill
+ * the first line, so a call without actor categories (or one resolving to
+ * category 0-2) touches exactly one line of configuration.
+ * Each threshold profile has its own block; the filter reads whichever one
+ * GetActiveFilter() points to.
+ */
+struct alignas(64) FilterParameters
+{
+	// Line 0
+	const FilterExpression* filterExpression;  // Set when filterMode == Expression (owned by ConfigSettings)
+	std::uint32_t categoryGeneration;          // Non-zero once rules are compiled; tags cache entries
+	FilterMode filterMode;                     // How to combine angle and distance filters
+	FacingSource facingSource;                 // sFacingSource: actor yaw or camera direction
+	std::uint16_t flags;                       // FilterFlag bits
+
+	// Line 0 (categories 0-2), line 1 (3-6), line 2 (7)
+	std::array<CategoryThresholds, kMaxActorCategories> categories;  // [0] = default, used when no rule matches
+
+	// Line 2 - read only when a flag says so, or on a category cache miss
+	const PluginConfig* config;            // Snapshot this block belongs to (set by PublishConfig)
+	const DecisionTable* decisionTables;   // FilterFlag::DecisionTable: one per category (owned by PluginConfig)
+	const FilterParameters* shadowFilter;  // FilterFlag::Shadow: candidate block (owned by PluginConfig::shadow)
+
+	bool Has(FilterFlag flag) const { return flags & (1u << static_cast<std::uint32_t>(flag)); }
+
+	void Set(FilterFlag flag, bool enabled)
+	{
+		const auto bit = static_cast<std::uint16_t>(1u << static_cast<std::uint32_t>(flag));
+		flags = static_cast<std::uint16_t>(enabled ? flags | bit : flags & ~bit);
+	}
+};
+static_assert(alignof(FilterParameters) == 64);
+static_assert(sizeof(FilterParameters) == 192, "FilterParameters should span exactly three cache lines");
+static_assert(offsetof(FilterParameters, categories) == 16, "The header must stay 16 bytes");
+static_assert(offsetof(FilterParameters, categories) + 3 * sizeof(CategoryThresholds) == 64, "Categories 0-2 must share the first line");
+static_assert(offsetof(FilterParameters, config) >= 128, "Pointers read on demand must stay off the first two lines");
@@ -0,0 +1,206 @@
+/**
+ * FilterStats.cpp - Per-thread filter statistics
+ *
+ * Each thread that calls AllowComment claims one slot from a fixed array on
+ * its first call. Only the owning thread writes its slot, so every update -
+ * increments and the running maximum alike - is a relaxed load + relaxed
+ * store (no lock prefix, no cache line ping-pong).
+ * Readers sum all slots with relaxed loads; counters are monotonic and
+ * independent, so no ordering between them is needed.
+ *
+ * Threads beyond kMaxStatsSlots share one overflow slot that uses fetch_add
+ * and a compare-exchange loop for the maximum.
+ *
+ * Call timing (enabled together with the shared-memory export) adds one
+ * __rdtsc per call and three more counters in the same slot: total, max and
+ * a log2 histogram, so a stutter shows up as a heavy tail rather than
+ * disappearing into the average.
+ *
+ * Game-independent (also built by tests/) - standard headers only, no PCH.
+ * The log summary lives with the other game-side reporting (StatsExport.cpp).
+ */
+
+#include "FilterStats.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+namespace
+{
+	inline constexpr std::size_t kMaxStatsSlots = 64;
+	inline constexpr std::size_t kOutcomeCount = static_cast<std::size_t>(FilterOutcome::kCount);
+	inline constexpr std::size_t kLineOfSightSources = static_cast<std::size_t>(LineOfSightSource::kCount);
+
+	static_assert(kOutcomeCount == StatsExport::kOutcomeCount, "Shared stats layout must match FilterOutcome");
+
+	struct alignas(64) StatsSlot
+	{
+		std::atomic<std::uint64_t> outcomes[kOutcomeCount];
+		std::atomic<std::uint64_t> timedCalls;
+		std::atomic<std::uint64_t> timedTicks;
+		std::atomic<std::uint64_t> maxTicks;
+		std::atomic<std::uint64_t> timeHistogram[StatsExport::kTimeBuckets];
+		std::atomic<std::uint64_t> referenceChecks;
+		std::atomic<std::uint64_t> referenceMismatches;
+		std::atomic<std::uint64_t> currentTicks;
+		std::atomic<std::uint64_t> referenceTicks;
+		std::atomic<std::uint64_t> lineOfSight[kLineOfSightSources];
+		std::atomic<std::uint64_t> shadow[4];
+		std::atomic<std::uint64_t> shadowTimedChecks;
+		std::atomic<std::uint64_t> shadowTicks;
+	};
+
+	std::array<StatsSlot, kMaxStatsSlots + 1> g_slots{};  // Last slot is the shared overflow slot
+	std::atomic<std::size_t> g_nextSlot{ 0 };
+
+	thread_local StatsSlot* t_slot = nullptr;
+
+	/**
+	 * Claims a slot for the calling thread on its first call.
+	 */
+	StatsSlot* GetThreadSlot()
+	{
+		if (!t_slot) {
+			const std::size_t index = g_nextSlot.fetch_add(1, std::memory_order_relaxed);
+			t_slot = &g_slots[std::min(index, kMaxStatsSlots)];
+		}
+		return t_slot;
+	}
+
+	/**
+	 * Adds to a counter. Owned slots have a single writer and skip the lock prefix.
+	 */
+	inline void Add(std::atomic<std::uint64_t>& counter, std::uint64_t amount, bool shared)
+	{
+		if (shared) {
+			counter.fetch_add(amount, std::memory_order_relaxed);
+		} else {
+			counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * Raises a running maximum. Owned slots have a single writer, so a plain
+	 * compare and store cannot lose an update; the shared slot needs the CAS loop.
+	 */
+	inline void Max(std::atomic<std::uint64_t>& counter, std::uint64_t value, bool shared)
+	{
+		std::uint64_t current = counter.load(std::memory_order_relaxed);
+		if (!shared) {
+			if (value > current) {
+				counter.store(value, std::memory_order_relaxed);
+			}
+			return;
+		}
+		while (value > current && !counter.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+		}
+	}
+}
+
+std::uint64_t FilterStatistics::Total() const
+{
+	std::uint64_t total = 0;
+	for (auto count : outcomes) {
+		total += count;
+	}
+	return total;
+}
+
+std::uint64_t FilterStatistics::Allowed() const
+{
+	return outcomes[static_cast<std::size_t>(FilterOutcome::AllowSanity)] +
+	       outcomes[static_cast<std::size_t>(FilterOutcome::AllowBypass)] +
+	       outcomes[static_cast<std::size_t>(FilterOutcome::AllowFilter)];
+}
+
+std::uint64_t FilterStatistics::Blocked() const
+{
+	return outcomes[static_cast<std::size_t>(FilterOutcome::BlockOutOfRange)] +
+	       outcomes[static_cast<std::size_t>(FilterOutcome::BlockFilter)] +
+	       outcomes[static_cast<std::size_t>(FilterOutcome::BlockLineOfSight)] +
+	       outcomes[static_cast<std::size_t>(FilterOutcome::BlockDwell)] +
+	       outcomes[static_cast<std::size_t>(FilterOutcome::BlockCooldown)] +
+	       outcomes[static_cast<std::size_t>(FilterOutcome::BlockRateLimit)];
+}
+
+void RecordOutcome(FilterOutcome outcome, std::uint64_t startTicks)
+{
+	StatsSlot* slot = GetThreadSlot();
+	const bool shared = slot == &g_slots[kMaxStatsSlots];  // Overflow slot
+
+	Add(slot->outcomes[static_cast<std::size_t>(outcome)], 1, shared);
+
+	if (startTicks) {
+		const std::uint64_t ticks = __rdtsc() - startTicks;
+		Add(slot->timedCalls, 1, shared);
+		Add(slot->timedTicks, ticks, shared);
+		Add(slot->timeHistogram[StatsExport::GetTimeBucket(ticks)], 1, shared);
+		Max(slot->maxTicks, ticks, shared);
+	}
+}
+
+void RecordReferenceCheck(bool mismatch, std::uint64_t currentTicks, std::uint64_t referenceTicks)
+{
+	StatsSlot* slot = GetThreadSlot();
+	const bool shared = slot == &g_slots[kMaxStatsSlots];
+
+	Add(slot->referenceChecks, 1, shared);
+	Add(slot->referenceMismatches, mismatch ? 1 : 0, shared);
+	Add(slot->currentTicks, currentTicks, shared);
+	Add(slot->referenceTicks, referenceTicks, shared);
+}
+
+void RecordLineOfSight(LineOfSightSource source)
+{
+	StatsSlot* slot = GetThreadSlot();
+	Add(slot->lineOfSight[static_cast<std::size_t>(source)], 1, slot == &g_slots[kMaxStatsSlots]);
+}
+
+void RecordShadow(bool activeAllow, bool candidateAllow, std::uint64_t ticks)
+{
+	StatsSlot* slot = GetThreadSlot();
+	const bool shared = slot == &g_slots[kMaxStatsSlots];
+
+	Add(slot->shadow[(activeAllow ? 2 : 0) + (candidateAllow ? 1 : 0)], 1, shared);
+	if (ticks) {
+		Add(slot->shadowTimedChecks, 1, shared);
+		Add(slot->shadowTicks, ticks, shared);
+	}
+}
+
+FilterStatistics CollectStatistics()
+{
+	FilterStatistics stats{};
+	for (const auto& slot : g_slots) {
+		for (std::size_t i = 0; i < kOutcomeCount; ++i) {
+			stats.outcomes[i] += slot.outcomes[i].load(std::memory_order_relaxed);
+		}
+		stats.timedCalls += slot.timedCalls.load(std::memory_order_relaxed);
+		stats.timedTicks += slot.timedTicks.load(std::memory_order_relaxed);
+		stats.maxTicks = std::max(stats.maxTicks, slot.maxTicks.load(std::memory_order_relaxed));
+		for (std::size_t i = 0; i < StatsExport::kTimeBuckets; ++i) {
+			stats.timeHistogram[i] += slot.timeHistogram[i].load(std::memory_order_relaxed);
+		}
+		stats.referenceChecks += slot.referenceChecks.load(std::memory_order_relaxed);
+		stats.referenceMismatches += slot.referenceMismatches.load(std::memory_order_relaxed);
+		stats.currentTicks += slot.currentTicks.load(std::memory_order_relaxed);
+		stats.referenceTicks += slot.referenceTicks.load(std::memory_order_relaxed);
+		for (std::size_t i = 0; i < kLineOfSightSources; ++i) {
+			stats.lineOfSight[i] += slot.lineOfSight[i].load(std::memory_order_relaxed);
+		}
+		for (std::size_t i = 0; i < 4; ++i) {
+			stats.shadow[i] += slot.shadow[i].load(std::memory_order_relaxed);
+		}
+		stats.shadowTimedChecks += slot.shadowTimedChecks.load(std::memory_order_relaxed);
+		stats.shadowTicks += slot.shadowTicks.load(std::memory_order_relaxed);
+	}
+	stats.threadCount = std::min(g_nextSlot.load(std::memory_order_relaxed), kMaxStatsSlots + 1);
+	return stats;
+}
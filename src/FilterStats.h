@@ -0,0 +1,95 @@
+#pragma once
+
+// Game-independent (also built by tests/) - standard headers only, no PCH.
+#include <cstddef>
+#include <cstdint>
+
+#include "StatsExportLayout.h"
+#include "LineOfSight.h"
+
+/**
+ * Outcome of one AllowComment call, recorded for statistics.
+ */
+enum class FilterOutcome : std::uint8_t
+{
+	AllowSanity = 0,       // Could not evaluate (no player/NPC) - allowed
+	AllowBypass = 1,       // Close range bypass
+	AllowFilter = 2,       // Passed the configured filter
+	BlockOutOfRange = 3,   // Broad-phase reject (beyond candidate range)
+	BlockFilter = 4,       // Failed the configured filter
+	BlockLineOfSight = 5,  // Passed the filter, but the NPC cannot see the player ([LineOfSight])
+	BlockDwell = 6,        // Passed the filter, but not for fDwellTime yet
+	BlockCooldown = 7,     // Allowed, but the NPC commented less than fNPCCooldown ago
+	BlockRateLimit = 8,    // Allowed, but fCommentsPerSecond was reached
+	kCount
+};
+
+/**
+ * Totals over all threads at the time of collection.
+ */
+struct FilterStatistics
+{
+	std::uint64_t outcomes[static_cast<std::size_t>(FilterOutcome::kCount)];
+	std::uint64_t timedCalls;  // Calls recorded with a start time
+	std::uint64_t timedTicks;  // Sum of their durations (TSC ticks)
+	std::uint64_t maxTicks;    // Slowest single call
+	std::uint64_t timeHistogram[StatsExport::kTimeBuckets];
+	std::size_t threadCount;   // Threads that have called the filter
+
+	// bReferenceCheck (AngleOnly mode only)
+	std::uint64_t referenceChecks;      // Decisions compared with the original plugin's logic
+	std::uint64_t referenceMismatches;  // ... that came out differently
+	std::uint64_t currentTicks;         // Time spent in DecideComment for those checks
+	std::uint64_t referenceTicks;       // Time spent in DecideCommentReference for those checks
+
+	// [LineOfSight], indexed by LineOfSightSource (raycast, cached, deferred)
+	std::uint64_t lineOfSight[static_cast<std::size_t>(LineOfSightSource::kCount)];
+
+	// [Shadow], indexed by active allow * 2 + candidate allow (filter decisions only)
+	std::uint64_t shadow[4];
+	std::uint64_t shadowTimedChecks;  // Candidate decisions timed (while statistics are exported)
+	std::uint64_t shadowTicks;        // Time spent deciding them
+
+	std::uint64_t Total() const;
+	std::uint64_t Allowed() const;
+	std::uint64_t Blocked() const;
+};
+
+/**
+ * Records one outcome in the calling thread's accumulator.
+ * Each thread owns a cache-line-aligned slot, so recording is a plain
+ * relaxed load + store with no contention between AI threads.
+ *
+ * @param outcome Result of the call
+ * @param startTicks __rdtsc() at the start of the call, or 0 if the call was not timed
+ */
+void RecordOutcome(FilterOutcome outcome, std::uint64_t startTicks = 0);
+
+/**
+ * Records one comparison against the original plugin's decision.
+ *
+ * @param mismatch The decisions differed
+ * @param currentTicks TSC ticks spent in DecideComment
+ * @param referenceTicks TSC ticks spent in DecideCommentReference
+ */
+void RecordReferenceCheck(bool mismatch, std::uint64_t currentTicks, std::uint64_t referenceTicks);
+
+/**
+ * Records where one line-of-sight answer came from.
+ */
+void RecordLineOfSight(LineOfSightSource source);
+
+/**
+ * Records one shadow comparison.
+ *
+ * @param activeAllow The active configuration's filter allowed the comment
+ * @param candidateAllow The candidate's filter allowed it
+ * @param ticks TSC ticks spent on the candidate decision, or 0 if not timed
+ */
+void RecordShadow(bool activeAllow, bool candidateAllow, std::uint64_t ticks);
+
+/**
+ * Sums all per-thread accumulators. Safe to call from any thread while
+ * the filter is running; the result may miss increments still in flight.
+ */
+FilterStatistics CollectStatistics();
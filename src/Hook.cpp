@@ -21,6 +21,7 @@
 #include "Hook.h"
 #include "CommentFilter.h"
 #include "PatternScanning.h"  // For kCommentBytes, kCommentByteCount
+#include "StartupTrace.h"
 
 inline constexpr size_t kMinJumpSize = 0xD;         // 13 bytes required for long jump (mov r11 + jmp r11)
 inline constexpr size_t kHookBufferSize = 0x100;    // 256 bytes for generated hook code
@@ -164,9 +165,12 @@ bool InstallCommentHook(uintptr_t commentAddress)
 	};
 
 	// Allocate executable memory for the hook
+	std::size_t allocatePhase = BeginStartupPhase("Hook buffer allocation");
 	void* hookBuffer = VirtualAlloc(nullptr, kHookBufferSize,
 		MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
 
+	EndStartupPhase(allocatePhase);
+
 	if (!hookBuffer) {
 		DWORD errorCode = GetLastError();
 		logger::error("Failed to allocate hook buffer!");
@@ -182,8 +186,10 @@ bool InstallCommentHook(uintptr_t commentAddress)
 
 	logger::info("Generating hook code with Xbyak...");
 
+	std::size_t codegenPhase = BeginStartupPhase("Hook code generation");
 	uintptr_t returnAddr = commentAddress + kCommentByteCount;
 	CommentHookCode code(hookBuffer, returnAddr);
+	EndStartupPhase(codegenPhase);
 
 	size_t codeSize = code.getSize();
 	logger::info("Hook code generated: {} bytes", codeSize);
@@ -203,7 +209,9 @@ bool InstallCommentHook(uintptr_t commentAddress)
 	logger::info("  Jump target: 0x{:016X}", (uintptr_t)code.getCode());
 	logger::info("  Overwrite size: {} bytes", kCommentByteCount);
 
+	std::size_t patchPhase = BeginStartupPhase("Patching");
 	WriteLongJmp64((void*)commentAddress, (void*)code.getCode(), kCommentByteCount);
+	EndStartupPhase(patchPhase);
 
 	logger::info("Long jump (mov r11, target; jmp r11) installed successfully");
 	logger::info("Hook installation: SUCCESSFUL");
@@ -0,0 +1,208 @@
+/**
+ * IniFile.cpp - Single-pass INI parser
+ *
+ * Game-independent (also built by tests/) - standard headers only, no PCH.
+ */
+
+#include "IniFile.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <utility>
+
+using namespace std::literals;
+
+namespace
+{
+	inline char ToLowerAscii(char c)
+	{
+		return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+	}
+
+	inline bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+	}
+
+	std::string_view Trim(std::string_view text)
+	{
+		while (!text.empty() && IsSpace(text.front())) {
+			text.remove_prefix(1);
+		}
+		while (!text.empty() && IsSpace(text.back())) {
+			text.remove_suffix(1);
+		}
+		return text;
+	}
+
+	bool EntryLess(const IniFile::Entry& entry, std::pair<std::string_view, std::string_view> target)
+	{
+		const int section = CompareIgnoreCase(entry.section, target.first);
+		return section != 0 ? section < 0 : CompareIgnoreCase(entry.key, target.second) < 0;
+	}
+}
+
+int CompareIgnoreCase(std::string_view a, std::string_view b)
+{
+	const std::size_t length = std::min(a.size(), b.size());
+	for (std::size_t i = 0; i < length; ++i) {
+		const char ca = ToLowerAscii(a[i]);
+		const char cb = ToLowerAscii(b[i]);
+		if (ca != cb) {
+			return ca < cb ? -1 : 1;
+		}
+	}
+	return a.size() == b.size() ? 0 : (a.size() < b.size() ? -1 : 1);
+}
+
+bool EqualsIgnoreCase(std::string_view a, std::string_view b)
+{
+	return a.size() == b.size() && CompareIgnoreCase(a, b) == 0;
+}
+
+std::optional<IniFile> IniFile::Load(const char* path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return std::nullopt;
+	}
+
+	IniFile ini;
+
+	// One read of the whole file - config files are a few KB
+	const auto size = static_cast<std::size_t>(file.tellg());
+	ini.text.resize(size);
+	file.seekg(0);
+	if (!file.read(ini.text.data(), static_cast<std::streamsize>(size))) {
+		return std::nullopt;
+	}
+
+	ini.Index();
+	return ini;
+}
+
+IniFile IniFile::Parse(std::string_view source)
+{
+	IniFile ini;
+	ini.text.assign(source.begin(), source.end());
+	ini.Index();
+	return ini;
+}
+
+void IniFile::Index()
+{
+	std::string_view remaining(text.data(), text.size());
+
+	// UTF-8 byte order mark (Notepad adds one)
+	if (remaining.starts_with("\xEF\xBB\xBF"sv)) {
+		remaining.remove_prefix(3);
+	}
+
+	std::string_view section;
+	std::uint32_t lineNumber = 0;
+
+	while (!remaining.empty()) {
+		const auto newline = remaining.find('\n');
+		std::string_view line = Trim(remaining.substr(0, newline));
+		remaining = newline == std::string_view::npos ? std::string_view{} : remaining.substr(newline + 1);
+		++lineNumber;
+
+		if (line.empty() || line.front() == ';' || line.front() == '#') {
+			continue;
+		}
+
+		if (line.front() == '[') {
+			const auto close = line.find(']');
+			if (close == std::string_view::npos) {
+				continue;
+			}
+			section = Trim(line.substr(1, close - 1));
+
+			const bool known = std::any_of(sections.begin(), sections.end(), [&](std::string_view name) {
+				return EqualsIgnoreCase(name, section);
+			});
+			if (!known) {
+				sections.push_back(section);
+			}
+			continue;
+		}
+
+		const auto equals = line.find('=');
+		if (equals == std::string_view::npos) {
+			continue;
+		}
+
+		std::string_view key = Trim(line.substr(0, equals));
+		std::string_view value = Trim(line.substr(equals + 1));
+		if (value.size() >= 2 && (value.front() == '"' || value.front() == '\'') && value.back() == value.front()) {
+			value = value.substr(1, value.size() - 2);
+		}
+
+		if (!key.empty()) {
+			entries.push_back({ section, key, value, lineNumber });
+		}
+	}
+
+	// Stable so the first of duplicate keys stays first, as with GetPrivateProfileString
+	std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+		const int sectionOrder = CompareIgnoreCase(a.section, b.section);
+		return sectionOrder != 0 ? sectionOrder < 0 : CompareIgnoreCase(a.key, b.key) < 0;
+	});
+}
+
+std::optional<std::string_view> IniFile::Find(std::string_view section, std::string_view key) const
+{
+	const auto it = std::lower_bound(entries.begin(), entries.end(), std::pair{ section, key }, EntryLess);
+	if (it == entries.end() || !EqualsIgnoreCase(it->section, section) || !EqualsIgnoreCase(it->key, key)) {
+		return std::nullopt;
+	}
+	return it->value;
+}
+
+std::string_view IniFile::GetString(std::string_view section, std::string_view key, std::string_view defaultValue) const
+{
+	return Find(section, key).value_or(defaultValue);
+}
+
+bool IniFile::GetBool(std::string_view section, std::string_view key, bool defaultValue) const
+{
+	const auto value = Find(section, key);
+	return value ? ParseIniBool(*value, defaultValue) : defaultValue;
+}
+
+float IniFile::GetFloat(std::string_view section, std::string_view key, float defaultValue) const
+{
+	const auto value = Find(section, key);
+	return value ? ParseIniFloat(*value, defaultValue) : defaultValue;
+}
+
+bool ParseIniBool(std::string_view value, bool defaultValue)
+{
+	// Check various boolean representations
+	for (std::string_view name : { "true"sv, "yes"sv, "1"sv, "on"sv, "enabled"sv }) {
+		if (EqualsIgnoreCase(value, name)) {
+			return true;
+		}
+	}
+	for (std::string_view name : { "false"sv, "no"sv, "0"sv, "off"sv, "disabled"sv }) {
+		if (EqualsIgnoreCase(value, name)) {
+			return false;
+		}
+	}
+
+	// Return default if value is unrecognized
+	return defaultValue;
+}
+
+float ParseIniFloat(std::string_view value, float defaultValue)
+{
+	// from_chars rejects a leading '+', atof did not
+	if (value.starts_with('+')) {
+		value.remove_prefix(1);
+	}
+
+	float result = defaultValue;
+	const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+	return error == std::errc{} ? result : defaultValue;
+}
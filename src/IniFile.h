@@ -0,0 +1,123 @@
+#pragma once
+
+// Game-independent (also built by tests/) - standard headers only, no PCH.
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/**
+ * Case-insensitive (ASCII) comparison, matching how the Win32 profile API
+ * treats section and key names.
+ */
+bool EqualsIgnoreCase(std::string_view a, std::string_view b);
+
+/**
+ * Case-insensitive (ASCII) three-way comparison.
+ *
+ * @return Negative, zero or positive like strcmp
+ */
+int CompareIgnoreCase(std::string_view a, std::string_view b);
+
+/**
+ * Converts an INI value to a boolean. Supports true/false, yes/no, 1/0, on/off, enabled/disabled.
+ *
+ * @return The value, or defaultValue if it is unrecognized
+ */
+bool ParseIniBool(std::string_view value, bool defaultValue);
+
+/**
+ * Converts an INI value to a float. Leading '+' and trailing text are ignored ("30 degrees" reads as 30).
+ *
+ * @return The value, or defaultValue if it is not a number
+ */
+float ParseIniFloat(std::string_view value, float defaultValue);
+
+/**
+ * Read-only INI document, parsed in one pass.
+ *
+ * The file is read into a single buffer and every section, key and value is a
+ * string_view into it - nothing is copied per entry. Lookups use a sorted
+ * index, so each getter is a binary search instead of a file reparse.
+ *
+ * Parsing follows GetPrivateProfileString so existing INI files behave the same:
+ *   - Section and key names are case-insensitive, the first occurrence wins
+ *   - Lines starting with ';' or '#' are comments, lines without '=' are ignored
+ *   - Keys and values are trimmed, a value enclosed in matching quotes is unquoted
+ *   - Text after the value is part of the value (no inline comments)
+ *
+ * Uses only the standard library, so it is built and fuzzed outside the game
+ * (tests/IniFileTest.cpp, tests/IniFileFuzz.cpp).
+ */
+class IniFile
+{
+public:
+	struct Entry
+	{
+		std::string_view section;
+		std::string_view key;
+		std::string_view value;
+		std::uint32_t line;  // 1-based, for diagnostics
+	};
+
+	/**
+	 * Reads and parses a file with a single read.
+	 *
+	 * @param path File to read
+	 * @return Parsed document, or std::nullopt if the file cannot be opened
+	 */
+	static std::optional<IniFile> Load(const char* path);
+
+	/**
+	 * Parses INI text (copied into the document's own buffer).
+	 */
+	static IniFile Parse(std::string_view text);
+
+	IniFile(IniFile&&) noexcept = default;
+	IniFile& operator=(IniFile&&) noexcept = default;
+	IniFile(const IniFile&) = delete;  // Views point into the buffer
+	IniFile& operator=(const IniFile&) = delete;
+
+	/**
+	 * @return The raw value, or std::nullopt if the key is not present
+	 */
+	std::optional<std::string_view> Find(std::string_view section, std::string_view key) const;
+
+	/**
+	 * @return The value, or defaultValue if the key is not present
+	 */
+	std::string_view GetString(std::string_view section, std::string_view key, std::string_view defaultValue) const;
+
+	/**
+	 * Reads a boolean (see ParseIniBool).
+	 *
+	 * @return The value, or defaultValue if the key is missing or unrecognized
+	 */
+	bool GetBool(std::string_view section, std::string_view key, bool defaultValue) const;
+
+	/**
+	 * Reads a float (see ParseIniFloat).
+	 *
+	 * @return The value, or defaultValue if the key is missing or not a number
+	 */
+	float GetFloat(std::string_view section, std::string_view key, float defaultValue) const;
+
+	/**
+	 * @return Distinct section names in file order
+	 */
+	const std::vector<std::string_view>& GetSections() const { return sections; }
+
+	/**
+	 * @return All entries, sorted by section then key (case-insensitive, file order for duplicates)
+	 */
+	const std::vector<Entry>& GetEntries() const { return entries; }
+
+private:
+	IniFile() = default;
+
+	void Index();
+
+	std::vector<char> text;  // Owns the characters all views point into (stable across moves)
+	std::vector<std::string_view> sections;
+	std::vector<Entry> entries;
+};
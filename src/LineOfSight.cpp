@@ -0,0 +1,32 @@
+/**
+ * LineOfSight.cpp - Line-of-sight stage, game side
+ *
+ * The scheduler (LineOfSight.h) decides whether a raycast is made; this file
+ * supplies the clock (StageClock.h) and the raycast. The engine's Actor::HasLineOfSight is
+ * the same test AI detection uses, and the game already calls it from the
+ * AI job threads AllowComment runs on.
+ */
+
+#include "PCH.h"
+#include "LineOfSight.h"
+#include "StageClock.h"
+#include "WorldEvents.h"
+
+namespace
+{
+	LineOfSightScheduler g_lineOfSight;  // Shared by all AI threads (lock-free)
+	WorldGenerationWatch g_lineOfSightWorld;  // Results only hold in the world they were cast in
+}
+
+LineOfSightResult CheckLineOfSight(RE::Character* npc, RE::PlayerCharacter* player, float dx, float dy, float dz,
+	const LineOfSightSettings& settings)
+{
+	if (g_lineOfSightWorld.Changed()) {
+		g_lineOfSight.Clear();
+	}
+
+	return g_lineOfSight.Check(npc->GetFormID(), dx, dy, dz, GetStageMilliseconds(), settings, [&] {
+		bool unused = false;
+		return npc->HasLineOfSight(player, unused);
+	});
+}
@@ -0,0 +1,250 @@
+#pragma once
+
+// Game-independent (also built by tests/) - standard headers only, no PCH.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace RE
+{
+	class Character;
+	class PlayerCharacter;
+}
+
+/**
+ * Line-of-sight stage.
+ *
+ * Runs only for comments the filter already allowed, so the raycast is paid
+ * for the few NPCs that are in range and in view - never for the crowd that
+ * the angle and distance tests reject. Even then raycasts are rationed:
+ *
+ *   - A global budget of raycasts per kLineOfSightWindow (one frame at 60 fps),
+ *     shared by all AI threads.
+ *   - A per-actor cache. A result stays valid for the cache TTL while the
+ *     NPC-player offset stays in the same cell of a fMoveTolerance grid, so an
+ *     NPC that keeps trying to comment from the same spot costs one raycast
+ *     per TTL.
+ *   - Over budget, the check is deferred: the NPC keeps its last result (even
+ *     if stale) and gets a raycast on a later attempt once the budget allows.
+ *     An NPC that was never checked keeps the filter's decision.
+ *
+ * LineOfSightScheduler never calls into the game: the raycast is a callable
+ * and the time is passed in, so the budget and cache can be driven by a mock
+ * ray provider and a synthetic clock outside of Skyrim.
+ */
+
+inline constexpr std::uint64_t kLineOfSightWindowMilliseconds = 16;  // Budget window
+
+/**
+ * [LineOfSight] limits.
+ */
+struct LineOfSightSettings
+{
+	std::uint32_t raycastBudget;      // Raycasts per window, all threads together
+	std::uint32_t cacheMilliseconds;  // Lifetime of a cached result (at most kMaxCacheMilliseconds, in whole budget windows)
+	float moveTolerance;              // Grid size for the NPC-player offset, game units
+
+	bool operator==(const LineOfSightSettings&) const = default;
+};
+
+/**
+ * Where a line-of-sight answer came from (for statistics).
+ */
+enum class LineOfSightSource : std::uint8_t
+{
+	Raycast = 0,   // Raycast made for this call
+	Cached = 1,    // Fresh cache entry
+	Deferred = 2,  // Over budget - last known result, or visible if there is none
+	kCount
+};
+
+struct LineOfSightResult
+{
+	bool visible;
+	LineOfSightSource source;
+};
+
+/**
+ * Raycast budget and per-actor result cache.
+ *
+ * The cache is an open-addressing table of 64-bit slots:
+ *   bits  0-31  actor reference FormID (0 = empty slot)
+ *   bits 32-43  hash of the quantized NPC-player offset
+ *   bit  44     visible
+ *   bits 45-63  time of the raycast in budget windows, modulo 2^19 (~2.3 h)
+ * Slots are claimed and updated with a single CAS of the whole word, like the
+ * category cache (ActorRules.cpp). Entries are never removed, only replaced
+ * once stale, so a probe sequence ends at the first empty slot.
+ *
+ * Ages are taken modulo the timestamp range, so an entry left alone for a
+ * whole wrap would look fresh again. The first call in each wrap period of
+ * the full clock clears the table; no entry outlives one wrap.
+ *
+ * The budget is one word: window number in bits 24-63, raycasts made in that
+ * window in bits 0-23.
+ */
+class LineOfSightScheduler
+{
+public:
+	static constexpr std::size_t kCacheSize = 0x1000;             // 4096 slots (power of two)
+	static constexpr std::size_t kMaxProbe = 16;                  // Slots searched per actor
+	static constexpr std::uint32_t kMaxCacheMilliseconds = 10000; // Far below the ~2.3 h timestamp wrap
+
+	/**
+	 * Answers whether the NPC can see the player, raycasting only if the
+	 * cache has no fresh answer and the budget allows.
+	 *
+	 * @param actorID NPC reference FormID (non-zero)
+	 * @param dx NPC position minus player position
+	 * @param nowMilliseconds Monotonic time
+	 * @param settings Budget and cache limits
+	 * @param raycast Callable returning true if the NPC can see the player
+	 */
+	template <class Raycast>
+	LineOfSightResult Check(std::uint32_t actorID, float dx, float dy, float dz, std::uint64_t nowMilliseconds,
+		const LineOfSightSettings& settings, Raycast&& raycast)
+	{
+		const std::uint64_t positionKey = GetPositionKey(dx, dy, dz, settings.moveTolerance);
+		const std::uint64_t windows = nowMilliseconds / kLineOfSightWindowMilliseconds;
+		const std::uint64_t now = windows & kTimeMask;
+		const std::uint64_t lifetime = settings.cacheMilliseconds / kLineOfSightWindowMilliseconds;
+
+		// A new wrap period: forget entries whose age could alias
+		std::uint64_t seenPeriod = period.load(std::memory_order_relaxed);
+		if (seenPeriod != windows >> kTimeBits && period.compare_exchange_strong(seenPeriod, windows >> kTimeBits, std::memory_order_relaxed)) {
+			Clear();
+		}
+
+		// Find the actor's entry, and the first slot a new entry could take
+		std::size_t slot = HashActor(actorID);
+		std::size_t freeSlot = kCacheSize;
+		std::uint64_t freeEntry = 0;
+		std::uint64_t entry = 0;
+		bool found = false;
+
+		for (std::size_t probe = 0; probe < kMaxProbe; ++probe, slot = (slot + 1) & (kCacheSize - 1)) {
+			entry = cache[slot].load(std::memory_order_relaxed);
+			if (static_cast<std::uint32_t>(entry) == actorID) {
+				found = true;
+				break;
+			}
+			if (freeSlot == kCacheSize && (entry == 0 || GetAge(entry, now) >= lifetime)) {
+				freeSlot = slot;
+				freeEntry = entry;
+			}
+			if (entry == 0) {
+				break;
+			}
+		}
+
+		const bool cachedVisible = (entry >> kVisibleShift) & 1;
+		if (found && ((entry >> kPositionShift) & kPositionMask) == positionKey && GetAge(entry, now) < lifetime) {
+			return { cachedVisible, LineOfSightSource::Cached };
+		}
+
+		if (!TryConsumeBudget(nowMilliseconds, settings.raycastBudget)) {
+			return { found ? cachedVisible : true, LineOfSightSource::Deferred };
+		}
+
+		const bool visible = raycast();
+
+		// If another thread updated the slot meanwhile, its result is as good as ours
+		const std::uint64_t updated = static_cast<std::uint64_t>(actorID) |
+		                              (positionKey << kPositionShift) |
+		                              (static_cast<std::uint64_t>(visible) << kVisibleShift) |
+		                              (now << kTimeShift);
+		if (found) {
+			cache[slot].compare_exchange_strong(entry, updated, std::memory_order_relaxed);
+		} else if (freeSlot != kCacheSize) {
+			cache[freeSlot].compare_exchange_strong(freeEntry, updated, std::memory_order_relaxed);
+		}
+		return { visible, LineOfSightSource::Raycast };
+	}
+
+	/**
+	 * Takes one raycast from the current window's budget. A thread whose clock
+	 * reading is behind another's counts against the newer window, so a late
+	 * caller never starts an old window's budget over.
+	 *
+	 * @return false if the window's budget is used up
+	 */
+	bool TryConsumeBudget(std::uint64_t nowMilliseconds, std::uint32_t raycastBudget)
+	{
+		const std::uint64_t now = (nowMilliseconds / kLineOfSightWindowMilliseconds) & kWindowMask;
+		std::uint64_t state = budget.load(std::memory_order_relaxed);
+		for (;;) {
+			const std::uint64_t window = std::max(state >> kCountBits, now);
+			const std::uint64_t used = (state >> kCountBits) == window ? (state & kCountMask) : 0;
+			if (used >= raycastBudget) {
+				return false;
+			}
+			if (budget.compare_exchange_weak(state, (window << kCountBits) | (used + 1), std::memory_order_relaxed)) {
+				return true;
+			}
+		}
+	}
+
+	/**
+	 * Forgets all cached results (after a world change, see WorldEvents.h).
+	 */
+	void Clear()
+	{
+		for (auto& slot : cache) {
+			slot.store(0, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	static constexpr int kPositionShift = 32;
+	static constexpr std::uint64_t kPositionMask = 0xFFF;
+	static constexpr int kVisibleShift = 44;
+	static constexpr int kTimeShift = 45;
+	static constexpr int kTimeBits = 64 - kTimeShift;
+	static constexpr std::uint64_t kTimeMask = (1ull << kTimeBits) - 1;
+	static_assert(kMaxCacheMilliseconds / kLineOfSightWindowMilliseconds < kTimeMask, "cache lifetime must be shorter than the timestamp wrap");
+	static constexpr int kCountBits = 24;
+	static constexpr std::uint64_t kCountMask = (1ull << kCountBits) - 1;
+	static constexpr std::uint64_t kWindowMask = (1ull << (64 - kCountBits)) - 1;
+
+	static std::size_t HashActor(std::uint32_t actorID)
+	{
+		return (actorID * 0x9E3779B1u) >> (32 - 12);
+	}
+	static_assert(kCacheSize == (1u << 12), "HashActor shift must match cache size");
+
+	/**
+	 * @return 12-bit hash of the offset's cell in a grid of the given size
+	 */
+	static std::uint64_t GetPositionKey(float dx, float dy, float dz, float tolerance)
+	{
+		const float scale = tolerance > 0.0f ? 1.0f / tolerance : 1.0f;
+		const auto qx = static_cast<std::uint32_t>(static_cast<std::int32_t>(std::floor(dx * scale)));
+		const auto qy = static_cast<std::uint32_t>(static_cast<std::int32_t>(std::floor(dy * scale)));
+		const auto qz = static_cast<std::uint32_t>(static_cast<std::int32_t>(std::floor(dz * scale)));
+		return ((qx * 73856093u ^ qy * 19349663u ^ qz * 83492791u) >> 20) & kPositionMask;
+	}
+
+	static std::uint64_t GetAge(std::uint64_t entry, std::uint64_t now)
+	{
+		return (now - (entry >> kTimeShift)) & kTimeMask;
+	}
+
+	std::array<std::atomic<std::uint64_t>, kCacheSize> cache{};
+	std::atomic<std::uint64_t> budget{ 0 };
+	std::atomic<std::uint64_t> period{ 0 };  // Full clock's wrap period the table's timestamps belong to
+};
+
+/**
+ * Game adapter: checks whether the NPC can see the player through the shared
+ * scheduler, using the engine's line-of-sight test as the raycast.
+ *
+ * @param npc NPC that wants to comment
+ * @param player The player
+ * @param dx NPC position minus player position (from the comment query)
+ * @param settings Active [LineOfSight] limits
+ */
+LineOfSightResult CheckLineOfSight(RE::Character* npc, RE::PlayerCharacter* player, float dx, float dy, float dz,
+	const LineOfSightSettings& settings);
@@ -3,11 +3,22 @@
 #include "PatternScanning.h"
 #include "Hook.h"
 #include "CommentFilter.h"
+#include "ActorRules.h"
+#include "FilterStats.h"
+#include "ConfigWatcher.h"
+#include "CellProfiles.h"
+#include "StartupLog.h"
+#include "StartupTrace.h"
+#include "StatsExport.h"
+#include "PgoTraining.h"
+#include "LineOfSight.h"
+#include "WorldEvents.h"
 
 namespace
 {
 	/**
-	 * Setup logging to the SKSE log directory
+	 * Setup logging to the SKSE log directory.
+	 * Startup records are buffered until FinishStartup() (see StartupLog.h).
 	 */
 	void SetupLog()
 	{
@@ -17,14 +28,56 @@ namespace
 		}
 
 		*path /= "to-your-face-reloaded.log";
-		auto sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(path->string(), true);
+		SetupStartupLog(*path);
+	}
+
+	/**
+	 * Writes the startup trace (if enabled) and the buffered startup log at
+	 * the configured verbosity. Called on every exit path of SKSEPlugin_Load.
+	 */
+	void FinishStartup()
+	{
+		const SnapshotReadGuard snapshotGuard;  // The config watcher may already be running
+		const PluginConfig* config = GetActiveConfig();
+		if (config && config->settings.enableStartupTrace) {
+			if (auto path = SKSE::log::log_directory()) {
+				WriteStartupTrace(*path / "to-your-face-reloaded-startup.json");
+			}
+		}
+		FinishStartupLog(config ? config->settings.startupLogVerbosity : StartupLogVerbosity::Full);
+	}
+
+	/**
+	 * SKSE message handler - runs work that needs game forms to be loaded
+	 */
+	void MessageHandler(SKSE::MessagingInterface::Message* a_msg)
+	{
+		switch (a_msg->type) {
+			case SKSE::MessagingInterface::kDataLoaded:
+				CompileActorRules();
+				RegisterCellEventHandler();
+				RegisterWorldEventHandlers();
+#ifdef TYF_PGO_INSTRUMENT
+				RunPgoTraining();
+#endif
+				break;
+
+			case SKSE::MessagingInterface::kPostLoadGame:
+			case SKSE::MessagingInterface::kNewGame:
+				BumpWorldGeneration(WorldChange::GameLoad);
+				UpdatePlayerLocation();
+				CollectRetiredConfigs();
+				break;
 
-		auto log = std::make_shared<spdlog::logger>("global log", std::move(sink));
-		log->set_level(spdlog::level::info);
-		log->flush_on(spdlog::level::info);
+			case SKSE::MessagingInterface::kSaveGame:
+				LogFilterStatistics();
+				LogWorldChanges();
+				CollectRetiredConfigs();
+				break;
 
-		spdlog::set_default_logger(std::move(log));
-		spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%l] %v");
+			default:
+				break;
+		}
 	}
 }
 
@@ -58,6 +111,12 @@ extern "C" DLLEXPORT bool SKSEAPI SKSEPlugin_Query(const SKSE::QueryInterface* a
 	a_info->name = Plugin::NAME.data();
 	a_info->version = Plugin::VERSION[0];
 
+	StartupPhaseScope queryPhase("SKSEPlugin_Query");
+	{
+		StartupPhaseScope phase("Log setup");
+		SetupLog();
+	}
+
 	// Editor check
 	if (a_skse->IsEditor()) {
 		logger::critical("Loaded in editor, marking as incompatible");
@@ -65,7 +124,9 @@ extern "C" DLLEXPORT bool SKSEAPI SKSEPlugin_Query(const SKSE::QueryInterface* a
 	}
 
 	// Version check
+	std::size_t runtimePhase = BeginStartupPhase("Runtime check");
 	const auto ver = a_skse->RuntimeVersion();
+	EndStartupPhase(runtimePhase);
 	if (ver < SKSE::RUNTIME_SSE_1_5_39) {
 		logger::critical("Unsupported runtime version: {}", ver.string());
 		logger::critical("Minimum required: 1.5.39");
@@ -87,7 +148,10 @@ extern "C" DLLEXPORT bool SKSEAPI SKSEPlugin_Query(const SKSE::QueryInterface* a
 		return false;
 	}
 
-	if (!IsBinaryCompatible(*commentAddress)) {
+	std::size_t compatibilityPhase = BeginStartupPhase("Binary compatibility check");
+	const bool compatible = IsBinaryCompatible(*commentAddress);
+	EndStartupPhase(compatibilityPhase);
+	if (!compatible) {
 		logger::critical("Binary compatibility check failed!");
 		logger::critical("  The game executable has unexpected bytes at the hook location");
 		logger::critical("  Installing the hook would likely cause crashes");
@@ -103,11 +167,19 @@ extern "C" DLLEXPORT bool SKSEAPI SKSEPlugin_Query(const SKSE::QueryInterface* a
  */
 extern "C" DLLEXPORT bool SKSEAPI SKSEPlugin_Load(const SKSE::LoadInterface* a_skse)
 {
+	StartupPhaseScope loadPhase("SKSEPlugin_Load");
+
 	// Initialize SKSE
-	SKSE::Init(a_skse);
+	{
+		StartupPhaseScope phase("SKSE init");
+		SKSE::Init(a_skse);
+	}
 
 	// Set up logging
-	SetupLog();
+	{
+		StartupPhaseScope phase("Log setup");
+		SetupLog();
+	}
 
 	logger::info("================================================================================");
 	logger::info("{} v{}", Plugin::NAME, Plugin::VERSION.string());
@@ -121,48 +193,121 @@ extern "C" DLLEXPORT bool SKSEAPI SKSEPlugin_Load(const SKSE::LoadInterface* a_s
 
 	// Load configuration
 	logger::info("");
-	if (!LoadConfiguration()) {
+	std::size_t configPhase = BeginStartupPhase("Config load");
+	const bool configLoaded = LoadConfiguration();
+	EndStartupPhase(configPhase);
+	if (!configLoaded) {
 		logger::error("Failed to load configuration!");
+		FinishStartup();
 		return false;
 	}
 
+	// Register for SKSE messages (actor category rules are compiled once forms are loaded)
+	if (!SKSE::GetMessagingInterface()->RegisterListener(MessageHandler)) {
+		logger::warn("Failed to register SKSE message listener - actor categories will not be applied");
+	}
+
+	// Watch the config files for live tuning (reloads run on the watcher thread)
+	if (GetActiveConfig()->settings.enableHotReload) {
+		logger::info("");
+		StartupPhaseScope phase("Config watcher start");
+		StartConfigWatcher();
+	}
+
+	// Publish live statistics for tools/StatsReader (summed on the export thread)
+	if (GetActiveConfig()->settings.enableStatsExport) {
+		logger::info("");
+		StartupPhaseScope phase("Statistics export start");
+		StartStatsExport();
+	}
+
 	// Install hook
 	logger::info("");
 	auto commentAddress = GetCommentAddress();
 	if (!commentAddress) {
 		logger::error("Failed to locate NPC comment function - hook not installed!");
 		logger::error("Plugin will load but will not function");
+		FinishStartup();
 		return true;  // Don't fail completely, just warn
 	}
 
 	if (!InstallCommentHook(*commentAddress)) {
 		logger::error("Failed to install comment hook!");
 		logger::error("Plugin will load but will not function");
+		FinishStartup();
 		return true;  // Don't fail completely, just warn
 	}
 
 	logger::info("");
+	BeginStartupSummary();
 	logger::info("================================================================================");
 	logger::info("{} v{} - Initialization Complete", Plugin::NAME, Plugin::VERSION.string());
 	logger::info("================================================================================");
 
 	// Print final status summary
-	constexpr std::array filterModeNames = { "ANGLE ONLY", "DISTANCE ONLY", "BOTH (AND)", "EITHER (OR)" };
+	const SnapshotReadGuard snapshotGuard;
+	const PluginConfig& config = *GetActiveConfig();
+	constexpr std::array filterModeNames = { "ANGLE ONLY", "DISTANCE ONLY", "BOTH (AND)", "EITHER (OR)", "EXPRESSION", "FRUSTUM (ON SCREEN)" };
 	logger::info("[INFO] Final Status:");
 	logger::info("  Plugin status: ACTIVE");
-	logger::info("  Filter mode: {}", filterModeNames[static_cast<int>(g_config.filterMode)]);
+	logger::info("  Filter mode: {}", filterModeNames[static_cast<int>(config.filter.filterMode)]);
+
+	if (config.filter.filterMode == FilterMode::AngleOnly || config.filter.filterMode == FilterMode::Both || config.filter.filterMode == FilterMode::Either) {
+		logger::info("  Angle filtering: ENABLED (max deviation: {:.0f} degrees)", config.settings.maxDeviationAngle * 180.0f / pi);
+	}
+
+	if (config.filter.filterMode == FilterMode::DistanceOnly || config.filter.filterMode == FilterMode::Both || config.filter.filterMode == FilterMode::Either) {
+		logger::info("  Distance filtering: ENABLED (max distance: {:.1f} units)", config.settings.maxGreetingDistance);
+	}
+
+	if (config.filter.filterMode == FilterMode::Frustum) {
+		logger::info("  On-screen filtering: ENABLED (camera view frustum, falls back to {:.0f} degree angle without a camera)", config.settings.maxDeviationAngle * 180.0f / pi);
+	}
+
+	if (config.filter.filterMode == FilterMode::Expression) {
+		logger::info("  Filter expression: {}", config.filter.filterExpression->IsJitCompiled() ? "native x64 (Xbyak)" : "bytecode interpreter");
+	}
+
+	if (config.filter.facingSource == FacingSource::Camera) {
+		logger::info("  Facing source: CAMERA (look direction, actor yaw while looking straight up/down)");
+	}
+
+	if (config.filter.Has(FilterFlag::ViewCone3D)) {
+		logger::info("  3D view cone: ENABLED (eye height by race, includes pitch)");
+	}
+
+	if (config.filter.Has(FilterFlag::CloseRangeBypass)) {
+		logger::info("  Close range bypass: ENABLED (threshold: {:.1f} units)", config.settings.closeRangeDistance);
+	}
+
+	if (config.filter.Has(FilterFlag::DwellTime)) {
+		logger::info("  Dwell time: ENABLED ({} ms facing before a comment)", config.settings.dwellMilliseconds);
+	}
+
+	if (config.filter.Has(FilterFlag::RateLimit)) {
+		logger::info("  Rate limit: ENABLED ({} comments per second, {:.2f} s NPC cooldown)",
+			config.settings.rateLimit.commentsPerSecond > 0.0f ? std::format("{:.2f}", config.settings.rateLimit.commentsPerSecond) : "unlimited"s,
+			config.settings.rateLimit.cooldownMilliseconds / 1000.0f);
+	}
+
+	if (config.filter.Has(FilterFlag::LineOfSight)) {
+		logger::info("  Line of sight: ENABLED ({} raycasts per {} ms, results cached {:.2f} s)",
+			config.settings.lineOfSight.raycastBudget, kLineOfSightWindowMilliseconds, config.settings.lineOfSight.cacheMilliseconds / 1000.0f);
+	}
 
-	if (g_config.filterMode == FilterMode::AngleOnly || g_config.filterMode == FilterMode::Both || g_config.filterMode == FilterMode::Either) {
-		logger::info("  Angle filtering: ENABLED (max deviation: {:.0f} degrees)", g_config.maxDeviationAngle * 180.0f / pi);
+	if (config.shadow) {
+		logger::info("  Shadow mode: ENABLED (candidate filter mode {}, results logged on save)",
+			filterModeNames[static_cast<int>(config.shadow->filter.filterMode)]);
 	}
 
-	if (g_config.filterMode == FilterMode::DistanceOnly || g_config.filterMode == FilterMode::Both || g_config.filterMode == FilterMode::Either) {
-		logger::info("  Distance filtering: ENABLED (max distance: {:.1f} units)", g_config.maxGreetingDistance);
+	if (!config.settings.categoryRules.empty()) {
+		logger::info("  Actor categories: {} (compiled when game data is loaded)", config.settings.categoryRules.size());
 	}
 
-	if (g_config.enableCloseRangeBypass) {
-		logger::info("  Close range bypass: ENABLED (threshold: {:.1f} units)", g_config.closeRangeDistance);
+	if (!config.settings.thresholdProfiles.empty()) {
+		logger::info("  Threshold profiles: {} (switched on cell change)", config.settings.thresholdProfiles.size());
 	}
 
+	FinishStartup();
 	return true;
 }
@@ -31,6 +31,7 @@
 
 #include "PCH.h"
 #include "PatternScanning.h"
+#include "StartupTrace.h"
 #include <immintrin.h>  // SSE2, AVX2 intrinsics
 #include <intrin.h>     // CPU feature detection, bit manipulation
 
@@ -214,7 +215,9 @@ std::optional<uintptr_t> GetCommentAddress()
 	logger::info("  Pattern bytes: F3 0F 59 F6 0F B6 EB B8 01 00 00 00 0F 2F F0 0F 43 E8");
 
 	// Detect CPU features
+	std::size_t detectPhase = BeginStartupPhase("CPU feature detection");
 	CPUFeatures cpu = DetectCPUFeatures();
+	EndStartupPhase(detectPhase);
 	logger::info("  CPU features detected:");
 	if (cpu.avx2) {
 		logger::info("    - AVX2: Available (using 256-bit SIMD)");
@@ -231,6 +234,7 @@ std::optional<uintptr_t> GetCommentAddress()
 	LARGE_INTEGER freq, time_start, time_end;
 	QueryPerformanceFrequency(&freq);
 	QueryPerformanceCounter(&time_start);
+	std::size_t scanPhase = BeginStartupPhase("Pattern scan");
 
 	// FIX #5: Separate __try/__except for each SIMD level with graceful fallback
 	// Catches ACCESS_VIOLATION and ILLEGAL_INSTRUCTION. Scalar fallback is OUTSIDE
@@ -281,11 +285,13 @@ std::optional<uintptr_t> GetCommentAddress()
 			}
 		} __except (EXCEPTION_EXECUTE_HANDLER) {
 			logger::error("Scalar scan raised exception, aborting");
+			EndStartupPhase(scanPhase);
 			return std::nullopt;
 		}
 	}
 
 	QueryPerformanceCounter(&time_end);
+	EndStartupPhase(scanPhase);
 	double elapsed_ms = (time_end.QuadPart - time_start.QuadPart) * 1000.0 / freq.QuadPart;
 
 	if (result) {
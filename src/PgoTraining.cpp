@@ -0,0 +1,124 @@
+/**
+ * PgoTraining.cpp - Training workload for profile-guided optimization
+ *
+ * Only compiled into PGO_MODE=INSTRUMENT builds. The instrumented DLL already
+ * profiles the startup path (pattern scan, config parsing, hook codegen) and
+ * whatever comment checks happen while playing; this adds a fixed synthetic
+ * stream so every profile sees the same decision mix regardless of how long
+ * the training session was:
+ *   - NPCs scattered 0-4000 units around the player, most out of range as in
+ *     a crowded exterior cell, a few right next to the player
+ *   - Random player yaw (and pitch with b3DViewCone), changing every few
+ *     queries (repeat checks of the same frame share the cached forward vector)
+ *   - The configured filter mode gets most of the calls, the other modes a
+ *     tenth each, so the configured path is laid out as the hot one (through
+ *     the decision table when bDecisionTable built one)
+ * The generator is a fixed-seed LCG, so the workload is identical every run.
+ */
+
+#include "PCH.h"
+
+#ifdef TYF_PGO_INSTRUMENT
+
+#include "PgoTraining.h"
+#include "FilterCore.h"
+
+namespace
+{
+	inline constexpr std::size_t kConfiguredModeQueries = 1'000'000;
+	inline constexpr std::size_t kOtherModeQueries = 100'000;
+	inline constexpr std::size_t kQueriesPerFrame = 16;  // Comment checks sharing one player yaw
+
+	/**
+	 * Fixed-seed linear congruential generator (Numerical Recipes constants).
+	 */
+	struct TrainingRandom
+	{
+		std::uint32_t state = 0x2545F491;
+
+		float Next()  // [0, 1)
+		{
+			state = state * 1664525u + 1013904223u;
+			return static_cast<float>(state >> 8) * (1.0f / 16777216.0f);
+		}
+	};
+
+	/**
+	 * Runs a synthetic stream through DecideComment.
+	 *
+	 * @return Number of allowed comments (consumed so the calls are not optimized away)
+	 */
+	std::size_t Train(const FilterParameters& filter, std::size_t queries)
+	{
+		TrainingRandom random;
+		CommentQuery query{};
+		std::size_t allowed = 0;
+
+		for (std::size_t i = 0; i < queries; ++i) {
+			if (i % kQueriesPerFrame == 0) {
+				query.yaw = random.Next() * 2.0f * pi;
+				query.forwardX = sin(query.yaw);
+				query.forwardY = cos(query.yaw);
+				if (filter.Has(FilterFlag::ViewCone3D)) {
+					const float pitch = (random.Next() - 0.5f) * 0.6f;
+					query.forwardX *= cos(pitch);
+					query.forwardY *= cos(pitch);
+					query.forwardZ = -sin(pitch);
+				}
+				query.playerSneaking = random.Next() < 0.2f;
+			}
+
+			// Squared falloff: most NPCs far away, some close
+			const float bearing = random.Next() * 2.0f * pi;
+			const float distance = 4000.0f * random.Next() * random.Next();
+			query.dx = sin(bearing) * distance;
+			query.dy = cos(bearing) * distance;
+			query.dz = (random.Next() - 0.5f) * 200.0f;
+			query.viewDz = filter.Has(FilterFlag::ViewCone3D) ? query.dz : 0.0f;  // Same race, eye heights cancel
+			query.npcInCombat = random.Next() < 0.05f;
+
+			CommentDecision decision;
+			if (!filter.Has(FilterFlag::DecisionTable) || !LookupDecision(filter.decisionTables[0], query, decision)) {
+				decision = DecideComment(filter, filter.categories[0], query);
+			}
+			allowed += decision.allow ? 1 : 0;
+		}
+
+		return allowed;
+	}
+}
+
+void RunPgoTraining()
+{
+	const SnapshotReadGuard snapshotGuard;
+	const FilterParameters* active = GetActiveFilter();
+	if (!active) {
+		return;
+	}
+
+	logger::info("Running PGO training workload...");
+	const auto start = std::chrono::steady_clock::now();
+
+	constexpr std::array modes = { FilterMode::AngleOnly, FilterMode::DistanceOnly, FilterMode::Both, FilterMode::Either, FilterMode::Expression };
+	std::size_t total = 0;
+	std::size_t allowed = 0;
+
+	for (const FilterMode mode : modes) {
+		if (mode == FilterMode::Expression && !active->filterExpression) {
+			continue;  // No compiled expression to train with
+		}
+
+		FilterParameters filter = *active;
+		filter.filterMode = mode;
+		filter.decisionTables = mode == active->filterMode ? active->decisionTables : nullptr;  // Built for the configured mode only
+		filter.Set(FilterFlag::DecisionTable, filter.decisionTables != nullptr);
+		const std::size_t queries = mode == active->filterMode ? kConfiguredModeQueries : kOtherModeQueries;
+		allowed += Train(filter, queries);
+		total += queries;
+	}
+
+	const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+	logger::info("  {} synthetic checks ({} allowed) in {} ms", total, allowed, elapsed.count());
+}
+
+#endif
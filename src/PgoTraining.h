@@ -0,0 +1,15 @@
+#pragma once
+
+#include "PCH.h"
+
+#ifdef TYF_PGO_INSTRUMENT
+
+/**
+ * Runs the profile-guided optimization training workload (PGO_MODE=INSTRUMENT
+ * builds only): synthetic comment checks through DecideComment in every
+ * filter mode, weighted toward the configured one. Call once game data is
+ * loaded; the instrumented DLL writes its counts when the game exits.
+ */
+void RunPgoTraining();
+
+#endif
@@ -0,0 +1,42 @@
+/**
+ * RateLimiter.cpp - Comment rate limiting, game side
+ *
+ * Owns the global token bucket and the cooldown table and supplies the clock
+ * (StageClock.h); its 10-16 ms resolution is fine for limits measured in
+ * comments per second.
+ */
+
+#include "PCH.h"
+#include "RateLimiter.h"
+#include "StageClock.h"
+#include "WorldEvents.h"
+
+namespace
+{
+	CommentTokenBucket g_commentBucket;
+	CommentCooldowns g_commentCooldowns;  // 32 KB, shared by all AI threads
+	WorldGenerationWatch g_cooldownWorld{ WorldChange::GameLoad };  // FormIDs are reused across saves; nothing else ends a cooldown
+}
+
+RateLimitResult ApplyRateLimit(RE::Character* npc, const RateLimitSettings& settings)
+{
+	if (g_cooldownWorld.Changed()) {
+		g_commentCooldowns.Clear();
+	}
+
+	const std::uint64_t now = GetStageMilliseconds();
+	const RE::FormID formID = npc->GetFormID();
+
+	if (settings.cooldownMilliseconds && g_commentCooldowns.IsCoolingDown(formID, now, settings.cooldownMilliseconds)) {
+		return RateLimitResult::Cooldown;
+	}
+
+	if (settings.commentsPerSecond > 0.0f && !g_commentBucket.TryTake(now * 1000, settings.commentsPerSecond)) {
+		return RateLimitResult::RateLimited;
+	}
+
+	if (settings.cooldownMilliseconds) {
+		g_commentCooldowns.RecordComment(formID, now, settings.cooldownMilliseconds);
+	}
+	return RateLimitResult::Allowed;
+}
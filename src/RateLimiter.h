@@ -0,0 +1,174 @@
+#pragma once
+
+// Game-independent (also built by tests/) - standard headers only, no PCH.
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace RE
+{
+	class Character;
+}
+
+/**
+ * Comment rate limiting ([RateLimit]).
+ *
+ * Runs last, only for comments every other stage allowed - blocked checks
+ * never reach it. Two independent limits:
+ *
+ *   - A global token bucket: at most fCommentsPerSecond comments per second,
+ *     with bursts of up to that many. Implemented as GCRA (the "virtual
+ *     scheduling" form of a token bucket): one word holds the theoretical
+ *     arrival time of the next comment, and taking a token is one CAS that
+ *     pushes it forward by the emission interval. A throttled call only loads.
+ *   - A per-NPC cooldown: an NPC that commented may not comment again for
+ *     fNPCCooldown seconds. A fixed open-addressing table of 64-bit words,
+ *     FormID in the low half and the time of the last comment (milliseconds
+ *     modulo 2^32) in the high half, expired lazily like the dwell table.
+ *
+ * The cooldown is checked first, so an NPC on cooldown does not use up a
+ * global token. Neither class calls into the game; time is passed in.
+ */
+
+inline constexpr std::uint32_t kMaxCooldownMilliseconds = 600000;  // fNPCCooldown limit (10 minutes)
+
+/**
+ * [RateLimit] settings.
+ */
+struct RateLimitSettings
+{
+	float commentsPerSecond;             // Global limit, 0 = unlimited
+	std::uint32_t cooldownMilliseconds;  // Per-NPC cooldown, 0 = none
+
+	bool operator==(const RateLimitSettings&) const = default;
+};
+
+/**
+ * Lock-free global token bucket (GCRA).
+ */
+class CommentTokenBucket
+{
+public:
+	/**
+	 * Takes one token if available.
+	 *
+	 * @param nowMicroseconds Monotonic time
+	 * @param commentsPerSecond Refill rate, also the bucket size (at least one token)
+	 * @return false if the bucket is empty (nothing is changed)
+	 */
+	bool TryTake(std::uint64_t nowMicroseconds, float commentsPerSecond)
+	{
+		const auto interval = static_cast<std::uint64_t>(1'000'000.0f / commentsPerSecond);
+		const std::uint64_t burst = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(commentsPerSecond));
+		const std::uint64_t limit = nowMicroseconds + burst * interval;  // Latest arrival time a full bucket allows
+
+		std::uint64_t arrival = theoreticalArrival.load(std::memory_order_relaxed);
+		for (;;) {
+			const std::uint64_t next = std::max(arrival, nowMicroseconds) + interval;
+			if (next > limit) {
+				return false;
+			}
+			if (theoreticalArrival.compare_exchange_weak(arrival, next, std::memory_order_relaxed)) {
+				return true;
+			}
+		}
+	}
+
+private:
+	std::atomic<std::uint64_t> theoreticalArrival{ 0 };
+};
+
+/**
+ * Per-NPC comment cooldown table.
+ */
+class CommentCooldowns
+{
+public:
+	static constexpr std::size_t kTableSize = 0x1000;  // 4096 slots (power of two)
+	static constexpr std::size_t kMaxProbe = 16;       // Slots searched per actor
+
+	/**
+	 * @return true if the actor commented less than the cooldown ago
+	 */
+	bool IsCoolingDown(std::uint32_t actorID, std::uint64_t nowMilliseconds, std::uint32_t cooldownMilliseconds) const
+	{
+		const auto now = static_cast<std::uint32_t>(nowMilliseconds);
+
+		std::size_t slot = HashActor(actorID);
+		for (std::size_t probe = 0; probe < kMaxProbe; ++probe, slot = (slot + 1) & (kTableSize - 1)) {
+			const std::uint64_t entry = table[slot].load(std::memory_order_relaxed);
+			if (static_cast<std::uint32_t>(entry) == actorID) {
+				return now - static_cast<std::uint32_t>(entry >> 32) < cooldownMilliseconds;
+			}
+			if (entry == 0) {
+				return false;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Records a comment; the actor's cooldown starts now.
+	 * If the probe window is full of live entries the comment goes unrecorded
+	 * (that NPC is simply not rate limited).
+	 */
+	void RecordComment(std::uint32_t actorID, std::uint64_t nowMilliseconds, std::uint32_t cooldownMilliseconds)
+	{
+		const auto now = static_cast<std::uint32_t>(nowMilliseconds);
+		const std::uint64_t updated = static_cast<std::uint64_t>(actorID) | (static_cast<std::uint64_t>(now) << 32);
+
+		std::size_t slot = HashActor(actorID);
+		for (std::size_t probe = 0; probe < kMaxProbe; ++probe, slot = (slot + 1) & (kTableSize - 1)) {
+			std::uint64_t entry = table[slot].load(std::memory_order_relaxed);
+			if (static_cast<std::uint32_t>(entry) == actorID) {
+				table[slot].store(updated, std::memory_order_relaxed);
+				return;
+			}
+			// Empty or expired - claim it (whoever wins the CAS keeps the slot)
+			if (entry == 0 || now - static_cast<std::uint32_t>(entry >> 32) >= cooldownMilliseconds) {
+				table[slot].compare_exchange_strong(entry, updated, std::memory_order_relaxed);
+				return;
+			}
+		}
+	}
+
+	/**
+	 * Forgets all cooldowns (after a world change, see WorldEvents.h).
+	 */
+	void Clear()
+	{
+		for (auto& slot : table) {
+			slot.store(0, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	static std::size_t HashActor(std::uint32_t actorID)
+	{
+		return (actorID * 0x9E3779B1u) >> (32 - 12);
+	}
+	static_assert(kTableSize == (1u << 12), "HashActor shift must match table size");
+
+	std::array<std::atomic<std::uint64_t>, kTableSize> table{};
+};
+
+/**
+ * Result of the rate limit stage.
+ */
+enum class RateLimitResult : std::uint8_t
+{
+	Allowed,
+	Cooldown,    // The NPC commented less than fNPCCooldown ago
+	RateLimited  // Global fCommentsPerSecond reached
+};
+
+/**
+ * Game adapter: applies [RateLimit] to a comment every other stage allowed,
+ * and records it if it goes through.
+ *
+ * @param npc NPC that wants to comment
+ * @param settings Active [RateLimit] settings
+ */
+RateLimitResult ApplyRateLimit(RE::Character* npc, const RateLimitSettings& settings);
@@ -0,0 +1,93 @@
+/**
+ * ReloadDebouncer.cpp - Quiet-period tracking for the config watcher
+ *
+ * Game-independent (also built by tests/) - standard headers only, no PCH.
+ */
+
+#include "ReloadDebouncer.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+	char ToLowerAscii(char c)
+	{
+		return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+	}
+
+	bool EqualsIgnoreCase(std::string_view a, std::string_view b)
+	{
+		return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+			return ToLowerAscii(x) == ToLowerAscii(y);
+		});
+	}
+}
+
+ReloadDebouncer::ReloadDebouncer(std::span<const std::string_view> paths, Clock::duration quietPeriod) :
+	quietPeriod(quietPeriod)
+{
+	for (const auto path : paths) {
+		const auto separator = path.find_last_of("\\/");
+		const auto directory = separator == std::string_view::npos ? std::string_view(".") : path.substr(0, separator);
+		const auto name = separator == std::string_view::npos ? path : path.substr(separator + 1);
+
+		auto existing = std::find(directories.begin(), directories.end(), directory);
+		if (existing == directories.end()) {
+			existing = directories.insert(directories.end(), std::string(directory));
+		}
+		files.push_back({ static_cast<std::size_t>(existing - directories.begin()), std::string(name) });
+	}
+}
+
+bool ReloadDebouncer::OnChange(const FileChange& change, Clock::time_point now)
+{
+	if (change.kind != FileChangeKind::Modified) {
+		const bool known = std::find(directories.begin(), directories.end(), change.directory) != directories.end();
+		MarkDirectory(change.directory, now);
+		return known;
+	}
+
+	bool matched = false;
+	for (std::size_t i = 0; i < files.size(); ++i) {
+		if (directories[files[i].directory] == change.directory && EqualsIgnoreCase(files[i].name, change.name)) {
+			changed |= 1u << i;
+			matched = true;
+		}
+	}
+	if (matched) {
+		lastChange = now;
+	}
+	return matched;
+}
+
+void ReloadDebouncer::OnDirectoryAppeared(std::string_view directory, Clock::time_point now)
+{
+	MarkDirectory(directory, now);
+}
+
+void ReloadDebouncer::MarkDirectory(std::string_view directory, Clock::time_point now)
+{
+	for (std::size_t i = 0; i < files.size(); ++i) {
+		if (directories[files[i].directory] == directory) {
+			changed |= 1u << i;
+			lastChange = now;
+		}
+	}
+}
+
+std::optional<ReloadDebouncer::Clock::time_point> ReloadDebouncer::GetDeadline() const
+{
+	if (!changed) {
+		return std::nullopt;
+	}
+	return lastChange + quietPeriod;
+}
+
+std::uint32_t ReloadDebouncer::TakeDue(Clock::time_point now)
+{
+	if (!changed || now < lastChange + quietPeriod) {
+		return 0;
+	}
+	return std::exchange(changed, 0);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+// Game-independent (also built by tests/) - standard headers only, no PCH.
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "FileWatcher.h"
+
+/**
+ * Decides when a burst of file changes has settled enough to reload.
+ *
+ * Editors and MCM Helper save with several operations (truncate, write,
+ * rename over a temp file), often spread over a few milliseconds, so every
+ * change to a config file restarts a quiet period and the reload happens
+ * once it has passed. Every config file takes part - the plugin INI, the
+ * MCM settings file, the _custom override and the shadow file - and the
+ * changed ones are reported together when the reload is due.
+ *
+ * Pure bookkeeping: time is passed in, so tests drive it with a synthetic clock.
+ */
+class ReloadDebouncer
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	/**
+	 * @param files Config file paths ('\\' or '/' separated), at most 32
+	 * @param quietPeriod Time without changes before a reload is due
+	 */
+	ReloadDebouncer(std::span<const std::string_view> files, Clock::duration quietPeriod);
+
+	/**
+	 * @return Distinct directories of the files, in order of first appearance
+	 */
+	const std::vector<std::string>& GetDirectories() const { return directories; }
+
+	/**
+	 * Applies one notification. A change to a config file (file names compare
+	 * case-insensitively), or an overflow or loss of a directory that holds
+	 * one, restarts the quiet period.
+	 *
+	 * @return true if the notification concerned a config file
+	 */
+	bool OnChange(const FileChange& change, Clock::time_point now);
+
+	/**
+	 * Marks every file in a directory as changed, e.g. when a directory that
+	 * did not exist at startup appears and may already contain its file.
+	 */
+	void OnDirectoryAppeared(std::string_view directory, Clock::time_point now);
+
+	/**
+	 * @return When the pending reload is due, or nothing if no change is pending
+	 */
+	std::optional<Clock::time_point> GetDeadline() const;
+
+	/**
+	 * Takes the pending reload once the quiet period has passed.
+	 *
+	 * @return Bitmask of the changed files (bit i = files[i]), or 0 if no reload is due
+	 */
+	std::uint32_t TakeDue(Clock::time_point now);
+
+private:
+	struct File
+	{
+		std::size_t directory;  // Index into directories
+		std::string name;
+	};
+
+	void MarkDirectory(std::string_view directory, Clock::time_point now);
+
+	std::vector<File> files;
+	std::vector<std::string> directories;
+	Clock::duration quietPeriod;
+	std::uint32_t changed = 0;
+	Clock::time_point lastChange{};
+};
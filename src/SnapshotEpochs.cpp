@@ -0,0 +1,131 @@
+/**
+ * SnapshotEpochs.cpp - Per-thread reader epochs
+ *
+ * Reader:  slot = epoch (acquire load); fence; load the snapshot pointer
+ * Writer:  store the new pointer; ++epoch; fence; read every slot
+ * Either the writer sees the reader's slot (and keeps the old snapshot), or
+ * the reader's pointer load comes after the writer's store and sees the new
+ * snapshot. A slot holding an epoch >= the retirement epoch was written after
+ * the increment, which the acquire load orders after the pointer store.
+ *
+ * Game-independent (also built by tests/) - standard headers only, no PCH.
+ */
+
+#include "SnapshotEpochs.h"
+
+#include <array>
+#include <atomic>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>  // FlushProcessWriteBuffers
+#endif
+
+namespace
+{
+	struct alignas(64) ReaderSlot
+	{
+		std::atomic<std::uint64_t> epoch{ 0 };  // 0 = not reading
+	};
+
+	std::array<ReaderSlot, kMaxSnapshotReaders> g_readers{};
+	alignas(64) std::atomic<std::uint64_t> g_epoch{ 1 };
+	alignas(64) std::atomic<std::uint32_t> g_overflowReaders{ 0 };  // Threads without a slot, reading now
+	std::atomic<std::size_t> g_nextReader{ 0 };
+
+	thread_local ReaderSlot* t_reader = nullptr;
+	thread_local bool t_claimed = false;
+	thread_local std::uint32_t t_depth = 0;
+
+	/**
+	 * Orders the reader's slot store before its snapshot pointer load.
+	 */
+	inline void ReaderFence()
+	{
+#ifdef _WIN32
+		std::atomic_signal_fence(std::memory_order_seq_cst);  // GetOldestSnapshotReader flushes the store
+#else
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+	}
+
+	/**
+	 * Orders the writer's pointer stores before its slot loads, on every core.
+	 */
+	inline void WriterFence()
+	{
+#ifdef _WIN32
+		FlushProcessWriteBuffers();
+#else
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+	}
+
+	/**
+	 * Claims a slot for the calling thread on its first read.
+	 *
+	 * @return The thread's slot, or nullptr if all are taken
+	 */
+	ReaderSlot* GetReaderSlot()
+	{
+		if (!t_claimed) {
+			t_claimed = true;
+			const std::size_t index = g_nextReader.fetch_add(1, std::memory_order_relaxed);
+			t_reader = index < kMaxSnapshotReaders ? &g_readers[index] : nullptr;
+		}
+		return t_reader;
+	}
+}
+
+void EnterSnapshotRead()
+{
+	if (t_depth++) {
+		return;
+	}
+
+	if (ReaderSlot* slot = GetReaderSlot()) {
+		slot->epoch.store(g_epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+	} else {
+		g_overflowReaders.fetch_add(1, std::memory_order_relaxed);
+	}
+	ReaderFence();
+}
+
+void LeaveSnapshotRead()
+{
+	if (--t_depth) {
+		return;
+	}
+
+	// Release: the writer that sees the slot cleared frees after our last access
+	if (t_reader) {
+		t_reader->epoch.store(0, std::memory_order_release);
+	} else {
+		g_overflowReaders.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+std::uint64_t AdvanceSnapshotEpoch()
+{
+	return g_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+}
+
+std::uint64_t GetOldestSnapshotReader()
+{
+	WriterFence();
+
+	if (g_overflowReaders.load(std::memory_order_acquire)) {
+		return 0;
+	}
+
+	std::uint64_t oldest = kNoSnapshotReaders;
+	for (const auto& slot : g_readers) {
+		const std::uint64_t epoch = slot.epoch.load(std::memory_order_acquire);
+		if (epoch && epoch < oldest) {
+			oldest = epoch;
+		}
+	}
+	return oldest;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+// Game-independent (also built by tests/) - standard headers only, no PCH.
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+/**
+ * SnapshotEpochs.h - Reclamation of published configuration snapshots
+ *
+ * Readers announce themselves: while a thread reads a published snapshot it
+ * holds a SnapshotReadGuard, which writes the current global epoch into the
+ * thread's own cache-line slot. A writer that replaced a snapshot advances
+ * the epoch and may free the old one once no slot holds an epoch older than
+ * that - every reader still inside then entered after the swap and can only
+ * have loaded the new pointer.
+ *
+ * Readers pay one load of the (rarely written) epoch and two stores to their
+ * own slot. The store-then-load ordering that makes this safe is enforced
+ * asymmetrically on Windows: the reader has only a compiler fence and the
+ * writer calls FlushProcessWriteBuffers, which serializes every core running
+ * this process. Elsewhere the reader issues a full fence.
+ *
+ * Threads beyond kMaxSnapshotReaders share a counter instead of a slot;
+ * while any of them is reading, nothing is freed.
+ */
+
+inline constexpr std::size_t kMaxSnapshotReaders = 64;
+
+inline constexpr std::uint64_t kNoSnapshotReaders = std::numeric_limits<std::uint64_t>::max();
+
+/**
+ * Marks the calling thread as reading published snapshots. Nests; only the
+ * outermost call publishes the epoch.
+ */
+void EnterSnapshotRead();
+
+/**
+ * Ends the read section started by the matching EnterSnapshotRead().
+ */
+void LeaveSnapshotRead();
+
+/**
+ * Advances the global epoch. Call after the new snapshot pointers have been
+ * stored; the returned epoch is the one the replaced snapshot waits for.
+ *
+ * @return Epoch to pass to the retired snapshot's later reclamation check
+ */
+std::uint64_t AdvanceSnapshotEpoch();
+
+/**
+ * Oldest epoch any reader entered with. A snapshot retired at epoch E can be
+ * freed if this is >= E. Writer side only (issues the asymmetric barrier).
+ *
+ * @return The oldest reader epoch, kNoSnapshotReaders if no thread is reading,
+ *         or 0 while a thread without a slot is reading
+ */
+std::uint64_t GetOldestSnapshotReader();
+
+/**
+ * RAII read section. The snapshot pointers loaded while it is alive stay
+ * valid until it is destroyed.
+ */
+class SnapshotReadGuard
+{
+public:
+	SnapshotReadGuard() { EnterSnapshotRead(); }
+	~SnapshotReadGuard() { LeaveSnapshotRead(); }
+
+	SnapshotReadGuard(const SnapshotReadGuard&) = delete;
+	SnapshotReadGuard& operator=(const SnapshotReadGuard&) = delete;
+};
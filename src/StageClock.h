@@ -0,0 +1,19 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * Clock of the per-actor stages: line of sight, dwell time and rate limit.
+ *
+ * The stages' tables compare timestamps taken by different AI threads and by
+ * each other's callers, so they must all read the same clock. The system
+ * tick count costs ~1 ns to read where steady_clock (QPC) costs tens; its
+ * 10-16 ms resolution is one line-of-sight budget window and well below any
+ * cache lifetime, dwell time or cooldown.
+ *
+ * @return Monotonic time in milliseconds
+ */
+inline std::uint64_t GetStageMilliseconds()
+{
+	return GetTickCount64();
+}
@@ -0,0 +1,232 @@
+/**
+ * StartupLog.cpp - Buffered logging while the game is starting up
+ *
+ * The plugin log used to flush after every info record, so each of the ~100
+ * lines written during Query/Load cost a file write on the game's loader
+ * thread. StartupLogSink sits in front of the file sink and keeps those
+ * records in memory until load-complete, then writes them with one flush.
+ *
+ * Nothing is lost if startup goes wrong: an error/critical record writes the
+ * buffer immediately, and an unhandled exception filter (installed only
+ * while buffering, chained to the previous one) does the same on a crash.
+ * After FinishStartupLog() the sink is write-through and the logger keeps
+ * its flush per info record, as before, for the runtime debug log.
+ */
+
+#include "PCH.h"
+#include "StartupLog.h"
+
+#include <spdlog/details/log_msg_buffer.h>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	thread_local std::uint32_t t_quietDepth = 0;  // Open QuietLogScopes on this thread
+
+	/**
+	 * Keeps an owning copy of each record until startup completes. Formatting
+	 * is left to the target file sink, so the log pattern is unchanged.
+	 */
+	class StartupLogSink final : public spdlog::sinks::base_sink<std::mutex>
+	{
+	public:
+		explicit StartupLogSink(std::shared_ptr<spdlog::sinks::basic_file_sink_mt> target) :
+			target(std::move(target))
+		{
+			records.reserve(256);
+		}
+
+		void BeginSummary()
+		{
+			std::lock_guard lock(mutex_);
+			summaryStart = records.size();
+		}
+
+		/**
+		 * Writes the remaining records and stops buffering.
+		 *
+		 * @return false if startup buffering had already finished
+		 */
+		bool Finish(StartupLogVerbosity verbosity)
+		{
+			std::lock_guard lock(mutex_);
+			if (!buffering) {
+				return false;
+			}
+
+			const auto start = Clock::now();
+			const std::size_t total = records.size();
+			for (std::size_t i = written; i < total; ++i) {
+				const bool keep = verbosity == StartupLogVerbosity::Full ||
+				                  records[i].level >= spdlog::level::warn ||
+				                  i >= summaryStart;
+				if (keep) {
+					target->log(records[i]);
+				} else {
+					++omitted;
+				}
+			}
+			written = total;
+			target->flush();
+			writeTime += Clock::now() - start;
+
+			buffering = false;
+			records.clear();
+			records.shrink_to_fit();
+			recordCount = total;
+			return true;
+		}
+
+		/**
+		 * Writes everything buffered so far from an exception filter. Gives up
+		 * rather than wait if the crashing thread was inside the sink.
+		 */
+		void FlushForCrash()
+		{
+			std::unique_lock lock(mutex_, std::try_to_lock);
+			if (lock && buffering) {
+				WriteBuffered();
+			}
+		}
+
+		std::size_t GetRecordCount() const { return recordCount; }
+		std::size_t GetOmittedCount() const { return omitted; }
+		Clock::duration GetBufferTime() const { return bufferTime; }
+		Clock::duration GetWriteTime() const { return writeTime; }
+
+	protected:
+		void sink_it_(const spdlog::details::log_msg& msg) override
+		{
+			// The logger calls its sinks on the logging thread
+			if (t_quietDepth && msg.level < spdlog::level::warn) {
+				return;
+			}
+
+			if (!buffering) {
+				target->log(msg);
+				return;
+			}
+
+			const auto start = Clock::now();
+			records.emplace_back(msg);
+			if (msg.level >= spdlog::level::err) {
+				// Something failed - get the context onto disk before anything else can go wrong
+				WriteBuffered();
+			}
+			bufferTime += Clock::now() - start;
+		}
+
+		void flush_() override
+		{
+			// The logger flushes after every info record; while buffering that is exactly the cost we avoid
+			if (!buffering) {
+				target->flush();
+			}
+		}
+
+		void set_pattern_(const std::string& pattern) override
+		{
+			target->set_pattern(pattern);
+		}
+
+		void set_formatter_(std::unique_ptr<spdlog::formatter> formatter) override
+		{
+			target->set_formatter(std::move(formatter));
+		}
+
+	private:
+		/**
+		 * Writes all unwritten records in full. Caller holds mutex_.
+		 */
+		void WriteBuffered()
+		{
+			for (std::size_t i = written; i < records.size(); ++i) {
+				target->log(records[i]);
+			}
+			written = records.size();
+			target->flush();
+		}
+
+		std::shared_ptr<spdlog::sinks::basic_file_sink_mt> target;
+		std::vector<spdlog::details::log_msg_buffer> records;  // Owning copies (payload and logger name)
+		std::size_t written = 0;                              // Records [0, written) are already in the file
+		std::size_t summaryStart = std::numeric_limits<std::size_t>::max();
+		std::size_t recordCount = 0;
+		std::size_t omitted = 0;
+		bool buffering = true;
+
+		Clock::duration bufferTime{};  // Time spent in sink_it_ while buffering (includes error flushes)
+		Clock::duration writeTime{};   // Time spent writing the buffer at load-complete
+	};
+
+	StartupLogSink* g_startupSink = nullptr;  // Owned by the default logger, which lives until unload
+	LPTOP_LEVEL_EXCEPTION_FILTER g_previousExceptionFilter = nullptr;
+
+	LONG WINAPI FlushStartupLogOnCrash(EXCEPTION_POINTERS* exception)
+	{
+		if (g_startupSink) {
+			g_startupSink->FlushForCrash();
+		}
+		return g_previousExceptionFilter ? g_previousExceptionFilter(exception) : EXCEPTION_CONTINUE_SEARCH;
+	}
+}
+
+void SetupStartupLog(const std::filesystem::path& path)
+{
+	// Query and Load both set up logging; only the first call opens (and truncates) the file
+	if (g_startupSink) {
+		return;
+	}
+
+	auto fileSink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(path.string(), true);
+	auto sink = std::make_shared<StartupLogSink>(std::move(fileSink));
+	g_startupSink = sink.get();
+
+	auto log = std::make_shared<spdlog::logger>("global log", std::move(sink));
+	log->set_level(spdlog::level::info);
+	log->flush_on(spdlog::level::info);
+
+	spdlog::set_default_logger(std::move(log));
+	spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%l] %v");
+
+	g_previousExceptionFilter = SetUnhandledExceptionFilter(FlushStartupLogOnCrash);
+}
+
+QuietLogScope::QuietLogScope()
+{
+	++t_quietDepth;
+}
+
+QuietLogScope::~QuietLogScope()
+{
+	--t_quietDepth;
+}
+
+void BeginStartupSummary()
+{
+	if (g_startupSink) {
+		g_startupSink->BeginSummary();
+	}
+}
+
+void FinishStartupLog(StartupLogVerbosity verbosity)
+{
+	if (!g_startupSink || !g_startupSink->Finish(verbosity)) {
+		return;
+	}
+
+	// Restore the previous filter unless someone installed theirs on top of ours
+	auto current = SetUnhandledExceptionFilter(g_previousExceptionFilter);
+	if (current != FlushStartupLogOnCrash) {
+		SetUnhandledExceptionFilter(current);
+	}
+
+	using std::chrono::duration_cast;
+	using std::chrono::microseconds;
+	logger::info("Startup log: {} records, {} us buffering, {} us writing{}",
+		g_startupSink->GetRecordCount(),
+		duration_cast<microseconds>(g_startupSink->GetBufferTime()).count(),
+		duration_cast<microseconds>(g_startupSink->GetWriteTime()).count(),
+		g_startupSink->GetOmittedCount() ? std::format(" ({} detail records omitted, sStartupLog=Summary)", g_startupSink->GetOmittedCount()) : "");
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * How much of the buffered startup log is written at load-complete.
+ */
+enum class StartupLogVerbosity : std::uint8_t
+{
+	Full,     // Every record
+	Summary   // Warnings, errors and the final status block only
+};
+
+/**
+ * Creates the plugin logger with startup buffering enabled.
+ *
+ * Until FinishStartupLog() is called, records are kept in memory instead of
+ * being flushed to the file one line at a time. An error or critical record,
+ * or an unhandled exception, writes everything buffered so far immediately.
+ *
+ * @param path Log file path (truncated)
+ */
+void SetupStartupLog(const std::filesystem::path& path);
+
+/**
+ * Marks the start of the final status block. In Summary mode, info records
+ * logged after this call are kept.
+ */
+void BeginStartupSummary();
+
+/**
+ * Writes the buffered startup records to the log file in one go and switches
+ * the logger to write-through with a flush per line. Safe to call more than once.
+ *
+ * @param verbosity Records to keep from the buffered startup log
+ */
+void FinishStartupLog(StartupLogVerbosity verbosity);
+
+/**
+ * Drops the info records this thread logs while in scope; warnings and errors
+ * still pass. For work whose details are logged another way, such as the
+ * [Shadow] candidate, which is logged as its differences from the active
+ * configuration.
+ */
+class QuietLogScope
+{
+public:
+	QuietLogScope();
+	~QuietLogScope();
+
+	QuietLogScope(const QuietLogScope&) = delete;
+	QuietLogScope& operator=(const QuietLogScope&) = delete;
+};
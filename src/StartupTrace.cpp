@@ -0,0 +1,146 @@
+/**
+ * StartupTrace.cpp - Startup phase timeline in Chrome trace format
+ *
+ * Each phase becomes one complete ("X") event. Begin/end are raw QPC ticks;
+ * the first BeginStartupPhase() also samples the wall clock, which anchors
+ * the ticks to the process creation time from GetProcessTimes(). The viewer
+ * therefore starts at process launch and the gap before our first phase is
+ * the game's (and other plugins') boot time up to that point.
+ */
+
+#include "PCH.h"
+#include "StartupTrace.h"
+
+namespace
+{
+	struct PhaseRecord
+	{
+		const char* name;
+		std::int64_t begin;  // QPC ticks
+		std::int64_t end;    // QPC ticks, 0 while the phase is open
+		std::uint32_t thread;
+	};
+
+	std::array<PhaseRecord, kMaxStartupPhases> g_phases{};
+	std::size_t g_phaseCount = 0;
+	bool g_traceWritten = false;
+
+	std::int64_t g_anchorTicks = 0;          // QPC at the first phase
+	std::uint64_t g_anchorFileTime = 0;      // Wall clock at the first phase (100 ns units)
+
+	inline std::int64_t ReadTicks()
+	{
+		LARGE_INTEGER now;
+		QueryPerformanceCounter(&now);
+		return now.QuadPart;
+	}
+
+	inline std::uint64_t ToUInt64(const FILETIME& time)
+	{
+		return (static_cast<std::uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+	}
+
+	/**
+	 * Escapes a phase name for a JSON string (names are literals, but be safe).
+	 */
+	std::string EscapeJson(std::string_view text)
+	{
+		std::string escaped;
+		escaped.reserve(text.size());
+		for (char c : text) {
+			if (c == '"' || c == '\\') {
+				escaped += '\\';
+			}
+			escaped += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+		}
+		return escaped;
+	}
+}
+
+std::size_t BeginStartupPhase(const char* name)
+{
+	if (g_traceWritten || g_phaseCount == kMaxStartupPhases) {
+		return kNoStartupPhase;
+	}
+
+	const std::int64_t now = ReadTicks();
+	if (g_phaseCount == 0) {
+		FILETIME wallClock;
+		GetSystemTimePreciseAsFileTime(&wallClock);
+		g_anchorTicks = now;
+		g_anchorFileTime = ToUInt64(wallClock);
+	}
+
+	g_phases[g_phaseCount] = { name, now, 0, GetCurrentThreadId() };
+	return g_phaseCount++;
+}
+
+void EndStartupPhase(std::size_t phase)
+{
+	if (phase < g_phaseCount && !g_traceWritten) {
+		g_phases[phase].end = ReadTicks();
+	}
+}
+
+bool WriteStartupTrace(const std::filesystem::path& path)
+{
+	if (g_traceWritten) {
+		return false;
+	}
+	g_traceWritten = true;
+
+	if (g_phaseCount == 0) {
+		return false;
+	}
+
+	const std::int64_t now = ReadTicks();
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+
+	// Offset of the anchor from process creation; 0 if the creation time is unavailable
+	double anchorMicroseconds = 0.0;
+	FILETIME creation, exitTime, kernelTime, userTime;
+	if (GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernelTime, &userTime) &&
+		g_anchorFileTime > ToUInt64(creation)) {
+		anchorMicroseconds = static_cast<double>(g_anchorFileTime - ToUInt64(creation)) / 10.0;
+	}
+
+	auto toMicroseconds = [&](std::int64_t ticks) {
+		return anchorMicroseconds + static_cast<double>(ticks - g_anchorTicks) * 1'000'000.0 / static_cast<double>(frequency.QuadPart);
+	};
+
+	std::ofstream file(path, std::ios::trunc);
+	if (!file) {
+		logger::warn("Failed to write startup trace: {}", path.string());
+		return false;
+	}
+
+	const DWORD processID = GetCurrentProcessId();
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	file << std::format("{{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":{},\"tid\":0,\"args\":{{\"name\":\"Skyrim ({} v{})\"}}}}",
+		processID, Plugin::NAME, Plugin::VERSION.string());
+
+	double totalMicroseconds = 0.0;
+	for (std::size_t i = 0; i < g_phaseCount; ++i) {
+		const PhaseRecord& phase = g_phases[i];
+		const double begin = toMicroseconds(phase.begin);
+		const double duration = toMicroseconds(phase.end ? phase.end : now) - begin;
+		file << std::format(",\n{{\"name\":\"{}\",\"cat\":\"startup\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":{},\"tid\":{}}}",
+			EscapeJson(phase.name), begin, duration, processID, phase.thread);
+
+		// The SKSEPlugin_Query/Load phases enclose all others
+		if (std::string_view(phase.name).starts_with("SKSEPlugin_")) {
+			totalMicroseconds += duration;
+		}
+	}
+	file << "\n]}\n";
+
+	if (!file) {
+		logger::warn("Failed to write startup trace: {}", path.string());
+		return false;
+	}
+
+	logger::info("Startup trace: {} phases, {:.3f} ms in SKSEPlugin_Query/Load, written to {}",
+		g_phaseCount, totalMicroseconds / 1000.0, path.filename().string());
+	return true;
+}
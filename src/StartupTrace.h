@@ -0,0 +1,59 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * Startup phase timeline.
+ *
+ * Phases record QueryPerformanceCounter begin/end timestamps into a fixed
+ * array; nothing is allocated or formatted until WriteStartupTrace() turns
+ * them into a Chrome trace (chrome://tracing, ui.perfetto.dev). Timestamps
+ * are relative to process creation, so the trace shows where the plugin's
+ * phases fall within the game's boot.
+ *
+ * Only the game's loader thread records phases, before load-complete.
+ * Functions that use __try cannot hold a StartupPhaseScope and call
+ * BeginStartupPhase()/EndStartupPhase() directly.
+ */
+
+inline constexpr std::size_t kMaxStartupPhases = 64;
+inline constexpr std::size_t kNoStartupPhase = kMaxStartupPhases;
+
+/**
+ * Starts a phase.
+ *
+ * @param name Phase name (string literal, shown in the trace viewer)
+ * @return Phase index for EndStartupPhase(), or kNoStartupPhase once the
+ *         array is full or the trace has been written
+ */
+std::size_t BeginStartupPhase(const char* name);
+
+/**
+ * Ends a phase started with BeginStartupPhase(). Ignores kNoStartupPhase.
+ */
+void EndStartupPhase(std::size_t phase);
+
+/**
+ * Records a phase for the lifetime of the scope.
+ */
+class StartupPhaseScope
+{
+public:
+	explicit StartupPhaseScope(const char* name) : phase(BeginStartupPhase(name)) {}
+	~StartupPhaseScope() { EndStartupPhase(phase); }
+
+	StartupPhaseScope(const StartupPhaseScope&) = delete;
+	StartupPhaseScope& operator=(const StartupPhaseScope&) = delete;
+
+private:
+	std::size_t phase;
+};
+
+/**
+ * Writes the recorded phases as Chrome trace JSON and stops recording.
+ * Phases that are still open (e.g. SKSEPlugin_Load itself) end now.
+ *
+ * @param path Output file (overwritten)
+ * @return true if the file was written
+ */
+bool WriteStartupTrace(const std::filesystem::path& path);
@@ -0,0 +1,138 @@
+/**
+ * StatsExport.cpp - Live filter statistics in named shared memory
+ *
+ * The block is a pagefile-backed mapping (StatsMapping.h), so publishing is a handful of
+ * stores into memory - no file I/O, no syscalls and nothing on the game's
+ * threads. The export thread sums the per-thread accumulators
+ * (CollectStatistics) and copies the totals into the block under a seqlock;
+ * readers in another process retry if they raced an update, and the
+ * publisher never waits for them.
+ *
+ * Call times are TSC ticks. The thread calibrates the TSC against QPC over
+ * its whole lifetime and publishes the current estimate with every update.
+ */
+
+#include "PCH.h"
+#include "StatsExport.h"
+#include "StatsExportLayout.h"
+#include "StatsMapping.h"
+#include "FilterStats.h"
+
+namespace
+{
+	inline constexpr auto kStatsPublishInterval = std::chrono::milliseconds(50);
+
+	/**
+	 * Copies one snapshot of the statistics into the shared block.
+	 */
+	void Publish(StatsExport::SharedStats& shared, const FilterStatistics& stats, std::uint64_t uptimeMicroseconds, std::uint64_t ticksPerSecond)
+	{
+		StatsExport::Snapshot snapshot{};
+		snapshot.uptimeMicroseconds = uptimeMicroseconds;
+		snapshot.ticksPerSecond = ticksPerSecond;
+		snapshot.threadCount = stats.threadCount;
+		std::copy_n(stats.outcomes, StatsExport::kOutcomeCount, snapshot.outcomes);
+		snapshot.timedCalls = stats.timedCalls;
+		snapshot.timedTicks = stats.timedTicks;
+		snapshot.maxTicks = stats.maxTicks;
+		std::copy_n(stats.timeHistogram, StatsExport::kTimeBuckets, snapshot.timeHistogram);
+
+		StatsExport::WriteSnapshot(shared, snapshot);
+	}
+
+	/**
+	 * Export thread body. Runs until the game exits.
+	 */
+	void ExportStatistics(StatsExport::SharedStats* shared)
+	{
+		LARGE_INTEGER frequency, startCounter;
+		QueryPerformanceFrequency(&frequency);
+		QueryPerformanceCounter(&startCounter);
+		const std::uint64_t startTicks = __rdtsc();
+
+		for (;;) {
+			std::this_thread::sleep_for(kStatsPublishInterval);
+
+			LARGE_INTEGER counter;
+			QueryPerformanceCounter(&counter);
+			const std::uint64_t ticks = __rdtsc();
+
+			const double seconds = static_cast<double>(counter.QuadPart - startCounter.QuadPart) / static_cast<double>(frequency.QuadPart);
+			const auto ticksPerSecond = static_cast<std::uint64_t>(static_cast<double>(ticks - startTicks) / seconds);
+
+			Publish(*shared, CollectStatistics(), static_cast<std::uint64_t>(seconds * 1'000'000.0), ticksPerSecond);
+		}
+	}
+}
+
+bool StartStatsExport()
+{
+	logger::info("Starting statistics export...");
+
+	std::string error;
+	auto mapping = CreateStatsMapping(StatsExport::kMappingName, error);
+	if (!mapping) {
+		logger::warn("  Failed to create shared memory ({}) - statistics export disabled", error);
+		return false;
+	}
+
+	// The mapping is never released, so the block stays available to readers until
+	// the game exits. Readers ignore it until the first update (sequence 2) is released.
+	auto shared = new (mapping.release()->Get()) StatsExport::SharedStats{};
+	shared->magic = StatsExport::kMagic;
+	shared->version = StatsExport::kStatsLayoutVersion;
+	shared->size = sizeof(StatsExport::SharedStats);
+	shared->processID = GetCurrentProcessId();
+
+	std::thread exporter(ExportStatistics, shared);
+
+	// Summing the counters is cheap, but never let it preempt the game
+	SetThreadPriority(exporter.native_handle(), THREAD_PRIORITY_LOWEST);
+	exporter.detach();
+
+	logger::info("  Publishing every {} ms to shared memory \"to-your-face-reloaded.stats\"", kStatsPublishInterval.count());
+	logger::info("  NPC comment checks are timed while the export is enabled");
+	return true;
+}
+
+void LogFilterStatistics()
+{
+	const FilterStatistics stats = CollectStatistics();
+	const auto count = [&](FilterOutcome outcome) { return stats.outcomes[static_cast<std::size_t>(outcome)]; };
+
+	logger::info("Filter statistics: {} check(s) on {} thread(s)", stats.Total(), stats.threadCount);
+	logger::info("  Allowed: {} (filter {}, close range {}, unchecked {})", stats.Allowed(),
+		count(FilterOutcome::AllowFilter), count(FilterOutcome::AllowBypass), count(FilterOutcome::AllowSanity));
+	logger::info("  Blocked: {} (filter {}, out of range {}, dwell time {}, no line of sight {})", stats.Blocked(),
+		count(FilterOutcome::BlockFilter), count(FilterOutcome::BlockOutOfRange), count(FilterOutcome::BlockDwell),
+		count(FilterOutcome::BlockLineOfSight));
+	if (count(FilterOutcome::BlockCooldown) || count(FilterOutcome::BlockRateLimit)) {
+		logger::info("  Throttled: {} (NPC cooldown {}, rate limit {})",
+			count(FilterOutcome::BlockCooldown) + count(FilterOutcome::BlockRateLimit),
+			count(FilterOutcome::BlockCooldown), count(FilterOutcome::BlockRateLimit));
+	}
+	if (stats.timedCalls) {
+		logger::info("  Timed: {} call(s), mean {} ticks, max {} ticks", stats.timedCalls,
+			stats.timedTicks / stats.timedCalls, stats.maxTicks);
+	}
+	if (const auto& los = stats.lineOfSight; los[0] + los[1] + los[2]) {
+		logger::info("  Line of sight: {} raycast(s), {} cached, {} deferred (over budget)",
+			los[static_cast<std::size_t>(LineOfSightSource::Raycast)],
+			los[static_cast<std::size_t>(LineOfSightSource::Cached)],
+			los[static_cast<std::size_t>(LineOfSightSource::Deferred)]);
+	}
+	if (const auto& shadow = stats.shadow; shadow[0] + shadow[1] + shadow[2] + shadow[3]) {
+		logger::info("  Shadow: {} compared - both allow {}, both block {}, only active allows {}, only candidate allows {}",
+			shadow[0] + shadow[1] + shadow[2] + shadow[3], shadow[3], shadow[0], shadow[2], shadow[1]);
+		if (stats.shadowTimedChecks) {
+			logger::info("  Shadow cost: {:.1f} ticks/check for the candidate decision",
+				static_cast<double>(stats.shadowTicks) / static_cast<double>(stats.shadowTimedChecks));
+		}
+	}
+	if (stats.referenceChecks) {
+		logger::info("  Reference check: {} compared, {} differing; current {:.1f} ticks/call, original {:.1f} ticks/call",
+			stats.referenceChecks, stats.referenceMismatches,
+			static_cast<double>(stats.currentTicks) / static_cast<double>(stats.referenceChecks),
+			static_cast<double>(stats.referenceTicks) / static_cast<double>(stats.referenceChecks));
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * Creates the shared statistics block (StatsExportLayout.h) and starts the
+ * background thread that republishes the filter statistics into it every
+ * kStatsPublishInterval. The thread lives until the game exits.
+ *
+ * Read it with tools/StatsReader while the game is running.
+ *
+ * @return true if the shared memory block was created
+ */
+bool StartStatsExport();
+
+/**
+ * Writes the current filter statistics totals (CollectStatistics) to the log.
+ */
+void LogFilterStatistics();
@@ -0,0 +1,173 @@
+#pragma once
+
+// Shared with tools/StatsReader and tests/ - standard headers only, no PCH.
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#	include <immintrin.h>
+#endif
+
+/**
+ * Layout of the live statistics block the plugin publishes in named shared
+ * memory (see StatsExport.cpp and StatsMapping.h). Readers open the mapping
+ * read-only and use the seqlock protocol below (WriteSnapshot/ReadSnapshot);
+ * the publisher never waits for them.
+ *
+ * Seqlock:
+ *   writer  sequence = odd (relaxed), release fence, payload stores (relaxed),
+ *           sequence = even (release)
+ *   reader  s1 = sequence (acquire), retry if odd, payload loads (relaxed),
+ *           acquire fence, s2 = sequence (relaxed), retry if s1 != s2
+ *
+ * Any change to the payload bumps kStatsLayoutVersion.
+ */
+namespace StatsExport
+{
+	inline constexpr char kMappingName[] = "to-your-face-reloaded.stats";  // Local\ on Windows, / for shm_open
+	inline constexpr std::uint32_t kMagic = 0x53465954;  // "TYFS"
+	inline constexpr std::uint32_t kStatsLayoutVersion = 4;
+
+	inline constexpr std::size_t kOutcomeCount = 9;  // FilterOutcome::kCount
+	inline constexpr std::size_t kTimeBuckets = 16;  // Bucket i: calls taking [64 << (i-1), 64 << i) TSC ticks, bucket 0: < 64
+
+	/**
+	 * @return Call time histogram bucket for a duration in TSC ticks
+	 */
+	inline std::size_t GetTimeBucket(std::uint64_t ticks)
+	{
+		std::size_t bucket = 0;
+		for (ticks >>= 6; ticks && bucket < kTimeBuckets - 1; ticks >>= 1) {
+			++bucket;
+		}
+		return bucket;
+	}
+
+	struct SharedStats
+	{
+		// Header - written once before the block is published
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint32_t size;       // sizeof(SharedStats)
+		std::uint32_t processID;  // Game process
+
+		alignas(64) std::atomic<std::uint64_t> sequence;  // Odd while an update is in progress
+
+		// Payload
+		std::atomic<std::uint64_t> publishCount;             // Updates since the game started
+		std::atomic<std::uint64_t> uptimeMicroseconds;       // Time of this update since the export started
+		std::atomic<std::uint64_t> ticksPerSecond;           // Calibrated TSC frequency, for converting call times
+		std::atomic<std::uint64_t> threadCount;              // Threads that have called the filter
+		std::atomic<std::uint64_t> outcomes[kOutcomeCount];  // Indexed by FilterOutcome
+		std::atomic<std::uint64_t> timedCalls;               // Calls measured (filter timing is on while exporting)
+		std::atomic<std::uint64_t> timedTicks;               // Sum of measured call times
+		std::atomic<std::uint64_t> maxTicks;                 // Slowest measured call
+		std::atomic<std::uint64_t> timeHistogram[kTimeBuckets];
+	};
+
+	static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Shared memory counters must be lock-free");
+
+	/**
+	 * Plain copy of the published payload.
+	 */
+	struct Snapshot
+	{
+		std::uint64_t publishCount;
+		std::uint64_t uptimeMicroseconds;
+		std::uint64_t ticksPerSecond;
+		std::uint64_t threadCount;
+		std::uint64_t outcomes[kOutcomeCount];
+		std::uint64_t timedCalls;
+		std::uint64_t timedTicks;
+		std::uint64_t maxTicks;
+		std::uint64_t timeHistogram[kTimeBuckets];
+
+		std::uint64_t Total() const
+		{
+			std::uint64_t total = 0;
+			for (auto count : outcomes) {
+				total += count;
+			}
+			return total;
+		}
+
+		// FilterOutcome: 0-2 allow, 3 out of range, 4 filter, 5 line of sight, 6 dwell time,
+		// 7 NPC cooldown, 8 rate limit
+		std::uint64_t Allowed() const { return outcomes[0] + outcomes[1] + outcomes[2]; }
+	};
+
+	/**
+	 * Copies a snapshot into the shared block (seqlock write side). Single
+	 * writer; snapshot.publishCount is ignored, the block counts its updates.
+	 */
+	inline void WriteSnapshot(SharedStats& shared, const Snapshot& snapshot)
+	{
+		constexpr auto relaxed = std::memory_order_relaxed;
+
+		const std::uint64_t sequence = shared.sequence.load(relaxed);
+		shared.sequence.store(sequence + 1, relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		shared.publishCount.store(shared.publishCount.load(relaxed) + 1, relaxed);
+		shared.uptimeMicroseconds.store(snapshot.uptimeMicroseconds, relaxed);
+		shared.ticksPerSecond.store(snapshot.ticksPerSecond, relaxed);
+		shared.threadCount.store(snapshot.threadCount, relaxed);
+		for (std::size_t i = 0; i < kOutcomeCount; ++i) {
+			shared.outcomes[i].store(snapshot.outcomes[i], relaxed);
+		}
+		shared.timedCalls.store(snapshot.timedCalls, relaxed);
+		shared.timedTicks.store(snapshot.timedTicks, relaxed);
+		shared.maxTicks.store(snapshot.maxTicks, relaxed);
+		for (std::size_t i = 0; i < kTimeBuckets; ++i) {
+			shared.timeHistogram[i].store(snapshot.timeHistogram[i], relaxed);
+		}
+
+		shared.sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	/**
+	 * Reads a consistent snapshot (seqlock read side).
+	 *
+	 * @param attempts Reads to try before giving up
+	 * @return false if nothing has been published yet or the publisher kept the
+	 *         block busy for every attempt
+	 */
+	inline bool ReadSnapshot(const SharedStats& shared, Snapshot& out, int attempts = 1000)
+	{
+		constexpr auto relaxed = std::memory_order_relaxed;
+
+		for (int attempt = 0; attempt < attempts; ++attempt) {
+			const std::uint64_t before = shared.sequence.load(std::memory_order_acquire);
+			if (before == 0) {
+				return false;
+			}
+			if (before & 1) {
+#if defined(_M_X64) || defined(__x86_64__)
+				_mm_pause();
+#endif
+				continue;
+			}
+
+			out.publishCount = shared.publishCount.load(relaxed);
+			out.uptimeMicroseconds = shared.uptimeMicroseconds.load(relaxed);
+			out.ticksPerSecond = shared.ticksPerSecond.load(relaxed);
+			out.threadCount = shared.threadCount.load(relaxed);
+			for (std::size_t i = 0; i < kOutcomeCount; ++i) {
+				out.outcomes[i] = shared.outcomes[i].load(relaxed);
+			}
+			out.timedCalls = shared.timedCalls.load(relaxed);
+			out.timedTicks = shared.timedTicks.load(relaxed);
+			out.maxTicks = shared.maxTicks.load(relaxed);
+			for (std::size_t i = 0; i < kTimeBuckets; ++i) {
+				out.timeHistogram[i] = shared.timeHistogram[i].load(relaxed);
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (shared.sequence.load(relaxed) == before) {
+				return true;
+			}
+		}
+		return false;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+// Shared with tools/StatsReader and tests/ - standard headers only, no PCH.
+#include "StatsExportLayout.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * StatsMapping.h - Named shared memory holding the statistics block
+ *
+ * The platform layer of the statistics export (StatsExport.cpp) and of
+ * tools/StatsReader. Backends:
+ *   StatsMappingWin32.cpp - pagefile-backed file mapping in the Local\ namespace (the plugin)
+ *   StatsMappingPosix.cpp - shm_open + mmap (tyf-stats elsewhere; tests/StatsExportTest)
+ * The block's contents are defined by StatsExportLayout.h; a mapping only
+ * creates, opens and unmaps it.
+ */
+class StatsMapping
+{
+public:
+	virtual ~StatsMapping() = default;
+
+	/**
+	 * @return The mapped block (read-only for mappings from OpenStatsMapping)
+	 */
+	StatsExport::SharedStats* Get() const { return shared; }
+
+protected:
+	StatsExport::SharedStats* shared = nullptr;
+};
+
+/**
+ * Creates a zero-filled block for the publisher. The name is released when
+ * the mapping is destroyed; the plugin keeps its mapping until the game exits.
+ *
+ * @param name Mapping name without a namespace prefix (StatsExport::kMappingName)
+ * @param error Receives the reason on failure
+ * @return nullptr if the block cannot be created, or another live process owns the name
+ */
+std::unique_ptr<StatsMapping> CreateStatsMapping(std::string_view name, std::string& error);
+
+/**
+ * Opens an existing block read-only.
+ *
+ * @param name Mapping name without a namespace prefix (StatsExport::kMappingName)
+ * @param error Receives the reason on failure
+ * @return nullptr if no block with this name exists or it is too small
+ */
+std::unique_ptr<StatsMapping> OpenStatsMapping(std::string_view name, std::string& error);
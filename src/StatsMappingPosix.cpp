@@ -0,0 +1,138 @@
+/**
+ * StatsMappingPosix.cpp - StatsMapping backend for POSIX systems (shm_open + mmap)
+ *
+ * The block is a POSIX shared memory object named "/<name>". Unlike a
+ * Windows mapping it outlives a publisher that crashed; CreateStatsMapping
+ * replaces such a leftover if the process recorded in its header is gone.
+ *
+ * Game-independent (also built by tests/) - standard headers only, no PCH.
+ */
+
+#include "StatsMapping.h"
+
+#ifndef _WIN32
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+	class PosixStatsMapping final : public StatsMapping
+	{
+	public:
+		PosixStatsMapping(void* view, std::string ownedName) :
+			ownedName(std::move(ownedName))
+		{
+			shared = static_cast<StatsExport::SharedStats*>(view);
+		}
+
+		~PosixStatsMapping() override
+		{
+			munmap(shared, sizeof(StatsExport::SharedStats));
+			if (!ownedName.empty()) {
+				shm_unlink(ownedName.c_str());
+			}
+		}
+
+	private:
+		std::string ownedName;  // Set for the creator, which removes the name again
+	};
+
+	std::string GetObjectName(std::string_view name)
+	{
+		std::string objectName(1, '/');
+		objectName.append(name);
+		return objectName;
+	}
+
+	std::string DescribeError(const char* call)
+	{
+		return std::string(call) + " failed: " + std::strerror(errno);
+	}
+
+	/**
+	 * @return true if the block left under this name names a process that no longer exists
+	 */
+	bool IsAbandoned(const std::string& objectName)
+	{
+		const int fd = shm_open(objectName.c_str(), O_RDONLY, 0);
+		if (fd < 0) {
+			return false;
+		}
+		struct stat status{};
+		void* view = fstat(fd, &status) == 0 && status.st_size >= static_cast<off_t>(sizeof(StatsExport::SharedStats)) ?
+		                 mmap(nullptr, sizeof(StatsExport::SharedStats), PROT_READ, MAP_SHARED, fd, 0) :
+		                 MAP_FAILED;
+		close(fd);
+		if (view == MAP_FAILED) {
+			return true;  // Truncated: the publisher died before sizing it
+		}
+
+		const auto* shared = static_cast<const StatsExport::SharedStats*>(view);
+		const auto processID = static_cast<pid_t>(shared->processID);
+		const bool abandoned = processID > 0 && kill(processID, 0) != 0 && errno == ESRCH;
+		munmap(view, sizeof(StatsExport::SharedStats));
+		return abandoned;
+	}
+}
+
+std::unique_ptr<StatsMapping> CreateStatsMapping(std::string_view name, std::string& error)
+{
+	const std::string objectName = GetObjectName(name);
+
+	int fd = shm_open(objectName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd < 0 && errno == EEXIST && IsAbandoned(objectName)) {
+		shm_unlink(objectName.c_str());
+		fd = shm_open(objectName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+	}
+	if (fd < 0) {
+		error = errno == EEXIST ? "the block already exists (another game instance?)" : DescribeError("shm_open");
+		return nullptr;
+	}
+
+	// A new object is zero-filled
+	void* view = MAP_FAILED;
+	if (ftruncate(fd, sizeof(StatsExport::SharedStats)) == 0) {
+		view = mmap(nullptr, sizeof(StatsExport::SharedStats), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	if (view == MAP_FAILED) {
+		error = DescribeError("ftruncate/mmap");
+		close(fd);
+		shm_unlink(objectName.c_str());
+		return nullptr;
+	}
+	close(fd);
+	return std::make_unique<PosixStatsMapping>(view, objectName);
+}
+
+std::unique_ptr<StatsMapping> OpenStatsMapping(std::string_view name, std::string& error)
+{
+	const int fd = shm_open(GetObjectName(name).c_str(), O_RDONLY, 0);
+	if (fd < 0) {
+		error = errno == ENOENT ? "no block named " + std::string(name) : DescribeError("shm_open");
+		return nullptr;
+	}
+
+	struct stat status{};
+	if (fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(StatsExport::SharedStats))) {
+		error = "the block is too small";
+		close(fd);
+		return nullptr;
+	}
+
+	void* view = mmap(nullptr, sizeof(StatsExport::SharedStats), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (view == MAP_FAILED) {
+		error = DescribeError("mmap");
+		return nullptr;
+	}
+	return std::make_unique<PosixStatsMapping>(view, std::string());
+}
+
+#endif
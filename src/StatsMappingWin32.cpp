@@ -0,0 +1,93 @@
+/**
+ * StatsMappingWin32.cpp - StatsMapping backend for Windows (named file mapping)
+ *
+ * The block is a pagefile-backed mapping in the session's Local\ namespace.
+ * Windows frees it when the last handle is closed, so a crashed game leaves
+ * nothing behind.
+ *
+ * Game-independent - Windows and standard headers only, no PCH.
+ */
+
+#include "StatsMapping.h"
+
+#ifdef _WIN32
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+
+namespace
+{
+	class Win32StatsMapping final : public StatsMapping
+	{
+	public:
+		Win32StatsMapping(HANDLE mapping, void* view) :
+			mapping(mapping)
+		{
+			shared = static_cast<StatsExport::SharedStats*>(view);
+		}
+
+		~Win32StatsMapping() override
+		{
+			UnmapViewOfFile(shared);
+			CloseHandle(mapping);
+		}
+
+	private:
+		HANDLE mapping;
+	};
+
+	std::wstring GetMappingName(std::string_view name)
+	{
+		std::wstring wide = L"Local\\";
+		wide.append(name.begin(), name.end());  // ASCII
+		return wide;
+	}
+}
+
+std::unique_ptr<StatsMapping> CreateStatsMapping(std::string_view name, std::string& error)
+{
+	HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+		static_cast<DWORD>(sizeof(StatsExport::SharedStats)), GetMappingName(name).c_str());
+	if (!mapping) {
+		error = "CreateFileMappingW failed with error " + std::to_string(GetLastError());
+		return nullptr;
+	}
+	if (GetLastError() == ERROR_ALREADY_EXISTS) {
+		error = "the block already exists (another game instance?)";
+		CloseHandle(mapping);
+		return nullptr;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, sizeof(StatsExport::SharedStats));
+	if (!view) {
+		error = "MapViewOfFile failed with error " + std::to_string(GetLastError());
+		CloseHandle(mapping);
+		return nullptr;
+	}
+	return std::make_unique<Win32StatsMapping>(mapping, view);
+}
+
+std::unique_ptr<StatsMapping> OpenStatsMapping(std::string_view name, std::string& error)
+{
+	HANDLE mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, GetMappingName(name).c_str());
+	if (!mapping) {
+		error = "no block named " + std::string(name);
+		return nullptr;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	MEMORY_BASIC_INFORMATION info{};
+	if (!view || !VirtualQuery(view, &info, sizeof(info)) || info.RegionSize < sizeof(StatsExport::SharedStats)) {
+		error = view ? "the block is too small" : "MapViewOfFile failed with error " + std::to_string(GetLastError());
+		if (view) {
+			UnmapViewOfFile(view);
+		}
+		CloseHandle(mapping);
+		return nullptr;
+	}
+	return std::make_unique<Win32StatsMapping>(mapping, view);
+}
+
+#endif
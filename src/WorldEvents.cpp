@@ -0,0 +1,100 @@
+/**
+ * WorldEvents.cpp - World generation bumps from game events
+ *
+ * Event sinks run on the game's main thread. Bumping is a relaxed increment;
+ * the caches that watch the generation may still answer a call or two from
+ * before the change on other AI threads, which is no worse than the event
+ * arriving a frame later.
+ *
+ * Per-reference cell attach/detach events are deliberately not used: they
+ * fire for every reference while cells stream in around the player, and
+ * would flush the caches continuously in exteriors.
+ */
+
+#include "PCH.h"
+#include "WorldEvents.h"
+
+namespace
+{
+	inline constexpr std::size_t kWorldChangeKinds = static_cast<std::size_t>(WorldChange::kCount);
+
+	std::array<std::atomic<std::uint64_t>, kWorldChangeKinds> g_worldChanges{};
+
+	/**
+	 * Receives reference move/attach events; only the player's count.
+	 */
+	class PlayerMoveHandler : public RE::BSTEventSink<RE::TESMoveAttachDetachEvent>
+	{
+	public:
+		static PlayerMoveHandler* GetSingleton()
+		{
+			static PlayerMoveHandler singleton;
+			return &singleton;
+		}
+
+		RE::BSEventNotifyControl ProcessEvent(const RE::TESMoveAttachDetachEvent* a_event, RE::BSTEventSource<RE::TESMoveAttachDetachEvent>*) override
+		{
+			if (a_event && a_event->isCellAttached && a_event->movedRef &&
+				a_event->movedRef.get() == RE::PlayerCharacter::GetSingleton()) {
+				BumpWorldGeneration(WorldChange::Teleport);
+			}
+			return RE::BSEventNotifyControl::kContinue;
+		}
+	};
+
+	/**
+	 * Receives the end of fast travel.
+	 */
+	class FastTravelHandler : public RE::BSTEventSink<RE::TESFastTravelEndEvent>
+	{
+	public:
+		static FastTravelHandler* GetSingleton()
+		{
+			static FastTravelHandler singleton;
+			return &singleton;
+		}
+
+		RE::BSEventNotifyControl ProcessEvent(const RE::TESFastTravelEndEvent*, RE::BSTEventSource<RE::TESFastTravelEndEvent>*) override
+		{
+			BumpWorldGeneration(WorldChange::FastTravel);
+			return RE::BSEventNotifyControl::kContinue;
+		}
+	};
+}
+
+void BumpWorldGeneration(WorldChange change)
+{
+	// Increment one counter without carrying into the next (config changes
+	// bump from the publishing thread, the rest from the main thread)
+	const int shift = static_cast<int>(change) * kWorldGenerationBits;
+	const std::uint64_t field = ((1ull << kWorldGenerationBits) - 1) << shift;
+	std::uint64_t generation = g_worldGeneration.load(std::memory_order_relaxed);
+	while (!g_worldGeneration.compare_exchange_weak(generation, (generation & ~field) | ((generation + (1ull << shift)) & field),
+		std::memory_order_relaxed)) {
+	}
+	g_worldChanges[static_cast<std::size_t>(change)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void RegisterWorldEventHandlers()
+{
+	auto events = RE::ScriptEventSourceHolder::GetSingleton();
+	if (!events) {
+		logger::warn("Script event source not available - caches will only reset on space change and game load");
+		return;
+	}
+
+	events->AddEventSink<RE::TESMoveAttachDetachEvent>(PlayerMoveHandler::GetSingleton());
+	events->AddEventSink<RE::TESFastTravelEndEvent>(FastTravelHandler::GetSingleton());
+	logger::info("Registered for teleport and fast travel events (cache invalidation)");
+}
+
+void LogWorldChanges()
+{
+	const auto count = [](WorldChange change) {
+		return g_worldChanges[static_cast<std::size_t>(change)].load(std::memory_order_relaxed);
+	};
+
+	logger::info("  World changes: {} space, {} teleport, {} fast travel, {} game load, {} config",
+		count(WorldChange::SpaceChange), count(WorldChange::Teleport), count(WorldChange::FastTravel),
+		count(WorldChange::GameLoad), count(WorldChange::ConfigChange));
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "PCH.h"
+
+/**
+ * World generation - invalidation of the filter's per-actor caches.
+ *
+ * The line-of-sight, dwell time and cooldown tables remember things about
+ * actors by reference FormID: results that stop being true once the player
+ * moves to another space (between interior and exterior, into another
+ * interior or worldspace), is teleported, fast travels or loads a save
+ * (FormIDs of created references are even reused across saves). Walking
+ * across exterior cell borders changes nothing for them and bumps nothing.
+ *
+ * Rather than each cache checking the world on every call, events bump a
+ * counter per kind of change, all packed into one word, and each cache
+ * compares the kinds it follows with the values it last saw: one relaxed
+ * load, mask and compare on the hot path, and the first call after a bump
+ * clears the cache. The cooldown table only follows game loads (a cooldown
+ * is about the NPC, wherever the player went), the other tables follow
+ * every kind.
+ *
+ * The actor category cache is not included; it follows the configuration's
+ * categoryGeneration instead, which only changes when rules are recompiled.
+ */
+
+/**
+ * What bumped the world generation (for statistics).
+ */
+enum class WorldChange : std::uint8_t
+{
+	SpaceChange = 0,   // Player entered another interior or worldspace, or crossed between them
+	Teleport = 1,      // Player moved to a new cell attachment (doors, MoveTo, coc)
+	FastTravel = 2,    // Fast travel finished
+	GameLoad = 3,      // Save loaded or new game started
+	ConfigChange = 4,  // A configuration snapshot was published
+	kCount
+};
+
+// One 12-bit counter per WorldChange (modulo 4096), kind k in bits 12k to 12k+11.
+// Bumped by BumpWorldGeneration() only; read by WorldGenerationWatch.
+inline constexpr int kWorldGenerationBits = 12;
+inline std::atomic<std::uint64_t> g_worldGeneration{ 0 };
+static_assert(static_cast<int>(WorldChange::kCount) * kWorldGenerationBits <= 64, "world change counters must fit one word");
+
+/**
+ * Invalidates every cache watching the world generation. O(1): caches clear
+ * themselves on their next use.
+ *
+ * @param change What changed (counted for the statistics)
+ */
+void BumpWorldGeneration(WorldChange change);
+
+/**
+ * Registers the event sinks that bump the world generation (teleport, fast
+ * travel). Player space changes are reported by the threshold profile handler
+ * (CellProfiles.cpp), game loads from the SKSE message handler and
+ * configuration changes from PublishConfig. Must run after kDataLoaded.
+ */
+void RegisterWorldEventHandlers();
+
+/**
+ * Writes the number of world changes by kind to the log.
+ */
+void LogWorldChanges();
+
+/**
+ * One cache's view of the world generation.
+ */
+class WorldGenerationWatch
+{
+public:
+	/**
+	 * Follows every kind of change.
+	 */
+	WorldGenerationWatch() :
+		mask(~0ull)
+	{}
+
+	/**
+	 * @param changes The kinds of change that clear this cache
+	 */
+	WorldGenerationWatch(std::initializer_list<WorldChange> changes) :
+		mask(0)
+	{
+		for (const WorldChange change : changes) {
+			mask |= ((1ull << kWorldGenerationBits) - 1) << (static_cast<int>(change) * kWorldGenerationBits);
+		}
+	}
+
+	/**
+	 * @return true once per bump of a followed kind, for exactly one caller - that caller clears the cache
+	 */
+	bool Changed()
+	{
+		const std::uint64_t current = g_worldGeneration.load(std::memory_order_relaxed) & mask;
+		std::uint64_t seen = seenGeneration.load(std::memory_order_relaxed);
+		return seen != current && seenGeneration.compare_exchange_strong(seen, current, std::memory_order_relaxed);
+	}
+
+private:
+	std::uint64_t mask;
+	std::atomic<std::uint64_t> seenGeneration{ 0 };
+};
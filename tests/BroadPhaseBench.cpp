@@ -0,0 +1,185 @@
+/**
+ * BroadPhaseBench.cpp - Out-of-range reject against brute force and a uniform grid
+ *
+ * Three ways to decide every NPC of a crowd once per frame in the modes with
+ * a hard distance gate (Distance, Both):
+ *   brute force  - full DecideComment for every NPC (no candidate range)
+ *   broad phase  - what the plugin does: reject beyond fMaxGreetingDistance
+ *                  right after the squared distance (candidateRangeSquared)
+ *   grid         - per-frame uniform grid of the crowd (cell = greeting
+ *                  distance); only NPCs in the 3x3 cells around the player
+ *                  reach DecideComment. The grid is rebuilt every frame, as
+ *                  actors move, and its build cost is included
+ * All three must allow exactly the same comments.
+ *
+ * Usage: BroadPhaseBench [--quick]
+ */
+
+#include "MockWorld.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <limits>
+
+namespace
+{
+	constexpr std::array<std::size_t, 4> kCrowdSizes = { 10, 100, 1000, 10000 };
+	constexpr float kCrowdRadius = 4000.0f;
+	constexpr float kTurnPerFrame = 0.05f;
+
+	enum class Method
+	{
+		BruteForce,
+		BroadPhase,
+		Grid
+	};
+
+	/**
+	 * Uniform grid over the crowd, rebuilt per frame (counting sort by cell).
+	 */
+	class CrowdGrid
+	{
+	public:
+		CrowdGrid(float radius, float cellSize) :
+			cellSize(cellSize),
+			cellsPerSide(static_cast<int>(2.0f * radius / cellSize) + 1),
+			offset(radius)
+		{
+			starts.resize(static_cast<std::size_t>(cellsPerSide * cellsPerSide) + 1);
+		}
+
+		void Build(const std::vector<mock::Npc>& crowd)
+		{
+			std::fill(starts.begin(), starts.end(), 0u);
+			cellOf.resize(crowd.size());
+			order.resize(crowd.size());
+			for (std::size_t i = 0; i < crowd.size(); ++i) {
+				cellOf[i] = CellIndex(CellCoordinate(crowd[i].x), CellCoordinate(crowd[i].y));
+				++starts[cellOf[i] + 1];
+			}
+			for (std::size_t i = 1; i < starts.size(); ++i) {
+				starts[i] += starts[i - 1];
+			}
+			fill.assign(starts.begin(), starts.end() - 1);
+			for (std::size_t i = 0; i < crowd.size(); ++i) {
+				order[fill[cellOf[i]]++] = static_cast<std::uint32_t>(i);
+			}
+		}
+
+		/**
+		 * Marks every NPC in the 3x3 cells around a point.
+		 */
+		void MarkNeighbours(float x, float y, std::vector<std::uint8_t>& marks) const
+		{
+			const int cx = CellCoordinate(x);
+			const int cy = CellCoordinate(y);
+			for (int gy = std::max(cy - 1, 0); gy <= std::min(cy + 1, cellsPerSide - 1); ++gy) {
+				for (int gx = std::max(cx - 1, 0); gx <= std::min(cx + 1, cellsPerSide - 1); ++gx) {
+					const std::size_t cell = CellIndex(gx, gy);
+					for (std::uint32_t i = starts[cell]; i < starts[cell + 1]; ++i) {
+						marks[order[i]] = 1;
+					}
+				}
+			}
+		}
+
+	private:
+		int CellCoordinate(float value) const
+		{
+			return std::clamp(static_cast<int>((value + offset) / cellSize), 0, cellsPerSide - 1);
+		}
+
+		std::size_t CellIndex(int x, int y) const { return static_cast<std::size_t>(y * cellsPerSide + x); }
+
+		float cellSize;
+		int cellsPerSide;
+		float offset;
+		std::vector<std::uint32_t> starts;
+		std::vector<std::uint32_t> fill;
+		std::vector<std::size_t> cellOf;
+		std::vector<std::uint32_t> order;
+	};
+
+	struct Result
+	{
+		double nanosecondsPerCall;
+		std::size_t allowed;
+	};
+
+	Result Simulate(Method method, const FilterParameters& filter, const std::vector<mock::Npc>& crowd, std::size_t frames)
+	{
+		// Largest greeting distance of the categories in use bounds the grid cell
+		float cellSize = 0.0f;
+		for (const auto& thresholds : filter.categories) {
+			cellSize = std::max(cellSize, std::sqrt(thresholds.maxGreetingDistanceSquared));
+		}
+		CrowdGrid grid(kCrowdRadius, cellSize);
+		std::vector<std::uint8_t> marks(crowd.size());
+
+		mock::Player player{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, false };
+		std::size_t allowed = 0;
+
+		const auto start = test::Clock::now();
+		for (std::size_t frame = 0; frame < frames; ++frame) {
+			player.yaw = static_cast<float>(frame % 126) * kTurnPerFrame;
+			const PlayerFacing facing = MakePlayerFacing(player.yaw, player.pitch);
+
+			if (method == Method::Grid) {
+				grid.Build(crowd);
+				std::fill(marks.begin(), marks.end(), std::uint8_t{ 0 });
+				grid.MarkNeighbours(player.x, player.y, marks);
+			}
+
+			for (std::size_t i = 0; i < crowd.size(); ++i) {
+				if (method == Method::Grid && !marks[i]) {
+					continue;  // Rejected by the grid
+				}
+				const CommentQuery query = mock::MakeQuery(filter, player, facing, crowd[i], nullptr);
+				allowed += DecideComment(filter, filter.categories[crowd[i].category], query).allow ? 1 : 0;
+			}
+		}
+		const double elapsed = test::ElapsedNanoseconds(start);
+
+		return { elapsed / static_cast<double>(frames * crowd.size()), allowed };
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = test::IsQuick(argc, argv);
+	const std::size_t callsPerCase = quick ? 200'000 : 5'000'000;
+
+	constexpr std::array modes = { FilterMode::DistanceOnly, FilterMode::Both };
+	constexpr std::array modeNames = { "Distance", "Both" };
+
+	std::printf("%-9s %7s %14s %14s %14s\n", "mode", "NPCs", "brute ns/NPC", "reject ns/NPC", "grid ns/NPC");
+
+	for (std::size_t m = 0; m < modes.size(); ++m) {
+		const auto withReject = mock::MakeFilter(modes[m], false);
+		auto bruteForce = mock::MakeFilter(modes[m], false);
+		for (auto& thresholds : bruteForce->params.categories) {
+			thresholds.candidateRangeSquared = std::numeric_limits<float>::infinity();
+		}
+
+		for (const std::size_t count : kCrowdSizes) {
+			test::Random random;
+			const auto crowd = mock::MakeCrowd(count, kCrowdRadius, 4, random);
+			const std::size_t frames = std::max<std::size_t>(1, callsPerCase / count);
+
+			Simulate(Method::BruteForce, bruteForce->params, crowd, std::max<std::size_t>(1, frames / 10));  // Warm up
+			const Result brute = Simulate(Method::BruteForce, bruteForce->params, crowd, frames);
+			const Result reject = Simulate(Method::BroadPhase, withReject->params, crowd, frames);
+			const Result grid = Simulate(Method::Grid, withReject->params, crowd, frames);
+
+			CHECK(brute.allowed == reject.allowed);
+			CHECK(grid.allowed == reject.allowed);
+			test::Consume(brute.allowed + reject.allowed + grid.allowed);
+
+			std::printf("%-9s %7zu %14.2f %14.2f %14.2f\n", modeNames[m], count,
+				brute.nanosecondsPerCall, reject.nanosecondsPerCall, grid.nanosecondsPerCall);
+		}
+	}
+
+	return test::Finish("BroadPhaseBench");
+}
@@ -0,0 +1,199 @@
+/**
+ * CameraFacingTest.cpp - sFacingSource=Camera against the actor facing
+ *
+ * A camera looking exactly where the actor looks must give the same facing
+ * as the actor's yaw and pitch, and with it the same decisions:
+ *   - facing   MakeCameraFacing of the actor's view direction against
+ *              MakePlayerFacing, for yaws all around (both sides of the
+ *              0 / 2*pi seam) and pitches up to ~86 degrees
+ *   - decide   a crowd decided with either facing, in every mode the facing
+ *              matters to, flat and with b3DViewCone; a different decision is
+ *              only accepted where turning the actor by 1e-4 radians changes
+ *              the decision too
+ *   - vertical cameras looking (almost) straight up or down have no facing
+ *              of their own, and the caller falls back to the actor's
+ *
+ * Usage: CameraFacingTest [--quick]
+ */
+
+#include "MockWorld.h"
+
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <numbers>
+#include <optional>
+#include <utility>
+
+namespace
+{
+	constexpr float kTwoPi = 2.0f * std::numbers::pi_v<float>;
+	constexpr float kMaxPitch = 1.5f;          // ~86 degrees, horizontal length 0.07
+	constexpr float kAngleTolerance = 1e-5f;   // Yaw and pitch, radians (the truncated pi is off by 1.85e-4)
+	constexpr float kVectorTolerance = 1e-6f;  // Forward and view components
+	constexpr float kBoundaryNudge = 1e-4f;    // Radians the actor is turned to find decisions on a boundary
+
+	float AngleDifference(float a, float b)
+	{
+		const float difference = std::fmod(std::fabs(a - b), kTwoPi);
+		return std::min(difference, kTwoPi - difference);
+	}
+
+	std::optional<PlayerFacing> CameraAlong(const PlayerFacing& actor)
+	{
+		return MakeCameraFacing(actor.viewX, actor.viewY, actor.viewZ);
+	}
+
+	void TestFacing(std::size_t count, test::Random& random)
+	{
+		float largestAngle = 0.0f;
+		float largestVector = 0.0f;
+		std::size_t mismatched = 0;
+
+		for (std::size_t i = 0; i < count; ++i) {
+			// Every fourth yaw within 0.05 radians of the seam, on either side
+			float yaw = random.Next() * kTwoPi;
+			if (i % 4 == 0) {
+				yaw = random.NextBits() & 1 ? random.Next() * 0.05f : kTwoPi - random.Next() * 0.05f;
+			}
+			const float pitch = (random.Next() * 2.0f - 1.0f) * kMaxPitch;
+
+			const PlayerFacing actor = MakePlayerFacing(yaw, pitch);
+			const auto camera = CameraAlong(actor);
+			if (!camera) {
+				++mismatched;
+				continue;
+			}
+
+			const float angle = std::max(AngleDifference(camera->yaw, actor.yaw), std::fabs(camera->pitch - actor.pitch));
+			const float vector = std::max({ std::fabs(camera->forwardX - actor.forwardX), std::fabs(camera->forwardY - actor.forwardY),
+				std::fabs(camera->viewX - actor.viewX), std::fabs(camera->viewY - actor.viewY), std::fabs(camera->viewZ - actor.viewZ) });
+			largestAngle = std::max(largestAngle, angle);
+			largestVector = std::max(largestVector, vector);
+			if (angle > kAngleTolerance || vector > kVectorTolerance || camera->yaw < 0.0f || camera->yaw >= kTwoPi) {
+				if (mismatched++ < 5) {
+					std::printf("  yaw=%.9g pitch=%.9g -> camera yaw=%.9g pitch=%.9g\n", yaw, pitch, camera->yaw, camera->pitch);
+				}
+			}
+		}
+
+		CHECK(mismatched == 0);
+		std::printf("  facing: %zu directions, largest angle difference %.3g rad, vector difference %.3g\n",
+			count, largestAngle, largestVector);
+
+		// Cameras turned left of +Y wrap to just below 2*pi, as GetAngleZ does
+		const auto left = CameraAlong(MakePlayerFacing(kTwoPi - 0.3f, 0.0f));
+		CHECK(left && AngleDifference(left->yaw, kTwoPi - 0.3f) < kAngleTolerance && left->yaw > std::numbers::pi_v<float>);
+
+		// Positive pitch looks down
+		const auto down = MakeCameraFacing(0.0f, std::cos(0.5f), -std::sin(0.5f));
+		CHECK(down && std::fabs(down->pitch - 0.5f) < kAngleTolerance && down->yaw == 0.0f);
+	}
+
+	struct DecideResult
+	{
+		std::size_t compared = 0;
+		std::size_t onBoundary = 0;  // Differing, where a nudge of the actor differs too
+		std::size_t differing = 0;   // Differing anywhere else: failures
+	};
+
+	void CompareDecisions(const mock::Filter& filter, const std::vector<mock::Npc>& crowd, const mock::Player& player, DecideResult& result)
+	{
+		const FilterParameters& params = filter.params;
+		const PlayerFacing actor = MakePlayerFacing(player.yaw, player.pitch);
+		const auto camera = CameraAlong(actor);
+		if (!camera) {
+			++result.differing;
+			return;
+		}
+
+		const std::array nudged = {
+			MakePlayerFacing(player.yaw - kBoundaryNudge, player.pitch), MakePlayerFacing(player.yaw + kBoundaryNudge, player.pitch),
+			MakePlayerFacing(player.yaw, player.pitch - kBoundaryNudge), MakePlayerFacing(player.yaw, player.pitch + kBoundaryNudge)
+		};
+
+		for (const mock::Npc& npc : crowd) {
+			const bool allow = mock::Decide(params, npc.category, mock::MakeQuery(params, player, actor, npc, nullptr)).allow;
+			++result.compared;
+			if (mock::Decide(params, npc.category, mock::MakeQuery(params, player, *camera, npc, nullptr)).allow == allow) {
+				continue;
+			}
+			const bool boundary = std::any_of(nudged.begin(), nudged.end(), [&](const PlayerFacing& facing) {
+				return mock::Decide(params, npc.category, mock::MakeQuery(params, player, facing, npc, nullptr)).allow != allow;
+			});
+			if (boundary) {
+				++result.onBoundary;
+			} else if (result.differing++ < 5) {
+				std::printf("  yaw=%.9g pitch=%.9g npc=(%.3f, %.3f, %.3f): actor %s, camera %s\n", player.yaw, player.pitch,
+					npc.x - player.x, npc.y - player.y, npc.z - player.z, allow ? "ALLOW" : "BLOCK", allow ? "BLOCK" : "ALLOW");
+			}
+		}
+	}
+
+	void TestDecisions(std::size_t playerCount, test::Random& random)
+	{
+		constexpr std::array modes = {
+			std::pair{ FilterMode::AngleOnly, "Angle" },
+			std::pair{ FilterMode::Both, "Both" },
+			std::pair{ FilterMode::Either, "Either" },
+			std::pair{ FilterMode::Expression, "Expression" }
+		};
+		const auto crowd = mock::MakeCrowd(512, 400.0f, 4, random);
+
+		std::printf("%-14s %10s %12s %10s\n", "mode", "compared", "on boundary", "differing");
+		for (const bool viewCone : { false, true }) {
+			for (const auto& [mode, name] : modes) {
+				auto filter = mock::MakeFilter(mode, false, viewCone);
+
+				DecideResult result;
+				test::Random players{ 0x5EED0000u + static_cast<std::uint32_t>(mode) };  // The same players with and without the cone
+				for (std::size_t i = 0; i < playerCount; ++i) {
+					const mock::Player player{ 0.0f, 0.0f, 0.0f, players.Next() * kTwoPi, (players.Next() * 2.0f - 1.0f) * kMaxPitch, false };
+					CompareDecisions(*filter, crowd, player, result);
+				}
+
+				CHECK(result.differing == 0);
+				CHECK(result.onBoundary * 1000 <= result.compared);  // Rounding, not a different facing
+				std::printf("%-11s %-2s %10zu %12zu %10zu\n", name, viewCone ? "3D" : "", result.compared, result.onBoundary, result.differing);
+			}
+		}
+	}
+
+	void TestVertical()
+	{
+		// Straight up or down: no horizontal direction at all
+		CHECK(!MakeCameraFacing(0.0f, 0.0f, 1.0f));
+		CHECK(!MakeCameraFacing(0.0f, 0.0f, -1.0f));
+
+		// Just inside and just outside the fallback, in every direction
+		for (int i = 0; i < 16; ++i) {
+			const float bearing = static_cast<float>(i) * kTwoPi / 16.0f;
+			for (const float z : { 1.0f, -1.0f }) {
+				const float below = kMinCameraHorizontal * 0.99f;
+				CHECK(!MakeCameraFacing(std::sin(bearing) * below, std::cos(bearing) * below, z));
+
+				const float above = kMinCameraHorizontal * 1.01f;
+				const auto facing = MakeCameraFacing(std::sin(bearing) * above, std::cos(bearing) * above, z * std::sqrt(1.0f - above * above));
+				CHECK(facing.has_value());
+				if (facing) {
+					CHECK(std::fabs(std::hypot(facing->forwardX, facing->forwardY) - 1.0f) < kVectorTolerance);
+					CHECK(AngleDifference(facing->yaw, bearing) < 1e-4f);
+					CHECK(std::fabs(std::fabs(facing->pitch) - std::acos(above)) < 1e-3f);
+					CHECK((facing->pitch < 0.0f) == (z > 0.0f));  // Looking up is negative pitch
+				}
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = test::IsQuick(argc, argv);
+	test::Random random;
+
+	TestFacing(quick ? 100'000 : 10'000'000, random);
+	TestDecisions(quick ? 64 : 4'096, random);
+	TestVertical();
+
+	return test::Finish("CameraFacingTest");
+}
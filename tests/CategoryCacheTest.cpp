@@ -0,0 +1,217 @@
+/**
+ * CategoryCacheTest.cpp - Per-base category cache: correctness and timing for 10k bases
+ *
+ * Mock actor bases carry faction and keyword lists; resolving one walks them
+ * through the rule bit tables exactly like ComputeCategory in ActorRules.cpp.
+ * Checks that cached results match an uncached resolve, that a new rule
+ * generation invalidates everything, and that a reused dynamic (0xFF) FormID
+ * is resolved again instead of returning the previous form's category.
+ * Then times 10,000 bases: uncached resolve, first (missing) pass, cached
+ * pass in random order, and dynamic bases, which are never cached.
+ *
+ * Usage: CategoryCacheTest [--quick]
+ */
+
+#include "CategoryCache.h"
+#include "TestSupport.h"
+
+#include <cstdio>
+#include <memory>
+#include <numeric>
+
+namespace
+{
+	constexpr std::size_t kBases = 10'000;
+	constexpr std::size_t kFactionPool = 2'000;  // Distinct factions in the load order
+	constexpr std::size_t kKeywordPool = 500;
+	constexpr std::size_t kFactionsPerBase = 8;
+	constexpr std::size_t kKeywordsPerBase = 4;
+	constexpr std::size_t kRules = 7;            // kMaxActorCategories - 1
+
+	struct MockBase
+	{
+		std::uint32_t formID;
+		std::vector<std::uint32_t> factions;
+		std::vector<std::uint32_t> keywords;
+	};
+
+	struct MockRule
+	{
+		std::uint64_t factionMask;
+		std::uint64_t keywordMask;
+	};
+
+	struct MockRules
+	{
+		std::vector<std::uint32_t> factionBits;  // Sorted, index = bit
+		std::vector<std::uint32_t> keywordBits;
+		std::vector<MockRule> rules;
+	};
+
+	std::uint32_t FactionID(std::size_t index) { return 0x00010000u + static_cast<std::uint32_t>(index); }
+	std::uint32_t KeywordID(std::size_t index) { return 0x00020000u + static_cast<std::uint32_t>(index); }
+
+	MockBase MakeBase(std::uint32_t formID, test::Random& random)
+	{
+		MockBase base{ formID, {}, {} };
+		for (std::size_t i = 0; i < kFactionsPerBase; ++i) {
+			base.factions.push_back(FactionID(random.NextBits() % kFactionPool));
+		}
+		for (std::size_t i = 0; i < kKeywordsPerBase; ++i) {
+			base.keywords.push_back(KeywordID(random.NextBits() % kKeywordPool));
+		}
+		return base;
+	}
+
+	/**
+	 * Seven rules referencing 48 factions and 14 keywords between them.
+	 */
+	MockRules MakeRules()
+	{
+		MockRules rules;
+		for (std::size_t i = 0; i < 48; ++i) {
+			rules.factionBits.push_back(FactionID(i * 40));
+		}
+		for (std::size_t i = 0; i < 14; ++i) {
+			rules.keywordBits.push_back(KeywordID(i * 35));
+		}
+		for (std::size_t i = 0; i < kRules; ++i) {
+			MockRule rule{};
+			for (std::size_t bit = i; bit < 48; bit += kRules) {
+				rule.factionMask |= 1ull << bit;
+			}
+			rule.keywordMask = 3ull << (2 * i);
+			rules.rules.push_back(rule);
+		}
+		return rules;
+	}
+
+	// Same walk as ComputeCategory
+	std::uint8_t ComputeCategory(const MockBase& base, const MockRules& rules)
+	{
+		std::uint64_t factionMask = 0;
+		for (const auto faction : base.factions) {
+			factionMask |= GetFormBit(rules.factionBits, faction);
+		}
+		std::uint64_t keywordMask = 0;
+		for (const auto keyword : base.keywords) {
+			keywordMask |= GetFormBit(rules.keywordBits, keyword);
+		}
+		return MatchCategoryRule(rules.rules, factionMask, keywordMask);
+	}
+
+	void TestCorrectness(const std::vector<MockBase>& bases, const MockRules& rules)
+	{
+		auto cache = std::make_unique<CategoryCache>();
+
+		std::size_t mismatches = 0;
+		std::size_t categorized = 0;
+		for (int pass = 0; pass < 2; ++pass) {
+			for (const auto& base : bases) {
+				const std::uint8_t expected = ComputeCategory(base, rules);
+				const std::uint8_t cached = cache->Resolve(base.formID, 1, [&] { return ComputeCategory(base, rules); });
+				mismatches += cached != expected ? 1 : 0;
+				categorized += expected != 0 ? 1 : 0;
+			}
+		}
+		CHECK(mismatches == 0);
+		CHECK(categorized > 0);  // The rules match something
+
+		// Second pass must not call compute for static bases
+		std::size_t computed = 0;
+		for (const auto& base : bases) {
+			cache->Resolve(base.formID, 1, [&] { ++computed; return ComputeCategory(base, rules); });
+		}
+		CHECK(computed < bases.size() / 100);  // Only bases that hit the probe limit
+
+		// New generation: every entry is stale
+		computed = 0;
+		for (const auto& base : bases) {
+			cache->Resolve(base.formID, 2, [&] { ++computed; return std::uint8_t{ 0 }; });
+		}
+		CHECK(computed == bases.size());
+
+		// A dynamic FormID reused for another base is resolved again
+		CHECK(cache->Resolve(0xFF000800u, 2, [] { return std::uint8_t{ 3 }; }) == 3);
+		CHECK(cache->Resolve(0xFF000800u, 2, [] { return std::uint8_t{ 5 }; }) == 5);
+		CHECK(IsDynamicFormID(0xFF000800u));
+		CHECK(!IsDynamicFormID(0xFE000800u));
+	}
+
+	template <class Body>
+	double TimePerBase(std::size_t repeats, std::size_t count, Body&& body)
+	{
+		const auto start = test::Clock::now();
+		for (std::size_t r = 0; r < repeats; ++r) {
+			body();
+		}
+		return test::ElapsedNanoseconds(start) / static_cast<double>(repeats * count);
+	}
+
+	void Benchmark(const std::vector<MockBase>& bases, const std::vector<MockBase>& dynamicBases, const MockRules& rules, bool quick)
+	{
+		const std::size_t repeats = quick ? 3 : 100;
+		auto cache = std::make_unique<CategoryCache>();
+		std::uint64_t sum = 0;
+
+		// Random lookup order, as NPCs come and go
+		std::vector<std::uint32_t> order(bases.size());
+		std::iota(order.begin(), order.end(), 0u);
+		test::Random random;
+		for (std::size_t i = order.size() - 1; i > 0; --i) {
+			std::swap(order[i], order[random.NextBits() % (i + 1)]);
+		}
+
+		const double uncached = TimePerBase(repeats, bases.size(), [&] {
+			for (const auto index : order) {
+				sum += ComputeCategory(bases[index], rules);
+			}
+		});
+
+		std::uint32_t generation = 0;
+		const double firstPass = TimePerBase(repeats, bases.size(), [&] {
+			++generation;  // Every repeat starts with a stale cache
+			for (const auto index : order) {
+				const auto& base = bases[index];
+				sum += cache->Resolve(base.formID, generation, [&] { return ComputeCategory(base, rules); });
+			}
+		});
+
+		const double cachedPass = TimePerBase(repeats, bases.size(), [&] {
+			for (const auto index : order) {
+				const auto& base = bases[index];
+				sum += cache->Resolve(base.formID, generation, [&] { return ComputeCategory(base, rules); });
+			}
+		});
+
+		const double dynamicPass = TimePerBase(repeats, dynamicBases.size(), [&] {
+			for (const auto& base : dynamicBases) {
+				sum += cache->Resolve(base.formID, generation, [&] { return ComputeCategory(base, rules); });
+			}
+		});
+
+		test::Consume(sum);
+		std::printf("%zu bases, %zu factions + %zu keywords each, %zu rules\n", bases.size(), kFactionsPerBase, kKeywordsPerBase, kRules);
+		std::printf("  uncached resolve      %7.2f ns/base\n", uncached);
+		std::printf("  first pass (misses)   %7.2f ns/base\n", firstPass);
+		std::printf("  cached pass (hits)    %7.2f ns/base\n", cachedPass);
+		std::printf("  dynamic 0xFF bases    %7.2f ns/base (never cached)\n", dynamicPass);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	test::Random random;
+	std::vector<MockBase> bases;
+	std::vector<MockBase> dynamicBases;
+	for (std::size_t i = 0; i < kBases; ++i) {
+		bases.push_back(MakeBase(0x00100000u + static_cast<std::uint32_t>(i) * 7, random));
+		dynamicBases.push_back(MakeBase(0xFF000800u + static_cast<std::uint32_t>(i), random));
+	}
+	const MockRules rules = MakeRules();
+
+	TestCorrectness(bases, rules);
+	Benchmark(bases, dynamicBases, rules, test::IsQuick(argc, argv));
+
+	return test::Finish("CategoryCacheTest");
+}
@@ -0,0 +1,316 @@
+/**
+ * ConfigLayersTest.cpp - Layered configuration merge and binary cache
+ *
+ * Writes INI, MCM, override and shadow files to a temporary directory and
+ * checks what LayeredConfig documents:
+ *   - key-by-key precedence INI < MCM < override, case-insensitive names,
+ *     sections in order of first appearance, missing files skipped
+ *   - the first of duplicate keys within one file wins
+ *   - the cache is used when no source changed, and discarded (the sources
+ *     parsed again, the cache rewritten) on a stale fingerprint, a truncated
+ *     file, a bad checksum, a wrong version or trailing bytes
+ *   - Overlay merges one source on top and leaves the lower ones untouched
+ *
+ * Usage: ConfigLayersTest
+ */
+
+#include "ConfigLayers.h"
+#include "IniFile.h"
+#include "TestSupport.h"
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace
+{
+	using namespace std::literals;
+
+	constexpr std::uint32_t Bit(ConfigSource source)
+	{
+		return 1u << static_cast<std::uint32_t>(source);
+	}
+
+	void WriteFile(const std::filesystem::path& path, std::string_view text)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file << text;
+	}
+
+	std::string ReadFile(const std::filesystem::path& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+	}
+
+	// The cache's checksum (FNV-1a), to forge caches that differ only in their body
+	std::uint64_t HashFNV1a(std::string_view data)
+	{
+		std::uint64_t hash = 0xCBF29CE484222325ull;
+		for (const char c : data) {
+			hash = (hash ^ static_cast<std::uint8_t>(c)) * 0x100000001B3ull;
+		}
+		return hash;
+	}
+
+	std::string WithChecksum(std::string body)
+	{
+		const auto bytes = std::bit_cast<std::array<char, sizeof(std::uint64_t)>>(HashFNV1a(body));
+		body.append(bytes.data(), bytes.size());
+		return body;
+	}
+
+	bool HasSetting(const LayeredConfig& config, std::string_view section, std::string_view key, std::string_view value, ConfigSource source)
+	{
+		const ConfigSetting* setting = config.Find(section, key);
+		return setting && setting->value == value && setting->source == source;
+	}
+
+	/**
+	 * The three regular sources (and the shadow file) in one directory.
+	 */
+	struct Sources
+	{
+		explicit Sources(const std::filesystem::path& root) :
+			root(root),
+			ini((root / "base.ini").string()),
+			mcm((root / "mcm.ini").string()),
+			custom((root / "custom.ini").string()),
+			shadow((root / "shadow.ini").string()),
+			cache(root / "merged.cache")
+		{
+			std::filesystem::create_directories(root);
+		}
+
+		std::array<ConfigLayer, 3> Layers() const
+		{
+			return { ConfigLayer{ ConfigSource::Ini, ini }, ConfigLayer{ ConfigSource::MCM, mcm }, ConfigLayer{ ConfigSource::Override, custom } };
+		}
+
+		std::filesystem::path root;
+		std::string ini;
+		std::string mcm;
+		std::string custom;
+		std::string shadow;
+		std::filesystem::path cache;
+	};
+
+	void TestPrecedence(const std::filesystem::path& root)
+	{
+		const Sources sources(root / "precedence");
+		WriteFile(sources.ini,
+			"[Main]\n"
+			"fMaxDeviationAngle = 30\n"
+			"sFilterMode = Angle\n"
+			"bOnlyInIni = true\n"
+			"[Distance]\n"
+			"fMaxGreetingDistance = 150\n");
+		WriteFile(sources.mcm,
+			"[main]\n"
+			"FMAXDEVIATIONANGLE = 45\n"
+			"sFilterMode = Both\n"
+			"sFilterMode = Distance\n"  // Not this one: the first duplicate wins
+			"[Category:Guards]\n"
+			"sFactions = Skyrim.esm|0x2BF9A\n");
+		WriteFile(sources.custom,
+			"[Main]\n"
+			"sFilterMode = Either\n");
+
+		const auto layers = sources.Layers();
+		const LayeredConfig config = LayeredConfig::Load(layers, {});
+
+		CHECK(config.GetPresentSources() == (Bit(ConfigSource::Ini) | Bit(ConfigSource::MCM) | Bit(ConfigSource::Override)));
+		CHECK(!config.IsFromCache());
+
+		CHECK(HasSetting(config, "Main", "fMaxDeviationAngle", "45", ConfigSource::MCM));
+		CHECK(HasSetting(config, "Main", "sFilterMode", "Either", ConfigSource::Override));
+		CHECK(HasSetting(config, "Main", "bOnlyInIni", "true", ConfigSource::Ini));
+		CHECK(HasSetting(config, "Distance", "fMaxGreetingDistance", "150", ConfigSource::Ini));
+		CHECK(HasSetting(config, "Category:Guards", "sFactions", "Skyrim.esm|0x2BF9A", ConfigSource::MCM));
+		CHECK(config.GetSettings().size() == 5);  // One entry per key, whatever its case
+
+		CHECK(config.GetFloat("MAIN", "fmaxdeviationangle", 0.0f) == 45.0f);
+		CHECK(config.GetBool("Main", "bOnlyInIni", false));
+		CHECK(config.GetString("Main", "sMissing", "default") == "default");
+		CHECK(config.GetFloat("Missing", "fMaxDeviationAngle", 12.5f) == 12.5f);
+		CHECK(config.Find("Main", "sMissing") == nullptr);
+
+		// Sections in order of first appearance, lowest source first, case-insensitive
+		const std::vector<std::string> sections = { "Main", "Distance", "Category:Guards" };
+		CHECK(config.GetSections() == sections);
+
+		// Settings sorted by section then key
+		for (std::size_t i = 1; i < config.GetSettings().size(); ++i) {
+			const ConfigSetting& a = config.GetSettings()[i - 1];
+			const ConfigSetting& b = config.GetSettings()[i];
+			const int section = CompareIgnoreCase(a.section, b.section);
+			CHECK(section < 0 || (section == 0 && CompareIgnoreCase(a.key, b.key) < 0));
+		}
+
+		// Missing files are skipped; the rest still merge by precedence
+		std::filesystem::remove(sources.mcm);
+		const LayeredConfig withoutMCM = LayeredConfig::Load(layers, {});
+		CHECK(withoutMCM.GetPresentSources() == (Bit(ConfigSource::Ini) | Bit(ConfigSource::Override)));
+		CHECK(HasSetting(withoutMCM, "Main", "fMaxDeviationAngle", "30", ConfigSource::Ini));
+		CHECK(HasSetting(withoutMCM, "Main", "sFilterMode", "Either", ConfigSource::Override));
+		CHECK(withoutMCM.Find("Category:Guards", "sFactions") == nullptr);
+
+		const std::array missing = { ConfigLayer{ ConfigSource::Ini, (sources.root / "none.ini").string() } };
+		const LayeredConfig empty = LayeredConfig::Load(missing, {});
+		CHECK(empty.GetPresentSources() == 0);
+		CHECK(empty.GetSettings().empty() && empty.GetSections().empty());
+	}
+
+	void TestCache(const std::filesystem::path& root)
+	{
+		const Sources sources(root / "cache");
+		WriteFile(sources.ini, "[Main]\nfMaxDeviationAngle = 30\nsFilterMode = Angle\n");
+		WriteFile(sources.custom, "[Main]\nsFilterMode = Both\n");
+		const auto layers = sources.Layers();
+
+		// The first load parses and writes the cache, the second reads it
+		const LayeredConfig parsed = LayeredConfig::Load(layers, sources.cache);
+		CHECK(!parsed.IsFromCache());
+		CHECK(std::filesystem::exists(sources.cache));
+		const LayeredConfig cached = LayeredConfig::Load(layers, sources.cache);
+		CHECK(cached.IsFromCache());
+		CHECK(cached.GetPresentSources() == parsed.GetPresentSources());
+		CHECK(cached.GetSections() == parsed.GetSections());
+		CHECK(cached.GetSettings().size() == parsed.GetSettings().size());
+		CHECK(HasSetting(cached, "Main", "fMaxDeviationAngle", "30", ConfigSource::Ini));
+		CHECK(HasSetting(cached, "Main", "sFilterMode", "Both", ConfigSource::Override));
+
+		// A cache that no longer matches its file is parsed again, and rewritten
+		auto checkRejected = [&](std::string_view what, std::string_view expectedMode) {
+			const LayeredConfig reloaded = LayeredConfig::Load(layers, sources.cache);
+			CHECK(!reloaded.IsFromCache());
+			CHECK(HasSetting(reloaded, "Main", "sFilterMode", expectedMode, ConfigSource::Override));
+			const LayeredConfig rewritten = LayeredConfig::Load(layers, sources.cache);
+			CHECK(rewritten.IsFromCache());
+			CHECK(HasSetting(rewritten, "Main", "sFilterMode", expectedMode, ConfigSource::Override));
+			std::printf("  %s: rejected\n", std::string(what).c_str());
+		};
+
+		// Stale fingerprint: a source changed size (and write time) after caching
+		WriteFile(sources.custom, "[Main]\nsFilterMode = Distance\n");
+		checkRejected("stale fingerprint (source written)", "Distance");
+
+		// A source that appeared after caching
+		WriteFile(sources.mcm, "[Main]\nfMaxDeviationAngle = 60\n");
+		checkRejected("stale fingerprint (source created)", "Distance");
+		CHECK(HasSetting(LayeredConfig::Load(layers, sources.cache), "Main", "fMaxDeviationAngle", "60", ConfigSource::MCM));
+
+		const std::string valid = ReadFile(sources.cache);
+		CHECK(valid.size() > 16);
+
+		// Truncated: the checksum no longer lines up
+		WriteFile(sources.cache, std::string_view(valid).substr(0, valid.size() / 2));
+		checkRejected("truncated", "Distance");
+
+		// Too short to hold a checksum at all
+		WriteFile(sources.cache, "TYF");
+		checkRejected("shorter than the checksum", "Distance");
+
+		// A flipped byte in the body
+		std::string corrupt = valid;
+		corrupt[corrupt.size() / 2] ^= 0x20;
+		WriteFile(sources.cache, corrupt);
+		checkRejected("bad checksum", "Distance");
+
+		// A valid checksum over bytes after the last setting
+		const std::string body = valid.substr(0, valid.size() - sizeof(std::uint64_t));
+		WriteFile(sources.cache, WithChecksum(body + "extra"));
+		checkRejected("trailing bytes", "Distance");
+
+		// A valid checksum over a body cut in the middle of a setting
+		WriteFile(sources.cache, WithChecksum(body.substr(0, body.size() - 3)));
+		checkRejected("body cut short", "Distance");
+
+		// A valid checksum over another cache version
+		std::string otherVersion = body;
+		otherVersion[4] ^= 0x7F;
+		WriteFile(sources.cache, WithChecksum(otherVersion));
+		checkRejected("wrong version", "Distance");
+
+		// The unmodified cache is still accepted
+		WriteFile(sources.cache, valid);
+		CHECK(LayeredConfig::Load(layers, sources.cache).IsFromCache());
+
+		// The fingerprint follows existence, size and write time of every source
+		const std::string fingerprint = LayeredConfig::GetFingerprint(layers);
+		CHECK(LayeredConfig::GetFingerprint(layers) == fingerprint);
+		std::filesystem::remove(sources.mcm);
+		CHECK(LayeredConfig::GetFingerprint(layers) != fingerprint);
+	}
+
+	void TestOverlay(const std::filesystem::path& root)
+	{
+		const Sources sources(root / "overlay");
+		WriteFile(sources.ini, "[Main]\nfMaxDeviationAngle = 30\nsFilterMode = Angle\n[Distance]\nfMaxGreetingDistance = 150\n");
+		WriteFile(sources.custom, "[Main]\nsFilterMode = Both\n");
+		WriteFile(sources.shadow,
+			"[main]\n"
+			"sfiltermode = Frustum\n"
+			"sFilterMode = Either\n"  // The first duplicate wins here too
+			"[Shadow]\n"
+			"bEnabled = true\n");
+		const auto layers = sources.Layers();
+
+		// From a cached base, so the overlay must not claim to be cached itself
+		LayeredConfig::Load(layers, sources.cache);
+		const LayeredConfig base = LayeredConfig::Load(layers, sources.cache);
+		CHECK(base.IsFromCache());
+		const std::size_t baseSettings = base.GetSettings().size();
+
+		const ConfigLayer shadowLayer{ ConfigSource::Shadow, sources.shadow };
+		const LayeredConfig overlay = LayeredConfig::Overlay(base, shadowLayer);
+		CHECK(!overlay.IsFromCache());
+		CHECK(overlay.GetPresentSources() == (base.GetPresentSources() | Bit(ConfigSource::Shadow)));
+		CHECK(HasSetting(overlay, "Main", "sFilterMode", "Frustum", ConfigSource::Shadow));
+		CHECK(HasSetting(overlay, "Shadow", "bEnabled", "true", ConfigSource::Shadow));
+		CHECK(HasSetting(overlay, "Main", "fMaxDeviationAngle", "30", ConfigSource::Ini));
+		CHECK(HasSetting(overlay, "Distance", "fMaxGreetingDistance", "150", ConfigSource::Ini));
+		CHECK(overlay.GetSettings().size() == baseSettings + 1);
+		const std::vector<std::string> sections = { "Main", "Distance", "Shadow" };
+		CHECK(overlay.GetSections() == sections);
+
+		// The base is untouched
+		CHECK(base.GetSettings().size() == baseSettings);
+		CHECK(HasSetting(base, "Main", "sFilterMode", "Both", ConfigSource::Override));
+		CHECK(base.Find("Shadow", "bEnabled") == nullptr);
+		CHECK(!(base.GetPresentSources() & Bit(ConfigSource::Shadow)));
+
+		// The same as merging all four sources at once
+		const std::array all = { layers[0], layers[1], layers[2], shadowLayer };
+		const LayeredConfig merged = LayeredConfig::Load(all, {});
+		CHECK(merged.GetSettings().size() == overlay.GetSettings().size());
+		for (const ConfigSetting& setting : merged.GetSettings()) {
+			CHECK(HasSetting(overlay, setting.section, setting.key, setting.value, setting.source));
+		}
+
+		// A missing shadow file leaves the table as it is
+		std::filesystem::remove(sources.shadow);
+		const LayeredConfig unchanged = LayeredConfig::Overlay(base, shadowLayer);
+		CHECK(unchanged.GetPresentSources() == base.GetPresentSources());
+		CHECK(unchanged.GetSettings().size() == baseSettings);
+		CHECK(HasSetting(unchanged, "Main", "sFilterMode", "Both", ConfigSource::Override));
+	}
+}
+
+int main()
+{
+	const auto root = std::filesystem::temp_directory_path() / ("tyf-layers-" + std::to_string(test::Clock::now().time_since_epoch().count()));
+
+	TestPrecedence(root);
+	TestCache(root);
+	TestOverlay(root);
+
+	std::error_code error;
+	std::filesystem::remove_all(root, error);
+
+	return test::Finish("ConfigLayersTest");
+}
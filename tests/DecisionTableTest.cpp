@@ -0,0 +1,255 @@
+/**
+ * DecisionTableTest.cpp - LookupDecision against DecideComment
+ *
+ * bDecisionTable answers most queries from a precomputed cell and leaves
+ * cells on a decision boundary to DecideComment. Every answer it gives must
+ * be DecideComment's (outcome and distance; only the reason text differs).
+ * For every mode with tables, with and without the close range bypass, and
+ * for the mock categories plus extreme thresholds (0 and 180 degrees, a
+ * bypass radius at or beyond the greeting distance, tiny and huge ranges),
+ * queries come in five classes:
+ *   - random   anywhere within the table's range
+ *   - angle    at the configured angle plus/minus 1e-7 to 1e-2 radians
+ *   - greeting at fMaxGreetingDistance plus/minus a relative 1e-7 to 1e-2
+ *   - close    at fCloseRangeDistance plus/minus the same
+ *   - edge     on cell edges and corners in the player's frame, plus/minus
+ *              the same, where the rotation into the frame may round a
+ *              query into the neighbouring cell
+ * Prints how many queries the table answered per class (the rest fall back).
+ *
+ * Usage: DecisionTableTest [--quick]
+ */
+
+#include "MockWorld.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	struct ThresholdCase
+	{
+		float angleDegrees;
+		float greetingDistance;
+		float closeRange;
+	};
+
+	// Beyond the mock categories (MockWorld.h: 30/150/50 scaled by 1 to 2.5)
+	constexpr std::array kExtremeThresholds = {
+		ThresholdCase{ 0.0f, 150.0f, 50.0f },      // Facing never passes
+		ThresholdCase{ 180.0f, 150.0f, 50.0f },    // Facing always passes (except at the player)
+		ThresholdCase{ 90.0f, 150.0f, 0.0f },      // No bypass radius
+		ThresholdCase{ 1.0f, 150.0f, 149.0f },     // Bypass radius almost the greeting distance
+		ThresholdCase{ 30.0f, 100.0f, 400.0f },    // Bypass radius clamped to the greeting distance
+		ThresholdCase{ 45.0f, 5.0f, 2.0f },        // Tiny range
+		ThresholdCase{ 60.0f, 10000.0f, 500.0f },  // Huge range
+	};
+
+	enum QueryClass : std::size_t
+	{
+		kRandom,
+		kAngle,
+		kGreeting,
+		kClose,
+		kEdge,
+		kClassCount
+	};
+	constexpr std::array<const char*, kClassCount> kClassNames = { "random", "angle", "greeting", "close", "edge" };
+
+	struct ClassResult
+	{
+		std::size_t queries = 0;
+		std::size_t hits = 0;        // Answered by the table
+		std::size_t mismatches = 0;  // Answered differently from DecideComment
+	};
+
+	float Sign(test::Random& random)
+	{
+		return random.NextBits() & 1 ? 1.0f : -1.0f;
+	}
+
+	// 1e-7 to 1e-2, either sign
+	float Epsilon(test::Random& random)
+	{
+		return static_cast<float>(std::pow(10.0, -7.0 + 5.0 * random.Next())) * Sign(random);
+	}
+
+	/**
+	 * A query for an NPC at (forward, lateral, height) in the player's frame.
+	 */
+	CommentQuery MakeFrameQuery(float yaw, float forward, float lateral, float height)
+	{
+		const PlayerFacing facing = MakePlayerFacing(yaw, 0.0f);
+		return { forward * facing.forwardX + lateral * facing.forwardY, forward * facing.forwardY - lateral * facing.forwardX, height,
+			facing.yaw, facing.forwardX, facing.forwardY, 0.0f, 0.0f, false, false, nullptr, 0.0f, 0.0f, 0.0f };
+	}
+
+	/**
+	 * A query at `distance` from the player in a random 3D direction.
+	 */
+	CommentQuery MakeSphereQuery(float yaw, float distance, test::Random& random)
+	{
+		const float z = random.Next() * 2.0f - 1.0f;
+		const float bearing = random.Next() * 2.0f * pi;
+		const float horizontal = std::sqrt(std::max(0.0f, 1.0f - z * z));
+		return MakeFrameQuery(yaw, distance * horizontal * std::cos(bearing), distance * horizontal * std::sin(bearing), distance * z);
+	}
+
+	CommentQuery MakeClassQuery(QueryClass queryClass, const CategoryThresholds& thresholds, float range, test::Random& random)
+	{
+		const float yaw = random.Next() * 2.0f * pi;
+		const float cellSize = range / static_cast<float>(kDecisionTableSize);
+
+		switch (queryClass) {
+			case kRandom:
+				return MakeFrameQuery(yaw, (random.Next() * 2.0f - 1.0f) * range, (random.Next() * 2.0f - 1.0f) * range,
+					(random.Next() * 2.0f - 1.0f) * range);
+			case kAngle:
+				{
+					const float angle = std::acos(thresholds.cosMaxDeviation) + Epsilon(random);
+					const float distance = range * 1.1f * random.Next();
+					return MakeFrameQuery(yaw, distance * std::cos(angle), Sign(random) * distance * std::sin(angle),
+						Sign(random) * range * 0.5f * random.Next());
+				}
+			case kGreeting:
+				return MakeSphereQuery(yaw, std::sqrt(thresholds.maxGreetingDistanceSquared) * (1.0f + Epsilon(random)), random);
+			case kClose:
+				return MakeSphereQuery(yaw, std::sqrt(thresholds.closeRangeDistanceSquared) * (1.0f + Epsilon(random)), random);
+			default:
+				{
+					// A cell edge on each axis, or the cell's middle on some of them (edges, then corners)
+					auto coordinate = [&](std::uint32_t cells, float origin) {
+						const auto cell = static_cast<float>(random.NextBits() % (cells + 1));
+						const float offset = random.NextBits() & 4 ? 0.5f * cellSize : 0.0f;
+						return origin + cell * cellSize + offset + Epsilon(random) * cellSize;
+					};
+					return MakeFrameQuery(yaw, coordinate(2 * kDecisionTableSize, -range), Sign(random) * coordinate(kDecisionTableSize, 0.0f),
+						Sign(random) * coordinate(kDecisionTableSize, 0.0f));
+				}
+		}
+	}
+
+	/**
+	 * Decides `count` queries of each class with the table and exactly.
+	 */
+	void CheckTable(const FilterParameters& filter, const CategoryThresholds& thresholds, std::size_t count, test::Random& random,
+		std::array<ClassResult, kClassCount>& results)
+	{
+		DecisionTable table;
+		BuildDecisionTable(filter, thresholds, table);
+		CHECK(table.range > 0.0f);
+
+		for (std::size_t c = 0; c < kClassCount; ++c) {
+			ClassResult& result = results[c];
+			for (std::size_t i = 0; i < count; ++i) {
+				const CommentQuery query = MakeClassQuery(static_cast<QueryClass>(c), thresholds, table.range, random);
+				++result.queries;
+
+				CommentDecision decision;
+				if (!LookupDecision(table, query, decision)) {
+					continue;
+				}
+				++result.hits;
+
+				const CommentDecision expected = DecideComment(filter, thresholds, query);
+				if (decision.allow != expected.allow || decision.outcome != expected.outcome ||
+					decision.distanceSquared != expected.distanceSquared) {
+					if (result.mismatches++ < 5) {
+						std::printf("  %s: dx=%.9g dy=%.9g dz=%.9g yaw=%.9g -> table %s (%d), exact %s (%d)\n", kClassNames[c],
+							query.dx, query.dy, query.dz, query.yaw, decision.reason, static_cast<int>(decision.outcome),
+							expected.reason, static_cast<int>(expected.outcome));
+					}
+				}
+			}
+		}
+	}
+
+	void TestModes(std::size_t count)
+	{
+		constexpr std::array modes = {
+			std::pair{ FilterMode::AngleOnly, "Angle" },
+			std::pair{ FilterMode::DistanceOnly, "Distance" },
+			std::pair{ FilterMode::Both, "Both" },
+			std::pair{ FilterMode::Either, "Either" }
+		};
+
+		std::printf("%-16s %-10s %10s %8s %10s\n", "mode", "class", "queries", "hits", "mismatches");
+		std::size_t mismatches = 0;
+		for (const auto& [mode, name] : modes) {
+			CHECK(SupportsDecisionTable(mode));
+			for (const bool bypass : { true, false }) {
+				auto filter = mock::MakeFilter(mode, false);
+				FilterParameters& params = filter->params;
+				params.Set(FilterFlag::CloseRangeBypass, bypass);
+
+				// The mock categories, with this bypass setting, then the extremes
+				std::vector<CategoryThresholds> thresholds;
+				for (std::size_t i = 0; i < kMaxActorCategories; ++i) {
+					const float scale = 1.0f + 0.5f * static_cast<float>(i % 4);
+					thresholds.push_back(MakeCategoryThresholds(params, mock::kDefaultAngleDegrees * scale * pi / 180.0f,
+						mock::kDefaultGreetingDistance * scale, mock::kDefaultCloseRange * scale));
+				}
+				for (const ThresholdCase& c : kExtremeThresholds) {
+					thresholds.push_back(MakeCategoryThresholds(params, c.angleDegrees * pi / 180.0f, c.greetingDistance, c.closeRange));
+				}
+
+				test::Random random{ 0xDEC15100u + static_cast<std::uint32_t>(mode) * 2 + (bypass ? 1 : 0) };
+				std::array<ClassResult, kClassCount> results{};
+				for (const CategoryThresholds& category : thresholds) {
+					CheckTable(params, category, count, random, results);
+				}
+
+				for (std::size_t c = 0; c < kClassCount; ++c) {
+					const ClassResult& result = results[c];
+					std::printf("%-9s %-6s %-10s %10zu %7.1f%% %10zu\n", name, bypass ? "bypass" : "", kClassNames[c], result.queries,
+						100.0 * static_cast<double>(result.hits) / static_cast<double>(result.queries), result.mismatches);
+					mismatches += result.mismatches;
+					CHECK(result.mismatches == 0);
+				}
+
+				// Most queries away from a boundary are answered by the table
+				CHECK(results[kRandom].hits * 5 >= results[kRandom].queries * 4);
+				CHECK(results[kEdge].hits > 0);
+			}
+		}
+		std::printf("  %zu table answers differed from DecideComment\n", mismatches);
+	}
+
+	void TestEmptyTables()
+	{
+		// Modes without tables, and a zero greeting distance, get an empty table: every query falls back
+		auto filter = mock::MakeFilter(FilterMode::Expression, false);
+		DecisionTable table;
+		CHECK(BuildDecisionTable(filter->params, filter->params.categories[0], table) == kDecisionTableCells);
+		CHECK(table.range == 0.0f);
+
+		auto angle = mock::MakeFilter(FilterMode::AngleOnly, false);
+		const CategoryThresholds zero = MakeCategoryThresholds(angle->params, 0.5f, 0.0f, 0.0f);
+		CHECK(BuildDecisionTable(angle->params, zero, table) == kDecisionTableCells);
+
+		CommentDecision decision;
+		CHECK(!LookupDecision(table, MakeFrameQuery(0.0f, 10.0f, 0.0f, 0.0f), decision));
+		CHECK(!LookupDecision(table, MakeFrameQuery(0.0f, 0.0f, 0.0f, 0.0f), decision));
+
+		// NaN input never hits
+		BuildDecisionTable(angle->params, angle->params.categories[0], table);
+		CommentQuery nan = MakeFrameQuery(0.0f, 10.0f, 0.0f, 0.0f);
+		nan.dx = std::numeric_limits<float>::quiet_NaN();
+		CHECK(!LookupDecision(table, nan, decision));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = test::IsQuick(argc, argv);
+
+	TestModes(quick ? 2'000 : 100'000);
+	TestEmptyTables();
+
+	return test::Finish("DecisionTableTest");
+}
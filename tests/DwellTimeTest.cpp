@@ -0,0 +1,158 @@
+/**
+ * DwellTimeTest.cpp - DwellTracker against a synthetic clock
+ *
+ * Drives the gaze dwell table the way AllowComment does - Facing() for a
+ * check the filter allowed, NotFacing() for one it blocked - with scripted
+ * timestamps:
+ *   - an NPC may comment once it has passed for fDwellTime, not before
+ *   - a failed check, or more than kDwellGapTicks between checks, starts over
+ *   - repeated checks within one tick, saturation at kMaxDwellMilliseconds
+ *   - an NPC faced again one timestamp wrap (~70 min) after its last check
+ *     starts a new dwell instead of continuing the old one
+ *   - actors sharing a probe sequence, and reuse of expired slots
+ *
+ * Usage: DwellTimeTest
+ */
+
+#include "DwellTime.h"
+#include "TestSupport.h"
+
+#include <memory>
+#include <vector>
+
+namespace
+{
+	constexpr std::uint64_t kGapMilliseconds = kDwellGapTicks * kDwellTickMilliseconds;
+
+	// Timestamp range of an entry: 2^20 ticks
+	constexpr std::uint64_t kWrapMilliseconds = (1ull << 20) * kDwellTickMilliseconds;
+
+	/**
+	 * Checks every `step` ms from `start` until the actor may comment.
+	 *
+	 * @return Time of the first check that passed, relative to start (or ~0 if none within `limit`)
+	 */
+	std::uint64_t TimeToComment(DwellTracker& tracker, std::uint32_t actorID, std::uint64_t start, std::uint64_t step,
+		std::uint32_t dwellMilliseconds, std::uint64_t limit = 60'000)
+	{
+		for (std::uint64_t t = 0; t <= limit; t += step) {
+			if (tracker.Facing(actorID, start + t, dwellMilliseconds)) {
+				return t;
+			}
+		}
+		return ~0ull;
+	}
+
+	void TestDwell()
+	{
+		auto tracker = std::make_unique<DwellTracker>();
+		const std::uint64_t start = 1'000'000;
+
+		// No dwell time: the first check passes
+		CHECK(tracker->Facing(0x10, start, 0));
+
+		// Checks every 100 ms: 500 ms of dwell after 500 ms, not before
+		CHECK(TimeToComment(*tracker, 0x11, start, 100, 500) == 500);
+		CHECK(tracker->Facing(0x11, start + 600, 500));  // And from then on
+
+		// Checks further apart than the gap never accumulate
+		CHECK(TimeToComment(*tracker, 0x12, start, kGapMilliseconds + 100, 500, 20'000) == ~0ull);
+
+		// Exactly the gap still continues
+		CHECK(TimeToComment(*tracker, 0x13, start, kGapMilliseconds, 2 * kGapMilliseconds) == 2 * kGapMilliseconds);
+
+		// Repeat checks within one tick change nothing
+		auto repeat = std::make_unique<DwellTracker>();
+		repeat->Facing(0x14, start, 8);
+		for (int i = 0; i < 100; ++i) {
+			CHECK(!repeat->Facing(0x14, start + 1, 8));
+		}
+		CHECK(repeat->Facing(0x14, start + 2 * kDwellTickMilliseconds, 8));
+
+		// The longest allowed dwell is reached (the counter saturates above it)
+		CHECK(TimeToComment(*tracker, 0x15, start, 500, kMaxDwellMilliseconds) == kMaxDwellMilliseconds);
+		CHECK(tracker->Facing(0x15, start + kMaxDwellMilliseconds + 60'000, kMaxDwellMilliseconds) == false);  // After a gap: over
+	}
+
+	void TestReset()
+	{
+		auto tracker = std::make_unique<DwellTracker>();
+		const std::uint64_t start = 2'000'000;
+
+		// A failed check in the middle starts the dwell over
+		CHECK(TimeToComment(*tracker, 0x20, start, 100, 300) == 300);
+		tracker->NotFacing(0x20, start + 400);
+		CHECK(!tracker->Facing(0x20, start + 500, 300));
+		CHECK(TimeToComment(*tracker, 0x20, start + 600, 100, 300) == 200);
+
+		// NotFacing for an actor never seen does nothing
+		tracker->NotFacing(0x21, start);
+		CHECK(!tracker->Facing(0x21, start + 100, 300));
+
+		// Clear() forgets every dwell
+		CHECK(TimeToComment(*tracker, 0x22, start, 100, 300) == 300);
+		tracker->Clear();
+		CHECK(!tracker->Facing(0x22, start + 400, 300));
+	}
+
+	void TestTimestampWrap()
+	{
+		// An actor faced for a while, then faced again one wrap (and up to the
+		// gap) later: a new dwell, whatever the period the first check fell in
+		std::size_t continued = 0;
+		std::size_t cases = 0;
+		for (const std::uint64_t start : { std::uint64_t{ 4'000 }, kWrapMilliseconds / 2, kWrapMilliseconds - 2'000, 5 * kWrapMilliseconds + 777 }) {
+			for (const std::uint64_t extra : { std::uint64_t{ 0 }, std::uint64_t{ 400 }, kGapMilliseconds }) {
+				auto tracker = std::make_unique<DwellTracker>();
+				TimeToComment(*tracker, 0x30, start, 100, 1000);
+				continued += tracker->Facing(0x30, start + 1000 + kWrapMilliseconds + extra, 1000) ? 1 : 0;
+				++cases;
+			}
+		}
+		CHECK(continued == 0);
+
+		// Across a period change the dwell still builds up normally
+		auto tracker = std::make_unique<DwellTracker>();
+		CHECK(TimeToComment(*tracker, 0x31, kWrapMilliseconds + 50, 100, 500) == 500);
+		std::printf("  faced again one wrap (%.0f min) later: %zu of %zu continued the old dwell\n",
+			static_cast<double>(kWrapMilliseconds) / 60'000.0, continued, cases);
+	}
+
+	void TestProbeSequence()
+	{
+		// Actors whose hash lands on the same slot
+		std::vector<std::uint32_t> colliding;
+		const std::uint32_t target = (0x2000u * 0x9E3779B1u) >> 20;
+		for (std::uint32_t id = 0x2000; colliding.size() < DwellTracker::kMaxProbe + 1; ++id) {
+			if (((id * 0x9E3779B1u) >> 20) == target) {
+				colliding.push_back(id);
+			}
+		}
+
+		auto tracker = std::make_unique<DwellTracker>();
+		const std::uint64_t start = 3'000'000;
+		for (const std::uint32_t id : colliding) {
+			tracker->Facing(id, start, 200);
+		}
+		std::size_t dwelled = 0;
+		for (const std::uint32_t id : colliding) {
+			dwelled += tracker->Facing(id, start + 200, 200) ? 1 : 0;
+		}
+		CHECK(dwelled == DwellTracker::kMaxProbe);  // The last one found no slot and never dwells
+
+		// Once the others' entries expire, it gets a slot
+		const std::uint64_t later = start + 200 + kGapMilliseconds + 100;
+		CHECK(!tracker->Facing(colliding.back(), later, 200));
+		CHECK(tracker->Facing(colliding.back(), later + 200, 200));
+	}
+}
+
+int main()
+{
+	TestDwell();
+	TestReset();
+	TestTimestampWrap();
+	TestProbeSequence();
+
+	return test::Finish("DwellTimeTest");
+}
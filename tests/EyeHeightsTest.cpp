@@ -0,0 +1,219 @@
+/**
+ * EyeHeightsTest.cpp - RaceEyeHeights against a counting race lookup
+ *
+ * The race lookup is a callable that counts its calls, so every check can
+ * tell a cache hit from a miss:
+ *   - a hit returns the male or female height encoded on the miss, and never
+ *     asks the race again
+ *   - heights are stored in 1/8 game units, rounded to the nearest step and
+ *     clamped to 0-8191.875
+ *   - races sharing a probe window: the first kMaxProbe are cached, the next
+ *     one is answered uncached (and correctly) on every call
+ *   - threads using one race for the first time at the same moment all get
+ *     its heights, and leave it cached
+ * Then times a hit (b3DViewCone reads two per query).
+ *
+ * Usage: EyeHeightsTest [--quick]
+ */
+
+#include "EyeHeights.h"
+#include "TestSupport.h"
+
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	/**
+	 * Race record stand-in: answers `heights` and counts its calls.
+	 */
+	struct MockRace
+	{
+		RaceEyeHeight heights{ kBaseEyeHeight, kBaseEyeHeight };
+		std::size_t calls = 0;
+
+		auto operator()()
+		{
+			return [this] {
+				++calls;
+				return heights;
+			};
+		}
+	};
+
+	void TestHit()
+	{
+		auto cache = std::make_unique<RaceEyeHeights>();
+		MockRace race{ { 123.0f, 114.5f } };
+
+		CHECK(cache->Get(0x13746, false, race()) == 123.0f);  // Miss: computed and cached
+		CHECK(race.calls == 1);
+		CHECK(cache->Get(0x13746, false, race()) == 123.0f);
+		CHECK(cache->Get(0x13746, true, race()) == 114.5f);  // The other sex comes from the same entry
+		CHECK(race.calls == 1);
+
+		// Another race has its own entry; the first one stays cached
+		MockRace other{ { 156.0f, 150.0f } };
+		CHECK(cache->Get(0x13740, true, other()) == 150.0f);
+		CHECK(cache->Get(0x13746, false, race()) == 123.0f);
+		CHECK(cache->Get(0x13740, false, other()) == 156.0f);
+		CHECK(race.calls == 1 && other.calls == 1);
+	}
+
+	void TestRounding()
+	{
+		auto cache = std::make_unique<RaceEyeHeights>();
+		constexpr float kStep = 0.125f;
+
+		struct Case
+		{
+			float height;
+			float expected;
+		};
+		constexpr Case cases[] = {
+			{ 120.0f, 120.0f },
+			{ 120.125f, 120.125f },      // Whole steps are exact
+			{ 120.06f, 120.0f },         // Below half a step: down
+			{ 120.07f, 120.125f },       // Above half a step: up
+			{ 120.1f, 120.125f },
+			{ 0.05f, 0.0f },
+			{ -10.0f, 0.0f },            // Clamped at 0
+			{ 8191.875f, 8191.875f },    // Largest encodable height
+			{ 20000.0f, 8191.875f },     // Clamped at 65535 steps
+		};
+
+		std::uint32_t raceID = 0x1000;
+		for (const Case& c : cases) {
+			MockRace race{ { c.height, c.height } };
+			CHECK(cache->Get(++raceID, false, race()) == c.expected);  // The miss returns the stored value
+			CHECK(cache->Get(raceID, true, race()) == c.expected);     // and a hit the same
+			CHECK(race.calls == 1);
+		}
+
+		// Every in-range height is stored within half a step
+		test::Random random;
+		float largestError = 0.0f;
+		for (std::uint32_t i = 0; i < 10'000; ++i) {
+			if (i % 64 == 0) {
+				cache = std::make_unique<RaceEyeHeights>();
+			}
+			const float height = random.Next() * 300.0f;
+			MockRace race{ { height, height } };
+			cache->Get(0x2000 + i, false, race());
+			largestError = std::max(largestError, std::abs(cache->Get(0x2000 + i, true, race()) - height));
+			CHECK(race.calls == 1);
+		}
+		CHECK(largestError <= kStep / 2);
+	}
+
+	void TestProbeWindow()
+	{
+		// Races whose hash lands on the same slot (the cache's hash: Fibonacci, top 8 bits)
+		std::vector<std::uint32_t> colliding;
+		const std::uint32_t target = (0x3000u * 0x9E3779B1u) >> 24;
+		for (std::uint32_t id = 0x3000; colliding.size() < RaceEyeHeights::kMaxProbe + 2; ++id) {
+			if (((id * 0x9E3779B1u) >> 24) == target) {
+				colliding.push_back(id);
+			}
+		}
+
+		auto cache = std::make_unique<RaceEyeHeights>();
+		std::vector<MockRace> races(colliding.size());
+		for (std::size_t i = 0; i < colliding.size(); ++i) {
+			races[i].heights = { 100.0f + static_cast<float>(i), 90.0f + static_cast<float>(i) };
+			CHECK(cache->Get(colliding[i], false, races[i]()) == races[i].heights.male);
+		}
+
+		// The window holds kMaxProbe races; the rest are correct, but computed on every call
+		for (int round = 0; round < 3; ++round) {
+			for (std::size_t i = 0; i < colliding.size(); ++i) {
+				CHECK(cache->Get(colliding[i], true, races[i]()) == races[i].heights.female);
+			}
+		}
+		for (std::size_t i = 0; i < colliding.size(); ++i) {
+			CHECK(races[i].calls == (i < RaceEyeHeights::kMaxProbe ? 1u : 4u));
+		}
+	}
+
+	void TestConcurrentFirstUse(std::size_t rounds, std::size_t threadCount)
+	{
+		std::size_t wrong = 0;
+		std::size_t recomputed = 0;
+
+		for (std::size_t round = 0; round < rounds; ++round) {
+			auto cache = std::make_unique<RaceEyeHeights>();
+			const auto raceID = static_cast<std::uint32_t>(0x4000 + round);
+			const RaceEyeHeight heights{ 130.0f + static_cast<float>(round % 8), 125.0f };
+
+			std::atomic<std::size_t> ready{ 0 };
+			std::atomic<std::size_t> computed{ 0 };
+			std::atomic<std::size_t> mismatches{ 0 };
+			std::vector<std::thread> threads;
+			for (std::size_t t = 0; t < threadCount; ++t) {
+				threads.emplace_back([&, t] {
+					ready.fetch_add(1);
+					while (ready.load() < threadCount) {
+					}
+					const bool female = t & 1;
+					const float height = cache->Get(raceID, female, [&] {
+						computed.fetch_add(1, std::memory_order_relaxed);
+						return heights;
+					});
+					if (height != (female ? heights.female : heights.male)) {
+						mismatches.fetch_add(1);
+					}
+				});
+			}
+			for (auto& thread : threads) {
+				thread.join();
+			}
+			wrong += mismatches.load();
+
+			// Whoever won, the race is cached now
+			MockRace after{ heights };
+			CHECK(cache->Get(raceID, false, after()) == heights.male);
+			CHECK(cache->Get(raceID, true, after()) == heights.female);
+			recomputed += after.calls;
+			CHECK(computed.load() >= 1 && computed.load() <= threadCount);
+		}
+
+		CHECK(wrong == 0);
+		CHECK(recomputed == 0);
+		std::printf("  %zu threads, %zu races used for the first time together: %zu wrong heights, %zu left uncached\n",
+			threadCount, rounds, wrong, recomputed);
+	}
+
+	void BenchmarkHit(std::size_t calls)
+	{
+		auto cache = std::make_unique<RaceEyeHeights>();
+		constexpr std::uint32_t kRaces[] = { 0x13740, 0x13741, 0x13742, 0x13743, 0x13744, 0x13745, 0x13746, 0x13747 };
+		for (const std::uint32_t race : kRaces) {
+			cache->Get(race, false, [] { return RaceEyeHeight{ 120.0f, 115.0f }; });
+		}
+
+		float total = 0.0f;
+		const auto start = test::Clock::now();
+		for (std::size_t i = 0; i < calls; ++i) {
+			total += cache->Get(kRaces[i & 7], i & 8, [] { return RaceEyeHeight{ 0.0f, 0.0f }; });
+		}
+		const double elapsed = test::ElapsedNanoseconds(start);
+		test::Consume(static_cast<std::uint64_t>(total));
+		std::printf("  hit: %.2f ns per lookup\n", elapsed / static_cast<double>(calls));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = test::IsQuick(argc, argv);
+
+	TestHit();
+	TestRounding();
+	TestProbeWindow();
+	TestConcurrentFirstUse(quick ? 200 : 5'000, 4);
+	BenchmarkHit(quick ? 1'000'000 : 100'000'000);
+
+	return test::Finish("EyeHeightsTest");
+}
@@ -0,0 +1,244 @@
+/**
+ * FileWatcherTest.cpp - Config watcher: debouncing and the platform layer
+ *
+ * ReloadDebouncer runs on a synthetic clock:
+ *   - bursts of changes to any config file (INI, MCM, _custom, shadow) reload
+ *     once, after the quiet period following the last change, and report
+ *     every file that changed
+ *   - other files, and config file names in the wrong directory, are ignored
+ *   - overflows, lost and newly appeared directories mark their files
+ * The FileWatcher backend (inotify here; ReadDirectoryChangesW in the game)
+ * runs against a temporary directory tree:
+ *   - writes, editor-style "write temp + rename" saves and deletes are reported
+ *   - a missing directory cannot be watched until it is created
+ *   - deleting a watched directory is reported as lost
+ *   - a save burst driven through watcher + debouncer reloads exactly once
+ *
+ * Usage: FileWatcherTest
+ */
+
+#include "FileWatcher.h"
+#include "ReloadDebouncer.h"
+#include "TestSupport.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+	using Clock = ReloadDebouncer::Clock;
+	using namespace std::chrono_literals;
+
+	constexpr auto kQuiet = 250ms;
+
+	constexpr std::array<std::string_view, 4> kGameFiles = {
+		"Data\\SKSE\\Plugins\\to-your-face-reloaded.ini",
+		"Data\\MCM\\Settings\\to-your-face-reloaded.ini",
+		"Data\\SKSE\\Plugins\\to-your-face-reloaded_custom.ini",
+		"Data\\SKSE\\Plugins\\to-your-face-reloaded_shadow.ini"
+	};
+	constexpr std::string_view kPluginDirectory = "Data\\SKSE\\Plugins";
+	constexpr std::string_view kMCMDirectory = "Data\\MCM\\Settings";
+
+	FileChange Modified(std::string_view directory, std::string_view name)
+	{
+		return { FileChangeKind::Modified, std::string(directory), std::string(name) };
+	}
+
+	void TestDebouncer()
+	{
+		const Clock::time_point t0{};
+		ReloadDebouncer debouncer(kGameFiles, kQuiet);
+
+		CHECK(debouncer.GetDirectories().size() == 2);
+		CHECK(debouncer.GetDirectories()[0] == kPluginDirectory);
+		CHECK(debouncer.GetDirectories()[1] == kMCMDirectory);
+		CHECK(!debouncer.GetDeadline());
+		CHECK(debouncer.TakeDue(t0 + 1h) == 0);
+
+		// A save burst across the MCM file and the _custom override: one reload, both reported
+		CHECK(debouncer.OnChange(Modified(kMCMDirectory, "to-your-face-reloaded.ini"), t0));
+		CHECK(debouncer.OnChange(Modified(kPluginDirectory, "TO-YOUR-FACE-RELOADED_CUSTOM.INI"), t0 + 100ms));
+		CHECK(!debouncer.OnChange(Modified(kPluginDirectory, "to-your-face-reloaded.ini.tmp"), t0 + 150ms));
+		CHECK(debouncer.OnChange(Modified(kMCMDirectory, "to-your-face-reloaded.ini"), t0 + 200ms));
+		CHECK(debouncer.GetDeadline() == t0 + 200ms + kQuiet);
+		CHECK(debouncer.TakeDue(t0 + 400ms) == 0);  // Quiet period restarted by the last change
+		CHECK(debouncer.TakeDue(t0 + 450ms) == 0b0110);
+		CHECK(debouncer.TakeDue(t0 + 1s) == 0);     // Taken
+		CHECK(!debouncer.GetDeadline());
+
+		// The INI's name in the MCM directory is the MCM file, not the INI; the
+		// shadow file's name in the MCM directory is nothing
+		CHECK(debouncer.OnChange(Modified(kMCMDirectory, "to-your-face-reloaded_shadow.ini"), t0) == false);
+		CHECK(!debouncer.GetDeadline());
+		CHECK(debouncer.OnChange(Modified(kPluginDirectory, "to-your-face-reloaded_shadow.ini"), t0));
+		CHECK(debouncer.TakeDue(t0 + kQuiet) == 0b1000);
+
+		// Unrelated directories and files never schedule a reload
+		CHECK(!debouncer.OnChange(Modified("Data\\SKSE", "to-your-face-reloaded.ini"), t0));
+		CHECK(!debouncer.OnChange({ FileChangeKind::Overflow, "Data\\Textures", {} }, t0));
+		CHECK(!debouncer.GetDeadline());
+
+		// An overflow or a lost directory marks all of its files
+		CHECK(debouncer.OnChange({ FileChangeKind::Overflow, std::string(kPluginDirectory), {} }, t0));
+		CHECK(debouncer.TakeDue(t0 + kQuiet) == 0b1101);
+		CHECK(debouncer.OnChange({ FileChangeKind::DirectoryLost, std::string(kMCMDirectory), {} }, t0));
+		CHECK(debouncer.TakeDue(t0 + kQuiet) == 0b0010);
+
+		// MCM Helper creating its settings directory later
+		debouncer.OnDirectoryAppeared(kMCMDirectory, t0);
+		CHECK(debouncer.TakeDue(t0 + kQuiet) == 0b0010);
+	}
+
+	void WriteFile(const std::filesystem::path& path, std::string_view text)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file << text;
+	}
+
+	/**
+	 * Collects changes until nothing arrives for a short while.
+	 */
+	std::vector<FileChange> Drain(FileWatcher& watcher)
+	{
+		std::vector<FileChange> changes;
+		std::string error;
+		while (watcher.Wait(50ms, changes, error) == FileWatchResult::Changes) {
+		}
+		return changes;
+	}
+
+	bool Contains(const std::vector<FileChange>& changes, FileChangeKind kind, std::string_view name)
+	{
+		return std::any_of(changes.begin(), changes.end(), [&](const FileChange& change) {
+			return change.kind == kind && change.name == name;
+		});
+	}
+
+	void TestWatcher(const std::filesystem::path& root)
+	{
+		auto watcher = CreateFileWatcher();
+		if (!watcher) {
+			std::printf("  no FileWatcher backend on this platform - watcher tests skipped\n");
+			return;
+		}
+
+		const auto plugins = root / "Plugins";
+		const auto settings = root / "MCM" / "Settings";
+		std::filesystem::create_directories(plugins);
+
+		std::string error;
+		CHECK(watcher->Watch(plugins.string(), error));
+		CHECK(!watcher->Watch(settings.string(), error));  // Does not exist yet
+		CHECK(!error.empty());
+
+		std::vector<FileChange> changes;
+		CHECK(watcher->Wait(20ms, changes, error) == FileWatchResult::Timeout);
+
+		// Plain write
+		WriteFile(plugins / "to-your-face-reloaded.ini", "[Main]\nfMaxDeviationAngle = 30\n");
+		changes = Drain(*watcher);
+		CHECK(Contains(changes, FileChangeKind::Modified, "to-your-face-reloaded.ini"));
+		CHECK(!changes.empty() && changes[0].directory == plugins.string());
+
+		// Editor save: write a temp file, rename it over the original
+		WriteFile(plugins / "to-your-face-reloaded.ini.tmp", "[Main]\nfMaxDeviationAngle = 45\n");
+		std::filesystem::rename(plugins / "to-your-face-reloaded.ini.tmp", plugins / "to-your-face-reloaded.ini");
+		changes = Drain(*watcher);
+		CHECK(Contains(changes, FileChangeKind::Modified, "to-your-face-reloaded.ini.tmp"));
+		CHECK(Contains(changes, FileChangeKind::Modified, "to-your-face-reloaded.ini"));
+
+		// Delete
+		std::filesystem::remove(plugins / "to-your-face-reloaded.ini");
+		changes = Drain(*watcher);
+		CHECK(Contains(changes, FileChangeKind::Modified, "to-your-face-reloaded.ini"));
+
+		// The missing directory appears and can be watched
+		std::filesystem::create_directories(settings);
+		CHECK(watcher->Watch(settings.string(), error));
+		WriteFile(settings / "to-your-face-reloaded.ini", "[Main]\n");
+		changes = Drain(*watcher);
+		CHECK(Contains(changes, FileChangeKind::Modified, "to-your-face-reloaded.ini"));
+		CHECK(!changes.empty() && changes[0].directory == settings.string());
+
+		// Deleting a watched directory
+		std::filesystem::remove_all(root / "MCM");
+		changes = Drain(*watcher);
+		CHECK(std::any_of(changes.begin(), changes.end(), [&](const FileChange& change) {
+			return change.kind == FileChangeKind::DirectoryLost && change.directory == settings.string();
+		}));
+	}
+
+	void TestSaveBurst(const std::filesystem::path& root)
+	{
+		auto watcher = CreateFileWatcher();
+		if (!watcher) {
+			return;
+		}
+
+		const auto plugins = root / "Burst";
+		std::filesystem::create_directories(plugins);
+		const std::string ini = (plugins / "to-your-face-reloaded.ini").string();
+		const std::string custom = (plugins / "to-your-face-reloaded_custom.ini").string();
+		const std::array<std::string_view, 2> files = { ini, custom };
+
+		constexpr auto quiet = 150ms;
+		ReloadDebouncer debouncer(files, quiet);
+		std::string error;
+		CHECK(watcher->Watch(debouncer.GetDirectories()[0], error));
+
+		// Writer: three quick saves of the INI and one of the override, then silence
+		std::thread writer([&] {
+			for (int i = 0; i < 3; ++i) {
+				WriteFile(plugins / "to-your-face-reloaded.ini.tmp", "[Main]\nfMaxDeviationAngle = " + std::to_string(30 + i) + "\n");
+				std::filesystem::rename(plugins / "to-your-face-reloaded.ini.tmp", ini);
+				std::this_thread::sleep_for(10ms);
+			}
+			WriteFile(custom, "[Main]\nsFilterMode = Both\n");
+		});
+
+		// The watcher loop of ConfigWatcher.cpp, without the game
+		std::vector<std::uint32_t> reloads;
+		const auto stopAt = Clock::now() + 1500ms;
+		while (Clock::now() < stopAt) {
+			auto timeout = 100ms;
+			if (const auto deadline = debouncer.GetDeadline()) {
+				timeout = std::clamp(std::chrono::ceil<std::chrono::milliseconds>(*deadline - Clock::now()), 0ms, 100ms);
+			}
+			std::vector<FileChange> changes;
+			if (watcher->Wait(timeout, changes, error) == FileWatchResult::Failed) {
+				CHECK(false);
+				break;
+			}
+			for (const auto& change : changes) {
+				debouncer.OnChange(change, Clock::now());
+			}
+			if (const std::uint32_t changed = debouncer.TakeDue(Clock::now())) {
+				reloads.push_back(changed);
+			}
+		}
+		writer.join();
+
+		CHECK(reloads.size() == 1);
+		CHECK(!reloads.empty() && reloads[0] == 0b11);
+		std::printf("  save burst (3 renames + 1 write): %zu reload(s)\n", reloads.size());
+	}
+}
+
+int main()
+{
+	TestDebouncer();
+
+	const auto root = std::filesystem::temp_directory_path() / ("tyf-watcher-" + std::to_string(Clock::now().time_since_epoch().count()));
+	TestWatcher(root);
+	TestSaveBurst(root);
+	std::error_code error;
+	std::filesystem::remove_all(root, error);
+
+	return test::Finish("FileWatcherTest");
+}
@@ -0,0 +1,343 @@
+/**
+ * FilterExpressionTest.cpp - sFilterExpression parser limits and differential tests
+ *
+ * Random expressions are generated together with an independent evaluator
+ * (a plain tree walk with C++ float semantics) and run on random inputs,
+ * including NaN, infinities and signed zeros:
+ *   - the bytecode interpreter must agree with the tree walk
+ *   - with Xbyak (TYF_TEST_JIT), the native code must agree with the interpreter
+ * Also checks that nesting and length limits are parse errors rather than
+ * stack overflows, and a few error messages.
+ */
+
+#include "FilterExpression.h"
+#include "TestSupport.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr std::size_t kExpressions = 3000;
+	constexpr std::size_t kInputsPerExpression = 200;
+	constexpr std::size_t kConstantsPerExpression = 4;
+
+	constexpr const char* kNumberVariables[] = { "dist", "angle", "height" };
+	constexpr const char* kBoolVariables[] = { "inCombat", "sneaking" };
+
+	/**
+	 * Reference tree: evaluates exactly what the source text means.
+	 */
+	struct RefNode
+	{
+		enum class Kind
+		{
+			Literal,   // true / false
+			BoolVar,   // values[index] != 0
+			Compare,   // operand <op> operand
+			Not,
+			And,
+			Or
+		} kind;
+
+		bool literal = false;
+		std::size_t index = 0;
+		int compare = 0;  // 0 <, 1 <=, 2 >, 3 >=, 4 ==, 5 !=
+		bool lhsIsVar = false, rhsIsVar = false;
+		std::size_t lhsIndex = 0, rhsIndex = 0;
+		float lhsConst = 0.0f, rhsConst = 0.0f;
+		std::unique_ptr<RefNode> a;
+		std::unique_ptr<RefNode> b;
+
+		bool Eval(const float* values) const
+		{
+			switch (kind) {
+				case Kind::Literal:
+					return literal;
+				case Kind::BoolVar:
+					return values[index] != 0.0f;
+				case Kind::Compare:
+				{
+					const float l = lhsIsVar ? values[lhsIndex] : lhsConst;
+					const float r = rhsIsVar ? values[rhsIndex] : rhsConst;
+					switch (compare) {
+						case 0: return l < r;
+						case 1: return l <= r;
+						case 2: return l > r;
+						case 3: return l >= r;
+						case 4: return l == r;
+						default: return l != r;
+					}
+				}
+				case Kind::Not:
+					return !a->Eval(values);
+				case Kind::And:
+					return a->Eval(values) && b->Eval(values);
+				case Kind::Or:
+					return a->Eval(values) || b->Eval(values);
+			}
+			return false;
+		}
+	};
+
+	// Input slot of each variable name (FilterVariable order)
+	constexpr std::size_t kNumberSlots[] = { 0, 1, 2 };
+	constexpr std::size_t kBoolSlots[] = { 3, 4 };
+
+	class Generator
+	{
+	public:
+		explicit Generator(test::Random& random) : random(random) {}
+
+		std::unique_ptr<RefNode> Make(std::string& source, std::vector<float>& constants, int depth)
+		{
+			this->constants = &constants;
+			return MakeNode(source, depth);
+		}
+
+	private:
+		std::uint32_t Pick(std::uint32_t count) { return random.NextBits() % count; }
+
+		float MakeConstant()
+		{
+			// Whole numbers compare equal to inputs more often; no sign (the grammar has no unary minus)
+			const float value = Pick(2) ? static_cast<float>(Pick(200)) : random.Next() * 500.0f;
+			constants->push_back(value);
+			return value;
+		}
+
+		void AppendConstant(std::string& source, float value)
+		{
+			char buffer[64];
+			const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed);
+			source.append(buffer, result.ptr);
+		}
+
+		void AppendOperand(std::string& source, bool& isVar, std::size_t& index, float& constant)
+		{
+			isVar = Pick(3) != 0;
+			if (isVar) {
+				const auto variable = Pick(3);
+				index = kNumberSlots[variable];
+				source += kNumberVariables[variable];
+			} else {
+				constant = MakeConstant();
+				AppendConstant(source, constant);
+			}
+		}
+
+		std::unique_ptr<RefNode> MakeNode(std::string& source, int depth)
+		{
+			auto node = std::make_unique<RefNode>();
+			const std::uint32_t choice = depth <= 0 ? Pick(3) : Pick(7);
+
+			switch (choice) {
+				case 0:
+				{
+					node->kind = RefNode::Kind::Compare;
+					static constexpr const char* operators[] = { " < ", " <= ", " > ", " >= ", " == ", " != " };
+					node->compare = static_cast<int>(Pick(6));
+					AppendOperand(source, node->lhsIsVar, node->lhsIndex, node->lhsConst);
+					source += operators[node->compare];
+					AppendOperand(source, node->rhsIsVar, node->rhsIndex, node->rhsConst);
+					break;
+				}
+				case 1:
+				{
+					node->kind = RefNode::Kind::BoolVar;
+					const auto variable = Pick(2);
+					node->index = kBoolSlots[variable];
+					source += kBoolVariables[variable];
+					break;
+				}
+				case 2:
+					node->kind = RefNode::Kind::Literal;
+					node->literal = Pick(2) != 0;
+					source += node->literal ? "true" : "false";
+					break;
+				case 3:
+					node->kind = RefNode::Kind::Not;
+					source += "!";
+					node->a = MakeParenthesized(source, depth - 1);
+					break;
+				default:
+				{
+					node->kind = choice % 2 ? RefNode::Kind::And : RefNode::Kind::Or;
+					node->a = MakeParenthesized(source, depth - 1);
+					source += node->kind == RefNode::Kind::And ? " && " : " || ";
+					node->b = MakeParenthesized(source, depth - 1);
+					break;
+				}
+			}
+			return node;
+		}
+
+		std::unique_ptr<RefNode> MakeParenthesized(std::string& source, int depth)
+		{
+			source += "(";
+			auto node = MakeNode(source, depth);
+			source += ")";
+			return node;
+		}
+
+		test::Random& random;
+		std::vector<float>* constants = nullptr;
+	};
+
+	float MakeInput(test::Random& random, const std::vector<float>& constants)
+	{
+		static constexpr float specials[] = {
+			std::numeric_limits<float>::quiet_NaN(), -std::numeric_limits<float>::quiet_NaN(),
+			std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+			0.0f, -0.0f, 1.0f, -1.0f, std::numeric_limits<float>::denorm_min()
+		};
+
+		switch (random.NextBits() % 4) {
+			case 0:
+				return specials[random.NextBits() % std::size(specials)];
+			case 1:
+				if (!constants.empty()) {
+					return constants[random.NextBits() % constants.size()];  // Exercises == and the boundary of < / <=
+				}
+				[[fallthrough]];
+			default:
+				return (random.Next() - 0.25f) * 600.0f;
+		}
+	}
+
+	void TestDifferential()
+	{
+		test::Random random;
+		Generator generator(random);
+		std::size_t compiled = 0;
+		std::size_t interpreterMismatches = 0;
+		std::size_t nativeMismatches = 0;
+		std::size_t nativeCompiled = 0;
+
+		for (std::size_t i = 0; i < kExpressions; ++i) {
+			std::string source;
+			std::vector<float> constants;
+			constants.reserve(kConstantsPerExpression);
+			const auto reference = generator.Make(source, constants, 1 + static_cast<int>(i % 4));
+
+			std::string error;
+			auto expression = FilterExpression::Compile(source, error);
+			if (!expression) {
+				std::printf("  failed to compile \"%s\": %s\n", source.c_str(), error.c_str());
+				CHECK(expression != nullptr);
+				continue;
+			}
+			++compiled;
+
+#ifdef TYF_TEST_JIT
+			std::unique_ptr<FilterExpression> native = FilterExpression::Compile(source, error);
+			const bool hasNative = native->CompileNative(error);
+			nativeCompiled += hasNative ? 1 : 0;
+#endif
+
+			for (std::size_t j = 0; j < kInputsPerExpression; ++j) {
+				FilterInputs inputs{};
+				for (auto& value : inputs.values) {
+					value = MakeInput(random, constants);
+				}
+
+				const bool expected = reference->Eval(inputs.values);
+				const bool interpreted = expression->Interpret(inputs);
+				if (interpreted != expected) {
+					if (interpreterMismatches++ < 5) {
+						std::printf("  interpreter mismatch: \"%s\" on (%g, %g, %g, %g, %g)\n", source.c_str(),
+							inputs.values[0], inputs.values[1], inputs.values[2], inputs.values[3], inputs.values[4]);
+					}
+				}
+
+#ifdef TYF_TEST_JIT
+				if (hasNative && native->Evaluate(inputs) != interpreted) {
+					if (nativeMismatches++ < 5) {
+						std::printf("  native mismatch: \"%s\" on (%g, %g, %g, %g, %g)\n", source.c_str(),
+							inputs.values[0], inputs.values[1], inputs.values[2], inputs.values[3], inputs.values[4]);
+					}
+				}
+#endif
+			}
+		}
+
+		CHECK(compiled == kExpressions);
+		CHECK(interpreterMismatches == 0);
+		CHECK(nativeMismatches == 0);
+#ifdef TYF_TEST_JIT
+		CHECK(nativeCompiled == compiled);
+		std::printf("  %zu expressions x %zu inputs: interpreter and native code agree with the reference\n", compiled, kInputsPerExpression);
+#else
+		std::printf("  %zu expressions x %zu inputs: interpreter agrees with the reference (built without Xbyak - native code not tested)\n",
+			compiled, kInputsPerExpression);
+		(void)nativeCompiled;
+#endif
+	}
+
+	bool CompileFails(const std::string& source, const char* expectedError)
+	{
+		std::string error;
+		const auto expression = FilterExpression::Compile(source, error);
+		if (expression || error.find(expectedError) == std::string::npos) {
+			std::printf("  \"%.40s%s\": expected error containing \"%s\", got \"%s\"\n",
+				source.c_str(), source.size() > 40 ? "..." : "", expectedError, error.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	bool CompileSucceeds(const std::string& source)
+	{
+		std::string error;
+		return FilterExpression::Compile(source, error) != nullptr;
+	}
+
+	std::string Repeat(std::string_view text, std::size_t count)
+	{
+		std::string result;
+		for (std::size_t i = 0; i < count; ++i) {
+			result += text;
+		}
+		return result;
+	}
+
+	void TestLimits()
+	{
+		constexpr std::size_t depth = FilterExpression::kMaxNestingDepth;
+
+		// Nesting up to the limit parses, one more level does not
+		CHECK(CompileSucceeds(Repeat("(", depth) + "dist < 5" + Repeat(")", depth)));
+		CHECK(CompileFails(Repeat("(", depth + 1) + "dist < 5" + Repeat(")", depth + 1), "nested too deeply"));
+		CHECK(CompileSucceeds(Repeat("!", depth) + "inCombat"));
+		CHECK(CompileFails(Repeat("!", depth + 1) + "inCombat", "nested too deeply"));
+		CHECK(CompileFails(Repeat("!(", depth) + "inCombat" + Repeat(")", depth), "nested too deeply"));
+
+		// Far beyond the limit: a parse error, not a stack overflow
+		CHECK(CompileFails(Repeat("(", 1'000'000), "nested too deeply"));
+		CHECK(CompileFails(Repeat("!", 1'000'000) + "inCombat", "nested too deeply"));
+
+		// Long flat chains are rejected while parsing, before lowering recurses through them
+		CHECK(CompileSucceeds("sneaking" + Repeat(" && sneaking", FilterExpression::kMaxInstructions / 2 - 1)));
+		CHECK(CompileFails("sneaking" + Repeat(" || sneaking", FilterExpression::kMaxInstructions), "too long"));
+		CHECK(CompileFails("sneaking" + Repeat(" && sneaking", 1'000'000), "too long"));
+
+		// Error messages still carry the column
+		CHECK(CompileFails("dist < 150 && foo", "unknown variable \"foo\" at column 15"));
+		CHECK(CompileFails("dist < 150 &", "unexpected character '&' at column 12"));
+		CHECK(CompileFails("(dist < 150", "missing ')' for '(' at column 1"));
+		CHECK(CompileFails("dist < 1.2.3", "invalid number \"1.2.3\" at column 8"));
+		CHECK(CompileFails("dist", "must be a condition"));
+	}
+}
+
+int main()
+{
+	TestLimits();
+	TestDifferential();
+	return test::Finish("FilterExpressionTest");
+}
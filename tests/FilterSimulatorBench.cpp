@@ -0,0 +1,232 @@
+/**
+ * FilterSimulatorBench.cpp - AllowComment decision cost over a simulated crowd
+ *
+ * Simulates 10 to 10,000 NPCs around a turning player and runs every NPC
+ * through the decision step of AllowComment once per frame (query gathering,
+ * decision table lookup, DecideComment), for each filter mode. Angle and
+ * Both also run with b3DViewCone ("3D"), to compare with their flat rows:
+ * the 3D cone must not cost more than the flat test. Prints the cost per
+ * call, the calls and time per frame, and decisions per second.
+ *
+ * Only the game-independent part is measured: category resolution, dwell
+ * time, line of sight and rate limiting have their own tests, and the game's
+ * own cost of calling the hook is not included.
+ *
+ * A second table measures a call with the configuration evicted from the
+ * cache beforehand (as after a frame's worth of other work on the AI thread),
+ * per category: the cost of every FilterParameters line the call touches.
+ *
+ * Usage: FilterSimulatorBench [--quick]
+ */
+
+#include "MockWorld.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#	include <immintrin.h>
+#	define TYF_BENCH_CLFLUSH
+#endif
+
+namespace
+{
+	struct ModeCase
+	{
+		const char* name;
+		FilterMode mode;
+		bool decisionTable;
+		bool viewCone3D = false;
+	};
+
+	constexpr std::array kModes = {
+		ModeCase{ "Angle", FilterMode::AngleOnly, false },
+		ModeCase{ "Angle+table", FilterMode::AngleOnly, true },
+		ModeCase{ "Angle 3D", FilterMode::AngleOnly, false, true },
+		ModeCase{ "Distance", FilterMode::DistanceOnly, false },
+		ModeCase{ "Distance+table", FilterMode::DistanceOnly, true },
+		ModeCase{ "Both", FilterMode::Both, false },
+		ModeCase{ "Both+table", FilterMode::Both, true },
+		ModeCase{ "Both 3D", FilterMode::Both, false, true },
+		ModeCase{ "Either", FilterMode::Either, false },
+		ModeCase{ "Either+table", FilterMode::Either, true },
+		ModeCase{ "Expression", FilterMode::Expression, false },
+		ModeCase{ "Frustum", FilterMode::Frustum, false }
+	};
+
+	constexpr std::array<std::size_t, 4> kCrowdSizes = { 10, 100, 1000, 10000 };
+	constexpr float kCrowdRadius = 4000.0f;
+	constexpr float kEyeHeight = 120.0f;
+	constexpr float kTurnPerFrame = 0.05f;  // Radians; the player keeps turning so every frame has a new facing
+
+	struct Result
+	{
+		double nanosecondsPerCall;
+		std::size_t allowed;
+	};
+
+	Result Simulate(const FilterParameters& filter, const std::vector<mock::Npc>& crowd, std::size_t frames)
+	{
+		mock::Player player{ 0.0f, 0.0f, 0.0f, 0.0f, 0.1f, false };
+		float viewProjection[4][4];
+		FrustumPlanes frustum;
+		std::size_t allowed = 0;
+
+		const auto start = test::Clock::now();
+		for (std::size_t frame = 0; frame < frames; ++frame) {
+			// Once per frame, like the per-thread facing and frustum caches in AllowComment
+			player.yaw = static_cast<float>(frame % 126) * kTurnPerFrame;
+			const PlayerFacing facing = MakePlayerFacing(player.yaw, player.pitch);
+			if (filter.filterMode == FilterMode::Frustum) {
+				mock::MakeViewProjection(player, kEyeHeight, viewProjection);
+				ExtractFrustumPlanes(viewProjection, frustum);
+			}
+
+			for (const auto& npc : crowd) {
+				const CommentQuery query = mock::MakeQuery(filter, player, facing, npc, &frustum);
+				allowed += mock::Decide(filter, npc.category, query).allow ? 1 : 0;
+			}
+		}
+		const double elapsed = test::ElapsedNanoseconds(start);
+
+		return { elapsed / static_cast<double>(frames * crowd.size()), allowed };
+	}
+
+	/**
+	 * Every flag AllowComment tests on a call that gets as far as the rate
+	 * limit, in the same order.
+	 */
+	std::uint32_t ReadCallFlags(const FilterParameters& filter)
+	{
+		constexpr std::array flags = { FilterFlag::Timing, FilterFlag::ViewCone3D, FilterFlag::Shadow, FilterFlag::DwellTime,
+			FilterFlag::LineOfSight, FilterFlag::RateLimit, FilterFlag::DebugLogging, FilterFlag::ReferenceCheck };
+		std::uint32_t result = 0;
+		for (const FilterFlag flag : flags) {
+			result = result << 1 | (filter.Has(flag) ? 1 : 0);
+		}
+		return result;
+	}
+
+#ifdef TYF_BENCH_CLFLUSH
+	/**
+	 * @return TSC ticks to load one byte (a few dozen if cached, hundreds if not)
+	 */
+	std::uint64_t TimeLoad(const char* address)
+	{
+		unsigned int processor;
+		_mm_mfence();
+		const std::uint64_t start = __rdtscp(&processor);
+		test::Consume(*reinterpret_cast<const volatile char*>(address));
+		const std::uint64_t ticks = __rdtscp(&processor) - start;
+		_mm_lfence();
+		return ticks;
+	}
+
+	/**
+	 * Flushes the filter parameters from every cache level, makes one call,
+	 * then probes each line: a line the call read loads from cache.
+	 *
+	 * @param touched Incremented per line that was cached after the call
+	 * @return TSC ticks of the call
+	 */
+	std::uint64_t ProbeColdCall(const FilterParameters& filter, std::uint8_t category, const CommentQuery& query,
+		std::uint64_t threshold, std::array<std::size_t, sizeof(FilterParameters) / 64>& touched)
+	{
+		const auto* lines = reinterpret_cast<const char*>(&filter);
+		for (std::size_t line = 0; line < touched.size(); ++line) {
+			_mm_clflush(lines + line * 64);
+		}
+		_mm_mfence();
+
+		unsigned int processor;
+		const std::uint64_t start = __rdtscp(&processor);
+		test::Consume(ReadCallFlags(filter) + (mock::Decide(filter, category, query).allow ? 1 : 0));
+		const std::uint64_t ticks = __rdtscp(&processor) - start;
+
+		for (std::size_t line = 0; line < touched.size(); ++line) {
+			touched[line] += TimeLoad(lines + line * 64) < threshold ? 1 : 0;
+		}
+		return ticks;
+	}
+
+	/**
+	 * Which FilterParameters lines a call reads, and what it costs with the
+	 * configuration cold, per category. Cached/uncached load times are
+	 * calibrated first; the line columns are the share of calls after which
+	 * the line was cached (the adjacent-line prefetcher may add a neighbour).
+	 */
+	void BenchmarkColdConfiguration(bool quick)
+	{
+		const std::size_t calls = quick ? 2'000 : 200'000;
+		const auto filter = mock::MakeFilter(FilterMode::AngleOnly, false);
+		const mock::Player player{ 0.0f, 0.0f, 0.0f, 0.0f, 0.1f, false };
+		const mock::Npc npc{ 20.0f, 100.0f, 0.0f, 0, false };  // In range and in front: the full angle test runs
+		const CommentQuery query = mock::MakeQuery(filter->params, player, MakePlayerFacing(player.yaw, player.pitch), npc, nullptr);
+
+		// Halfway between a cached and a flushed load
+		const auto* first = reinterpret_cast<const char*>(&filter->params);
+		std::vector<std::uint64_t> cached(1001), uncached(1001);
+		for (std::size_t i = 0; i < cached.size(); ++i) {
+			cached[i] = TimeLoad(first);
+			_mm_clflush(first);
+			uncached[i] = TimeLoad(first);
+		}
+		std::nth_element(cached.begin(), cached.begin() + 500, cached.end());
+		std::nth_element(uncached.begin(), uncached.begin() + 500, uncached.end());
+		const std::uint64_t threshold = (cached[500] + uncached[500]) / 2;
+
+		std::printf("\ncold config (load: %llu ticks cached, %llu flushed)\n", static_cast<unsigned long long>(cached[500]),
+			static_cast<unsigned long long>(uncached[500]));
+		std::printf("%-16s %10s %8s %8s %8s\n", "category", "ticks", "line 0", "line 1", "line 2");
+		for (std::uint8_t category = 0; category < kMaxActorCategories; ++category) {
+			std::array<std::size_t, sizeof(FilterParameters) / 64> touched{};
+			std::vector<std::uint64_t> ticks(calls);
+			for (auto& elapsed : ticks) {
+				elapsed = ProbeColdCall(filter->params, category, query, threshold, touched);
+			}
+			std::nth_element(ticks.begin(), ticks.begin() + calls / 2, ticks.end());
+			std::printf("%-16u %10llu", category, static_cast<unsigned long long>(ticks[calls / 2]));
+			for (const std::size_t count : touched) {
+				std::printf(" %7.0f%%", 100.0 * static_cast<double>(count) / static_cast<double>(calls));
+			}
+			std::printf("\n");
+		}
+	}
+#else
+	void BenchmarkColdConfiguration(bool)
+	{
+		std::printf("\ncold config: needs CLFLUSH (x64) - skipped\n");
+	}
+#endif
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = test::IsQuick(argc, argv);
+	const std::size_t callsPerCase = quick ? 200'000 : 5'000'000;
+
+	std::printf("%-16s %7s %10s %12s %12s %14s %8s\n", "mode", "NPCs", "ns/call", "calls/frame", "us/frame", "decisions/s", "allowed");
+
+	for (const std::size_t count : kCrowdSizes) {
+		test::Random random;
+		const auto crowd = mock::MakeCrowd(count, kCrowdRadius, 4, random);
+		const std::size_t frames = std::max<std::size_t>(1, callsPerCase / count);
+
+		for (const auto& mode : kModes) {
+			const auto filter = mock::MakeFilter(mode.mode, mode.decisionTable, mode.viewCone3D);
+			Simulate(filter->params, crowd, std::max<std::size_t>(1, frames / 10));  // Warm up
+			const Result result = Simulate(filter->params, crowd, frames);
+			test::Consume(result.allowed);
+
+			std::printf("%-16s %7zu %10.2f %12zu %12.2f %14.3g %7.1f%%\n", mode.name, count, result.nanosecondsPerCall, count,
+				result.nanosecondsPerCall * static_cast<double>(count) / 1000.0, 1e9 / result.nanosecondsPerCall,
+				100.0 * static_cast<double>(result.allowed) / static_cast<double>(frames * count));
+		}
+	}
+
+	BenchmarkColdConfiguration(quick);
+
+	return 0;
+}
@@ -0,0 +1,160 @@
+/**
+ * FilterStatsStressTest.cpp - Per-thread statistics under many threads
+ *
+ * First measures recording throughput with 1-16 threads, next to a single
+ * shared fetch_add counter for comparison: owned slots should scale with the
+ * thread count, the shared counter should not.
+ * Then runs more threads than there are slots (kMaxStatsSlots = 64), so the
+ * late threads share the overflow slot, while another thread keeps calling
+ * CollectStatistics. Totals must be exact once the writers have joined, and
+ * the maximum must come from the slowest recorded call.
+ *
+ * CTest also runs FilterStatsStressTest_tsan, the same test built with
+ * -fsanitize=thread (GCC and Clang), which reports any data race between
+ * writers, the overflow slot and the reader.
+ *
+ * Usage: FilterStatsStressTest [--quick]
+ */
+
+#include "FilterStats.h"
+#include "TestSupport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+namespace
+{
+	constexpr std::size_t kThreadCounts[] = { 1, 2, 4, 8, 16 };
+	constexpr std::size_t kScalingThreads = 1 + 2 + 4 + 8 + 16;
+	constexpr std::size_t kStressThreads = 48;  // Together with the scaling threads, more than 64 slots
+	constexpr std::size_t kSlots = 64;          // kMaxStatsSlots in FilterStats.cpp
+	constexpr std::uint64_t kMaxOffset = 1ull << 40;  // Ticks added to the slowest recorded call
+
+	std::atomic<std::uint64_t> g_sharedCounter{ 0 };
+
+	template <class Work>
+	double RunThreads(std::size_t threads, Work work)
+	{
+		std::atomic<std::size_t> ready{ 0 };
+		std::atomic<bool> go{ false };
+		std::vector<std::thread> pool;
+		for (std::size_t t = 0; t < threads; ++t) {
+			pool.emplace_back([&, t] {
+				ready.fetch_add(1);
+				while (!go.load()) {
+					std::this_thread::yield();
+				}
+				work(t);
+			});
+		}
+		while (ready.load() != threads) {
+			std::this_thread::yield();
+		}
+
+		const auto start = test::Clock::now();
+		go.store(true);
+		for (auto& thread : pool) {
+			thread.join();
+		}
+		return test::ElapsedNanoseconds(start);
+	}
+
+	void MeasureScaling(std::size_t perThread)
+	{
+		std::printf("  %-8s %22s %22s\n", "threads", "owned slots (M/s)", "shared fetch_add (M/s)");
+		for (const std::size_t threads : kThreadCounts) {
+			const double owned = RunThreads(threads, [&](std::size_t) {
+				for (std::size_t i = 0; i < perThread; ++i) {
+					RecordOutcome(FilterOutcome::AllowFilter);
+				}
+			});
+			const double shared = RunThreads(threads, [&](std::size_t) {
+				for (std::size_t i = 0; i < perThread; ++i) {
+					g_sharedCounter.fetch_add(1, std::memory_order_relaxed);
+				}
+			});
+
+			const double records = static_cast<double>(threads * perThread) * 1000.0;  // Per ns -> M/s
+			std::printf("  %-8zu %22.1f %22.1f\n", threads, records / owned, records / shared);
+		}
+	}
+
+	void TestExactTotals(std::size_t perThread)
+	{
+		const FilterStatistics before = CollectStatistics();
+
+		std::atomic<bool> writing{ true };
+		std::size_t reads = 0;
+		std::uint64_t lastTotal = before.Total();
+		bool monotonic = true;
+		std::thread reader([&] {
+			while (writing.load()) {
+				const FilterStatistics stats = CollectStatistics();
+				monotonic = monotonic && stats.Total() >= lastTotal;
+				lastTotal = stats.Total();
+				++reads;
+			}
+		});
+
+		RunThreads(kStressThreads, [&](std::size_t t) {
+			for (std::size_t i = 0; i < perThread; ++i) {
+				const auto outcome = static_cast<FilterOutcome>(i % static_cast<std::size_t>(FilterOutcome::kCount));
+				// Every 16th call is timed; thread 0's last call is the slowest by kMaxOffset
+				const bool slowest = t == 0 && i == perThread - 1;
+				const std::uint64_t start = i % 16 == 0 || slowest ? __rdtsc() - (slowest ? kMaxOffset : 0) : 0;
+				RecordOutcome(outcome, start);
+				RecordLineOfSight(LineOfSightSource::Raycast);
+			}
+		});
+		writing.store(false);
+		reader.join();
+
+		const FilterStatistics after = CollectStatistics();
+		const std::uint64_t calls = kStressThreads * perThread;
+		const std::uint64_t expectedTimed = kStressThreads * ((perThread + 15) / 16) + ((perThread - 1) % 16 ? 1 : 0);
+
+		std::uint64_t histogram = 0;
+		for (std::size_t i = 0; i < StatsExport::kTimeBuckets; ++i) {
+			histogram += after.timeHistogram[i] - before.timeHistogram[i];
+		}
+
+		CHECK(after.Total() - before.Total() == calls);
+		for (std::size_t i = 0; i < static_cast<std::size_t>(FilterOutcome::kCount); ++i) {
+			std::uint64_t expected = 0;
+			for (std::size_t j = 0; j < perThread; ++j) {
+				expected += j % static_cast<std::size_t>(FilterOutcome::kCount) == i ? kStressThreads : 0;
+			}
+			CHECK(after.outcomes[i] - before.outcomes[i] == expected);
+		}
+		const auto raycast = static_cast<std::size_t>(LineOfSightSource::Raycast);
+		CHECK(after.lineOfSight[raycast] - before.lineOfSight[raycast] == calls);
+		CHECK(after.timedCalls - before.timedCalls == expectedTimed);
+		CHECK(histogram == expectedTimed);
+		CHECK(after.maxTicks >= kMaxOffset);
+		CHECK(after.maxTicks < kMaxOffset + (kMaxOffset >> 4));
+		CHECK(after.threadCount == kSlots + 1);  // Every owned slot + the overflow slot
+		CHECK(monotonic);
+
+		std::printf("  %zu threads x %zu calls (overflow slot shared by %zu): totals exact, %zu concurrent reads\n",
+			kStressThreads, perThread, kScalingThreads + kStressThreads - kSlots, reads);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = test::IsQuick(argc, argv);
+
+	MeasureScaling(quick ? 100'000 : 20'000'000);
+	TestExactTotals(quick ? 2'000 : 200'000);
+
+	return test::Finish("FilterStatsStressTest");
+}
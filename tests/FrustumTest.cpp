@@ -0,0 +1,330 @@
+/**
+ * FrustumTest.cpp - ExtractFrustumPlanes / IsInFrustum against reference projections
+ *
+ * Frustum mode (FilterMode::Frustum) decides from six planes pulled out of the
+ * view-projection matrix and a four-lane SSE test. Two references that share
+ * no code with it check every decision, in double precision:
+ *   - clip space   points only: clip = M * (x, y, z, 1), inside if w > 0,
+ *                  -w <= x <= w, -w <= y <= w and z <= w
+ *   - camera space points and spheres: the point in the camera's right / up /
+ *                  forward basis, signed distances to the planes derived from
+ *                  the field of view alone; a sphere counts while it is at
+ *                  least partly inside every plane, as IsInFrustum documents
+ * Query classes:
+ *   - scatter  random camera poses anywhere in a worldspace, points and
+ *              spheres around the camera, behind it and beyond the far plane
+ *   - boundary spheres 1e-3 to 1e2 units inside or outside one plane
+ *   - heads    DecideComment in Frustum mode over mock crowds (head sphere)
+ * A differing decision is only accepted within the float rounding of the
+ * world position (kRelativeTolerance of the coordinates' magnitude). The far
+ * plane is extracted with cancellation and gets kFarRelativeTolerance: about
+ * 10 units at 2e5 units from the world origin, where a head at the far plane
+ * is 10000 units away and never greets.
+ *
+ * Usage: FrustumTest [--quick]
+ */
+
+#include "MockWorld.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	// A few float ulps of the largest coordinate involved: the planes' d terms
+	// are products of world positions up to several 1e5 units
+	constexpr double kRelativeTolerance = 2e-6;
+	constexpr double kAbsoluteTolerance = 1e-3;
+
+	// The far plane is row 3 minus row 2, which differ by only near / far of
+	// their length: the float matrix's rounding grows by far / near there
+	constexpr double kFarRelativeTolerance = 2.0 * 5.96e-8 * mock::kFarPlane / mock::kNearPlane;
+
+	constexpr float kEyeHeight = 120.0f;
+	constexpr float kWorldExtent = 200'000.0f;  // Tamriel's cell grid spans about +-250000 units
+
+	/**
+	 * Camera built from the pose and the FOV, not from the matrix.
+	 */
+	struct ReferenceCamera
+	{
+		double eye[3];
+		double right[3];
+		double up[3];
+		double forward[3];
+		double tanHalfX;  // Horizontal half-FOV
+		double tanHalfY;  // Vertical half-FOV
+	};
+
+	ReferenceCamera MakeReferenceCamera(const mock::Player& player)
+	{
+		const double yaw = player.yaw;
+		const double pitch = player.pitch;
+		ReferenceCamera camera{};
+		camera.eye[0] = player.x;
+		camera.eye[1] = player.y;
+		camera.eye[2] = static_cast<double>(player.z) + kEyeHeight;
+		camera.forward[0] = std::sin(yaw) * std::cos(pitch);
+		camera.forward[1] = std::cos(yaw) * std::cos(pitch);
+		camera.forward[2] = -std::sin(pitch);
+		camera.right[0] = std::cos(yaw);
+		camera.right[1] = -std::sin(yaw);
+		camera.right[2] = 0.0;
+		camera.up[0] = camera.right[1] * camera.forward[2] - camera.right[2] * camera.forward[1];
+		camera.up[1] = camera.right[2] * camera.forward[0] - camera.right[0] * camera.forward[2];
+		camera.up[2] = camera.right[0] * camera.forward[1] - camera.right[1] * camera.forward[0];
+		camera.tanHalfX = std::tan(static_cast<double>(mock::kHorizontalFov) / 2.0);
+		camera.tanHalfY = camera.tanHalfX / static_cast<double>(mock::kAspect);
+		return camera;
+	}
+
+	double Dot(const double (&axis)[3], const double (&v)[3])
+	{
+		return axis[0] * v[0] + axis[1] * v[1] + axis[2] * v[2];
+	}
+
+	/**
+	 * @param binding Receives the index of the closest plane (ExtractFrustumPlanes order)
+	 * @return Smallest signed distance to the six planes, positive inside
+	 */
+	double GetReferenceMargin(const ReferenceCamera& camera, double x, double y, double z, std::size_t* binding = nullptr)
+	{
+		const double v[3] = { x - camera.eye[0], y - camera.eye[1], z - camera.eye[2] };
+		const double cx = Dot(camera.right, v);
+		const double cy = Dot(camera.up, v);
+		const double cz = Dot(camera.forward, v);
+
+		// Side planes through the eye: x = +-z * tan(half FOV), normals scaled by cos(half FOV)
+		const double cosHalfX = 1.0 / std::sqrt(1.0 + camera.tanHalfX * camera.tanHalfX);
+		const double cosHalfY = 1.0 / std::sqrt(1.0 + camera.tanHalfY * camera.tanHalfY);
+		const std::array<double, 6> distances = {
+			(cz * camera.tanHalfX + cx) * cosHalfX,  // Left
+			(cz * camera.tanHalfX - cx) * cosHalfX,  // Right
+			(cz * camera.tanHalfY + cy) * cosHalfY,  // Bottom
+			(cz * camera.tanHalfY - cy) * cosHalfY,  // Top
+			cz,                                      // Camera plane
+			mock::kFarPlane - cz                     // Far
+		};
+		const auto closest = std::min_element(distances.begin(), distances.end());
+		if (binding) {
+			*binding = static_cast<std::size_t>(closest - distances.begin());
+		}
+		return *closest;
+	}
+
+	/**
+	 * @return true if the point is inside the clip volume of the matrix
+	 */
+	bool IsInClipVolume(const float (&m)[4][4], double x, double y, double z)
+	{
+		double clip[4];
+		for (int row = 0; row < 4; ++row) {
+			clip[row] = m[row][0] * x + m[row][1] * y + m[row][2] * z + m[row][3];
+		}
+		const double w = clip[3];
+		return w > 0.0 && std::fabs(clip[0]) <= w && std::fabs(clip[1]) <= w && clip[2] <= w;
+	}
+
+	mock::Player MakeRandomPlayer(test::Random& random)
+	{
+		return { (random.Next() - 0.5f) * 2.0f * kWorldExtent, (random.Next() - 0.5f) * 2.0f * kWorldExtent,
+			(random.Next() - 0.5f) * 20'000.0f, random.Next() * 2.0f * pi, (random.Next() - 0.5f) * 2.4f, false };
+	}
+
+	struct ClassResult
+	{
+		std::size_t compared = 0;
+		std::size_t differing = 0;
+		double largestMargin = 0.0;  // Of the differing decisions, distance from the boundary in units
+		std::size_t beyondTolerance = 0;
+	};
+
+	/**
+	 * Compares one decision with the camera-space reference.
+	 */
+	void Compare(ClassResult& result, const char* name, const ReferenceCamera& camera, bool decision,
+		double x, double y, double z, double radius)
+	{
+		++result.compared;
+		std::size_t plane;
+		const double margin = GetReferenceMargin(camera, x, y, z, &plane) + radius;
+		if (decision == (margin >= 0.0)) {
+			return;
+		}
+		++result.differing;
+		result.largestMargin = std::max(result.largestMargin, std::fabs(margin));
+		const double magnitude = std::fabs(camera.eye[0]) + std::fabs(camera.eye[1]) + std::fabs(camera.eye[2]) +
+		                         std::fabs(x - camera.eye[0]) + std::fabs(y - camera.eye[1]) + std::fabs(z - camera.eye[2]);
+		const double tolerance = (plane == 5 ? kFarRelativeTolerance : kRelativeTolerance) * magnitude + kAbsoluteTolerance;
+		if (std::fabs(margin) > tolerance && result.beyondTolerance++ < 5) {
+			std::printf("  %s: eye=(%.9g, %.9g, %.9g) point=(%.9g, %.9g, %.9g) radius=%g margin=%g -> %s\n", name,
+				camera.eye[0], camera.eye[1], camera.eye[2], x, y, z, radius, margin, decision ? "inside" : "outside");
+		}
+	}
+
+	void Report(const ClassResult& result, const char* name)
+	{
+		std::printf("%-10s %10zu %10zu %14.3g\n", name, result.compared, result.differing, result.largestMargin);
+		CHECK(result.compared > 0);
+		CHECK(result.beyondTolerance == 0);
+	}
+
+	void TestScatter(std::size_t poses, std::size_t pointsPerPose)
+	{
+		test::Random random;
+		ClassResult result;
+		std::size_t clipDiffering = 0;
+		std::size_t clipBeyondTolerance = 0;
+
+		for (std::size_t pose = 0; pose < poses; ++pose) {
+			const mock::Player player = MakeRandomPlayer(random);
+			float viewProjection[4][4];
+			mock::MakeViewProjection(player, kEyeHeight, viewProjection);
+			FrustumPlanes planes;
+			ExtractFrustumPlanes(viewProjection, planes);
+			const ReferenceCamera camera = MakeReferenceCamera(player);
+
+			for (std::size_t i = 0; i < pointsPerPose; ++i) {
+				// Up to 1.2 times the far plane in any direction, points (radius 0) a third of the time
+				const float reach = 1.2f * mock::kFarPlane * random.Next() * random.Next();
+				const float bearing = random.Next() * 2.0f * pi;
+				const float elevation = (random.Next() - 0.5f) * pi;
+				const float x = player.x + reach * std::cos(elevation) * std::sin(bearing);
+				const float y = player.y + reach * std::cos(elevation) * std::cos(bearing);
+				const float z = player.z + kEyeHeight + reach * std::sin(elevation);
+				const float radius = i % 3 == 0 ? 0.0f : 500.0f * random.Next() * random.Next();
+
+				const bool inside = IsInFrustum(planes, x, y, z, radius);
+				Compare(result, "scatter", camera, inside, x, y, z, radius);
+
+				// Points: the clip-space test on the same matrix
+				if (radius == 0.0f && inside != IsInClipVolume(viewProjection, x, y, z)) {
+					++clipDiffering;
+					const double margin = std::fabs(GetReferenceMargin(camera, x, y, z));
+					clipBeyondTolerance += margin > kRelativeTolerance * (2.0 * kWorldExtent + mock::kFarPlane) + kAbsoluteTolerance ? 1 : 0;
+				}
+			}
+		}
+
+		Report(result, "scatter");
+		std::printf("%-10s %10s %10zu %14s  (points against the clip-space test)\n", "clip", "", clipDiffering, "");
+		CHECK(clipBeyondTolerance == 0);
+	}
+
+	void TestBoundary(std::size_t poses, std::size_t spheresPerPose)
+	{
+		test::Random random;
+		ClassResult result;
+
+		for (std::size_t pose = 0; pose < poses; ++pose) {
+			const mock::Player player = MakeRandomPlayer(random);
+			float viewProjection[4][4];
+			mock::MakeViewProjection(player, kEyeHeight, viewProjection);
+			FrustumPlanes planes;
+			ExtractFrustumPlanes(viewProjection, planes);
+			const ReferenceCamera camera = MakeReferenceCamera(player);
+
+			for (std::size_t i = 0; i < spheresPerPose; ++i) {
+				// A point on one of the planes, in camera space: depth, then the lateral
+				// position at a random fraction of the cross-section
+				const std::size_t plane = i % 6;
+				const double depth = plane == 4 ? 0.0 : plane == 5 ? mock::kFarPlane : 20.0 + (mock::kFarPlane - 40.0) * random.Next();
+				double cx = depth * camera.tanHalfX * (2.0 * random.Next() - 1.0);
+				double cy = depth * camera.tanHalfY * (2.0 * random.Next() - 1.0);
+				double normal[3] = { 0.0, 0.0, 0.0 };  // Inward, camera space
+				const double cosHalfX = 1.0 / std::sqrt(1.0 + camera.tanHalfX * camera.tanHalfX);
+				const double cosHalfY = 1.0 / std::sqrt(1.0 + camera.tanHalfY * camera.tanHalfY);
+				switch (plane) {
+					case 0: cx = -depth * camera.tanHalfX; normal[0] = cosHalfX; normal[2] = camera.tanHalfX * cosHalfX; break;
+					case 1: cx = depth * camera.tanHalfX; normal[0] = -cosHalfX; normal[2] = camera.tanHalfX * cosHalfX; break;
+					case 2: cy = -depth * camera.tanHalfY; normal[1] = cosHalfY; normal[2] = camera.tanHalfY * cosHalfY; break;
+					case 3: cy = depth * camera.tanHalfY; normal[1] = -cosHalfY; normal[2] = camera.tanHalfY * cosHalfY; break;
+					case 4: normal[2] = 1.0; break;
+					default: normal[2] = -1.0; break;
+				}
+
+				// Sphere surface 1e-3 to 1e2 units inside or outside the plane
+				const double radius = i % 4 == 0 ? 0.0 : kFrustumHeadRadius;
+				const double offset = std::pow(10.0, -3.0 + 5.0 * random.Next()) * (random.NextBits() & 1 ? 1.0 : -1.0);
+				const double shift = offset - radius;
+				cx += normal[0] * shift;
+				cy += normal[1] * shift;
+				const double cz = depth + normal[2] * shift;
+
+				double world[3];
+				for (int axis = 0; axis < 3; ++axis) {
+					world[axis] = camera.eye[axis] + camera.right[axis] * cx + camera.up[axis] * cy + camera.forward[axis] * cz;
+				}
+				const auto x = static_cast<float>(world[0]);
+				const auto y = static_cast<float>(world[1]);
+				const auto z = static_cast<float>(world[2]);
+				Compare(result, "boundary", camera, IsInFrustum(planes, x, y, z, static_cast<float>(radius)), x, y, z, radius);
+			}
+		}
+
+		Report(result, "boundary");
+	}
+
+	void TestHeads(std::size_t poses, std::size_t crowdSize)
+	{
+		test::Random random;
+		ClassResult result;
+		auto filter = mock::MakeFilter(FilterMode::Frustum, false);
+		filter->params.Set(FilterFlag::CloseRangeBypass, false);  // Only frustum decisions
+
+		for (std::size_t pose = 0; pose < poses; ++pose) {
+			mock::Player player = MakeRandomPlayer(random);
+			float viewProjection[4][4];
+			mock::MakeViewProjection(player, kEyeHeight, viewProjection);
+			FrustumPlanes planes;
+			ExtractFrustumPlanes(viewProjection, planes);
+			const ReferenceCamera camera = MakeReferenceCamera(player);
+			const PlayerFacing facing = MakePlayerFacing(player.yaw, player.pitch);
+
+			for (mock::Npc npc : mock::MakeCrowd(crowdSize, 4000.0f, kMaxActorCategories, random)) {
+				npc.x += player.x;
+				npc.y += player.y;
+				npc.z += player.z;
+				const CommentQuery query = mock::MakeQuery(filter->params, player, facing, npc, &planes);
+				const CommentDecision decision = DecideComment(filter->params, filter->params.categories[npc.category], query);
+				CHECK(decision.outcome == FilterOutcome::AllowFilter || decision.outcome == FilterOutcome::BlockFilter);
+				Compare(result, "heads", camera, decision.allow, npc.x, npc.y,
+					static_cast<double>(npc.z) + kFrustumHeadHeight, kFrustumHeadRadius);
+			}
+		}
+
+		Report(result, "heads");
+	}
+
+	void TestPadding()
+	{
+		// Planes 6 and 7 pass everything, so only the six real planes decide
+		const mock::Player player{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, false };
+		float viewProjection[4][4];
+		mock::MakeViewProjection(player, kEyeHeight, viewProjection);
+		FrustumPlanes planes;
+		ExtractFrustumPlanes(viewProjection, planes);
+		for (std::size_t i = 6; i < 8; ++i) {
+			CHECK(planes.a[i] == 0.0f && planes.b[i] == 0.0f && planes.c[i] == 0.0f && planes.d[i] > 1e30f);
+		}
+		CHECK(IsInFrustum(planes, 0.0f, 1000.0f, kEyeHeight, 0.0f));    // Straight ahead
+		CHECK(!IsInFrustum(planes, 0.0f, -1000.0f, kEyeHeight, 0.0f));  // Straight behind
+		CHECK(IsInFrustum(planes, 0.0f, -10.0f, kEyeHeight, 25.0f));    // Behind, but the sphere reaches the camera plane
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = test::IsQuick(argc, argv);
+
+	std::printf("%-10s %10s %10s %14s  (tolerance %.3g * coordinates + %.3g, far plane %.3g * coordinates)\n", "class",
+		"compared", "differing", "largest margin", kRelativeTolerance, kAbsoluteTolerance, kFarRelativeTolerance);
+	TestScatter(quick ? 200 : 20'000, 1000);
+	TestBoundary(quick ? 200 : 20'000, 1000);
+	TestHeads(quick ? 100 : 10'000, 1000);
+	TestPadding();
+
+	return test::Finish("FrustumTest");
+}
@@ -0,0 +1,35 @@
+/**
+ * IniFileFuzz.cpp - libFuzzer target for the INI parser
+ *
+ * Parses arbitrary bytes and compares the result with the reference parser
+ * (IniFileReference.h); any difference aborts. Built with Clang only
+ * (-fsanitize=fuzzer,address). CTest runs a short fixed-length session;
+ * run it directly for longer:
+ *
+ *   IniFileFuzz -max_total_time=600 corpus/
+ */
+
+#include "IniFile.h"
+#include "IniFileReference.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size)
+{
+	const std::string_view text(reinterpret_cast<const char*>(data), size);
+	const IniFile ini = IniFile::Parse(text);
+
+	std::string difference;
+	if (!ini_reference::Matches(ini, text, difference)) {
+		std::fprintf(stderr, "IniFile differs from the reference: %s\n", difference.c_str());
+		std::abort();
+	}
+
+	// Every lookup path on whatever was parsed
+	for (const auto& entry : ini.GetEntries()) {
+		(void)ini.GetBool(entry.section, entry.key, false);
+		(void)ini.GetFloat(entry.section, entry.key, 0.0f);
+	}
+	return 0;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+/**
+ * IniFileReference.h - Straightforward INI parser to check IniFile against
+ *
+ * Splits the text into std::string lines and applies the documented rules
+ * one at a time, copying every name and value. Shared by IniFileTest and the
+ * IniFileFuzz libFuzzer target.
+ */
+
+#include "IniFile.h"
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ini_reference
+{
+	struct Entry
+	{
+		std::string section;
+		std::string key;
+		std::string value;
+		std::uint32_t line;
+	};
+
+	inline std::string Trim(const std::string& text)
+	{
+		constexpr std::string_view spaces = " \t\r\v\f";
+		const auto first = text.find_first_not_of(spaces);
+		if (first == std::string::npos) {
+			return {};
+		}
+		return text.substr(first, text.find_last_not_of(spaces) - first + 1);
+	}
+
+	inline std::vector<Entry> Parse(std::string_view text, std::vector<std::string>& sections)
+	{
+		if (text.substr(0, 3) == "\xEF\xBB\xBF") {
+			text.remove_prefix(3);
+		}
+
+		std::vector<Entry> entries;
+		std::string section;
+		std::uint32_t number = 0;
+		std::size_t start = 0;
+		while (start < text.size()) {
+			std::size_t end = text.find('\n', start);
+			if (end == std::string_view::npos) {
+				end = text.size();
+			}
+			const std::string line = Trim(std::string(text.substr(start, end - start)));
+			start = end + 1;
+			++number;
+
+			if (line.empty() || line[0] == ';' || line[0] == '#') {
+				continue;
+			}
+			if (line[0] == '[') {
+				const auto close = line.find(']');
+				if (close == std::string::npos) {
+					continue;
+				}
+				section = Trim(line.substr(1, close - 1));
+				const bool known = std::any_of(sections.begin(), sections.end(), [&](const std::string& name) {
+					return EqualsIgnoreCase(name, section);
+				});
+				if (!known) {
+					sections.push_back(section);
+				}
+				continue;
+			}
+
+			const auto equals = line.find('=');
+			if (equals == std::string::npos) {
+				continue;
+			}
+			const std::string key = Trim(line.substr(0, equals));
+			std::string value = Trim(line.substr(equals + 1));
+			if (value.size() >= 2 && (value[0] == '"' || value[0] == '\'') && value.back() == value[0]) {
+				value = value.substr(1, value.size() - 2);
+			}
+			if (!key.empty()) {
+				entries.push_back({ section, key, value, number });
+			}
+		}
+
+		std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+			const int order = CompareIgnoreCase(a.section, b.section);
+			return order != 0 ? order < 0 : CompareIgnoreCase(a.key, b.key) < 0;
+		});
+		return entries;
+	}
+
+	/**
+	 * @param difference Receives what differs first
+	 * @return true if the parsed document matches the reference parse of text
+	 */
+	inline bool Matches(const IniFile& ini, std::string_view text, std::string& difference)
+	{
+		std::vector<std::string> sections;
+		const std::vector<Entry> expected = Parse(text, sections);
+		const auto& entries = ini.GetEntries();
+
+		if (entries.size() != expected.size()) {
+			difference = "entry count " + std::to_string(entries.size()) + " vs " + std::to_string(expected.size());
+			return false;
+		}
+		for (std::size_t i = 0; i < entries.size(); ++i) {
+			const auto& a = entries[i];
+			const auto& b = expected[i];
+			if (a.section != b.section || a.key != b.key || a.value != b.value || a.line != b.line) {
+				difference = "entry " + std::to_string(i) + " (line " + std::to_string(b.line) + ")";
+				return false;
+			}
+			// Lookups find the first occurrence of a name
+			const auto found = ini.Find(b.section, b.key);
+			const auto first = std::find_if(expected.begin(), expected.end(), [&](const Entry& entry) {
+				return EqualsIgnoreCase(entry.section, b.section) && EqualsIgnoreCase(entry.key, b.key);
+			});
+			if (!found || *found != first->value) {
+				difference = "lookup of entry " + std::to_string(i);
+				return false;
+			}
+		}
+
+		const auto& parsedSections = ini.GetSections();
+		if (!std::equal(parsedSections.begin(), parsedSections.end(), sections.begin(), sections.end())) {
+			difference = "sections";
+			return false;
+		}
+		return true;
+	}
+}
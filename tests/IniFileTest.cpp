@@ -0,0 +1,226 @@
+/**
+ * IniFileTest.cpp - INI parser rules and a differential test against a reference
+ *
+ * Checks the GetPrivateProfileString rules IniFile.h documents (comments,
+ * first duplicate wins, case-insensitive names, trimming, quotes, BOM, CRLF,
+ * no inline comments), the value converters and loading from disk.
+ * Then parses random documents built from INI-like fragments, plus random
+ * bytes, and compares every entry with a line-by-line reference parser that
+ * copies strings instead of indexing a buffer. tests/IniFileFuzz.cpp runs the
+ * same comparison under libFuzzer where Clang is available.
+ *
+ * Usage: IniFileTest [--quick]
+ */
+
+#include "IniFile.h"
+#include "IniFileReference.h"
+#include "TestSupport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace
+{
+	using namespace std::literals;
+
+	void TestRules()
+	{
+		const IniFile ini = IniFile::Parse(
+			"\xEF\xBB\xBF"
+			"; comment\r\n"
+			"# another = comment\r\n"
+			"global = before any section\r\n"
+			"[Main]\r\n"
+			"  fMaxDeviationAngle =  30.5  \r\n"
+			"sFilterMode = Angle ; not a comment\r\n"
+			"FMAXDEVIATIONANGLE = 99\r\n"
+			"line without equals\r\n"
+			"sQuoted = \"  padded  \"\r\n"
+			"sSingle = 'x'\r\n"
+			"sMismatched = \"x'\r\n"
+			"sEmpty =\r\n"
+			" = no key\r\n"
+			"[ Distance ]\r\n"
+			"fMaxGreetingDistance=150\r\n"
+			"[main]\r\n"
+			"bLater = true\r\n"
+			"[Broken\r\n"
+			"bStillMain = yes\r\n"
+			"sEquals = a=b\n"
+			"sLast = no newline");
+
+		CHECK(ini.GetSections().size() == 2);  // "" is not listed; [main] is [Main]; [Broken is ignored
+		CHECK(ini.GetString("", "global", "") == "before any section");
+		CHECK(ini.GetFloat("Main", "fMaxDeviationAngle", 0.0f) == 30.5f);  // First duplicate wins
+		CHECK(ini.GetFloat("MAIN", "fmaxdeviationangle", 0.0f) == 30.5f);
+		CHECK(ini.GetString("Main", "sFilterMode", "") == "Angle ; not a comment");
+		CHECK(!ini.Find("Main", "line without equals"));
+		CHECK(ini.GetString("Main", "sQuoted", "") == "  padded  ");
+		CHECK(ini.GetString("Main", "sSingle", "") == "x");
+		CHECK(ini.GetString("Main", "sMismatched", "") == "\"x'");
+		CHECK(ini.Find("Main", "sEmpty") == ""sv);
+		CHECK(!ini.Find("Main", ""));
+		CHECK(ini.GetFloat("Distance", "fMaxGreetingDistance", 0.0f) == 150.0f);
+		CHECK(ini.GetBool("Main", "bLater", false));
+		CHECK(ini.GetBool("main", "bStillMain", false));  // A broken header does not change the section
+		CHECK(ini.GetString("Main", "sEquals", "") == "a=b");
+		CHECK(ini.GetString("Main", "sLast", "") == "no newline");
+		CHECK(ini.GetString("Main", "sMissing", "default") == "default");
+		CHECK(ini.GetString("Missing", "sLast", "default") == "default");
+
+		const auto& entries = ini.GetEntries();
+		CHECK(std::is_sorted(entries.begin(), entries.end(), [](const IniFile::Entry& a, const IniFile::Entry& b) {
+			const int section = CompareIgnoreCase(a.section, b.section);
+			return section != 0 ? section < 0 : CompareIgnoreCase(a.key, b.key) < 0;
+		}));
+
+		// Empty and degenerate documents
+		CHECK(IniFile::Parse("").GetEntries().empty());
+		CHECK(IniFile::Parse("\xEF\xBB\xBF").GetEntries().empty());
+		CHECK(IniFile::Parse("[").GetSections().empty());
+		CHECK(IniFile::Parse("[]\nk=v").GetString("", "k", "") == "v");
+		CHECK(IniFile::Parse("=").GetEntries().empty());
+		CHECK(IniFile::Parse("k=\"").GetString("", "k", "") == "\"");
+		CHECK(IniFile::Parse("k=\"\"").GetString("", "k", "x").empty());
+		CHECK(IniFile::Parse(std::string_view("k=a\0b", 5)).GetString("", "k", "").size() == 3);
+	}
+
+	void TestConverters()
+	{
+		for (const auto text : { "true", "TRUE", "yes", "1", "on", "Enabled" }) {
+			CHECK(ParseIniBool(text, false));
+		}
+		for (const auto text : { "false", "No", "0", "off", "DISABLED" }) {
+			CHECK(!ParseIniBool(text, true));
+		}
+		CHECK(ParseIniBool("maybe", true));
+		CHECK(!ParseIniBool("", false));
+		CHECK(ParseIniBool(" true", true));  // Values are trimmed by the parser, not here
+
+		CHECK(ParseIniFloat("30", 0.0f) == 30.0f);
+		CHECK(ParseIniFloat("+30", 0.0f) == 30.0f);
+		CHECK(ParseIniFloat("-2.5", 0.0f) == -2.5f);
+		CHECK(ParseIniFloat("30 degrees", 0.0f) == 30.0f);
+		CHECK(ParseIniFloat("1e3", 0.0f) == 1000.0f);
+		CHECK(ParseIniFloat(".5", 0.0f) == 0.5f);
+		CHECK(ParseIniFloat("abc", 7.0f) == 7.0f);
+		CHECK(ParseIniFloat("", 7.0f) == 7.0f);
+		CHECK(ParseIniFloat("+", 7.0f) == 7.0f);
+		CHECK(ParseIniFloat("++1", 7.0f) == 7.0f);
+		CHECK(std::isinf(ParseIniFloat("inf", 0.0f)));
+		CHECK(std::isnan(ParseIniFloat("nan", 0.0f)));
+		CHECK(ParseIniFloat("1e99", 7.0f) == 7.0f);  // Out of range: the default
+
+		CHECK(CompareIgnoreCase("abc", "ABD") < 0);
+		CHECK(CompareIgnoreCase("abc", "AB") > 0);
+		CHECK(CompareIgnoreCase("", "") == 0);
+		CHECK(EqualsIgnoreCase("fMaxGreetingDistance", "FMAXGREETINGDISTANCE"));
+		CHECK(!EqualsIgnoreCase("a", "ab"));
+	}
+
+	void TestLoad()
+	{
+		const auto path = std::filesystem::temp_directory_path() / "tyf-inifile-test.ini";
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file << "[Main]\r\nfMaxDeviationAngle = 42\r\n";
+		}
+
+		auto ini = IniFile::Load(path.string().c_str());
+		CHECK(ini.has_value());
+		CHECK(ini && ini->GetFloat("Main", "fMaxDeviationAngle", 0.0f) == 42.0f);
+		CHECK(ini && ini->GetEntries()[0].line == 2);
+
+		// The document owns its text - moving it keeps every view valid
+		std::optional<IniFile> moved;
+		if (ini) {
+			moved.emplace(std::move(*ini));
+		}
+		CHECK(moved && moved->GetString("main", "FMAXDEVIATIONANGLE", "") == "42");
+
+		std::filesystem::remove(path);
+		CHECK(!IniFile::Load(path.string().c_str()).has_value());
+	}
+
+	/**
+	 * Builds a document from fragments that exercise every rule.
+	 */
+	std::string MakeDocument(test::Random& random)
+	{
+		static constexpr std::string_view fragments[] = {
+			"[Main]", "[main]", "[ Distance ]", "[Broken", "[]", "[a]b]", "[", "]",
+			"fMaxDeviationAngle", "FMAXDEVIATIONANGLE", "sFilterMode", "key", "KEY", "k",
+			" = ", "=", "==", " ", "\t", "\r", "\v", ";", "#", "\"", "'", "\"quoted\"", "'x'",
+			"30", "+30", "-1.5", "1e3", "abc", "\xEF\xBB\xBF", std::string_view("\0", 1), "\xFF",
+		};
+
+		std::string document;
+		if (random.NextBits() % 8 == 0) {
+			document += "\xEF\xBB\xBF";
+		}
+		const std::size_t lines = random.NextBits() % 24;
+		for (std::size_t i = 0; i < lines; ++i) {
+			const std::size_t parts = random.NextBits() % 6;
+			for (std::size_t j = 0; j < parts; ++j) {
+				document += fragments[random.NextBits() % std::size(fragments)];
+			}
+			document += random.NextBits() % 3 ? "\n" : "\r\n";
+		}
+		if (!document.empty() && random.NextBits() % 2) {
+			document.pop_back();  // No final newline
+		}
+		return document;
+	}
+
+	std::string MakeBytes(test::Random& random)
+	{
+		static constexpr char alphabet[] = "[]=;#\"' \t\r\n\vabAB01.+-";
+		std::string bytes(random.NextBits() % 256, '\0');
+		for (auto& c : bytes) {
+			c = random.NextBits() % 4 ? alphabet[random.NextBits() % (sizeof(alphabet) - 1)] : static_cast<char>(random.NextBits());
+		}
+		return bytes;
+	}
+
+	void TestDifferential(std::size_t documents)
+	{
+		test::Random random;
+		std::size_t mismatches = 0;
+		std::size_t entries = 0;
+
+		for (std::size_t i = 0; i < documents; ++i) {
+			const std::string document = i % 2 ? MakeDocument(random) : MakeBytes(random);
+			const IniFile ini = IniFile::Parse(document);
+			std::string difference;
+			if (!ini_reference::Matches(ini, document, difference)) {
+				if (mismatches++ < 5) {
+					std::printf("  mismatch (%s) on: ", difference.c_str());
+					for (const char c : document) {
+						std::printf(c >= 0x20 && c < 0x7F ? "%c" : "\\x%02X", static_cast<unsigned char>(c));
+					}
+					std::printf("\n");
+				}
+			}
+			entries += ini.GetEntries().size();
+		}
+
+		CHECK(mismatches == 0);
+		std::printf("  %zu documents (%zu entries): parser agrees with the reference\n", documents, entries);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = test::IsQuick(argc, argv);
+
+	TestRules();
+	TestConverters();
+	TestLoad();
+	TestDifferential(quick ? 20'000 : 2'000'000);
+
+	return test::Finish("IniFileTest");
+}
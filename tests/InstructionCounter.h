@@ -0,0 +1,83 @@
+#pragma once
+
+/**
+ * InstructionCounter.h - Instructions retired by the calling thread
+ *
+ * Reads the CPU's retired-instruction counter through perf_event_open
+ * (Linux, user space only). Unlike a timer it does not depend on the clock
+ * speed, other load on the machine or the VM's scheduling, so it makes a
+ * stable regression number. Unavailable elsewhere, in VMs without a virtual
+ * PMU and when perf_event_paranoid forbids it; callers print "n/a" then.
+ */
+
+#include <cstdint>
+
+#if defined(__linux__)
+#	include <cstring>
+#	include <linux/perf_event.h>
+#	include <sys/ioctl.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
+namespace test
+{
+	class InstructionCounter
+	{
+	public:
+		InstructionCounter(const InstructionCounter&) = delete;
+		InstructionCounter& operator=(const InstructionCounter&) = delete;
+
+#if defined(__linux__)
+		InstructionCounter()
+		{
+			perf_event_attr attr;
+			std::memset(&attr, 0, sizeof(attr));
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.size = sizeof(attr);
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+			attr.disabled = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+		}
+
+		~InstructionCounter()
+		{
+			if (fd >= 0) {
+				close(fd);
+			}
+		}
+
+		bool IsAvailable() const { return fd >= 0; }
+
+		void Start()
+		{
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+
+		/**
+		 * @return Instructions retired since Start()
+		 */
+		std::uint64_t Stop()
+		{
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			std::uint64_t count = 0;
+			if (read(fd, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count))) {
+				return 0;
+			}
+			return count;
+		}
+
+	private:
+		int fd = -1;
+#else
+		InstructionCounter() = default;
+
+		bool IsAvailable() const { return false; }
+		void Start() {}
+		std::uint64_t Stop() { return 0; }
+#endif
+	};
+}
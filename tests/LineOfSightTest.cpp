@@ -0,0 +1,249 @@
+/**
+ * LineOfSightTest.cpp - LineOfSightScheduler against a mock raycast and a synthetic clock
+ *
+ * The raycast is a counting callable with a scripted answer, so every check
+ * can tell whether the scheduler cast a ray, served the cache or deferred:
+ *   - a result is cached for the TTL while the NPC stays in its grid cell,
+ *     and cast again once the TTL ends or the NPC moves a cell
+ *   - an entry refreshed 33-43 s ago is stale (the 2^15 ms timestamp used to
+ *     wrap there), and so is one refreshed exactly one timestamp wrap ago
+ *   - the budget allows raycastBudget casts per window, all actors and
+ *     threads together; over budget the last known result (or visible) is kept
+ *   - actors sharing a probe sequence, stale slots are reused, and a full
+ *     probe sequence only costs caching, never an answer
+ *
+ * Usage: LineOfSightTest [--quick]
+ */
+
+#include "LineOfSight.h"
+#include "TestSupport.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr LineOfSightSettings kSettings{ 4, 2000, 64.0f };  // 4 raycasts per window, 2 s TTL, 64 unit grid
+
+	// Timestamp range of a cache entry: 2^19 budget windows
+	constexpr std::uint64_t kWrapMilliseconds = (1ull << 19) * kLineOfSightWindowMilliseconds;
+
+	/**
+	 * Raycast stand-in: answers `visible` and counts its calls.
+	 */
+	struct MockRaycast
+	{
+		bool visible = true;
+		std::size_t calls = 0;
+
+		auto operator()()
+		{
+			return [this] {
+				++calls;
+				return visible;
+			};
+		}
+	};
+
+	LineOfSightResult Check(LineOfSightScheduler& scheduler, MockRaycast& ray, std::uint32_t actorID, std::uint64_t now,
+		float dx = 100.0f, const LineOfSightSettings& settings = kSettings)
+	{
+		return scheduler.Check(actorID, dx, 50.0f, 0.0f, now, settings, ray());
+	}
+
+	void TestCache()
+	{
+		auto scheduler = std::make_unique<LineOfSightScheduler>();
+		MockRaycast ray;
+		constexpr std::uint64_t start = 1'000'000;
+
+		ray.visible = false;
+		LineOfSightResult result = Check(*scheduler, ray, 0x14, start);
+		CHECK(result.source == LineOfSightSource::Raycast && !result.visible);
+		CHECK(ray.calls == 1);
+
+		// Same cell within the TTL: the cached answer, even if the world changed
+		ray.visible = true;
+		result = Check(*scheduler, ray, 0x14, start + 1000, 110.0f);
+		CHECK(result.source == LineOfSightSource::Cached && !result.visible);
+		CHECK(ray.calls == 1);
+
+		// Another grid cell: cast again
+		result = Check(*scheduler, ray, 0x14, start + 1100, 100.0f + kSettings.moveTolerance);
+		CHECK(result.source == LineOfSightSource::Raycast && result.visible);
+		CHECK(ray.calls == 2);
+
+		// The TTL ends
+		result = Check(*scheduler, ray, 0x14, start + 1100 + kSettings.cacheMilliseconds + kLineOfSightWindowMilliseconds, 100.0f + kSettings.moveTolerance);
+		CHECK(result.source == LineOfSightSource::Raycast);
+		CHECK(ray.calls == 3);
+
+		// Other actors have their own entries
+		result = Check(*scheduler, ray, 0x15, start + 5000);
+		CHECK(result.source == LineOfSightSource::Raycast);
+
+		// TTL 0 caches nothing
+		const LineOfSightSettings uncached{ 4, 0, 64.0f };
+		Check(*scheduler, ray, 0x16, start + 6000, 100.0f, uncached);
+		result = Check(*scheduler, ray, 0x16, start + 6000 + kLineOfSightWindowMilliseconds, 100.0f, uncached);
+		CHECK(result.source == LineOfSightSource::Raycast);
+
+		// Clear() forgets every actor
+		Check(*scheduler, ray, 0x17, start + 7000);
+		scheduler->Clear();
+		result = Check(*scheduler, ray, 0x17, start + 7000 + kLineOfSightWindowMilliseconds);
+		CHECK(result.source == LineOfSightSource::Raycast);
+	}
+
+	void TestTimestampWrap()
+	{
+		// Entries refreshed 33-43 s ago, where the 15-bit millisecond timestamp wrapped
+		std::size_t cached = 0;
+		for (std::uint64_t ago = 33'000; ago <= 43'000; ago += 250) {
+			auto scheduler = std::make_unique<LineOfSightScheduler>();
+			MockRaycast ray;
+			const std::uint64_t refreshed = 5'000'000;
+			Check(*scheduler, ray, 0x20, refreshed);
+			cached += Check(*scheduler, ray, 0x20, refreshed + ago).source == LineOfSightSource::Cached ? 1 : 0;
+		}
+		CHECK(cached == 0);
+
+		// Exactly one wrap of the current timestamp (and a bit), from anywhere in a period
+		std::size_t aliased = 0;
+		for (const std::uint64_t refreshed : { std::uint64_t{ 0 }, kWrapMilliseconds / 2, kWrapMilliseconds - kLineOfSightWindowMilliseconds, 3 * kWrapMilliseconds + 12'345 }) {
+			for (const std::uint64_t extra : { std::uint64_t{ 0 }, std::uint64_t{ 16 }, std::uint64_t{ 1000 } }) {
+				auto scheduler = std::make_unique<LineOfSightScheduler>();
+				MockRaycast ray;
+				Check(*scheduler, ray, 0x21, refreshed);
+				aliased += Check(*scheduler, ray, 0x21, refreshed + kWrapMilliseconds + extra).source == LineOfSightSource::Cached ? 1 : 0;
+			}
+		}
+		CHECK(aliased == 0);
+
+		// A period change keeps working: fresh entries after it are cached again
+		auto scheduler = std::make_unique<LineOfSightScheduler>();
+		MockRaycast ray;
+		Check(*scheduler, ray, 0x22, kWrapMilliseconds - 100);
+		Check(*scheduler, ray, 0x22, kWrapMilliseconds + 100);
+		CHECK(Check(*scheduler, ray, 0x22, kWrapMilliseconds + 500).source == LineOfSightSource::Cached);
+		std::printf("  entries refreshed 33-43 s ago: %zu cached; one wrap (%.1f h) ago: %zu cached\n",
+			cached, static_cast<double>(kWrapMilliseconds) / 3.6e6, aliased);
+	}
+
+	void TestBudget()
+	{
+		auto scheduler = std::make_unique<LineOfSightScheduler>();
+		MockRaycast ray;
+		const std::uint64_t window = 2'000 * kLineOfSightWindowMilliseconds;
+
+		// Ten new actors in one window: four raycasts, the rest keep the filter's decision
+		ray.visible = false;
+		std::size_t raycasts = 0, deferred = 0;
+		for (std::uint32_t actor = 0x100; actor < 0x10A; ++actor) {
+			const LineOfSightResult result = Check(*scheduler, ray, actor, window + 3);
+			raycasts += result.source == LineOfSightSource::Raycast ? 1 : 0;
+			if (result.source == LineOfSightSource::Deferred) {
+				++deferred;
+				CHECK(result.visible);  // Never checked: visible
+			}
+		}
+		CHECK(raycasts == kSettings.raycastBudget);
+		CHECK(deferred == 10 - kSettings.raycastBudget);
+		CHECK(ray.calls == kSettings.raycastBudget);
+
+		// The next window has a new budget
+		const LineOfSightResult next = Check(*scheduler, ray, 0x109, window + kLineOfSightWindowMilliseconds);
+		CHECK(next.source == LineOfSightSource::Raycast);
+
+		// Over budget with a stale result: the stale result, not "visible"
+		for (std::uint32_t actor = 0x200; actor < 0x204; ++actor) {
+			Check(*scheduler, ray, actor, window + 100 * kLineOfSightWindowMilliseconds);
+		}
+		const std::uint64_t later = window + 100 * kLineOfSightWindowMilliseconds + kSettings.cacheMilliseconds + 100;
+		for (std::uint32_t actor = 0x300; actor < 0x304; ++actor) {
+			Check(*scheduler, ray, actor, later);  // Use up the window
+		}
+		const LineOfSightResult stale = Check(*scheduler, ray, 0x200, later);
+		CHECK(stale.source == LineOfSightSource::Deferred && !stale.visible);
+	}
+
+	void TestProbeSequence()
+	{
+		// Actors whose hash lands on the same slot
+		std::vector<std::uint32_t> colliding;
+		const std::uint32_t target = (0x1000u * 0x9E3779B1u) >> 20;
+		for (std::uint32_t id = 0x1000; colliding.size() < LineOfSightScheduler::kMaxProbe + 2; ++id) {
+			if (((id * 0x9E3779B1u) >> 20) == target) {
+				colliding.push_back(id);
+			}
+		}
+
+		auto scheduler = std::make_unique<LineOfSightScheduler>();
+		MockRaycast ray;
+		const LineOfSightSettings unlimited{ 1000, 2000, 64.0f };
+		const std::uint64_t now = 10'000'000;
+
+		for (const std::uint32_t id : colliding) {
+			Check(*scheduler, ray, id, now, 100.0f, unlimited);
+		}
+		std::size_t cached = 0;
+		for (const std::uint32_t id : colliding) {
+			const LineOfSightResult result = Check(*scheduler, ray, id, now + 100, 100.0f, unlimited);
+			cached += result.source == LineOfSightSource::Cached ? 1 : 0;
+			CHECK(result.visible);
+		}
+		CHECK(cached == LineOfSightScheduler::kMaxProbe);  // The rest have no slot left, and are cast every time
+
+		// Once the entries are stale their slots are reused
+		const std::uint64_t later = now + unlimited.cacheMilliseconds + 100;
+		Check(*scheduler, ray, colliding.back(), later, 100.0f, unlimited);
+		CHECK(Check(*scheduler, ray, colliding.back(), later + 100, 100.0f, unlimited).source == LineOfSightSource::Cached);
+	}
+
+	void TestConcurrentBudget(std::size_t windows, std::size_t threadCount)
+	{
+		auto scheduler = std::make_unique<LineOfSightScheduler>();
+		std::atomic<std::size_t> raycasts{ 0 };
+
+		std::vector<std::thread> threads;
+		for (std::size_t t = 0; t < threadCount; ++t) {
+			threads.emplace_back([&, t] {
+				for (std::size_t w = 0; w < windows; ++w) {
+					for (std::uint32_t i = 0; i < 8; ++i) {
+						// A new actor per call, so nothing is served from the cache
+						const auto actor = static_cast<std::uint32_t>(1 + (w * threadCount + t) * 8 + i);
+						const LineOfSightResult result = scheduler->Check(actor, 100.0f, 0.0f, 0.0f,
+							w * kLineOfSightWindowMilliseconds, kSettings, [] { return true; });
+						raycasts += result.source == LineOfSightSource::Raycast ? 1 : 0;
+					}
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		// Threads run through the windows at their own pace: a thread behind the
+		// others spends the newest window's budget, so a window may go unused,
+		// but no more than the budget per window is spent in total
+		CHECK(raycasts <= windows * kSettings.raycastBudget);
+		CHECK(raycasts > 0);
+		std::printf("  %zu threads, %zu windows: %zu raycasts (budget %zu)\n", threadCount, windows, raycasts.load(),
+			windows * kSettings.raycastBudget);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = test::IsQuick(argc, argv);
+
+	TestCache();
+	TestTimestampWrap();
+	TestBudget();
+	TestProbeSequence();
+	TestConcurrentBudget(quick ? 2'000 : 200'000, 4);
+
+	return test::Finish("LineOfSightTest");
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+/**
+ * MockWorld.h - Synthetic player, NPCs and filter parameters for tests/
+ *
+ * Stands in for the game side of AllowComment: a player with a yaw and pitch,
+ * a crowd of NPCs around it, and filter parameters built with the same
+ * helpers BuildConfiguration uses (MakeCategoryThresholds, BuildDecisionTable).
+ * Queries are gathered the way AllowComment gathers them, then decided with
+ * the real DecideComment / LookupDecision from src/FilterCore.cpp.
+ */
+
+#include "FilterCore.h"
+#include "FilterExpression.h"
+#include "TestSupport.h"
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mock
+{
+	// Plugin defaults (config/to-your-face-reloaded.ini)
+	inline constexpr float kDefaultAngleDegrees = 30.0f;
+	inline constexpr float kDefaultGreetingDistance = 150.0f;
+	inline constexpr float kDefaultCloseRange = 50.0f;
+	inline constexpr std::string_view kDefaultExpression = "dist < 150 && (angle < 30 || dist < 50) && !inCombat";
+
+	// Camera used for Frustum mode: Skyrim's default 75 degree horizontal FOV at 16:9
+	inline constexpr float kHorizontalFov = 75.0f * pi / 180.0f;
+	inline constexpr float kAspect = 16.0f / 9.0f;
+	inline constexpr float kNearPlane = 15.0f;
+	inline constexpr float kFarPlane = 10000.0f;
+
+	struct Player
+	{
+		float x;
+		float y;
+		float z;
+		float yaw;    // Radians, 0 = +Y, clockwise
+		float pitch;  // Radians, positive = looking down
+		bool sneaking;
+	};
+
+	struct Npc
+	{
+		float x;
+		float y;
+		float z;
+		std::uint8_t category;
+		bool inCombat;
+	};
+
+	/**
+	 * NPCs scattered around the origin with a squared falloff (most far away,
+	 * some close), as in a crowded exterior cell - the PgoTraining distribution.
+	 *
+	 * @param count Number of NPCs
+	 * @param radius Maximum distance in game units
+	 * @param categories Categories are assigned round-robin over 0..categories-1
+	 */
+	inline std::vector<Npc> MakeCrowd(std::size_t count, float radius, std::size_t categories, test::Random& random)
+	{
+		std::vector<Npc> crowd(count);
+		for (std::size_t i = 0; i < count; ++i) {
+			const float bearing = random.Next() * 2.0f * pi;
+			const float distance = radius * random.Next() * random.Next();
+			crowd[i] = { std::sin(bearing) * distance, std::cos(bearing) * distance, (random.Next() - 0.5f) * 200.0f,
+				static_cast<std::uint8_t>(i % categories), random.Next() < 0.05f };
+		}
+		return crowd;
+	}
+
+	/**
+	 * Filter parameters plus everything they point to.
+	 */
+	struct Filter
+	{
+		FilterParameters params{};
+		std::unique_ptr<FilterExpression> expression;
+		std::vector<DecisionTable> tables;
+	};
+
+	/**
+	 * Builds filter parameters for a mode with the plugin defaults. Categories
+	 * 1..3 get progressively wider thresholds, like typical [Category:*] rules.
+	 *
+	 * @param decisionTable Build decision tables (only for modes that support
+	 *        them, and not with viewCone3D - as BuildConfiguration does)
+	 * @param viewCone3D b3DViewCone: MakeQuery gathers the 3D facing test
+	 */
+	inline std::unique_ptr<Filter> MakeFilter(FilterMode mode, bool decisionTable, bool viewCone3D = false,
+		std::string_view expression = kDefaultExpression)
+	{
+		auto filter = std::make_unique<Filter>();
+		FilterParameters& params = filter->params;
+		params.filterMode = mode;
+		params.Set(FilterFlag::CloseRangeBypass, true);
+		params.Set(FilterFlag::ViewCone3D, viewCone3D);
+
+		if (mode == FilterMode::Expression) {
+			std::string error;
+			filter->expression = FilterExpression::Compile(expression, error);
+			params.filterExpression = filter->expression.get();
+		}
+
+		for (std::size_t i = 0; i < kMaxActorCategories; ++i) {
+			const float scale = 1.0f + 0.5f * static_cast<float>(i % 4);
+			params.categories[i] = MakeCategoryThresholds(params, kDefaultAngleDegrees * scale * pi / 180.0f,
+				kDefaultGreetingDistance * scale, kDefaultCloseRange * scale);
+		}
+
+		if (decisionTable && !viewCone3D && SupportsDecisionTable(mode)) {
+			filter->tables.resize(kMaxActorCategories);
+			for (std::size_t i = 0; i < kMaxActorCategories; ++i) {
+				BuildDecisionTable(params, params.categories[i], filter->tables[i]);
+			}
+			params.decisionTables = filter->tables.data();
+			params.Set(FilterFlag::DecisionTable, true);
+		}
+
+		return filter;
+	}
+
+	/**
+	 * Row-major D3D-style world-to-clip matrix for a camera at the player's
+	 * eyes looking along yaw/pitch (0 <= z <= w inside, as ExtractFrustumPlanes expects).
+	 */
+	inline void MakeViewProjection(const Player& player, float eyeHeight, float (&m)[4][4])
+	{
+		const PlayerFacing facing = MakePlayerFacing(player.yaw, player.pitch);
+		const float forward[3] = { facing.viewX, facing.viewY, facing.viewZ };
+		const float right[3] = { facing.forwardY, -facing.forwardX, 0.0f };
+		const float up[3] = {  // right x forward
+			right[1] * forward[2] - right[2] * forward[1],
+			right[2] * forward[0] - right[0] * forward[2],
+			right[0] * forward[1] - right[1] * forward[0]
+		};
+		const float eye[3] = { player.x, player.y, player.z + eyeHeight };
+
+		const float scaleX = 1.0f / std::tan(kHorizontalFov * 0.5f);
+		const float scaleY = scaleX * kAspect;
+		const float depthScale = kFarPlane / (kFarPlane - kNearPlane);
+
+		auto row = [&](float (&out)[4], const float (&axis)[3], float scale, float offset) {
+			for (int i = 0; i < 3; ++i) {
+				out[i] = axis[i] * scale;
+			}
+			out[3] = -(axis[0] * eye[0] + axis[1] * eye[1] + axis[2] * eye[2]) * scale + offset;
+		};
+		row(m[0], right, scaleX, 0.0f);
+		row(m[1], up, scaleY, 0.0f);
+		row(m[2], forward, depthScale, -kNearPlane * depthScale);
+		row(m[3], forward, 1.0f, 0.0f);
+	}
+
+	/**
+	 * Gathers the query for one NPC the way AllowComment does.
+	 *
+	 * @param frustum Camera frustum for Frustum mode (nullptr = no camera)
+	 */
+	inline CommentQuery MakeQuery(const FilterParameters& filter, const Player& player, const PlayerFacing& facing,
+		const Npc& npc, const FrustumPlanes* frustum)
+	{
+		CommentQuery query{
+			npc.x - player.x,
+			npc.y - player.y,
+			npc.z - player.z,
+			facing.yaw, facing.forwardX, facing.forwardY, 0.0f, 0.0f,
+			false, false,
+			nullptr, 0.0f, 0.0f, 0.0f
+		};
+		if (filter.Has(FilterFlag::ViewCone3D)) {
+			query.forwardX = facing.viewX;
+			query.forwardY = facing.viewY;
+			query.forwardZ = facing.viewZ;
+			query.viewDz = query.dz;  // Same race, eye heights cancel
+		}
+		if (filter.filterMode == FilterMode::Expression && filter.filterExpression) {
+			query.npcInCombat = filter.filterExpression->Uses(FilterVariable::InCombat) && npc.inCombat;
+			query.playerSneaking = filter.filterExpression->Uses(FilterVariable::Sneaking) && player.sneaking;
+		} else if (filter.filterMode == FilterMode::Frustum) {
+			query.frustum = frustum;
+			query.headX = npc.x;
+			query.headY = npc.y;
+			query.headZ = npc.z + kFrustumHeadHeight;
+		}
+		return query;
+	}
+
+	/**
+	 * The decision step of AllowComment: table lookup first, exact decision otherwise.
+	 */
+	inline CommentDecision Decide(const FilterParameters& filter, std::uint8_t category, const CommentQuery& query)
+	{
+		CommentDecision decision;
+		if (!filter.Has(FilterFlag::DecisionTable) || !LookupDecision(filter.decisionTables[category], query, decision)) {
+			decision = DecideComment(filter, filter.categories[category], query);
+		}
+		return decision;
+	}
+}
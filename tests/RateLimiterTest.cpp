@@ -0,0 +1,182 @@
+/**
+ * RateLimiterTest.cpp - CommentTokenBucket and CommentCooldowns against a synthetic clock
+ *
+ * Token bucket (GCRA):
+ *   - a full bucket allows a burst of fCommentsPerSecond (at least one), then
+ *     one comment per emission interval
+ *   - over a long run the allowed rate converges on fCommentsPerSecond
+ *   - a throttled call changes nothing
+ *   - threads taking tokens at the same instant get exactly the burst
+ * Cooldown table:
+ *   - an NPC that commented is cooling down for fNPCCooldown, then free
+ *   - actors sharing a probe sequence; a full sequence leaves the NPC
+ *     unlimited rather than failing, and expired slots are reused
+ *
+ * Usage: RateLimiterTest [--quick]
+ */
+
+#include "RateLimiter.h"
+#include "TestSupport.h"
+
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr std::uint64_t kMicrosecondsPerSecond = 1'000'000;
+
+	void TestBurstAndRefill()
+	{
+		CommentTokenBucket bucket;
+		const std::uint64_t start = 100 * kMicrosecondsPerSecond;
+
+		// Two per second: a burst of two, then one every 500 ms
+		CHECK(bucket.TryTake(start, 2.0f));
+		CHECK(bucket.TryTake(start, 2.0f));
+		CHECK(!bucket.TryTake(start, 2.0f));
+		CHECK(!bucket.TryTake(start + 499'999, 2.0f));
+		CHECK(bucket.TryTake(start + 500'000, 2.0f));
+		CHECK(!bucket.TryTake(start + 500'000, 2.0f));
+
+		// Refused calls did not push the next token back
+		CHECK(bucket.TryTake(start + 1'000'000, 2.0f));
+
+		// An idle bucket refills to the burst, not beyond
+		const std::uint64_t idle = start + 60 * kMicrosecondsPerSecond;
+		CHECK(bucket.TryTake(idle, 2.0f));
+		CHECK(bucket.TryTake(idle, 2.0f));
+		CHECK(!bucket.TryTake(idle, 2.0f));
+
+		// Below one per second the burst is still one comment
+		CommentTokenBucket slow;
+		CHECK(slow.TryTake(start, 0.5f));
+		CHECK(!slow.TryTake(start + 1'999'999, 0.5f));
+		CHECK(slow.TryTake(start + 2'000'000, 0.5f));
+	}
+
+	void TestLongRunRate(std::uint64_t seconds)
+	{
+		// Attempts every 10 ms (as often as NPCs try in a crowd) for a while
+		for (const float rate : { 0.2f, 1.0f, 3.0f, 10.0f, 50.0f }) {
+			CommentTokenBucket bucket;
+			std::uint64_t allowed = 0;
+			for (std::uint64_t t = 0; t < seconds * kMicrosecondsPerSecond; t += 10'000) {
+				allowed += bucket.TryTake(kMicrosecondsPerSecond + t, rate) ? 1 : 0;
+			}
+			const double expected = static_cast<double>(rate) * static_cast<double>(seconds) + std::max(1.0, std::floor(static_cast<double>(rate)));
+			CHECK(std::fabs(static_cast<double>(allowed) - expected) <= 0.01 * expected + 2.0);
+			std::printf("  %5.1f/s over %llu s: %llu allowed (expected %.0f)\n", rate,
+				static_cast<unsigned long long>(seconds), static_cast<unsigned long long>(allowed), expected);
+		}
+	}
+
+	void TestConcurrentBurst(std::size_t rounds, std::size_t threadCount)
+	{
+		// Every round all threads race for tokens at the same instant, one
+		// second after the last: exactly the burst goes through per round
+		constexpr float kRate = 5.0f;
+		CommentTokenBucket bucket;
+		std::atomic<std::size_t> arrived{ 0 };
+		std::atomic<std::size_t> taken{ 0 };
+		std::atomic<std::size_t> wrongRounds{ 0 };
+		std::vector<std::atomic<std::size_t>> perRound(rounds);
+
+		std::vector<std::thread> threads;
+		for (std::size_t t = 0; t < threadCount; ++t) {
+			threads.emplace_back([&] {
+				for (std::size_t round = 0; round < rounds; ++round) {
+					const std::uint64_t now = (round + 1) * 10 * kMicrosecondsPerSecond;
+					for (int attempt = 0; attempt < 4; ++attempt) {
+						if (bucket.TryTake(now, kRate)) {
+							++perRound[round];
+							++taken;
+						}
+					}
+					// Wait for every thread before the next round
+					++arrived;
+					while (arrived.load() < (round + 1) * threadCount) {
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		for (const auto& count : perRound) {
+			wrongRounds += count.load() != static_cast<std::size_t>(kRate) ? 1 : 0;
+		}
+		CHECK(wrongRounds == 0);
+		std::printf("  %zu threads, %zu rounds: %zu tokens taken (burst %.0f per round)\n", threadCount, rounds, taken.load(), kRate);
+	}
+
+	void TestCooldowns()
+	{
+		auto cooldowns = std::make_unique<CommentCooldowns>();
+		constexpr std::uint32_t kCooldown = 30'000;
+		const std::uint64_t start = 7'000'000;
+
+		CHECK(!cooldowns->IsCoolingDown(0x40, start, kCooldown));
+		cooldowns->RecordComment(0x40, start, kCooldown);
+		CHECK(cooldowns->IsCoolingDown(0x40, start, kCooldown));
+		CHECK(cooldowns->IsCoolingDown(0x40, start + kCooldown - 1, kCooldown));
+		CHECK(!cooldowns->IsCoolingDown(0x40, start + kCooldown, kCooldown));
+		CHECK(!cooldowns->IsCoolingDown(0x41, start, kCooldown));  // Only that NPC
+
+		// A new comment restarts the cooldown
+		cooldowns->RecordComment(0x40, start + kCooldown, kCooldown);
+		CHECK(cooldowns->IsCoolingDown(0x40, start + kCooldown + 1000, kCooldown));
+
+		// A shorter fNPCCooldown applies at once to existing entries
+		CHECK(!cooldowns->IsCoolingDown(0x40, start + kCooldown + 1000, 500));
+
+		cooldowns->Clear();
+		CHECK(!cooldowns->IsCoolingDown(0x40, start + kCooldown + 1000, kCooldown));
+	}
+
+	void TestCooldownProbeSequence()
+	{
+		// Actors whose hash lands on the same slot
+		std::vector<std::uint32_t> colliding;
+		const std::uint32_t target = (0x3000u * 0x9E3779B1u) >> 20;
+		for (std::uint32_t id = 0x3000; colliding.size() < CommentCooldowns::kMaxProbe + 1; ++id) {
+			if (((id * 0x9E3779B1u) >> 20) == target) {
+				colliding.push_back(id);
+			}
+		}
+
+		auto cooldowns = std::make_unique<CommentCooldowns>();
+		constexpr std::uint32_t kCooldown = 10'000;
+		const std::uint64_t start = 9'000'000;
+		for (const std::uint32_t id : colliding) {
+			cooldowns->RecordComment(id, start, kCooldown);
+		}
+		std::size_t cooling = 0;
+		for (const std::uint32_t id : colliding) {
+			cooling += cooldowns->IsCoolingDown(id, start + 1, kCooldown) ? 1 : 0;
+		}
+		CHECK(cooling == CommentCooldowns::kMaxProbe);  // The last one went unrecorded: not limited
+
+		// Expired entries make room
+		const std::uint64_t later = start + kCooldown;
+		cooldowns->RecordComment(colliding.back(), later, kCooldown);
+		CHECK(cooldowns->IsCoolingDown(colliding.back(), later + 1, kCooldown));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = test::IsQuick(argc, argv);
+
+	TestBurstAndRefill();
+	TestLongRunRate(quick ? 100 : 10'000);
+	TestConcurrentBurst(quick ? 500 : 50'000, 4);
+	TestCooldowns();
+	TestCooldownProbeSequence();
+
+	return test::Finish("RateLimiterTest");
+}
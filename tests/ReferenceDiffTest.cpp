@@ -0,0 +1,295 @@
+/**
+ * ReferenceDiffTest.cpp - DecideComment against the original plugin's angle test
+ *
+ * The offline counterpart of [Debug] bReferenceCheck: drives AngleOnly
+ * DecideComment (dot product against the precomputed cosine) and
+ * DecideCommentReference (the original atan2 deviation test) with synthetic
+ * queries and compares every decision. Query classes:
+ *   - crowd    NPCs scattered around the player, any yaw
+ *   - boundary NPCs at the configured angle plus/minus 1e-7 to 1e-2 radians
+ *   - wrap     bearings and yaws on both sides of 0 / 2*pi
+ *   - overhead NPC at the player's XY (no direction: documented difference)
+ * A differing decision is only accepted within kBoundaryTolerance of the
+ * configured angle; the largest such margin is printed. The original wraps
+ * its angles with pi = 3.1415 (FilterParameters.h), which moves its boundary
+ * by up to 2 * (pi - 3.1415) = 1.85e-4 radians on one side of the player;
+ * float rounding of atan2 versus the dot product adds a few 1e-7.
+ * The same classes then go through b3DViewCone's query with forwardZ =
+ * viewDz = 0 (no pitch, NPC head at eye level) in the modes with an angle
+ * test; the decision must be exactly the flat one, as both share one dot
+ * product. Then both are timed over the crowd class, with instructions retired per
+ * call where the CPU counter is available.
+ *
+ * Usage: ReferenceDiffTest [--quick]
+ */
+
+#include "InstructionCounter.h"
+#include "MockWorld.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	// The original's truncated pi plus float rounding; differing decisions
+	// further than this from the configured angle are bugs
+	constexpr double kTruncatedPiError = 3.14159265358979323846 - static_cast<double>(pi);
+	constexpr double kBoundaryTolerance = 2.0 * kTruncatedPiError + 1e-5;
+
+	constexpr std::array kAnglesDegrees = { 5.0f, 10.0f, 30.0f, 45.0f, 60.0f, 90.0f, 120.0f, 170.0f };
+	constexpr float kCrowdRadius = 4000.0f;
+
+	struct Case
+	{
+		CommentQuery query;
+		float maxDeviation;  // Radians, as the INI angle converts
+	};
+
+	CommentQuery MakeFlatQuery(float yaw, float dx, float dy, float dz)
+	{
+		const PlayerFacing facing = MakePlayerFacing(yaw, 0.0f);
+		return { dx, dy, dz, facing.yaw, facing.forwardX, facing.forwardY, 0.0f, 0.0f, false, false, nullptr, 0.0f, 0.0f, 0.0f };
+	}
+
+	/**
+	 * @return Deviation of the NPC from the facing in double precision (the exact answer)
+	 */
+	double GetExactDeviation(const CommentQuery& query)
+	{
+		constexpr double twoPi = 6.283185307179586;
+		double deviation = std::fabs(std::atan2(static_cast<double>(query.dx), static_cast<double>(query.dy)) - static_cast<double>(query.yaw));
+		deviation = std::fmod(deviation, twoPi);
+		return deviation > twoPi / 2.0 ? twoPi - deviation : deviation;
+	}
+
+	float RandomYaw(test::Random& random)
+	{
+		return random.Next() * 2.0f * pi;  // The game's rot.z range
+	}
+
+	void AddCrowd(std::vector<Case>& cases, std::size_t count, test::Random& random)
+	{
+		for (std::size_t i = 0; i < count; ++i) {
+			const float bearing = random.Next() * 2.0f * pi;
+			const float distance = 1.0f + kCrowdRadius * random.Next() * random.Next();
+			const float angle = kAnglesDegrees[i % kAnglesDegrees.size()] * pi / 180.0f;
+			cases.push_back({ MakeFlatQuery(RandomYaw(random), std::sin(bearing) * distance, std::cos(bearing) * distance,
+				(random.Next() - 0.5f) * 400.0f), angle });
+		}
+	}
+
+	void AddBoundary(std::vector<Case>& cases, std::size_t count, test::Random& random)
+	{
+		for (std::size_t i = 0; i < count; ++i) {
+			const float yaw = RandomYaw(random);
+			const float angle = kAnglesDegrees[i % kAnglesDegrees.size()] * pi / 180.0f;
+			const double offset = std::pow(10.0, -7.0 + 5.0 * random.Next()) * (random.NextBits() & 1 ? 1.0 : -1.0);
+			const double side = random.NextBits() & 2 ? 1.0 : -1.0;
+			const double bearing = yaw + side * (angle + offset);
+			const float distance = 10.0f + 2000.0f * random.Next();
+			cases.push_back({ MakeFlatQuery(yaw, static_cast<float>(std::sin(bearing) * distance),
+				static_cast<float>(std::cos(bearing) * distance), 0.0f), angle });
+		}
+	}
+
+	void AddWrap(std::vector<Case>& cases, std::size_t count, test::Random& random)
+	{
+		for (std::size_t i = 0; i < count; ++i) {
+			// Yaw just above 0 or just below 2*pi, NPC within a few degrees of the seam
+			const float yaw = random.NextBits() & 1 ? random.Next() * 0.05f : 2.0f * pi - random.Next() * 0.05f;
+			const float bearing = (random.Next() - 0.5f) * 0.5f;
+			const float distance = 10.0f + 1000.0f * random.Next();
+			const float angle = kAnglesDegrees[i % 3] * pi / 180.0f;  // Narrow cones straddle the seam
+			cases.push_back({ MakeFlatQuery(yaw, std::sin(bearing) * distance, std::cos(bearing) * distance, 0.0f), angle });
+		}
+	}
+
+	struct ClassResult
+	{
+		std::size_t compared = 0;
+		std::size_t differing = 0;
+		double largestMargin = 0.0;  // Of the differing decisions, distance from the configured angle
+		std::size_t beyondTolerance = 0;
+	};
+
+	ClassResult Compare(const std::vector<Case>& cases, const char* name)
+	{
+		auto filter = mock::MakeFilter(FilterMode::AngleOnly, false);
+		filter->params.Set(FilterFlag::CloseRangeBypass, false);  // Only angle decisions, as bReferenceCheck compares
+
+		ClassResult result;
+		for (const auto& c : cases) {
+			const CategoryThresholds thresholds = MakeCategoryThresholds(filter->params, c.maxDeviation, 1000.0f, 0.0f);
+			const CommentDecision decision = DecideComment(filter->params, thresholds, c.query);
+			if (decision.outcome != FilterOutcome::AllowFilter && decision.outcome != FilterOutcome::BlockFilter) {
+				continue;
+			}
+			++result.compared;
+			if (decision.allow == DecideCommentReference(c.query, c.maxDeviation)) {
+				continue;
+			}
+			++result.differing;
+			const double margin = std::fabs(GetExactDeviation(c.query) - static_cast<double>(c.maxDeviation));
+			result.largestMargin = std::max(result.largestMargin, margin);
+			if (margin > kBoundaryTolerance) {
+				if (result.beyondTolerance++ < 5) {
+					std::printf("  %s: dx=%.9g dy=%.9g yaw=%.9g max=%.9g -> current %s, original %s\n", name,
+						c.query.dx, c.query.dy, c.query.yaw, c.maxDeviation,
+						decision.allow ? "ALLOW" : "BLOCK", decision.allow ? "BLOCK" : "ALLOW");
+				}
+			}
+		}
+
+		std::printf("%-10s %10zu %10zu %14.3g\n", name, result.compared, result.differing, result.largestMargin);
+		return result;
+	}
+
+	/**
+	 * b3DViewCone with no pitch and the NPC's head at eye level: every field
+	 * of the decision must equal the flat one.
+	 */
+	void TestFlatViewCone(const std::vector<Case>& cases, const char* name)
+	{
+		constexpr std::array modes = { FilterMode::AngleOnly, FilterMode::Both, FilterMode::Either };
+
+		std::size_t compared = 0;
+		std::size_t differing = 0;
+		for (const FilterMode mode : modes) {
+			auto flat = mock::MakeFilter(mode, false);
+			auto cone = mock::MakeFilter(mode, false, true);
+			for (const auto& c : cases) {
+				const CategoryThresholds thresholds = MakeCategoryThresholds(flat->params, c.maxDeviation, 300.0f, 50.0f);
+
+				// What AllowComment gathers with b3DViewCone at pitch 0 and equal eye and head heights
+				const PlayerFacing facing = MakePlayerFacing(c.query.yaw, 0.0f);
+				CommentQuery query = c.query;
+				query.forwardX = facing.viewX;
+				query.forwardY = facing.viewY;
+				query.forwardZ = facing.viewZ;
+				query.viewDz = 0.0f;
+				CHECK(query.forwardZ == 0.0f && query.forwardX == c.query.forwardX && query.forwardY == c.query.forwardY);
+
+				const CommentDecision expected = DecideComment(flat->params, thresholds, c.query);
+				const CommentDecision decision = DecideComment(cone->params, thresholds, query);
+				++compared;
+				if (decision.allow != expected.allow || decision.outcome != expected.outcome || decision.reason != expected.reason ||
+					decision.distanceSquared != expected.distanceSquared) {
+					if (differing++ < 5) {
+						std::printf("  %s: dx=%.9g dy=%.9g yaw=%.9g -> flat %s, 3D cone %s\n", name, c.query.dx, c.query.dy, c.query.yaw,
+							expected.reason, decision.reason);
+					}
+				}
+			}
+		}
+
+		CHECK(differing == 0);
+		std::printf("%-10s %10zu %10zu  (b3DViewCone, forwardZ = viewDz = 0)\n", name, compared, differing);
+	}
+
+	void TestDifferential(std::size_t count)
+	{
+		test::Random random;
+		std::vector<Case> crowd, boundary, wrap;
+		AddCrowd(crowd, count, random);
+		AddBoundary(boundary, count, random);
+		AddWrap(wrap, count / 4, random);
+
+		std::printf("%-10s %10s %10s %14s  (tolerance %.3g)\n", "class", "compared", "differing", "largest margin", kBoundaryTolerance);
+		for (const auto& [cases, name] : { std::pair{ &crowd, "crowd" }, std::pair{ &boundary, "boundary" }, std::pair{ &wrap, "wrap" } }) {
+			const ClassResult result = Compare(*cases, name);
+			CHECK(result.compared > 0);
+			CHECK(result.beyondTolerance == 0);
+		}
+		for (const auto& [cases, name] : { std::pair{ &crowd, "crowd" }, std::pair{ &boundary, "boundary" }, std::pair{ &wrap, "wrap" } }) {
+			TestFlatViewCone(*cases, name);
+		}
+
+		// No direction to face: the dot product is 0 and never beats cos(max) * 0,
+		// the original measures the yaw against atan2(0, 0) = 0
+		auto filter = mock::MakeFilter(FilterMode::AngleOnly, false);
+		filter->params.Set(FilterFlag::CloseRangeBypass, false);
+		const float angle = 30.0f * pi / 180.0f;
+		const CategoryThresholds thresholds = MakeCategoryThresholds(filter->params, angle, 1000.0f, 0.0f);
+		const CommentQuery overhead = MakeFlatQuery(0.1f, 0.0f, 0.0f, 150.0f);
+		CHECK(DecideComment(filter->params, thresholds, overhead).outcome == FilterOutcome::BlockFilter);
+		CHECK(DecideCommentReference(overhead, angle));
+		std::printf("overhead   NPC at the player's XY: current BLOCK, original ALLOW for yaw < max (known difference)\n");
+	}
+
+	struct Timing
+	{
+		double nanosecondsPerCall;
+		double instructionsPerCall;  // < 0 if the counter is unavailable
+	};
+
+	template <class Decide>
+	Timing Measure(const std::vector<Case>& cases, std::size_t rounds, Decide decide)
+	{
+		test::InstructionCounter instructions;
+		std::uint64_t allowed = 0;
+		for (const auto& c : cases) {  // Warm up
+			allowed += decide(c) ? 1 : 0;
+		}
+
+		if (instructions.IsAvailable()) {
+			instructions.Start();
+		}
+		const auto start = test::Clock::now();
+		for (std::size_t round = 0; round < rounds; ++round) {
+			for (const auto& c : cases) {
+				allowed += decide(c) ? 1 : 0;
+			}
+		}
+		const double elapsed = test::ElapsedNanoseconds(start);
+		const std::uint64_t retired = instructions.IsAvailable() ? instructions.Stop() : 0;
+		test::Consume(allowed);
+
+		const auto calls = static_cast<double>(rounds * cases.size());
+		return { elapsed / calls, instructions.IsAvailable() ? static_cast<double>(retired) / calls : -1.0 };
+	}
+
+	void BenchmarkDecisions(std::size_t rounds)
+	{
+		test::Random random;
+		std::vector<Case> cases;
+		AddCrowd(cases, 4096, random);
+
+		auto filter = mock::MakeFilter(FilterMode::AngleOnly, false);
+		filter->params.Set(FilterFlag::CloseRangeBypass, false);
+		std::vector<CategoryThresholds> thresholds;
+		for (const auto& c : cases) {
+			thresholds.push_back(MakeCategoryThresholds(filter->params, c.maxDeviation, 1000.0f, 0.0f));
+		}
+
+		const Timing current = Measure(cases, rounds, [&, i = std::size_t{ 0 }](const Case& c) mutable {
+			const bool allow = DecideComment(filter->params, thresholds[i], c.query).allow;
+			i = i + 1 == thresholds.size() ? 0 : i + 1;
+			return allow;
+		});
+		const Timing reference = Measure(cases, rounds, [](const Case& c) {
+			return DecideCommentReference(c.query, c.maxDeviation);
+		});
+
+		std::printf("\n%-22s %10s %16s\n", "decision", "ns/call", "instructions/call");
+		for (const auto& [timing, name] : { std::pair{ current, "DecideComment" }, std::pair{ reference, "DecideCommentReference" } }) {
+			if (timing.instructionsPerCall < 0.0) {
+				std::printf("%-22s %10.2f %16s\n", name, timing.nanosecondsPerCall, "n/a");
+			} else {
+				std::printf("%-22s %10.2f %16.1f\n", name, timing.nanosecondsPerCall, timing.instructionsPerCall);
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = test::IsQuick(argc, argv);
+
+	TestDifferential(quick ? 200'000 : 10'000'000);
+	BenchmarkDecisions(quick ? 20 : 2'000);
+
+	return test::Finish("ReferenceDiffTest");
+}
@@ -0,0 +1,301 @@
+/**
+ * SnapshotEpochsTest.cpp - Reclamation of published snapshots
+ *
+ * Publishes and retires mock snapshots the way PublishConfig does and checks:
+ *   - a snapshot is kept while a reader that may have loaded it is inside
+ *     its SnapshotReadGuard, and freed by the next collection after it left
+ *   - readers that entered after the swap, and threads not reading at all,
+ *     never hold a snapshot back
+ *   - nested guards keep the outer section open
+ *   - under a stress run (readers in a tight loop, one writer publishing
+ *     continuously) no reader ever sees a reclaimed snapshot, and every
+ *     snapshot is freed once the readers stop; it prints how many were still
+ *     waiting after an average publication (readers preempted inside their
+ *     section hold snapshots back, so this depends on the core count)
+ *   - threads beyond kMaxSnapshotReaders block reclamation while reading
+ * Reclaimed snapshots are poisoned and parked instead of deleted, so a reader
+ * touching one fails a check rather than reading freed memory.
+ * Also times an empty read section.
+ *
+ * CTest also runs SnapshotEpochsTest_tsan (GCC and Clang).
+ *
+ * Usage: SnapshotEpochsTest [--quick]
+ */
+
+#include "SnapshotEpochs.h"
+#include "TestSupport.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr std::uint64_t kAlive = 0x5AFE5AFE5AFE5AFEull;
+	constexpr std::uint64_t kPoisoned = 0xDEADDEADDEADDEADull;
+	constexpr std::size_t kStressReaders = 8;
+
+	struct MockSnapshot
+	{
+		std::atomic<std::uint64_t> canary{ kAlive };
+		std::uint64_t generation = 0;
+	};
+
+	/**
+	 * The publishing side of Config.cpp: active pointer, retire list, collection.
+	 */
+	class Publisher
+	{
+	public:
+		Publisher() { active.store(NewSnapshot(0), std::memory_order_release); }
+
+		const MockSnapshot* Load() const { return active.load(std::memory_order_acquire); }
+
+		/**
+		 * @return Snapshots still waiting for a reader after the publication
+		 */
+		std::size_t Publish(std::uint64_t generation)
+		{
+			std::lock_guard lock(mutex);
+			const MockSnapshot* old = active.load(std::memory_order_relaxed);
+			active.store(NewSnapshot(generation), std::memory_order_release);
+			retired.push_back({ old, AdvanceSnapshotEpoch() });
+			return CollectLocked();
+		}
+
+		std::size_t Collect()
+		{
+			std::lock_guard lock(mutex);
+			return CollectLocked();
+		}
+
+		std::size_t Reclaimed() const { return graveyard.size(); }
+
+	private:
+		struct Retired
+		{
+			const MockSnapshot* snapshot;
+			std::uint64_t epoch;
+		};
+
+		const MockSnapshot* NewSnapshot(std::uint64_t generation)
+		{
+			auto snapshot = std::make_unique<MockSnapshot>();
+			snapshot->generation = generation;
+			owned.push_back(std::move(snapshot));
+			return owned.back().get();
+		}
+
+		std::size_t CollectLocked()
+		{
+			const std::uint64_t oldest = GetOldestSnapshotReader();
+			std::erase_if(retired, [&](const Retired& entry) {
+				if (entry.epoch > oldest) {
+					return false;
+				}
+				const_cast<MockSnapshot*>(entry.snapshot)->canary.store(kPoisoned, std::memory_order_relaxed);
+				graveyard.push_back(entry.snapshot);
+				return true;
+			});
+			return retired.size();
+		}
+
+		std::atomic<const MockSnapshot*> active{ nullptr };
+		std::mutex mutex;
+		std::vector<Retired> retired;
+		std::vector<const MockSnapshot*> graveyard;       // Poisoned, never deleted
+		std::vector<std::unique_ptr<MockSnapshot>> owned;  // Keeps the memory of every snapshot
+	};
+
+	/**
+	 * Runs a reader on another thread that enters, loads, signals and waits.
+	 */
+	class HeldReader
+	{
+	public:
+		explicit HeldReader(const Publisher& publisher) :
+			thread([&] {
+				const SnapshotReadGuard guard;
+				seen = publisher.Load();
+				inside.store(true);
+				while (!release.load()) {
+					std::this_thread::yield();
+				}
+				alive = seen->canary.load(std::memory_order_relaxed) == kAlive;
+			})
+		{
+			while (!inside.load()) {
+				std::this_thread::yield();
+			}
+		}
+
+		bool Leave()
+		{
+			release.store(true);
+			thread.join();
+			return alive;
+		}
+
+	private:
+		std::atomic<bool> inside{ false };
+		std::atomic<bool> release{ false };
+		const MockSnapshot* seen = nullptr;
+		bool alive = false;
+		std::thread thread;
+	};
+
+	void TestHeldReader()
+	{
+		Publisher publisher;
+		CHECK(publisher.Publish(1) == 0);  // Nobody reading: freed by the publication itself
+
+		HeldReader reader(publisher);      // Holds generation 1
+		CHECK(publisher.Publish(2) == 1);
+		CHECK(publisher.Publish(3) == 2);  // Generation 2 was retired while the reader was inside too
+		CHECK(publisher.Collect() == 2);
+		CHECK(reader.Leave());
+		CHECK(publisher.Collect() == 0);
+		CHECK(publisher.Reclaimed() == 3);
+
+		// A reader that entered after the swap does not hold the older snapshot
+		HeldReader late(publisher);
+		CHECK(publisher.Publish(4) == 1);  // Its own (generation 3) is held
+		CHECK(late.Leave());
+		CHECK(publisher.Collect() == 0);
+	}
+
+	void TestNesting()
+	{
+		Publisher publisher;
+		std::atomic<int> step{ 0 };
+		bool alive = false;
+		std::thread reader([&] {
+			const SnapshotReadGuard outer;
+			const MockSnapshot* seen = publisher.Load();
+			{
+				const SnapshotReadGuard inner;
+			}
+			step.store(1);
+			while (step.load() != 2) {
+				std::this_thread::yield();
+			}
+			alive = seen->canary.load(std::memory_order_relaxed) == kAlive;
+		});
+		while (step.load() != 1) {
+			std::this_thread::yield();
+		}
+		CHECK(publisher.Publish(1) == 1);  // The inner guard's exit did not end the section
+		step.store(2);
+		reader.join();
+		CHECK(alive);
+		CHECK(publisher.Collect() == 0);
+	}
+
+	void TestStress(std::size_t publications)
+	{
+		Publisher publisher;
+		std::atomic<bool> running{ true };
+		std::atomic<std::uint64_t> poisonedReads{ 0 };
+		std::atomic<std::uint64_t> reads{ 0 };
+		std::atomic<std::uint64_t> backwards{ 0 };
+
+		std::vector<std::thread> readers;
+		for (std::size_t r = 0; r < kStressReaders; ++r) {
+			readers.emplace_back([&] {
+				std::uint64_t count = 0;
+				std::uint64_t lastGeneration = 0;
+				while (running.load(std::memory_order_relaxed)) {
+					const SnapshotReadGuard guard;
+					const MockSnapshot* snapshot = publisher.Load();
+					if (snapshot->canary.load(std::memory_order_relaxed) != kAlive) {
+						poisonedReads.fetch_add(1);
+					}
+					backwards.fetch_add(snapshot->generation < lastGeneration ? 1 : 0, std::memory_order_relaxed);
+					lastGeneration = snapshot->generation;
+					++count;
+				}
+				reads.fetch_add(count);
+			});
+		}
+
+		std::size_t pendingAfterPublish = 0;
+		for (std::size_t i = 1; i <= publications; ++i) {
+			pendingAfterPublish += publisher.Publish(i);
+			if (i % 64 == 0) {
+				std::this_thread::yield();
+			}
+		}
+		running.store(false);
+		for (auto& reader : readers) {
+			reader.join();
+		}
+
+		CHECK(poisonedReads.load() == 0);
+		CHECK(backwards.load() == 0);
+		CHECK(publisher.Collect() == 0);
+		CHECK(publisher.Reclaimed() == publications);
+
+		std::printf("  %zu readers, %zu publications: %llu reads, none saw a reclaimed snapshot; "
+		            "%.2f snapshots waiting after an average publication\n",
+			kStressReaders, publications, static_cast<unsigned long long>(reads.load()),
+			static_cast<double>(pendingAfterPublish) / static_cast<double>(publications));
+	}
+
+	void TestOverflow()
+	{
+		// Claim every remaining slot with threads that have finished reading
+		std::vector<std::thread> claimers;
+		for (std::size_t i = 0; i < kMaxSnapshotReaders; ++i) {
+			claimers.emplace_back([] { const SnapshotReadGuard guard; });
+		}
+		for (auto& thread : claimers) {
+			thread.join();
+		}
+		CHECK(GetOldestSnapshotReader() == kNoSnapshotReaders);
+
+		Publisher publisher;
+		HeldReader reader(publisher);  // No slot left: counted as an overflow reader
+		CHECK(GetOldestSnapshotReader() == 0);
+		CHECK(publisher.Publish(1) == 1);
+		CHECK(reader.Leave());
+		CHECK(publisher.Collect() == 0);
+	}
+
+	void MeasureReadSection(std::size_t iterations)
+	{
+		Publisher publisher;
+		std::uint64_t sum = 0;
+
+		auto start = test::Clock::now();
+		for (std::size_t i = 0; i < iterations; ++i) {
+			sum += publisher.Load()->generation;
+		}
+		const double bare = test::ElapsedNanoseconds(start) / static_cast<double>(iterations);
+
+		start = test::Clock::now();
+		for (std::size_t i = 0; i < iterations; ++i) {
+			const SnapshotReadGuard guard;
+			sum += publisher.Load()->generation;
+		}
+		const double guarded = test::ElapsedNanoseconds(start) / static_cast<double>(iterations);
+
+		test::Consume(sum);
+		std::printf("  load: %.2f ns, guarded load: %.2f ns\n", bare, guarded);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = test::IsQuick(argc, argv);
+
+	TestHeldReader();
+	TestNesting();
+	TestStress(quick ? 2'000 : 200'000);
+	MeasureReadSection(quick ? 1'000'000 : 100'000'000);
+	TestOverflow();  // Last: uses up the reader slots
+
+	return test::Finish("SnapshotEpochsTest");
+}
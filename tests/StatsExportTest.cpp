@@ -0,0 +1,257 @@
+/**
+ * StatsExportTest.cpp - Statistics block: seqlock and shared memory mapping
+ *
+ * Seqlock (StatsExportLayout.h):
+ *   - nothing is read before the first update, or while an update is in progress
+ *   - a writer publishes snapshots whose every field is derived from one
+ *     number while readers copy them; every copy ReadSnapshot accepts must
+ *     belong to a single update (no torn reads). Copies made without the
+ *     sequence check are counted for comparison.
+ * Mapping (StatsMapping.h, shm_open + mmap here):
+ *   - a second publisher cannot take a live block's name
+ *   - a read-only mapping sees the publisher's updates
+ *   - the name disappears with the publisher, and a block left by a
+ *     publisher that died is replaced
+ *
+ * Usage: StatsExportTest [--quick]
+ */
+
+#include "StatsMapping.h"
+#include "TestSupport.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#	ifndef NOMINMAX
+#		define NOMINMAX
+#	endif
+#	include <Windows.h>
+#else
+#	include <sys/wait.h>
+#	include <unistd.h>
+#endif
+
+namespace
+{
+	using StatsExport::SharedStats;
+	using StatsExport::Snapshot;
+
+	/**
+	 * Snapshot number k: every field a different function of k, so fields
+	 * from two different updates never match each other.
+	 */
+	Snapshot MakeSnapshot(std::uint64_t k)
+	{
+		Snapshot snapshot{};
+		snapshot.uptimeMicroseconds = k;
+		snapshot.ticksPerSecond = k * 3 + 1;
+		snapshot.threadCount = k * 5 + 2;
+		for (std::size_t i = 0; i < StatsExport::kOutcomeCount; ++i) {
+			snapshot.outcomes[i] = k * 7 + i;
+		}
+		snapshot.timedCalls = k * 11 + 3;
+		snapshot.timedTicks = k * 13 + 4;
+		snapshot.maxTicks = k * 17 + 5;
+		for (std::size_t i = 0; i < StatsExport::kTimeBuckets; ++i) {
+			snapshot.timeHistogram[i] = k * 19 + i;
+		}
+		return snapshot;
+	}
+
+	/**
+	 * @return true if every field belongs to the same update (the one named by uptimeMicroseconds)
+	 */
+	bool IsConsistent(const Snapshot& snapshot)
+	{
+		Snapshot expected = MakeSnapshot(snapshot.uptimeMicroseconds);
+		expected.publishCount = snapshot.uptimeMicroseconds;  // The writer publishes 1, 2, 3, ...
+		return std::memcmp(&snapshot, &expected, sizeof(Snapshot)) == 0;
+	}
+
+	/**
+	 * Copy without the seqlock's sequence checks - what a reader would see
+	 * without the protocol.
+	 */
+	Snapshot CopyUnprotected(const SharedStats& shared)
+	{
+		constexpr auto relaxed = std::memory_order_relaxed;
+		Snapshot out{};
+		out.publishCount = shared.publishCount.load(relaxed);
+		out.uptimeMicroseconds = shared.uptimeMicroseconds.load(relaxed);
+		out.ticksPerSecond = shared.ticksPerSecond.load(relaxed);
+		out.threadCount = shared.threadCount.load(relaxed);
+		for (std::size_t i = 0; i < StatsExport::kOutcomeCount; ++i) {
+			out.outcomes[i] = shared.outcomes[i].load(relaxed);
+		}
+		out.timedCalls = shared.timedCalls.load(relaxed);
+		out.timedTicks = shared.timedTicks.load(relaxed);
+		out.maxTicks = shared.maxTicks.load(relaxed);
+		for (std::size_t i = 0; i < StatsExport::kTimeBuckets; ++i) {
+			out.timeHistogram[i] = shared.timeHistogram[i].load(relaxed);
+		}
+		return out;
+	}
+
+	void TestProtocol()
+	{
+		auto shared = std::make_unique<SharedStats>();
+		Snapshot snapshot{};
+		CHECK(!StatsExport::ReadSnapshot(*shared, snapshot));  // Nothing published yet
+
+		StatsExport::WriteSnapshot(*shared, MakeSnapshot(1));
+		CHECK(shared->sequence.load() == 2);
+		CHECK(StatsExport::ReadSnapshot(*shared, snapshot));
+		CHECK(IsConsistent(snapshot));
+
+		// A publisher stopped in the middle of an update: readers give up, never copy
+		shared->sequence.store(3);
+		snapshot = {};
+		CHECK(!StatsExport::ReadSnapshot(*shared, snapshot, 10));
+		CHECK(snapshot.publishCount == 0);
+		shared->sequence.store(4);
+
+		StatsExport::WriteSnapshot(*shared, MakeSnapshot(2));
+		CHECK(shared->sequence.load() == 6);
+		CHECK(StatsExport::ReadSnapshot(*shared, snapshot));
+		CHECK(snapshot.publishCount == 2 && IsConsistent(snapshot));
+	}
+
+	/**
+	 * @param readers Reader threads; every second one copies without the protocol
+	 */
+	void TestTornReads(std::size_t updates, std::size_t readers)
+	{
+		auto shared = std::make_unique<SharedStats>();
+		StatsExport::WriteSnapshot(*shared, MakeSnapshot(1));
+
+		std::atomic<std::size_t> started{ 0 };
+		std::atomic<bool> done{ false };
+		std::atomic<std::size_t> accepted{ 0 };
+		std::atomic<std::size_t> busy{ 0 };
+		std::atomic<std::size_t> torn{ 0 };
+		std::atomic<std::size_t> unprotectedTorn{ 0 };
+		std::atomic<std::size_t> unprotectedCopies{ 0 };
+		std::atomic<std::size_t> backwards{ 0 };
+
+		std::vector<std::thread> threads;
+		for (std::size_t r = 0; r < readers; ++r) {
+			threads.emplace_back([&, r] {
+				std::uint64_t last = 0;
+				++started;
+				while (!done.load(std::memory_order_relaxed)) {
+					if (r % 2) {
+						// Control: the same copy without the protocol
+						unprotectedTorn += IsConsistent(CopyUnprotected(*shared)) ? 0 : 1;
+						++unprotectedCopies;
+						continue;
+					}
+					Snapshot snapshot;
+					if (!StatsExport::ReadSnapshot(*shared, snapshot)) {
+						++busy;
+						continue;
+					}
+					++accepted;
+					torn += IsConsistent(snapshot) ? 0 : 1;
+					backwards += snapshot.publishCount < last ? 1 : 0;
+					last = snapshot.publishCount;
+				}
+			});
+		}
+
+		while (started.load() < readers) {
+			std::this_thread::yield();
+		}
+		for (std::uint64_t k = 2; k <= updates; ++k) {
+			StatsExport::WriteSnapshot(*shared, MakeSnapshot(k));
+		}
+		done = true;
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		CHECK(shared->publishCount.load() == updates);
+		CHECK(accepted > 0);
+		CHECK(torn == 0);
+		CHECK(backwards == 0);
+		std::printf("  %zu updates, %zu readers: %zu snapshots read, %zu torn, %zu gave up (busy)\n",
+			updates, (readers + 1) / 2, accepted.load(), torn.load(), busy.load());
+		std::printf("  control without the sequence check: %zu of %zu copies torn\n", unprotectedTorn.load(), unprotectedCopies.load());
+	}
+
+	void TestMapping()
+	{
+		const std::string name = "tyf-stats-test-" + std::to_string(test::Clock::now().time_since_epoch().count());
+		std::string error;
+
+		CHECK(!OpenStatsMapping(name, error));
+		CHECK(!error.empty());
+
+		auto publisher = CreateStatsMapping(name, error);
+		CHECK(publisher != nullptr);
+		if (!publisher) {
+			std::printf("  cannot create shared memory (%s) - mapping tests skipped\n", error.c_str());
+			return;
+		}
+		SharedStats& shared = *publisher->Get();
+		CHECK(shared.sequence.load() == 0);  // Zero-filled
+#ifdef _WIN32
+		shared.processID = static_cast<std::uint32_t>(GetCurrentProcessId());
+#else
+		shared.processID = static_cast<std::uint32_t>(getpid());
+#endif
+
+		// A live publisher keeps its name
+		CHECK(!CreateStatsMapping(name, error));
+
+		// The reader maps the same pages
+		auto reader = OpenStatsMapping(name, error);
+		CHECK(reader != nullptr);
+		if (reader) {
+			CHECK(reader->Get() != publisher->Get());
+			StatsExport::WriteSnapshot(shared, MakeSnapshot(1));
+			Snapshot snapshot;
+			CHECK(StatsExport::ReadSnapshot(*reader->Get(), snapshot));
+			CHECK(IsConsistent(snapshot));
+			CHECK(reader->Get()->processID == shared.processID);
+		}
+
+		// A reader keeps its view; new readers no longer find the name
+		publisher.reset();
+		CHECK(!OpenStatsMapping(name, error));
+		reader.reset();
+
+#ifndef _WIN32
+		// A publisher that died without removing the name (the mapping is leaked on purpose)
+		const pid_t child = fork();
+		if (child == 0) {
+			_exit(0);
+		}
+		waitpid(child, nullptr, 0);
+
+		auto crashed = CreateStatsMapping(name, error);
+		CHECK(crashed != nullptr);
+		if (crashed) {
+			crashed->Get()->processID = static_cast<std::uint32_t>(child);
+			static_cast<void>(crashed.release());
+		}
+		auto replacement = CreateStatsMapping(name, error);
+		CHECK(replacement != nullptr);
+		CHECK(replacement && replacement->Get()->processID == 0);
+#endif
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = test::IsQuick(argc, argv);
+
+	TestProtocol();
+	TestTornReads(quick ? 200'000 : 20'000'000, 4);
+	TestMapping();
+
+	return test::Finish("StatsExportTest");
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+/**
+ * TestSupport.h - Minimal check macros and timing for tests/
+ *
+ * Every test is a plain executable registered with CTest: it prints what it
+ * checked and returns non-zero if any CHECK failed. Benchmarks accept --quick
+ * (fewer iterations, used by CTest so the suite stays fast) and otherwise run
+ * long enough for stable numbers.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace test
+{
+	inline int g_failures = 0;
+
+	inline void ReportFailure(const char* file, int line, const char* expression)
+	{
+		std::printf("%s:%d: CHECK failed: %s\n", file, line, expression);
+		++g_failures;
+	}
+
+	/**
+	 * @return Process exit code: 0 if every check passed
+	 */
+	inline int Finish(const char* name)
+	{
+		if (g_failures) {
+			std::printf("%s: %d check(s) failed\n", name, g_failures);
+			return 1;
+		}
+		std::printf("%s: all checks passed\n", name);
+		return 0;
+	}
+
+	/**
+	 * @return true if --quick was passed (CTest runs benchmarks this way)
+	 */
+	inline bool IsQuick(int argc, char** argv)
+	{
+		for (int i = 1; i < argc; ++i) {
+			if (std::strcmp(argv[i], "--quick") == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Fixed-seed linear congruential generator (Numerical Recipes constants),
+	 * the same one PgoTraining.cpp uses, so runs are reproducible.
+	 */
+	struct Random
+	{
+		std::uint32_t state = 0x2545F491;
+
+		std::uint32_t NextBits()
+		{
+			state = state * 1664525u + 1013904223u;
+			return state;
+		}
+
+		float Next()  // [0, 1)
+		{
+			return static_cast<float>(NextBits() >> 8) * (1.0f / 16777216.0f);
+		}
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	inline double ElapsedNanoseconds(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+	}
+
+	inline volatile std::uint64_t g_sink = 0;
+
+	// Keeps a result alive so the measured loop is not optimized away
+	inline void Consume(std::uint64_t value)
+	{
+		g_sink = g_sink + value;
+	}
+}
+
+#define CHECK(expression) \
+	do { \
+		if (!(expression)) { \
+			test::ReportFailure(__FILE__, __LINE__, #expression); \
+		} \
+	} while (false)
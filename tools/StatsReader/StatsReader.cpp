@@ -0,0 +1,130 @@
+/**
+ * StatsReader.cpp - Live view of the plugin's filter statistics
+ *
+ * Opens the shared statistics block published by the plugin (bStatsExport)
+ * read-only and prints one line per sample. Reading never blocks or slows
+ * the game: the plugin's export thread publishes under a seqlock and a
+ * sample that races an update is simply retried.
+ *
+ * Usage: tyf-stats [interval_ms] [samples]
+ *   interval_ms  Time between samples (default 1000)
+ *   samples      Number of samples, 0 = until Ctrl+C (default 0)
+ */
+
+#include "StatsExportLayout.h"
+#include "StatsMapping.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace
+{
+	using StatsExport::SharedStats;
+	using StatsExport::Snapshot;
+
+	/**
+	 * Upper bound of a histogram bucket in nanoseconds.
+	 */
+	double BucketLimitNanoseconds(std::size_t bucket, std::uint64_t ticksPerSecond)
+	{
+		const double ticks = static_cast<double>(64ull << bucket);
+		return ticks * 1e9 / static_cast<double>(ticksPerSecond);
+	}
+
+	/**
+	 * Smallest bucket limit below which the given fraction of the interval's calls fall.
+	 */
+	double Percentile(const Snapshot& now, const Snapshot& last, double fraction)
+	{
+		std::uint64_t total = 0;
+		for (std::size_t i = 0; i < StatsExport::kTimeBuckets; ++i) {
+			total += now.timeHistogram[i] - last.timeHistogram[i];
+		}
+		if (total == 0 || now.ticksPerSecond == 0) {
+			return 0.0;
+		}
+
+		const auto target = static_cast<std::uint64_t>(static_cast<double>(total) * fraction);
+		std::uint64_t seen = 0;
+		for (std::size_t i = 0; i < StatsExport::kTimeBuckets; ++i) {
+			seen += now.timeHistogram[i] - last.timeHistogram[i];
+			if (seen >= target) {
+				return BucketLimitNanoseconds(i, now.ticksPerSecond);
+			}
+		}
+		return BucketLimitNanoseconds(StatsExport::kTimeBuckets - 1, now.ticksPerSecond);
+	}
+
+	void PrintSample(const Snapshot& now, const Snapshot& last)
+	{
+		const double seconds = static_cast<double>(now.uptimeMicroseconds - last.uptimeMicroseconds) / 1e6;
+		const std::uint64_t checks = now.Total() - last.Total();
+		const std::uint64_t allowed = now.Allowed() - last.Allowed();
+		const std::uint64_t outOfRange = now.outcomes[3] - last.outcomes[3];
+		const std::uint64_t timed = now.timedCalls - last.timedCalls;
+
+		std::printf("%10.1f s  %8.0f checks/s  allow %5.1f%%  out-of-range %5.1f%%  threads %2llu",
+			static_cast<double>(now.uptimeMicroseconds) / 1e6,
+			seconds > 0.0 ? static_cast<double>(checks) / seconds : 0.0,
+			checks ? 100.0 * static_cast<double>(allowed) / static_cast<double>(checks) : 0.0,
+			checks ? 100.0 * static_cast<double>(outOfRange) / static_cast<double>(checks) : 0.0,
+			static_cast<unsigned long long>(now.threadCount));
+
+		if (timed && now.ticksPerSecond) {
+			const double ticksToNs = 1e9 / static_cast<double>(now.ticksPerSecond);
+			std::printf("  mean %6.0f ns  p50 <%6.0f ns  p99 <%7.0f ns  max %8.0f ns",
+				static_cast<double>(now.timedTicks - last.timedTicks) / static_cast<double>(timed) * ticksToNs,
+				Percentile(now, last, 0.50), Percentile(now, last, 0.99),
+				static_cast<double>(now.maxTicks) * ticksToNs);
+		}
+		std::printf("\n");
+		std::fflush(stdout);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const unsigned long intervalMs = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+	const unsigned long samples = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0;
+	if (intervalMs == 0) {
+		std::fprintf(stderr, "usage: tyf-stats [interval_ms] [samples]\n");
+		return 2;
+	}
+
+	std::string error;
+	const auto mapping = OpenStatsMapping(StatsExport::kMappingName, error);
+	if (!mapping) {
+		std::fprintf(stderr, "Statistics block not found (%s) - is the game running with bStatsExport=true?\n", error.c_str());
+		return 1;
+	}
+
+	const SharedStats* shared = mapping->Get();
+	if (shared->magic != StatsExport::kMagic || shared->version != StatsExport::kStatsLayoutVersion || shared->size != sizeof(SharedStats)) {
+		std::fprintf(stderr, "Statistics block has an unknown layout (version %u) - rebuild tyf-stats for this plugin version\n", shared->version);
+		return 1;
+	}
+
+	std::printf("to-your-face-reloaded statistics (game process %u), sampling every %lu ms\n", shared->processID, intervalMs);
+
+	Snapshot last{};
+	while (!StatsExport::ReadSnapshot(*shared, last)) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+
+	for (unsigned long i = 0; samples == 0 || i < samples; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+
+		Snapshot now{};
+		if (!StatsExport::ReadSnapshot(*shared, now)) {
+			continue;
+		}
+		if (now.publishCount != last.publishCount) {
+			PrintSample(now, last);
+			last = now;
+		}
+	}
+
+	return 0;
+}